@@ -15,8 +15,8 @@
 #include "xmalloc.h"
 
 /** @cond PRIVATE */
-#define obstack_chunk_alloc xmalloc
-#define obstack_chunk_free  free
+#define obstack_chunk_alloc obstack_arena_chunk_alloc
+#define obstack_chunk_free  obstack_arena_chunk_free
 /** @endcond */
 
 #endif
@@ -514,6 +514,43 @@ FIRM_API int obstack_printf(struct obstack *obst, const char *fmt, ...)
 FIRM_API int obstack_vprintf(struct obstack *obst, const char *fmt, va_list ap)
 	FIRM_NOTHROW FIRM_PRINTF(2, 0);
 
+/* Chunk allocator used by libfirm's obstacks (see obst.h).  Chunks are
+   rounded up to power of two size classes and freed chunks are kept in a
+   per thread cache, so they can be reused by the next obstack instead of
+   going back to malloc.  `obstack_arena_chunk_free' expects a chunk
+   initialized by the obstack functions, as it reads the chunk size from
+   its limit field.  */
+FIRM_API void *obstack_arena_chunk_alloc (ptrdiff_t size);
+FIRM_API void obstack_arena_chunk_free (void *chunk);
+
+/* Returns all chunks cached by the calling thread to the system.  Threads
+   using obstacks should call this before they exit.  */
+FIRM_API void obstack_arena_release (void);
+
+/* Sets the size up to which the preferred chunk size of an obstack doubles
+   whenever it needs a new chunk.  Rounded up to a power of two, at most
+   2 MiB.  Default is 64 KiB.  */
+FIRM_API void obstack_arena_set_max_chunk_size (ptrdiff_t size);
+FIRM_API ptrdiff_t obstack_arena_get_max_chunk_size (void);
+
+/* If nonzero, chunks of 2 MiB and more are advised to use transparent huge
+   pages where the system supports it.  */
+FIRM_API void obstack_arena_set_hugepages (int enable);
+
+/* Sets the number of bytes each thread may keep in its chunk cache.  */
+FIRM_API void obstack_arena_set_cache_limit (size_t bytes);
+
+typedef struct obstack_arena_stats
+{
+	size_t n_system_allocs;  /* chunks allocated from the system */
+	size_t n_system_frees;   /* chunks returned to the system */
+	size_t n_reused;         /* chunk allocations served from the cache */
+	size_t cached_bytes;     /* bytes currently held in the cache */
+} obstack_arena_stats;
+
+/* Stores the chunk allocator statistics of the calling thread.  */
+FIRM_API void obstack_arena_get_stats (obstack_arena_stats *stats);
+
 /** @endcond */
 
 #include "../end.h"
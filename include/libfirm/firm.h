@@ -92,12 +92,14 @@
 #include "irio.h"
 #include "irloop.h"
 #include "irmemory.h"
+#include "irmemstat.h"
 #include "irmode.h"
 #include "irnode.h"
 #include "irop.h"
 #include "iropt.h"
 #include "iroptimize.h"
 #include "irouts.h"
+#include "irpipeline.h"
 #include "irprintf.h"
 #include "irprog.h"
 #include "irverify.h"
@@ -47,6 +47,15 @@ FIRM_API void ir_init_library(void);
  */
 FIRM_API void ir_finish(void);
 
+/**
+ * Prepares the firm library for creating idents, tarvals and modes from
+ * several threads at the same time.  This must be called before such threads
+ * are started; until then the interning tables are used without locking.
+ * ir_pipeline_run() calls this itself before it runs passes on several
+ * threads.
+ */
+FIRM_API void ir_enable_threads(void);
+
 /** returns the libFirm major version number */
 FIRM_API unsigned ir_get_version_major(void);
 /** returns libFirm minor version number */
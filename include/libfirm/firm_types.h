@@ -301,9 +301,33 @@ typedef enum ir_builtin_kind {
 	                                 1 otherwise */
 	ir_bk_va_start,             /**< va_start from <stdarg.h> */
 	ir_bk_va_arg,               /**< va_arg from <stdarg.h> */
-	ir_bk_last = ir_bk_va_arg,
+	ir_bk_atomic_fetch_add,     /**< atomic add, returns the previous value */
+	ir_bk_atomic_fetch_sub,     /**< atomic subtract, returns the previous
+	                                 value */
+	ir_bk_atomic_fetch_and,     /**< atomic and, returns the previous value */
+	ir_bk_atomic_fetch_or,      /**< atomic or, returns the previous value */
+	ir_bk_atomic_fetch_xor,     /**< atomic xor, returns the previous value */
+	ir_bk_atomic_exchange,      /**< atomic exchange, returns the previous
+	                                 value */
+	ir_bk_atomic_load,          /**< atomic load */
+	ir_bk_atomic_store,         /**< atomic store */
+	ir_bk_atomic_fence,         /**< memory fence */
+	ir_bk_last = ir_bk_atomic_fence,
 } ir_builtin_kind;
 
+/** Memory ordering constraints of atomic builtins, modeled after the C11
+ * memory_order.
+ * @ingroup Builtin
+ */
+typedef enum ir_memory_order {
+	ir_memory_order_relaxed, /**< only atomicity, no ordering constraints */
+	ir_memory_order_acquire, /**< later accesses stay after the operation */
+	ir_memory_order_release, /**< earlier accesses stay before the
+	                              operation */
+	ir_memory_order_acq_rel, /**< acquire and release */
+	ir_memory_order_seq_cst, /**< sequentially consistent (default) */
+} ir_memory_order;
+
 /**
  * This enumeration flags the volatility of entities and Loads/Stores.
  */
@@ -264,9 +264,9 @@
  *    problem is hidden in the content of this variable.
  *
  *    All values known in a Block are listed in the block's attribute
- *    block.graph_arr which is used to automatically insert Phi nodes.  The
+ *    block.values which is used to automatically insert Phi nodes.  The
  *    following two functions can be used to add a newly computed value to the
- *    array, or to get the producer of a value, i.e., the current live value.
+ *    table, or to get the producer of a value, i.e., the current live value.
  *
  *    void set_value(int pos, ir_node *value)
  *    -----------------------------------------------
@@ -110,6 +110,21 @@ FIRM_API void set_opt_global_null_ptr_elimination(int value);
 /** Returns global null pointer test elimination setting. */
 FIRM_API int get_opt_global_null_ptr_elimination(void);
 
+/**
+ * Enables/Disables the block-wise node layout of dead_node_elimination().
+ *
+ * If enabled, dead_node_elimination() copies the nodes block by block, with
+ * the blocks in control flow order and the nodes of each block in dependence
+ * order.  This speeds up block-wise and topological walks, but slows down
+ * plain graph walks and dead_node_elimination() itself.  Otherwise the nodes
+ * are copied in the order of a depth-first walk.
+ * Default: opt_dce_block_layout == 0.
+ */
+FIRM_API void set_opt_dce_block_layout(int value);
+
+/** Returns the block-wise node layout setting of dead_node_elimination(). */
+FIRM_API int get_opt_dce_block_layout(void);
+
 /**
  * Save the current optimization state.
  */
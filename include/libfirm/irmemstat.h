@@ -0,0 +1,94 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Memory usage accounting per subsystem.
+ */
+#ifndef FIRM_IR_IRMEMSTAT_H
+#define FIRM_IR_IRMEMSTAT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "firm_types.h"
+
+#include "begin.h"
+
+/**
+ * @defgroup irmemstat Memory Statistics
+ *
+ * libFirm can account the memory of its major data structures per subsystem.
+ * The accounting works on the granularity of obstack chunks and hash tables,
+ * so it costs an atomic addition whenever a chunk or table is allocated or
+ * freed.  For each subsystem the current and the peak number of bytes are
+ * tracked.  The accounting is off unless ir_mem_stat_enable() is called.
+ *
+ * When statistic events are enabled, the current usage is emitted whenever an
+ * optimization confirms the properties of a graph, after each pass of an
+ * ir_pipeline_t and at the phase boundaries of the backend.
+ * @{
+ */
+
+/** Subsystems whose memory is accounted. */
+typedef enum ir_mem_kind {
+	ir_mem_nodes,    /**< node obstacks of the graphs */
+	ir_mem_outs,     /**< def-use arrays, see irouts.h */
+	ir_mem_edges,    /**< out edges, see iredges.h */
+	ir_mem_tarvals,  /**< target values */
+	ir_mem_idents,   /**< identifiers */
+	ir_mem_types,    /**< types and entities */
+	ir_mem_backend,  /**< backend obstacks of the graphs */
+	ir_mem_liveness, /**< backend liveness information */
+	ir_mem_sets,     /**< set, pset and hashset tables */
+	ir_mem_last = ir_mem_sets
+} ir_mem_kind;
+
+/**
+ * Enables the memory accounting.  This must be called before ir_init(), as
+ * memory allocated before is not accounted.  Without it, all usages are 0.
+ */
+FIRM_API void ir_mem_stat_enable(void);
+
+/** Returns the name of memory subsystem @p kind. */
+FIRM_API char const *get_ir_mem_kind_name(ir_mem_kind kind);
+
+/** Returns the number of bytes currently used by subsystem @p kind. */
+FIRM_API size_t ir_mem_stat_get_current(ir_mem_kind kind);
+
+/**
+ * Returns the largest number of bytes used by subsystem @p kind since the
+ * start or the last call of ir_mem_stat_reset_peaks().
+ */
+FIRM_API size_t ir_mem_stat_get_peak(ir_mem_kind kind);
+
+/** Returns the number of bytes currently used by all subsystems together. */
+FIRM_API size_t ir_mem_stat_get_total(void);
+
+/**
+ * Returns the largest number of bytes used by all subsystems together since
+ * the start or the last call of ir_mem_stat_reset_peaks().
+ */
+FIRM_API size_t ir_mem_stat_get_total_peak(void);
+
+/** Sets all peaks to the current usage. */
+FIRM_API void ir_mem_stat_reset_peaks(void);
+
+/**
+ * Returns the number of bytes, which the graph @p irg currently uses in
+ * subsystem @p kind.  Only the per graph subsystems ir_mem_nodes, ir_mem_outs,
+ * ir_mem_edges, ir_mem_backend and ir_mem_liveness are attributed to graphs,
+ * 0 is returned for the others.
+ */
+FIRM_API size_t ir_mem_stat_get_graph(ir_graph const *irg, ir_mem_kind kind);
+
+/** Prints the current and peak usage of all subsystems to @p out. */
+FIRM_API void ir_mem_stat_print(FILE *out);
+
+/** @} */
+
+#include "end.h"
+
+#endif
@@ -287,6 +287,9 @@ FIRM_API ir_entity *get_Call_callee(const ir_node *call);
 /** Returns a human readable string for the ir_builtin_kind. */
 FIRM_API const char *get_builtin_kind_name(ir_builtin_kind kind);
 
+/** Returns a human readable string for the ir_memory_order. */
+FIRM_API const char *get_memory_order_name(ir_memory_order order);
+
 /** Returns left operand of binary operation @p node. */
 FIRM_API ir_node *get_binop_left(const ir_node *node);
 /** Sets left operand of binary operation @p node. */
@@ -10,6 +10,7 @@
 #ifndef FIRM_IROPTIMIZE_H
 #define FIRM_IROPTIMIZE_H
 
+#include <stddef.h>
 #include "firm_types.h"
 
 #include "begin.h"
@@ -39,6 +40,22 @@ FIRM_API void optimize_cf(ir_graph *irg);
  */
 FIRM_API void opt_jumpthreading(ir_graph* irg);
 
+/**
+ * Forms superblocks along hot traces by tail duplication.
+ *
+ * Traces follow the most likely successors according to the block execution
+ * frequencies.  These are taken as they are, so frequencies from a profile
+ * (see ir_create_execfreqs_from_profile()) are used if present, otherwise
+ * they are estimated.  Blocks of a trace with side entrances are duplicated
+ * so the trace is only entered at its head, then the local optimizations are
+ * rerun on the duplicated blocks.
+ *
+ * @param irg     the graph
+ * @param growth  maximum number of duplicated nodes in percent of the
+ *                number of nodes in the graph
+ */
+FIRM_API void form_superblocks(ir_graph *irg, unsigned growth);
+
 /**
  * Simplifies boolean expression in the given ir graph.
  * eg. x < 5 && x < 6 becomes x < 5
@@ -301,6 +318,19 @@ FIRM_API void remove_phi_cycles(ir_graph *irg);
  */
 FIRM_API void proc_cloning(float threshold);
 
+/**
+ * Performs interprocedural sparse conditional constant propagation.
+ *
+ * Propagates constant arguments from all call sites into functions whose
+ * callers are all known (they are neither externally visible nor is their
+ * address taken). Constant return values replace the call results in the
+ * callers, integer return values within a known range get Confirm nodes.
+ * Results no call site uses are no longer computed by such functions.
+ *
+ * Run local optimizations afterwards to remove the code that became dead.
+ */
+FIRM_API void ipsccp(void);
+
 /**
  * Reassociation.
  *
@@ -444,6 +474,47 @@ FIRM_API void do_loop_unrolling(ir_graph *irg);
  */
 FIRM_API void unroll_loops(ir_graph *irg, unsigned factor, unsigned maxsize);
 
+/**
+ * Perform loop versioning on a given graph.
+ * Innermost loops whose trip count is only known at runtime get a fast
+ * version which tests for the loop exit once every @p factor iterations.  It
+ * is entered if a runtime check shows at least @p factor iterations; the
+ * original loop executes the remaining iterations.  Compares of the
+ * induction variable against the loop limit in the body, which the exit test
+ * decides, are folded in the fast version.
+ *
+ * @param irg       the IR-graph to optimize
+ * @param factor    the number of iterations per exit test in the fast version
+ * @param maxsize   the maximum number of nodes in a loop
+ */
+FIRM_API void version_loops(ir_graph *irg, unsigned factor, unsigned maxsize);
+
+/**
+ * Inserts software prefetches for loads in innermost loops whose address
+ * advances by a constant stride in each iteration.
+ *
+ * The prefetch distance is chosen such that a prefetch is issued about
+ * @p latency cost units (roughly instructions) before the load executes; the
+ * cost of a loop iteration is estimated from its size.  Backends without
+ * prefetch instructions drop the inserted builtins.
+ *
+ * @param irg       the IR-graph to optimize
+ * @param latency   the memory latency to hide
+ */
+FIRM_API void insert_prefetches(ir_graph *irg, unsigned latency);
+
+/**
+ * Replaces loop idioms by library calls and builtins.
+ * Innermost loops filling consecutive elements with a byte pattern become
+ * memset calls, loops copying between non-overlapping arrays become CopyB
+ * nodes or memcpy calls and loops counting the set bits of a value by
+ * clearing the lowest one become popcount builtins.  Replacements for loops
+ * with a symbolic trip count are guarded by the loop entry test.
+ *
+ * @param irg       the IR-graph to optimize
+ */
+FIRM_API void replace_loop_idioms(ir_graph *irg);
+
 /**
  * Perform loop peeling on a given graph.
  */
@@ -459,6 +530,20 @@ FIRM_API void do_loop_peeling(ir_graph *irg);
  */
 FIRM_API void garbage_collect_entities(void);
 
+/**
+ * Merges functions with identical bodies (identical code folding).
+ *
+ * Graphs are bucketed by a structural hash and compared for exact
+ * isomorphism. A function identical to another one becomes an alias of it,
+ * or a thunk calling it if its address may be compared. Functions differing
+ * only in a few numeric constants are merged into a new local function
+ * taking these constants as additional parameters; the originals become
+ * thunks calling it. Direct calls to folded functions are redirected.
+ *
+ * @return the estimated number of code bytes saved
+ */
+FIRM_API size_t merge_identical_functions(void);
+
 /**
  * Performs dead node elimination by copying the ir graph to a new obstack.
  *
@@ -0,0 +1,125 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Driver for a sequence of optimization passes.
+ */
+#ifndef FIRM_IR_IRPIPELINE_H
+#define FIRM_IR_IRPIPELINE_H
+
+#include <stdio.h>
+
+#include "firm_types.h"
+#include "irgraph.h"
+
+#include "begin.h"
+
+/**
+ * @ingroup iroptimize
+ * @defgroup irpipeline  Pass Pipeline
+ *
+ * A pipeline is a list of passes, which is run over the whole program.
+ *
+ * Graph passes transform a single graph.  They declare the graph properties
+ * they need, which the pipeline assures before running the pass, and the
+ * properties they destroy, which the pipeline invalidates afterwards.
+ * Consecutive graph passes form a stage: all passes of a stage are applied to
+ * one graph before the next graph is processed, so a graph stays hot in the
+ * caches while it is optimized.
+ *
+ * Program passes (like inlining or garbage_collect_entities()) work on the
+ * whole program.  They act as a barrier: all graph passes before a program
+ * pass have finished on all graphs before it is run.
+ *
+ * Graph passes may be declared re-entrant, which means that they can run on
+ * different graphs at the same time.  Consecutive re-entrant passes form a
+ * stage of their own, which is run on several threads, see
+ * ir_pipeline_set_n_threads().  Each thread applies all passes of the stage to
+ * one graph before taking the next.
+ * A re-entrant pass, including the analyses assured for it, must only modify
+ * the graph it is applied to; creating nodes, tarvals, idents and modes is
+ * fine, modifying types, entities or the list of graphs is not.
+ * local_optimize_graph(), remove_bads() and remove_tuples() are re-entrant.
+ *
+ * Every pass is timed, see ir_pipeline_print_times().
+ * @{
+ */
+
+/** A pass pipeline. */
+typedef struct ir_pipeline_t ir_pipeline_t;
+
+/** A pass working on a single graph. */
+typedef void (*ir_graph_pass_func)(ir_graph *irg);
+
+/** A pass working on the whole program. */
+typedef void (*ir_prog_pass_func)(void);
+
+/** Creates a new, empty pipeline. */
+FIRM_API ir_pipeline_t *new_ir_pipeline(void);
+
+/** Frees the pipeline @p pipeline. */
+FIRM_API void free_ir_pipeline(ir_pipeline_t *pipeline);
+
+/**
+ * Appends a graph pass to @p pipeline.
+ *
+ * @param pipeline     the pipeline
+ * @param name         name of the pass, used for timing output
+ * @param func         the pass
+ * @param required     properties assured before running the pass
+ * @param invalidated  properties invalidated after running the pass
+ */
+FIRM_API void ir_pipeline_add_graph_pass(ir_pipeline_t *pipeline,
+                                         char const *name,
+                                         ir_graph_pass_func func,
+                                         ir_graph_properties_t required,
+                                         ir_graph_properties_t invalidated);
+
+/**
+ * Appends a re-entrant graph pass to @p pipeline.  The parameters are the same
+ * as for ir_pipeline_add_graph_pass().
+ */
+FIRM_API void ir_pipeline_add_reentrant_graph_pass(ir_pipeline_t *pipeline,
+                                                   char const *name,
+                                                   ir_graph_pass_func func,
+                                                   ir_graph_properties_t required,
+                                                   ir_graph_properties_t invalidated);
+
+/**
+ * Appends a program pass to @p pipeline.
+ *
+ * @param pipeline  the pipeline
+ * @param name      name of the pass, used for timing output
+ * @param func      the pass
+ */
+FIRM_API void ir_pipeline_add_prog_pass(ir_pipeline_t *pipeline,
+                                        char const *name,
+                                        ir_prog_pass_func func);
+
+/**
+ * Sets the number of threads, which run the stages consisting only of
+ * re-entrant passes.  The default is 1, so all passes run on the calling
+ * thread.  On Windows the stages are always run on the calling thread.
+ */
+FIRM_API void ir_pipeline_set_n_threads(ir_pipeline_t *pipeline,
+                                        unsigned n_threads);
+
+/** Runs all passes of @p pipeline over all graphs of the program. */
+FIRM_API void ir_pipeline_run(ir_pipeline_t *pipeline);
+
+/**
+ * Prints the time spent in each pass of @p pipeline, accumulated over all
+ * runs of the pipeline, to @p out.  The time of a pass run on several threads
+ * is the sum of the time spent in each thread.
+ */
+FIRM_API void ir_pipeline_print_times(ir_pipeline_t const *pipeline,
+                                      FILE *out);
+
+/** @} */
+
+#include "end.h"
+
+#endif
@@ -41,7 +41,7 @@ FIRM_API ir_jit_segment_t *be_new_jit_segment(void);
 
 /**
  * Destroy jit segment \p segment. Invalidates references to functions created in
- * the segment.
+ * the segment and frees the code installed in it.
  */
 FIRM_API void be_destroy_jit_segment(ir_jit_segment_t *segment);
 
@@ -72,6 +72,65 @@ FIRM_API unsigned be_get_function_size(ir_jit_function_t const *function);
  */
 FIRM_API void be_emit_function(char *buffer, ir_jit_function_t *function);
 
+/**
+ * Copy \p function into executable memory owned by \p segment and resolve its
+ * relocations. Returns the address of the code, which stays valid until it is
+ * freed with be_jit_free_function() or \p segment is destroyed.
+ *
+ * Code memory is never writable and executable at the same time. While code
+ * is installed or freed, the pages it occupies are not executable, so this
+ * must not happen concurrently with other threads running code of
+ * \p segment.
+ */
+FIRM_API void const *be_jit_install_function(ir_jit_segment_t *segment,
+                                             ir_jit_function_t *function);
+
+/**
+ * Free code previously returned by be_jit_install_function().
+ */
+FIRM_API void be_jit_free_function(ir_jit_segment_t *segment,
+                                   void const *code);
+
+/**
+ * Make \p code the target of the entry point of \p entity. The first call
+ * creates the entry point in \p segment and makes it the address of
+ * \p entity. Later calls redirect the entry point atomically, so callers
+ * switch to recompiled code without being recompiled themselves. The
+ * previous code may be freed once no thread executes it anymore.
+ */
+FIRM_API void be_jit_set_entry(ir_jit_segment_t *segment, ir_entity *entity,
+                               void const *code);
+
+/**
+ * Callback to materialize the code of \p entity on demand. Typically it
+ * compiles the graph of \p entity with be_jit_compile() and emits it with
+ * be_emit_function(). Returns the address of the executable code.
+ */
+typedef void const *(*ir_jit_resolver_t)(ir_entity *entity, void *data);
+
+/**
+ * Set the resolver used by the stubs of \p segment. \p data is passed to
+ * each call of \p resolver.
+ */
+FIRM_API void be_jit_set_resolver(ir_jit_segment_t *segment,
+                                  ir_jit_resolver_t resolver, void *data);
+
+/**
+ * Return whether the target supports be_jit_emit_stub().
+ */
+FIRM_API int be_jit_supports_stubs(void);
+
+/**
+ * Create a lazy compilation stub for \p entity in \p segment. The stub
+ * becomes the entry point of \p entity, see be_jit_set_entry(), which must
+ * not have one yet. The first call through the stub invokes the resolver of
+ * \p segment, makes the entry point jump to the returned code and continues
+ * there, so functions which are never called are never compiled.
+ *
+ * Stubs must not be executed concurrently before they are resolved.
+ */
+FIRM_API void be_jit_emit_stub(ir_jit_segment_t *segment, ir_entity *entity);
+
 /** @} */
 
 #include "end.h"
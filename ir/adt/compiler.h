@@ -53,6 +53,15 @@
 #define ENUMBF(type)  unsigned
 #endif
 
+/**
+ * Gives each thread its own instance of a static variable.
+ */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 /**
  * Asserts that the constant expression x is not zero at compiletime. name has
  * to be a unique identifier.
@@ -42,7 +42,10 @@
  * <ul>
  *  <li><b>JUMP(num_probes)</b> The probing method</li>
  *  <li><b>Alloc(count)</b>     Allocates count hashset entries (NOT bytes)</li>
- *  <li><b>Free(ptr)</b>        Frees a block of memory allocated by Alloc</li>
+ *  <li><b>Free(ptr,count)</b>  Frees a block of count entries allocated by
+ *                              Alloc</li>
+ *  <li><b>MemKind</b>          The subsystem the default Alloc accounts the
+ *                              entries to, see irmemstat.h</li>
  *  <li><b>SetRangeEmpty(ptr,count)</b> Efficiently sets a range of elements to
  *                                      the Null value</li>
  *  <li><b>ADDITIONAL_DATA<b>   Additional fields appended to the hashset struct</li>
@@ -78,9 +81,14 @@
 #endif /* DO_REHASH */
 
 #ifndef Alloc
-#include "xmalloc.h"
-#define Alloc(size) XMALLOCN(HashSetEntry, (size))
-#define Free(ptr)      free(ptr)
+#include "irmemstat_t.h"
+#ifndef MemKind
+#define MemKind ir_mem_sets
+#endif
+#define Alloc(size) \
+	((HashSetEntry*)ir_mem_alloc(MemKind, sizeof(HashSetEntry) * (size)))
+#define Free(ptr, size) \
+	ir_mem_free(MemKind, (ptr), sizeof(HashSetEntry) * (size))
 #endif /* Alloc */
 
 #ifdef ID_HASH
@@ -316,7 +324,7 @@ static inline void resize(HashSet *self, size_t new_size)
 	}
 
 	/* now we can free the old array */
-	Free(old_entries);
+	Free(old_entries, num_buckets);
 }
 #else
 
@@ -527,7 +535,7 @@ void hashset_destroy(HashSet *self)
 #ifdef ADDITIONAL_TERM
 	ADDITIONAL_TERM
 #endif
-	Free(self->entries);
+	Free(self->entries, self->num_buckets);
 #ifndef NDEBUG
 	self->entries = NULL;
 #endif
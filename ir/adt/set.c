@@ -44,14 +44,14 @@
 #ifdef PSET
 #include "pset.h"
 #else
-#include "set.h"
+#include "set_t.h"
 #endif
 
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-#include "xmalloc.h"
+#include "irmemstat_t.h"
 #include "lc_printf.h"
 #include "obst.h"
 
@@ -79,11 +79,13 @@ struct SET {
 #ifdef PSET
 	element_t *free_list;       /**< list of free Elements */
 #endif
+	ir_mem_kind mem_kind;     /**< subsystem the memory is accounted to */
 	struct obstack obst;      /**< obstack for allocation all data */
 };
 
 
-SET *(PMANGLE(new))(MANGLEP(cmp_fun) cmp, size_t nslots)
+static SET *new_table(MANGLEP(cmp_fun) cmp, size_t nslots,
+                      ir_mem_kind mem_kind)
 {
 	if (nslots > SEGMENT_SIZE * DIRECTORY_SIZE) {
 		nslots = DIRECTORY_SIZE;
@@ -95,7 +97,7 @@ SET *(PMANGLE(new))(MANGLEP(cmp_fun) cmp, size_t nslots)
 		nslots = i >> SEGMENT_SIZE_SHIFT;
 	}
 
-	SET *table = XMALLOC(SET);
+	SET *table = (SET*)ir_mem_alloc(mem_kind, sizeof(SET));
 	table->nseg      = table->p = table->nkey = 0;
 	table->maxp      = nslots << SEGMENT_SIZE_SHIFT;
 	table->cmp       = cmp;
@@ -103,7 +105,8 @@ SET *(PMANGLE(new))(MANGLEP(cmp_fun) cmp, size_t nslots)
 #ifdef PSET
 	table->free_list = NULL;
 #endif
-	obstack_init(&table->obst);
+	table->mem_kind  = mem_kind;
+	ir_mem_obstack_init(&table->obst, mem_kind);
 
 	/* Make segments */
 	for (size_t i = 0; i < nslots;  ++i) {
@@ -114,10 +117,22 @@ SET *(PMANGLE(new))(MANGLEP(cmp_fun) cmp, size_t nslots)
 	return table;
 }
 
+SET *(PMANGLE(new))(MANGLEP(cmp_fun) cmp, size_t nslots)
+{
+	return new_table(cmp, nslots, ir_mem_sets);
+}
+
+#ifndef PSET
+set *new_set_mem_kind(set_cmp_fun cmp, size_t nslots, ir_mem_kind mem_kind)
+{
+	return new_table(cmp, nslots, mem_kind);
+}
+#endif
+
 void PMANGLE(del)(SET *table)
 {
 	obstack_free(&table->obst, NULL);
-	free(table);
+	ir_mem_free(table->mem_kind, table, sizeof(SET));
 }
 
 size_t MANGLEP(count)(SET const *table)
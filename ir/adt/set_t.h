@@ -0,0 +1,22 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Internal interface of the hashed set.
+ */
+#ifndef FIRM_ADT_SET_T_H
+#define FIRM_ADT_SET_T_H
+
+#include "irmemstat.h"
+#include "set.h"
+
+/**
+ * Creates a new set like new_set(), whose memory is accounted to subsystem
+ * @p mem_kind instead of ir_mem_sets.
+ */
+set *new_set_mem_kind(set_cmp_fun func, size_t slots, ir_mem_kind mem_kind);
+
+#endif
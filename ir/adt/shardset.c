@@ -0,0 +1,95 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   A set, which can be split into independently locked shards.
+ */
+#include "shardset.h"
+
+#include <limits.h>
+
+#include "set_t.h"
+
+void shardset_init(shardset_t *const shardset, set_cmp_fun const func,
+                   size_t const slots, ir_mem_kind const mem_kind)
+{
+	shardset->base     = new_set_mem_kind(func, slots, mem_kind);
+	shardset->sharded  = false;
+	shardset->cmp      = func;
+	shardset->slots    = slots;
+	shardset->mem_kind = mem_kind;
+	for (unsigned i = 0; i != SHARDSET_N_SHARDS; ++i) {
+		shardset_shard_t *const shard = &shardset->shards[i];
+		shard->lock.locked = 0;
+		shard->set         = NULL;
+	}
+}
+
+void shardset_destroy(shardset_t *const shardset)
+{
+	del_set(shardset->base);
+	shardset->base = NULL;
+	for (unsigned i = 0; i != SHARDSET_N_SHARDS; ++i) {
+		shardset_shard_t *const shard = &shardset->shards[i];
+		if (shard->set != NULL) {
+			del_set(shard->set);
+			shard->set = NULL;
+		}
+	}
+	shardset->sharded = false;
+}
+
+void shardset_enable_threads(shardset_t *const shardset)
+{
+	if (shardset->sharded)
+		return;
+	size_t const shard_slots = shardset->slots / SHARDSET_N_SHARDS;
+	for (unsigned i = 0; i != SHARDSET_N_SHARDS; ++i) {
+		shardset->shards[i].set = new_set_mem_kind(shardset->cmp, shard_slots,
+		                                           shardset->mem_kind);
+	}
+	shardset->sharded = true;
+}
+
+static shardset_shard_t *get_shard(shardset_t *const shardset,
+                                   unsigned const hash)
+{
+	unsigned const shift = sizeof(hash) * CHAR_BIT - SHARDSET_SHARD_BITS;
+	return &shardset->shards[hash >> shift];
+}
+
+static void *insert(shardset_t *const shardset, void const *const key,
+                    size_t const size, unsigned const hash,
+                    _set_action const action)
+{
+	if (!shardset->sharded)
+		return ((set_entry*)_set_search(shardset->base, key, size, hash, action))->dptr;
+
+	/* The base set is not modified anymore, so it can be searched without
+	 * locking. */
+	void *const found = _set_search(shardset->base, key, size, hash, _set_find);
+	if (found != NULL)
+		return found;
+
+	shardset_shard_t *const shard = get_shard(shardset, hash);
+	spin_lock(&shard->lock);
+	set_entry *const entry = (set_entry*)_set_search(shard->set, key, size, hash,
+	                                                 action);
+	spin_unlock(&shard->lock);
+	return entry->dptr;
+}
+
+void *shardset_insert(shardset_t *const shardset, void const *const key,
+                      size_t const size, unsigned const hash)
+{
+	return insert(shardset, key, size, hash, _set_hinsert);
+}
+
+void *shardset_insert0(shardset_t *const shardset, void const *const key,
+                       size_t const size, unsigned const hash)
+{
+	return insert(shardset, key, size, hash, _set_hinsert0);
+}
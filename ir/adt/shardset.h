@@ -0,0 +1,83 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   A set, which can be split into independently locked shards, so
+ *          several threads can insert into it at the same time.
+ *
+ * A shardset starts out as a single set without any locking.  Once
+ * shardset_enable_threads() has been called, the single set is frozen and new
+ * entries go to the shards, which are selected by the upper bits of the hash.
+ * Sharding costs locality, so it is only done when threads are actually used.
+ *
+ * Entries are copied into the set like in a normal set and never move, so the
+ * returned pointers can be compared for identity.
+ */
+#ifndef FIRM_ADT_SHARDSET_H
+#define FIRM_ADT_SHARDSET_H
+
+#include <stdbool.h>
+
+#include "irmemstat.h"
+#include "set.h"
+#include "spinlock.h"
+
+#define SHARDSET_SHARD_BITS 6
+#define SHARDSET_N_SHARDS   (1U << SHARDSET_SHARD_BITS)
+
+/** One shard, padded to a cache line so the locks do not share lines. */
+typedef struct shardset_shard_t {
+	spinlock_t lock;
+	set       *set;
+	char       padding[64 - sizeof(spinlock_t) - sizeof(set*)];
+} shardset_shard_t;
+
+typedef struct shardset_t {
+	set             *base;     /**< entries inserted before sharding */
+	bool             sharded;  /**< new entries go to the shards */
+	set_cmp_fun      cmp;
+	size_t           slots;
+	ir_mem_kind      mem_kind;
+	shardset_shard_t shards[SHARDSET_N_SHARDS];
+} shardset_t;
+
+/**
+ * Initializes a sharded set.
+ *
+ * @param shardset  the set
+ * @param func      the compare function of the entries
+ * @param slots     expected number of entries of the whole set
+ * @param mem_kind  subsystem the memory of the set is accounted to
+ */
+void shardset_init(shardset_t *shardset, set_cmp_fun func, size_t slots,
+                   ir_mem_kind mem_kind);
+
+/** Frees the memory of a sharded set. */
+void shardset_destroy(shardset_t *shardset);
+
+/**
+ * Splits @p shardset into shards, so it can be inserted into from several
+ * threads.  This must be called before the threads are started.
+ */
+void shardset_enable_threads(shardset_t *shardset);
+
+/**
+ * Inserts an entry into a sharded set, see set_hinsert().
+ *
+ * @return the data of the entry in the set
+ */
+void *shardset_insert(shardset_t *shardset, void const *key, size_t size,
+                      unsigned hash);
+
+/**
+ * Inserts a zero-terminated entry into a sharded set, see set_hinsert0().
+ *
+ * @return the data of the entry in the set
+ */
+void *shardset_insert0(shardset_t *shardset, void const *key, size_t size,
+                       unsigned hash);
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   A minimal spin lock for short critical sections.
+ */
+#ifndef FIRM_ADT_SPINLOCK_H
+#define FIRM_ADT_SPINLOCK_H
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/** A spin lock.  A zero-initialized lock is unlocked. */
+typedef struct spinlock_t {
+#if defined(_MSC_VER)
+	volatile char locked;
+#else
+	unsigned char locked;
+#endif
+} spinlock_t;
+
+static inline void spin_lock(spinlock_t *const lock)
+{
+#if defined(_MSC_VER)
+	while (_InterlockedExchange8(&lock->locked, 1) != 0) {
+		while (lock->locked != 0)
+			_mm_pause();
+	}
+#else
+	while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) != 0) {
+		/* Wait with plain loads, so the cache line is not bounced around. */
+		while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED) != 0) {
+#if defined(__i386__) || defined(__x86_64__)
+			__builtin_ia32_pause();
+#endif
+		}
+	}
+#endif
+}
+
+static inline void spin_unlock(spinlock_t *const lock)
+{
+#if defined(_MSC_VER)
+	_InterlockedExchange8(&lock->locked, 0);
+#else
+	__atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+#endif
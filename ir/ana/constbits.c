@@ -10,13 +10,17 @@
  */
 #include "constbits.h"
 
+#include "array.h"
 #include "debug.h"
 #include "iredges_t.h"
 #include "irgwalk.h"
 #include "irnode_t.h"
 #include "irnodemap.h"
 #include "iropt.h"
+#include "panic.h"
+#include "tv_t.h"
 #include <assert.h>
+#include <limits.h>
 
 #ifndef VERIFY_CONSTBITS
 #	ifdef DEBUG_libfirm
@@ -29,7 +33,6 @@
 #if VERIFY_CONSTBITS
 #include "irdump.h"
 #include "irprintf.h"
-#include "panic.h"
 #endif
 
 /* TODO:
@@ -109,28 +112,101 @@
 
 DEBUG_ONLY(static firm_dbg_module_t *dbg;)
 
+/** Worklist of nodes, whose users must be triggered, see trigger_users(). */
+static ir_node const **trigger_worklist;
+
+/**
+ * Modes up to this width are analysed on native masks.  Only wider modes use
+ * tarvals during the fixpoint iteration.
+ */
+#define NATIVE_BITS 64
+
+static bool is_native_mode(ir_mode const *const mode)
+{
+	return get_mode_size_bits(mode) <= NATIVE_BITS;
+}
+
+static uint64_t mode_mask(ir_mode const *const mode)
+{
+	unsigned const bits = get_mode_size_bits(mode);
+	return bits >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+}
+
+static uint64_t tarval_to_bits(ir_tarval const *const tv)
+{
+	ir_mode *const mode = get_tarval_mode(tv);
+	if (mode == mode_b)
+		return tv == tarval_b_true;
+	return get_tarval_uint64(tv) & mode_mask(mode);
+}
+
+static ir_tarval *bits_to_tarval(uint64_t const bits, ir_mode *const mode)
+{
+	if (mode == mode_b)
+		return bits != 0 ? tarval_b_true : tarval_b_false;
+	unsigned char buf[sizeof(bits)];
+	for (size_t i = 0; i != sizeof(buf); ++i)
+		buf[i] = (unsigned char)(bits >> (i * CHAR_BIT));
+	return new_tarval_from_bytes(buf, mode);
+}
+
 static bool is_undefined(bitinfo const *const b)
 {
+	if (is_native_mode(b->mode))
+		return b->zb == 0 && b->ob == mode_mask(b->mode);
 	return tarval_is_null(b->z) && tarval_is_all_one(b->o);
 }
 
+/** Update the tarval representation of a natively analysed node. */
+static void materialize_bitinfo(bitinfo *const b)
+{
+	if (is_native_mode(b->mode)) {
+		b->z = bits_to_tarval(b->zb, b->mode);
+		b->o = bits_to_tarval(b->ob, b->mode);
+	}
+}
+
+static bitinfo *new_bitinfo(ir_node const *const irn, ir_mode *const mode)
+{
+	ir_graph       *const irg  = get_irn_irg(irn);
+	struct obstack *const obst = &irg->bitinfo.obst;
+	bitinfo        *const b    = OALLOCZ(obst, bitinfo);
+	b->mode = mode;
+	ir_nodemap_insert(&irg->bitinfo.map, irn, b);
+	return b;
+}
+
+/** Set native analysis information for node @p irn. */
+static bool set_bitinfo_bits(ir_node const *const irn, uint64_t const z, uint64_t const o)
+{
+	ir_graph *const irg = get_irn_irg(irn);
+	bitinfo  *const b   = ir_nodemap_get(bitinfo, &irg->bitinfo.map, irn);
+	if (z == b->zb && o == b->ob)
+		return false;
+
+	/* Assert ascending chain. */
+	assert((b->zb & ~z) == 0);
+	assert((o & ~b->ob) == 0);
+	b->zb = z;
+	b->ob = o;
+	DB((dbg, LEVEL_3, "Set %+F: 0:%llx 1:%llx%s\n", irn, (unsigned long long)z, (unsigned long long)o, is_undefined(b) ? " (bottom)" : z == mode_mask(b->mode) && o == 0 ? " (top)" : ""));
+	return true;
+}
+
 /** Set analysis information for node @p irn. */
 static bool set_bitinfo(ir_node const *const irn, ir_tarval *const z, ir_tarval *const o)
 {
-	ir_graph   *const irg  = get_irn_irg(irn);
-	ir_nodemap *const map  = &irg->bitinfo.map;
-	bitinfo          *b    = ir_nodemap_get(bitinfo, map, irn);
-	if (b == NULL) {
-		struct obstack *const obst = &irg->bitinfo.obst;
-		b = OALLOCZ(obst, bitinfo);
-		ir_nodemap_insert(map, irn, b);
-	} else if (z == b->z && o == b->o) {
+	ir_graph *const irg = get_irn_irg(irn);
+	bitinfo  *const b   = ir_nodemap_get(bitinfo, &irg->bitinfo.map, irn);
+	if (is_native_mode(b->mode))
+		return set_bitinfo_bits(irn, tarval_to_bits(z), tarval_to_bits(o));
+
+	if (z == b->z && o == b->o)
 		return false;
-	} else {
-		/* Assert ascending chain. */
-		assert(tarval_is_null(tarval_andnot(b->z, z)));
-		assert(tarval_is_null(tarval_andnot(o, b->o)));
-	}
+
+	/* Assert ascending chain. */
+	assert(tarval_is_null(tarval_andnot(b->z, z)));
+	assert(tarval_is_null(tarval_andnot(o, b->o)));
 	b->z = z;
 	b->o = o;
 	DB((dbg, LEVEL_3, "Set %+F: 0:%T 1:%T%s\n", irn, z, o, is_undefined(b) ? " (bottom)" : tarval_is_all_one(z) && tarval_is_null(o) ? " (top)" : ""));
@@ -142,6 +218,22 @@ static bool mode_is_intb(ir_mode const *const m)
 	return mode_is_int(m) || m == mode_b;
 }
 
+/**
+ * Get the mode of the lattice value of @p irn, or NULL if the node is not
+ * analysed.
+ */
+static ir_mode *get_bitinfo_mode(ir_node const *const irn)
+{
+	ir_mode *const mode = get_irn_mode(irn);
+	if (mode == mode_BB || mode == mode_X) {
+		/* Blocks and jumps use a boolean domain. */
+		return mode_b;
+	} else if (!mode_is_intb(mode)) {
+		return NULL;
+	}
+	return mode;
+}
+
 bitinfo const *try_get_bitinfo(ir_node const *const irn)
 {
 	ir_graph   *const irg = get_irn_irg(irn);
@@ -162,8 +254,13 @@ static bitinfo *get_bitinfo_direct(ir_node const *const irn)
 	bitinfo          *b   = ir_nodemap_get(bitinfo, map, irn);
 	if (!b && is_Const(irn) && mode_is_intb(get_irn_mode(irn))) {
 		ir_tarval *const tv = get_Const_tarval(irn);
-		set_bitinfo(irn, tv, tv);
-		b = ir_nodemap_get(bitinfo, map, irn);
+		b = new_bitinfo(irn, get_irn_mode(irn));
+		b->z = tv;
+		b->o = tv;
+		if (is_native_mode(b->mode)) {
+			b->zb = tarval_to_bits(tv);
+			b->ob = b->zb;
+		}
 	}
 	return b;
 }
@@ -181,29 +278,40 @@ static bitinfo *get_bitinfo_recursive(ir_node const *const irn)
 	ir_nodemap *const map = &irg->bitinfo.map;
 	bitinfo          *b   = ir_nodemap_get(bitinfo, map, irn);
 	if (!b || b->state == BITINFO_INVALID || b->state == BITINFO_UNSTABLE) {
-		ir_mode *mode = get_irn_mode(irn);
-		if (mode == mode_BB || mode == mode_X) {
-			/* Blocks and jumps use a boolean domain. */
-			mode = mode_b;
-		} else if (!mode_is_intb(mode)) {
+		ir_mode *const mode = get_bitinfo_mode(irn);
+		if (!mode)
 			return NULL;
-		}
 
 		/* Insert bottom to break cycles. */
-		struct obstack *const obst = &irg->bitinfo.obst;
 		if (!b)
-			b = OALLOCZ(obst, bitinfo);
+			b = new_bitinfo(irn, mode);
 		if (b->state == BITINFO_INVALID) {
-			b->z = get_mode_null(mode);
-			b->o = get_mode_all_one(mode);
+			if (is_native_mode(mode)) {
+				b->zb = 0;
+				b->ob = mode_mask(mode);
+			} else {
+				b->z = get_mode_null(mode);
+				b->o = get_mode_all_one(mode);
+			}
 		}
-		ir_nodemap_insert(map, irn, b);
 
 		calc_bitinfo(irn, b);
 	}
 	return b;
 }
 
+/**
+ * Get analysis information for node @p irn with an up to date tarval
+ * representation.
+ */
+static bitinfo *get_bitinfo_tarval(ir_node const *const irn)
+{
+	bitinfo *const b = get_bitinfo_recursive(irn);
+	if (b)
+		materialize_bitinfo(b);
+	return b;
+}
+
 static bitinfo *(*get_bitinfo_func)(ir_node const*) = &get_bitinfo_null;
 
 bitinfo *get_bitinfo(ir_node const *const irn)
@@ -211,22 +319,66 @@ bitinfo *get_bitinfo(ir_node const *const irn)
 	return get_bitinfo_func(irn);
 }
 
-static bool transfer(ir_node const *const irn)
+/** Shift the native mask @p x of mode @p m like the shift node @p irn. */
+static uint64_t shift_bits(ir_node const *const irn, uint64_t const x, uint64_t amount, ir_mode const *const m)
 {
-	ir_tarval *const f = tarval_b_false;
-	ir_tarval *const t = tarval_b_true;
-	ir_mode   *const m = get_irn_mode(irn);
-	ir_tarval       *z;
-	ir_tarval       *o;
+	unsigned const bits   = get_mode_size_bits(m);
+	unsigned const modulo = get_mode_modulo_shift(m);
+	uint64_t const mask   = mode_mask(m);
+	if (modulo != 0)
+		amount %= modulo;
+	switch (get_irn_opcode(irn)) {
+	case iro_Shl:
+		return amount < bits ? (x << amount) & mask : 0;
+	case iro_Shr:
+		return amount < bits ? x >> amount : 0;
+	case iro_Shrs: {
+		uint64_t const sign = (x >> (bits - 1) & 1) != 0 ? mask : 0;
+		if (amount >= bits)
+			return sign;
+		return x >> amount | (sign & ~(mask >> amount));
+	}
+	default:
+		panic("unexpected shift %+F", irn);
+	}
+}
+
+static uint64_t convert_bits(uint64_t x, ir_mode const *const src, ir_mode const *const dst)
+{
+	unsigned const bits = get_mode_size_bits(src);
+	if (mode_is_signed(src) && (x >> (bits - 1) & 1) != 0)
+		x |= ~mode_mask(src);
+	return x & mode_mask(dst);
+}
+
+static bool is_negative_bits(uint64_t const x, ir_mode const *const m)
+{
+	return mode_is_signed(m) && (x >> (get_mode_size_bits(m) - 1) & 1) != 0;
+}
 
-	if (m == mode_X) {
-		DB((dbg, LEVEL_3, "transfer %+F\n", irn));
+/** Compare two non-negative native values. */
+static ir_relation cmp_bits(uint64_t const a, uint64_t const b)
+{
+	return a < b ? ir_relation_less : a > b ? ir_relation_greater : ir_relation_equal;
+}
 
+/**
+ * Transfer function on native masks.  It handles control flow and all nodes,
+ * whose mode and operand modes fit into NATIVE_BITS.
+ */
+static bool transfer_bits(ir_node const *const irn, ir_mode *const m)
+{
+	uint64_t const mask = mode_mask(m);
+	uint64_t       z;
+	uint64_t       o;
+
+	DB((dbg, LEVEL_3, "transfer %+F\n", irn));
+	if (get_irn_mode(irn) == mode_X) {
 		bitinfo *const b = get_bitinfo_recursive(get_nodes_block(irn));
-		if (b->z == f) {
+		if (b->zb == 0) {
 unreachable_X:
-			z = f;
-			o = t;
+			z = 0;
+			o = 1;
 		} else switch (get_irn_opcode(irn)) {
 			case iro_Bad:
 				goto unreachable_X;
@@ -236,15 +388,15 @@ unreachable_X:
 				if (is_Start(pred)) {
 					goto result_unknown_X;
 				} else if (is_Cond(pred)) {
-					ir_node   *const selector = get_Cond_selector(pred);
-					bitinfo   *const b        = get_bitinfo_recursive(selector);
+					ir_node *const selector = get_Cond_selector(pred);
+					bitinfo *const b        = get_bitinfo_recursive(selector);
 					if (is_undefined(b))
 						goto unreachable_X;
-					if (b->z == b->o) {
-						if ((b->z == t) == get_Proj_num(irn)) {
-							z = o = t;
+					if (b->zb == b->ob) {
+						if ((b->zb == 1) == get_Proj_num(irn)) {
+							z = o = 1;
 						} else {
-							z = o = f;
+							z = o = 0;
 						}
 					} else {
 						goto result_unknown_X;
@@ -269,16 +421,15 @@ unreachable_X:
 cannot_analyse_X:
 				DB((dbg, LEVEL_4, "cannot analyse %+F\n", irn));
 result_unknown_X:
-				z = t;
-				o = f;
+				z = 1;
+				o = 0;
 				break;
 		}
 	} else if (is_Block(irn)) {
-		DB((dbg, LEVEL_3, "transfer %+F\n", irn));
 		bool reachable = false;
 		foreach_irn_in(irn, i, pred_block) {
 			bitinfo *const b = get_bitinfo_recursive(pred_block);
-			if (b->z == t) {
+			if (b->zb == 1) {
 				reachable = true;
 				/* We need to iterate all operands to reach a global fix point.
 				 * Thus, do not use a break here. */
@@ -293,466 +444,823 @@ result_unknown_X:
 		}
 
 		if (reachable) {
-			z = t;
-			o = f;
+			z = 1;
+			o = 0;
 		} else {
-			z = f;
-			o = t;
+			z = 0;
+			o = 1;
 		}
-	} else if (mode_is_intb(m)) {
-		DB((dbg, LEVEL_3, "transfer %+F\n", irn));
-
-		if (is_Phi(irn)) {
-			ir_node *const block = get_nodes_block(irn);
+	} else if (is_Phi(irn)) {
+		ir_node *const block = get_nodes_block(irn);
 
 repeatphi:
-			z = get_mode_null(m);
-			o = get_mode_all_one(m);
-			foreach_irn_in(block, i, pred_block) {
-				bitinfo *const b_cfg = get_bitinfo_recursive(pred_block);
-				if (b_cfg->z != f) {
-					bitinfo *const b = get_bitinfo_recursive(get_Phi_pred(irn, i));
-					z = tarval_or( z, b->z);
-					o = tarval_and(o, b->o);
-				}
+		z = 0;
+		o = mask;
+		foreach_irn_in(block, i, pred_block) {
+			bitinfo *const b_cfg = get_bitinfo_recursive(pred_block);
+			if (b_cfg->zb != 0) {
+				bitinfo *const b = get_bitinfo_recursive(get_Phi_pred(irn, i));
+				z |= b->zb;
+				o &= b->ob;
 			}
-			/* Computing bitinfo for operand 1 might render operand 0 unstable.
-			 * Thus, evaluate the operands until all of them are stable. */
-			foreach_irn_in(block, i, pred_block) {
-				bitinfo *const b_cfg = get_bitinfo_recursive(pred_block);
-				if (b_cfg->z != f) {
-					bitinfo *const b = get_bitinfo_direct(get_Phi_pred(irn, i));
-					if (b->state == BITINFO_UNSTABLE) {
-						goto repeatphi;
-					}
+		}
+		/* Computing bitinfo for operand 1 might render operand 0 unstable.
+		 * Thus, evaluate the operands until all of them are stable. */
+		foreach_irn_in(block, i, pred_block) {
+			bitinfo *const b_cfg = get_bitinfo_recursive(pred_block);
+			if (b_cfg->zb != 0) {
+				bitinfo *const b = get_bitinfo_direct(get_Phi_pred(irn, i));
+				if (b->state == BITINFO_UNSTABLE) {
+					goto repeatphi;
 				}
 			}
-		} else {
-			/* Undefined if any input is undefined. */
-			foreach_irn_in(irn, i, pred) {
-				bitinfo *const pred_b = get_bitinfo_recursive(pred);
-				if (pred_b != NULL && is_undefined(pred_b))
-					goto undefined;
-			}
+		}
+	} else {
+		/* Undefined if any input is undefined. */
+		foreach_irn_in(irn, i, pred) {
+			bitinfo *const pred_b = get_bitinfo_recursive(pred);
+			if (pred_b != NULL && is_undefined(pred_b))
+				goto undefined;
+		}
 
-			switch (get_irn_opcode(irn)) {
-				case iro_Bad:
+		switch (get_irn_opcode(irn)) {
+			case iro_Bad:
 undefined:
-					z = get_mode_null(m);
-					o = get_mode_all_one(m);
-					break;
+				z = 0;
+				o = mask;
+				break;
 
-				case iro_Const: {
-					z = o = get_Const_tarval(irn);
-					break;
-				}
+			case iro_Const:
+				z = o = tarval_to_bits(get_Const_tarval(irn));
+				break;
 
-				case iro_Confirm: {
-					ir_node *const v = get_Confirm_value(irn);
-					bitinfo *const b = get_bitinfo_recursive(v);
-					/* TODO Use bound and relation. */
-					z = b->z;
-					o = b->o;
-					if ((get_Confirm_relation(irn) & ~ir_relation_unordered) == ir_relation_equal) {
-						bitinfo *const bound_b = get_bitinfo_recursive(get_Confirm_bound(irn));
-						z = tarval_and(z, bound_b->z);
-						o = tarval_or( o, bound_b->o);
-					}
-					break;
+			case iro_Confirm: {
+				ir_node *const v = get_Confirm_value(irn);
+				bitinfo *const b = get_bitinfo_recursive(v);
+				/* TODO Use bound and relation. */
+				z = b->zb;
+				o = b->ob;
+				if ((get_Confirm_relation(irn) & ~ir_relation_unordered) == ir_relation_equal) {
+					bitinfo *const bound_b = get_bitinfo_recursive(get_Confirm_bound(irn));
+					z &= bound_b->zb;
+					o |= bound_b->ob;
 				}
+				break;
+			}
 
-				case iro_Shl: {
-					ir_node   *const right = get_Shl_right(irn);
-					bitinfo   *const l     = get_bitinfo_recursive(get_Shl_left(irn));
-					bitinfo   *const r     = get_bitinfo_recursive(right);
-					ir_tarval *const lo    = l->o;
-					ir_tarval *const lz    = l->z;
-					ir_tarval *const ro    = r->o;
-					ir_tarval *const rz    = r->z;
-					if (rz == ro) {
-						z = tarval_shl(lz, rz);
-						o = tarval_shl(lo, rz);
-					} else {
-						const long        size_bits     = get_mode_size_bits(m);
-						const long        modulo_shift  = get_mode_modulo_shift(m);
-						ir_mode    *const rmode         = get_irn_mode(right);
-						ir_tarval  *const rone          = get_mode_one(rmode);
-						ir_tarval  *const size_mask     = tarval_sub(new_tarval_from_long(size_bits, rmode), rone);
-						ir_tarval  *const modulo_mask   = tarval_sub(new_tarval_from_long(modulo_shift, rmode), rone);
-						ir_tarval  *const zero          = get_mode_null(m);
-						ir_tarval  *const all_one       = get_mode_all_one(m);
-						ir_tarval  *const oversize_mask = tarval_andnot(modulo_mask, size_mask);
-
-						z = zero;
-						o = tarval_is_null(tarval_and(rz, oversize_mask)) ? all_one : zero;
-
-						if (tarval_is_null(tarval_and(ro, oversize_mask))) {
-							ir_tarval *const rmask  = tarval_and(size_mask, modulo_mask);
-							ir_tarval *const rsure  = tarval_and(tarval_not(tarval_eor(ro, rz)), rmask);
-							ir_tarval *const rbound = tarval_add(rmask, rone);
-							ir_tarval *const rzero  = get_mode_null(rmode);
-							for (ir_tarval *shift_amount = rzero; shift_amount != rbound; shift_amount = tarval_add(shift_amount, rone)) {
-								if (tarval_is_null(tarval_and(rsure, tarval_eor(shift_amount, rz)))) {
-									z = tarval_or(z, tarval_shl(lz, shift_amount));
-									o = tarval_and(o, tarval_shl(lo, shift_amount));
-								}
+			case iro_Shl:
+			case iro_Shr:
+			case iro_Shrs: {
+				ir_node  *const right = get_binop_right(irn);
+				bitinfo  *const l     = get_bitinfo_recursive(get_binop_left(irn));
+				bitinfo  *const r     = get_bitinfo_recursive(right);
+				uint64_t  const lz    = l->zb;
+				uint64_t  const lo    = l->ob;
+				uint64_t  const rz    = r->zb;
+				uint64_t  const ro    = r->ob;
+				if (rz == ro) {
+					z = shift_bits(irn, lz, rz, m);
+					o = shift_bits(irn, lo, rz, m);
+				} else {
+					ir_mode  *const rmode         = get_irn_mode(right);
+					uint64_t  const rmode_mask    = mode_mask(rmode);
+					uint64_t  const size_mask     = ((uint64_t)get_mode_size_bits(m) - 1) & rmode_mask;
+					uint64_t  const modulo_mask   = ((uint64_t)get_mode_modulo_shift(m) - 1) & rmode_mask;
+					uint64_t  const oversize_mask = modulo_mask & ~size_mask;
+
+					z = 0;
+					o = (rz & oversize_mask) == 0 ? mask : 0;
+
+					if ((ro & oversize_mask) == 0) {
+						uint64_t const rmask = size_mask & modulo_mask;
+						uint64_t const rsure = ~(ro ^ rz) & rmask;
+						for (uint64_t shift_amount = 0; shift_amount <= rmask; ++shift_amount) {
+							if ((rsure & (shift_amount ^ rz)) == 0) {
+								z |= shift_bits(irn, lz, shift_amount, m);
+								o &= shift_bits(irn, lo, shift_amount, m);
 							}
 						}
-
-						/* Ensure that we do not create undefined bit information. */
-						assert(!tarval_is_null(z) || !tarval_is_all_one(o));
 					}
-					break;
+
+					/* Ensure that we do not create undefined bit information. */
+					assert(z != 0 || o != mask);
 				}
+				break;
+			}
 
-				case iro_Shr: {
-					ir_node   *const right = get_Shr_right(irn);
-					bitinfo   *const l     = get_bitinfo_recursive(get_Shr_left(irn));
-					bitinfo   *const r     = get_bitinfo_recursive(right);
-					ir_tarval *const lz    = l->z;
-					ir_tarval *const lo    = l->o;
-					ir_tarval *const rz    = r->z;
-					ir_tarval *const ro    = r->o;
-					if (rz == r->o) {
-						z = tarval_shr(lz, rz);
-						o = tarval_shr(lo, rz);
-					} else {
-						const long        size_bits     = get_mode_size_bits(m);
-						const long        modulo_shift  = get_mode_modulo_shift(m);
-						ir_mode    *const rmode         = get_irn_mode(right);
-						ir_tarval  *const rone          = get_mode_one(rmode);
-						ir_tarval  *const size_mask     = tarval_sub(new_tarval_from_long(size_bits, rmode), rone);
-						ir_tarval  *const modulo_mask   = tarval_sub(new_tarval_from_long(modulo_shift, rmode), rone);
-						ir_tarval  *const zero          = get_mode_null(m);
-						ir_tarval  *const all_one       = get_mode_all_one(m);
-						ir_tarval  *const oversize_mask = tarval_andnot(modulo_mask, size_mask);
-
-						z = zero;
-						o = tarval_is_null(tarval_and(rz, oversize_mask)) ? all_one : zero;
-
-						if (tarval_is_null(tarval_and(ro, oversize_mask))) {
-							ir_tarval *const rmask  = tarval_and(size_mask, modulo_mask);
-							ir_tarval *const rsure  = tarval_and(tarval_not(tarval_eor(ro, rz)), rmask);
-							ir_tarval *const rbound = tarval_add(rmask, rone);
-							ir_tarval *const rzero  = get_mode_null(rmode);
-							for (ir_tarval *shift_amount = rzero; shift_amount != rbound; shift_amount = tarval_add(shift_amount, rone)) {
-								if (tarval_is_null(tarval_and(rsure, tarval_eor(shift_amount, rz)))) {
-									z = tarval_or(z, tarval_shr(lz, shift_amount));
-									o = tarval_and(o, tarval_shr(lo, shift_amount));
-								}
+			case iro_Add: {
+				bitinfo  *const l   = get_bitinfo_recursive(get_Add_left(irn));
+				bitinfo  *const r   = get_bitinfo_recursive(get_Add_right(irn));
+				uint64_t  const lz  = l->zb;
+				uint64_t  const lo  = l->ob;
+				uint64_t  const rz  = r->zb;
+				uint64_t  const ro  = r->ob;
+				uint64_t  const vz  = (lz + rz) & mask;
+				uint64_t  const vo  = (lo + ro) & mask;
+				uint64_t  const nc  = (lz ^ lo) | (rz ^ ro) | (vz ^ vo);
+				z = vz | nc;
+				o = vz & ~nc;
+				break;
+			}
+
+			case iro_Sub: {
+				bitinfo *const l = get_bitinfo_recursive(get_Sub_left(irn));
+				bitinfo *const r = get_bitinfo_recursive(get_Sub_right(irn));
+				// might subtract pointers
+				if (l == NULL || r == NULL)
+					goto cannot_analyse;
+
+				uint64_t const lz = l->zb;
+				uint64_t const lo = l->ob;
+				uint64_t const rz = r->zb;
+				uint64_t const ro = r->ob;
+				uint64_t const vz = (lo - rz) & mask;
+				uint64_t const vo = (lz - ro) & mask;
+				uint64_t const nc = (lz ^ lo) | (rz ^ ro) | (vz ^ vo);
+				z = vz | nc;
+				o = vz & ~nc;
+				break;
+			}
+
+			case iro_Mul: {
+				bitinfo *const l  = get_bitinfo_recursive(get_Mul_left(irn));
+				bitinfo *const r  = get_bitinfo_recursive(get_Mul_right(irn));
+				uint64_t       lz = l->zb;
+				uint64_t       lo = l->ob;
+				uint64_t       rz = r->zb;
+				uint64_t       ro = r->ob;
+				if (lz == lo && rz == ro) {
+					z = o = (lz * rz) & mask;
+				} else {
+					z = o = 0;
+					while (rz != 0) {
+						if ((rz & 1) != 0) {
+							uint64_t const vz = (lz + z) & mask;
+							uint64_t const vo = (lo + o) & mask;
+							uint64_t const nc = (lz ^ lo) | (z ^ o) | (vz ^ vo);
+							uint64_t const az = vz | nc;
+							uint64_t const ao = vz & ~nc;
+
+							if ((ro & 1) != 0) {
+								z = az;
+								o = ao;
+							} else {
+								z |= az;
+								o &= ao;
 							}
 						}
-
-						/* Ensure that we do not create undefined bit information. */
-						assert(!tarval_is_null(z) || !tarval_is_all_one(o));
+						lz = (lz << 1) & mask;
+						lo = (lo << 1) & mask;
+						rz >>= 1;
+						ro >>= 1;
 					}
-					break;
 				}
+				break;
+			}
 
-				case iro_Shrs: {
-					ir_node   *const right = get_Shrs_right(irn);
-					bitinfo   *const l     = get_bitinfo_recursive(get_Shrs_left(irn));
-					bitinfo   *const r     = get_bitinfo_recursive(right);
-					ir_tarval *const lz    = l->z;
-					ir_tarval *const lo    = l->o;
-					ir_tarval *const rz    = r->z;
-					ir_tarval *const ro    = r->o;
-					if (rz == r->o) {
-						z = tarval_shrs(lz, rz);
-						o = tarval_shrs(lo, rz);
-					} else {
-						const long        size_bits     = get_mode_size_bits(m);
-						const long        modulo_shift  = get_mode_modulo_shift(m);
-						ir_mode    *const rmode         = get_irn_mode(right);
-						ir_tarval  *const rone          = get_mode_one(rmode);
-						ir_tarval  *const size_mask     = tarval_sub(new_tarval_from_long(size_bits, rmode), rone);
-						ir_tarval  *const modulo_mask   = tarval_sub(new_tarval_from_long(modulo_shift, rmode), rone);
-						ir_tarval  *const zero          = get_mode_null(m);
-						ir_tarval  *const all_one       = get_mode_all_one(m);
-						ir_tarval  *const oversize_mask = tarval_andnot(modulo_mask, size_mask);
-
-						z = zero;
-						o = tarval_is_null(tarval_and(rz, oversize_mask)) ? all_one : zero;
-
-						if (tarval_is_null(tarval_and(ro, oversize_mask))) {
-							ir_tarval *const rmask  = tarval_and(size_mask, modulo_mask);
-							ir_tarval *const rsure  = tarval_and(tarval_not(tarval_eor(ro, rz)), rmask);
-							ir_tarval *const rbound = tarval_add(rmask, rone);
-							ir_tarval *const rzero  = get_mode_null(rmode);
-							for (ir_tarval *shift_amount = rzero; shift_amount != rbound; shift_amount = tarval_add(shift_amount, rone)) {
-								if (tarval_is_null(tarval_and(rsure, tarval_eor(shift_amount, rz)))) {
-									z = tarval_or(z, tarval_shrs(lz, shift_amount));
-									o = tarval_and(o, tarval_shrs(lo, shift_amount));
-								}
-							}
+			case iro_Minus: {
+				/* -a = 0 - a */
+				bitinfo  *const b  = get_bitinfo_recursive(get_Minus_op(irn));
+				uint64_t  const bz = b->zb;
+				uint64_t  const bo = b->ob;
+				uint64_t  const vz = -bz & mask;
+				uint64_t  const vo = -bo & mask;
+				uint64_t  const nc = (bz ^ bo) | (vz ^ vo);
+				z = vz | nc;
+				o = vz & ~nc;
+				break;
+			}
+
+			case iro_And: {
+				bitinfo *const l = get_bitinfo_recursive(get_And_left(irn));
+				bitinfo *const r = get_bitinfo_recursive(get_And_right(irn));
+				z = l->zb & r->zb;
+				o = l->ob & r->ob;
+				break;
+			}
+
+			case iro_Or: {
+				bitinfo *const l = get_bitinfo_recursive(get_Or_left(irn));
+				bitinfo *const r = get_bitinfo_recursive(get_Or_right(irn));
+				z = l->zb | r->zb;
+				o = l->ob | r->ob;
+				break;
+			}
+
+			case iro_Eor: {
+				bitinfo  *const l  = get_bitinfo_recursive(get_Eor_left(irn));
+				bitinfo  *const r  = get_bitinfo_recursive(get_Eor_right(irn));
+				uint64_t  const lz = l->zb;
+				uint64_t  const lo = l->ob;
+				uint64_t  const rz = r->zb;
+				uint64_t  const ro = r->ob;
+				z = (lz & ~ro) | (rz & ~lo);
+				o = (ro & ~lz) | (lo & ~rz);
+				break;
+			}
+
+			case iro_Not: {
+				bitinfo *const b = get_bitinfo_recursive(get_Not_op(irn));
+				z = ~b->ob & mask;
+				o = ~b->zb & mask;
+				break;
+			}
+
+			case iro_Conv: {
+				ir_node *const op = get_Conv_op(irn);
+				bitinfo *const b  = get_bitinfo_recursive(op);
+				if (b == NULL) // Happens when converting from float values.
+					goto result_unknown;
+				ir_mode *const op_mode = get_irn_mode(op);
+				z = convert_bits(b->zb, op_mode, m);
+				o = convert_bits(b->ob, op_mode, m);
+				break;
+			}
+
+			case iro_Mux: {
+				bitinfo *const bf = get_bitinfo_recursive(get_Mux_false(irn));
+				bitinfo *const bt = get_bitinfo_recursive(get_Mux_true(irn));
+				bitinfo *const c  = get_bitinfo_recursive(get_Mux_sel(irn));
+				if (c->ob == 1) {
+					z = bt->zb;
+					o = bt->ob;
+				} else if (c->zb == 0) {
+					z = bf->zb;
+					o = bf->ob;
+				} else {
+					z = bf->zb | bt->zb;
+					o = bf->ob & bt->ob;
+				}
+				break;
+			}
+
+			case iro_Cmp: {
+				ir_node *const left = get_Cmp_left(irn);
+				bitinfo *const l    = get_bitinfo_recursive(left);
+				bitinfo *const r    = get_bitinfo_recursive(get_Cmp_right(irn));
+				if (l == NULL || r == NULL)
+					goto result_unknown; // Cmp compares something we cannot evaluate.
+				ir_mode    *const cmp_mode = get_irn_mode(left);
+				uint64_t    const lz       = l->zb;
+				uint64_t    const lo       = l->ob;
+				uint64_t    const rz       = r->zb;
+				uint64_t    const ro       = r->ob;
+				ir_relation const relation = get_Cmp_relation(irn);
+				switch (relation) {
+					case ir_relation_less_greater:
+						if ((ro & ~lz) != 0 || (lo & ~rz) != 0) {
+							// At least one bit differs.
+							z = o = 1;
+						} else if (lz == lo && rz == ro && lz == rz) {
+							z = o = 0;
+						} else {
+							goto result_unknown;
+						}
+						break;
+
+					case ir_relation_equal:
+						if ((ro & ~lz) != 0 || (lo & ~rz) != 0) {
+							// At least one bit differs.
+							z = o = 0;
+						} else if (lz == lo && rz == ro && lz == rz) {
+							z = o = 1;
+						} else {
+							goto result_unknown;
 						}
+						break;
+
+					case ir_relation_less_equal:
+					case ir_relation_less:
+						/* TODO handle negative values */
+						if (is_negative_bits(lz, cmp_mode) || is_negative_bits(lo, cmp_mode) ||
+						    is_negative_bits(rz, cmp_mode) || is_negative_bits(ro, cmp_mode))
+							goto result_unknown;
+
+						if (cmp_bits(lz, ro) & relation) {
+							/* Left upper bound is smaller(/equal) than right lower bound. */
+							z = o = 1;
+						} else if (!(cmp_bits(lo, rz) & relation)) {
+							/* Left lower bound is not smaller(/equal) than right upper bound. */
+							z = o = 0;
+						} else {
+							goto result_unknown;
+						}
+						break;
+
+					case ir_relation_greater_equal:
+					case ir_relation_greater:
+						/* TODO handle negative values */
+						if (is_negative_bits(lz, cmp_mode) || is_negative_bits(lo, cmp_mode) ||
+						    is_negative_bits(rz, cmp_mode) || is_negative_bits(ro, cmp_mode))
+							goto result_unknown;
+
+						if (!(cmp_bits(lz, ro) & relation)) {
+							/* Left upper bound is not greater(/equal) than right lower bound. */
+							z = o = 0;
+						} else if (cmp_bits(lo, rz) & relation) {
+							/* Left lower bound is greater(/equal) than right upper bound. */
+							z = o = 1;
+						} else {
+							goto result_unknown;
+						}
+						break;
 
-						/* Ensure that we do not create undefined bit information. */
-						assert(!tarval_is_null(z) || !tarval_is_all_one(o));
-					}
-					break;
+					default:
+						goto cannot_analyse;
 				}
+				break;
+			}
 
-				case iro_Add: {
-					bitinfo   *const l   = get_bitinfo_recursive(get_Add_left(irn));
-					bitinfo   *const r   = get_bitinfo_recursive(get_Add_right(irn));
-					ir_tarval *const lz  = l->z;
-					ir_tarval *const lo  = l->o;
-					ir_tarval *const rz  = r->z;
-					ir_tarval *const ro  = r->o;
-					ir_tarval *const vz  = tarval_add(lz, rz);
-					ir_tarval *const vo  = tarval_add(lo, ro);
-					ir_tarval *const lnc = tarval_eor(lz, lo);
-					ir_tarval *const rnc = tarval_eor(rz, ro);
-					ir_tarval *const vnc = tarval_eor(vz, vo);
-					ir_tarval *const nc  = tarval_or(tarval_or(lnc, rnc), vnc);
-					z = tarval_or(vz, nc);
-					o = tarval_andnot(vz, nc);
+			case iro_Proj: {
+				ir_node *const pred = get_Proj_pred(irn);
+				if (is_Tuple(pred)) {
+					unsigned       pn = get_Proj_num(irn);
+					ir_node *const op = get_Tuple_pred(pred, pn);
+					bitinfo *const b  = get_bitinfo_recursive(op);
+					z = b->zb;
+					o = b->ob;
 					break;
 				}
+				goto cannot_analyse;
+			}
 
-				case iro_Sub: {
-					bitinfo *const l = get_bitinfo_recursive(get_Sub_left(irn));
-					bitinfo *const r = get_bitinfo_recursive(get_Sub_right(irn));
-					// might subtract pointers
-					if (l == NULL || r == NULL)
-						goto cannot_analyse;
+			default: {
+cannot_analyse:
+				DB((dbg, LEVEL_4, "cannot analyse %+F\n", irn));
+result_unknown:
+				z = mask;
+				o = 0;
+				break;
+			}
+		}
+	}
 
-					ir_tarval *const lz  = l->z;
-					ir_tarval *const lo  = l->o;
-					ir_tarval *const rz  = r->z;
-					ir_tarval *const ro  = r->o;
-					ir_tarval *const vz  = tarval_sub(lo, rz);
-					ir_tarval *const vo  = tarval_sub(lz, ro);
-					ir_tarval *const lnc = tarval_eor(lz, lo);
-					ir_tarval *const rnc = tarval_eor(rz, ro);
-					ir_tarval *const vnc = tarval_eor(vz, vo);
-					ir_tarval *const nc  = tarval_or(tarval_or(lnc, rnc), vnc);
-					z = tarval_or(vz, nc);
-					o = tarval_andnot(vz, nc);
-					break;
+	bool changed = set_bitinfo_bits(irn, z, o);
+	DB((dbg, LEVEL_4, "finish transfer %+F\n", irn));
+	return changed;
+}
+
+/**
+ * Transfer function on tarvals.  It handles nodes, whose mode or operand modes
+ * are too wide for the native masks.
+ */
+static bool transfer_tarval(ir_node const *const irn)
+{
+	ir_tarval *const f = tarval_b_false;
+	ir_tarval *const t = tarval_b_true;
+	ir_mode   *const m = get_irn_mode(irn);
+	ir_tarval       *z;
+	ir_tarval       *o;
+
+	DB((dbg, LEVEL_3, "transfer %+F\n", irn));
+
+	if (is_Phi(irn)) {
+		ir_node *const block = get_nodes_block(irn);
+
+repeatphi:
+		z = get_mode_null(m);
+		o = get_mode_all_one(m);
+		foreach_irn_in(block, i, pred_block) {
+			bitinfo *const b_cfg = get_bitinfo_recursive(pred_block);
+			if (b_cfg->zb != 0) {
+				bitinfo *const b = get_bitinfo_tarval(get_Phi_pred(irn, i));
+				z = tarval_or( z, b->z);
+				o = tarval_and(o, b->o);
+			}
+		}
+		/* Computing bitinfo for operand 1 might render operand 0 unstable.
+		 * Thus, evaluate the operands until all of them are stable. */
+		foreach_irn_in(block, i, pred_block) {
+			bitinfo *const b_cfg = get_bitinfo_recursive(pred_block);
+			if (b_cfg->zb != 0) {
+				bitinfo *const b = get_bitinfo_direct(get_Phi_pred(irn, i));
+				if (b->state == BITINFO_UNSTABLE) {
+					goto repeatphi;
+				}
+			}
+		}
+	} else {
+		/* Undefined if any input is undefined. */
+		foreach_irn_in(irn, i, pred) {
+			bitinfo *const pred_b = get_bitinfo_tarval(pred);
+			if (pred_b != NULL && is_undefined(pred_b))
+				goto undefined;
+		}
+
+		switch (get_irn_opcode(irn)) {
+			case iro_Bad:
+undefined:
+				z = get_mode_null(m);
+				o = get_mode_all_one(m);
+				break;
+
+			case iro_Const: {
+				z = o = get_Const_tarval(irn);
+				break;
+			}
+
+			case iro_Confirm: {
+				ir_node *const v = get_Confirm_value(irn);
+				bitinfo *const b = get_bitinfo_tarval(v);
+				/* TODO Use bound and relation. */
+				z = b->z;
+				o = b->o;
+				if ((get_Confirm_relation(irn) & ~ir_relation_unordered) == ir_relation_equal) {
+					bitinfo *const bound_b = get_bitinfo_tarval(get_Confirm_bound(irn));
+					z = tarval_and(z, bound_b->z);
+					o = tarval_or( o, bound_b->o);
 				}
+				break;
+			}
 
-				case iro_Mul: {
-					bitinfo   *const l  = get_bitinfo_recursive(get_Mul_left(irn));
-					bitinfo   *const r  = get_bitinfo_recursive(get_Mul_right(irn));
-					ir_tarval *      lz = l->z;
-					ir_tarval *      lo = l->o;
-					ir_tarval *      rz = r->z;
-					ir_tarval *      ro = r->o;
-					if (lz == lo && rz == ro) {
-						z = o = tarval_mul(lz, rz);
-					} else {
-						ir_tarval *one = get_mode_one(m);
-						z = o = get_mode_null(m);
-						while (!tarval_is_null(rz)) {
-							if (!tarval_is_null(tarval_and(rz, one))) {
-								ir_tarval *const vz  = tarval_add(lz, z);
-								ir_tarval *const vo  = tarval_add(lo, o);
-								ir_tarval *const lnc = tarval_eor(lz, lo);
-								ir_tarval *const rnc = tarval_eor(z, o);
-								ir_tarval *const vnc = tarval_eor(vz, vo);
-								ir_tarval *const nc  = tarval_or(tarval_or(lnc, rnc), vnc);
-								ir_tarval *const az  = tarval_or(vz, nc);
-								ir_tarval *const ao  = tarval_andnot(vz, nc);
-
-								if (tarval_is_null(tarval_andnot(one, ro))) {
-									z = az;
-									o = ao;
-								} else {
-									z = tarval_or(z, az);
-									o = tarval_and(o, ao);
-								}
+			case iro_Shl: {
+				ir_node   *const right = get_Shl_right(irn);
+				bitinfo   *const l     = get_bitinfo_tarval(get_Shl_left(irn));
+				bitinfo   *const r     = get_bitinfo_tarval(right);
+				ir_tarval *const lo    = l->o;
+				ir_tarval *const lz    = l->z;
+				ir_tarval *const ro    = r->o;
+				ir_tarval *const rz    = r->z;
+				if (rz == ro) {
+					z = tarval_shl(lz, rz);
+					o = tarval_shl(lo, rz);
+				} else {
+					const long        size_bits     = get_mode_size_bits(m);
+					const long        modulo_shift  = get_mode_modulo_shift(m);
+					ir_mode    *const rmode         = get_irn_mode(right);
+					ir_tarval  *const rone          = get_mode_one(rmode);
+					ir_tarval  *const size_mask     = tarval_sub(new_tarval_from_long(size_bits, rmode), rone);
+					ir_tarval  *const modulo_mask   = tarval_sub(new_tarval_from_long(modulo_shift, rmode), rone);
+					ir_tarval  *const zero          = get_mode_null(m);
+					ir_tarval  *const all_one       = get_mode_all_one(m);
+					ir_tarval  *const oversize_mask = tarval_andnot(modulo_mask, size_mask);
+
+					z = zero;
+					o = tarval_is_null(tarval_and(rz, oversize_mask)) ? all_one : zero;
+
+					if (tarval_is_null(tarval_and(ro, oversize_mask))) {
+						ir_tarval *const rmask  = tarval_and(size_mask, modulo_mask);
+						ir_tarval *const rsure  = tarval_and(tarval_not(tarval_eor(ro, rz)), rmask);
+						ir_tarval *const rbound = tarval_add(rmask, rone);
+						ir_tarval *const rzero  = get_mode_null(rmode);
+						for (ir_tarval *shift_amount = rzero; shift_amount != rbound; shift_amount = tarval_add(shift_amount, rone)) {
+							if (tarval_is_null(tarval_and(rsure, tarval_eor(shift_amount, rz)))) {
+								z = tarval_or(z, tarval_shl(lz, shift_amount));
+								o = tarval_and(o, tarval_shl(lo, shift_amount));
 							}
-							lz = tarval_shl(lz, one);
-							lo = tarval_shl(lo, one);
-							rz = tarval_shr(rz, one);
-							ro = tarval_shr(ro, one);
 						}
 					}
-					break;
+
+					/* Ensure that we do not create undefined bit information. */
+					assert(!tarval_is_null(z) || !tarval_is_all_one(o));
 				}
+				break;
+			}
 
-				case iro_Minus: {
-					/* -a = 0 - a */
-					bitinfo   *const b   = get_bitinfo_recursive(get_Minus_op(irn));
-					ir_tarval *const bz  = b->z;
-					ir_tarval *const bo  = b->o;
-					ir_tarval *const vz  = tarval_neg(bz);
-					ir_tarval *const vo  = tarval_neg(bo);
-					ir_tarval *const bnc = tarval_eor(bz, bo);
-					ir_tarval *const vnc = tarval_eor(vz, vo);
-					ir_tarval *const nc  = tarval_or(bnc, vnc);
-					z = tarval_or(vz, nc);
-					o = tarval_andnot(vz, nc);
-					break;
+			case iro_Shr: {
+				ir_node   *const right = get_Shr_right(irn);
+				bitinfo   *const l     = get_bitinfo_tarval(get_Shr_left(irn));
+				bitinfo   *const r     = get_bitinfo_tarval(right);
+				ir_tarval *const lz    = l->z;
+				ir_tarval *const lo    = l->o;
+				ir_tarval *const rz    = r->z;
+				ir_tarval *const ro    = r->o;
+				if (rz == r->o) {
+					z = tarval_shr(lz, rz);
+					o = tarval_shr(lo, rz);
+				} else {
+					const long        size_bits     = get_mode_size_bits(m);
+					const long        modulo_shift  = get_mode_modulo_shift(m);
+					ir_mode    *const rmode         = get_irn_mode(right);
+					ir_tarval  *const rone          = get_mode_one(rmode);
+					ir_tarval  *const size_mask     = tarval_sub(new_tarval_from_long(size_bits, rmode), rone);
+					ir_tarval  *const modulo_mask   = tarval_sub(new_tarval_from_long(modulo_shift, rmode), rone);
+					ir_tarval  *const zero          = get_mode_null(m);
+					ir_tarval  *const all_one       = get_mode_all_one(m);
+					ir_tarval  *const oversize_mask = tarval_andnot(modulo_mask, size_mask);
+
+					z = zero;
+					o = tarval_is_null(tarval_and(rz, oversize_mask)) ? all_one : zero;
+
+					if (tarval_is_null(tarval_and(ro, oversize_mask))) {
+						ir_tarval *const rmask  = tarval_and(size_mask, modulo_mask);
+						ir_tarval *const rsure  = tarval_and(tarval_not(tarval_eor(ro, rz)), rmask);
+						ir_tarval *const rbound = tarval_add(rmask, rone);
+						ir_tarval *const rzero  = get_mode_null(rmode);
+						for (ir_tarval *shift_amount = rzero; shift_amount != rbound; shift_amount = tarval_add(shift_amount, rone)) {
+							if (tarval_is_null(tarval_and(rsure, tarval_eor(shift_amount, rz)))) {
+								z = tarval_or(z, tarval_shr(lz, shift_amount));
+								o = tarval_and(o, tarval_shr(lo, shift_amount));
+							}
+						}
+					}
 
+					/* Ensure that we do not create undefined bit information. */
+					assert(!tarval_is_null(z) || !tarval_is_all_one(o));
 				}
+				break;
+			}
 
-				case iro_And: {
-					bitinfo *const l = get_bitinfo_recursive(get_And_left(irn));
-					bitinfo *const r = get_bitinfo_recursive(get_And_right(irn));
-					z = tarval_and(l->z, r->z);
-					o = tarval_and(l->o, r->o);
-					break;
-				}
+			case iro_Shrs: {
+				ir_node   *const right = get_Shrs_right(irn);
+				bitinfo   *const l     = get_bitinfo_tarval(get_Shrs_left(irn));
+				bitinfo   *const r     = get_bitinfo_tarval(right);
+				ir_tarval *const lz    = l->z;
+				ir_tarval *const lo    = l->o;
+				ir_tarval *const rz    = r->z;
+				ir_tarval *const ro    = r->o;
+				if (rz == r->o) {
+					z = tarval_shrs(lz, rz);
+					o = tarval_shrs(lo, rz);
+				} else {
+					const long        size_bits     = get_mode_size_bits(m);
+					const long        modulo_shift  = get_mode_modulo_shift(m);
+					ir_mode    *const rmode         = get_irn_mode(right);
+					ir_tarval  *const rone          = get_mode_one(rmode);
+					ir_tarval  *const size_mask     = tarval_sub(new_tarval_from_long(size_bits, rmode), rone);
+					ir_tarval  *const modulo_mask   = tarval_sub(new_tarval_from_long(modulo_shift, rmode), rone);
+					ir_tarval  *const zero          = get_mode_null(m);
+					ir_tarval  *const all_one       = get_mode_all_one(m);
+					ir_tarval  *const oversize_mask = tarval_andnot(modulo_mask, size_mask);
+
+					z = zero;
+					o = tarval_is_null(tarval_and(rz, oversize_mask)) ? all_one : zero;
+
+					if (tarval_is_null(tarval_and(ro, oversize_mask))) {
+						ir_tarval *const rmask  = tarval_and(size_mask, modulo_mask);
+						ir_tarval *const rsure  = tarval_and(tarval_not(tarval_eor(ro, rz)), rmask);
+						ir_tarval *const rbound = tarval_add(rmask, rone);
+						ir_tarval *const rzero  = get_mode_null(rmode);
+						for (ir_tarval *shift_amount = rzero; shift_amount != rbound; shift_amount = tarval_add(shift_amount, rone)) {
+							if (tarval_is_null(tarval_and(rsure, tarval_eor(shift_amount, rz)))) {
+								z = tarval_or(z, tarval_shrs(lz, shift_amount));
+								o = tarval_and(o, tarval_shrs(lo, shift_amount));
+							}
+						}
+					}
 
-				case iro_Or: {
-					bitinfo *const l = get_bitinfo_recursive(get_Or_left(irn));
-					bitinfo *const r = get_bitinfo_recursive(get_Or_right(irn));
-					z = tarval_or(l->z, r->z);
-					o = tarval_or(l->o, r->o);
-					break;
+					/* Ensure that we do not create undefined bit information. */
+					assert(!tarval_is_null(z) || !tarval_is_all_one(o));
 				}
+				break;
+			}
 
-				case iro_Eor: {
-					bitinfo   *const l  = get_bitinfo_recursive(get_Eor_left(irn));
-					bitinfo   *const r  = get_bitinfo_recursive(get_Eor_right(irn));
-					ir_tarval *const lz = l->z;
-					ir_tarval *const lo = l->o;
-					ir_tarval *const rz = r->z;
-					ir_tarval *const ro = r->o;
-					z = tarval_or(tarval_andnot(lz, ro), tarval_andnot(rz, lo));
-					o = tarval_or(tarval_andnot(ro, lz), tarval_andnot(lo, rz));
-					break;
-				}
+			case iro_Add: {
+				bitinfo   *const l   = get_bitinfo_tarval(get_Add_left(irn));
+				bitinfo   *const r   = get_bitinfo_tarval(get_Add_right(irn));
+				ir_tarval *const lz  = l->z;
+				ir_tarval *const lo  = l->o;
+				ir_tarval *const rz  = r->z;
+				ir_tarval *const ro  = r->o;
+				ir_tarval *const vz  = tarval_add(lz, rz);
+				ir_tarval *const vo  = tarval_add(lo, ro);
+				ir_tarval *const lnc = tarval_eor(lz, lo);
+				ir_tarval *const rnc = tarval_eor(rz, ro);
+				ir_tarval *const vnc = tarval_eor(vz, vo);
+				ir_tarval *const nc  = tarval_or(tarval_or(lnc, rnc), vnc);
+				z = tarval_or(vz, nc);
+				o = tarval_andnot(vz, nc);
+				break;
+			}
 
-				case iro_Not: {
-					bitinfo *const b = get_bitinfo_recursive(get_Not_op(irn));
-					z = tarval_not(b->o);
-					o = tarval_not(b->z);
-					break;
-				}
+			case iro_Sub: {
+				bitinfo *const l = get_bitinfo_tarval(get_Sub_left(irn));
+				bitinfo *const r = get_bitinfo_tarval(get_Sub_right(irn));
+				// might subtract pointers
+				if (l == NULL || r == NULL)
+					goto cannot_analyse;
 
-				case iro_Conv: {
-					bitinfo *const b = get_bitinfo_recursive(get_Conv_op(irn));
-					if (b == NULL) // Happens when converting from float values.
-						goto result_unknown;
-					z = tarval_convert_to(b->z, m);
-					o = tarval_convert_to(b->o, m);
-					break;
-				}
+				ir_tarval *const lz  = l->z;
+				ir_tarval *const lo  = l->o;
+				ir_tarval *const rz  = r->z;
+				ir_tarval *const ro  = r->o;
+				ir_tarval *const vz  = tarval_sub(lo, rz);
+				ir_tarval *const vo  = tarval_sub(lz, ro);
+				ir_tarval *const lnc = tarval_eor(lz, lo);
+				ir_tarval *const rnc = tarval_eor(rz, ro);
+				ir_tarval *const vnc = tarval_eor(vz, vo);
+				ir_tarval *const nc  = tarval_or(tarval_or(lnc, rnc), vnc);
+				z = tarval_or(vz, nc);
+				o = tarval_andnot(vz, nc);
+				break;
+			}
 
-				case iro_Mux: {
-					bitinfo *const bf = get_bitinfo_recursive(get_Mux_false(irn));
-					bitinfo *const bt = get_bitinfo_recursive(get_Mux_true(irn));
-					bitinfo *const c  = get_bitinfo_recursive(get_Mux_sel(irn));
-					if (c->o == t) {
-						z = bt->z;
-						o = bt->o;
-					} else if (c->z == f) {
-						z = bf->z;
-						o = bf->o;
-					} else {
-						z = tarval_or( bf->z, bt->z);
-						o = tarval_and(bf->o, bt->o);
+			case iro_Mul: {
+				bitinfo   *const l  = get_bitinfo_tarval(get_Mul_left(irn));
+				bitinfo   *const r  = get_bitinfo_tarval(get_Mul_right(irn));
+				ir_tarval *      lz = l->z;
+				ir_tarval *      lo = l->o;
+				ir_tarval *      rz = r->z;
+				ir_tarval *      ro = r->o;
+				if (lz == lo && rz == ro) {
+					z = o = tarval_mul(lz, rz);
+				} else {
+					ir_tarval *one = get_mode_one(m);
+					z = o = get_mode_null(m);
+					while (!tarval_is_null(rz)) {
+						if (!tarval_is_null(tarval_and(rz, one))) {
+							ir_tarval *const vz  = tarval_add(lz, z);
+							ir_tarval *const vo  = tarval_add(lo, o);
+							ir_tarval *const lnc = tarval_eor(lz, lo);
+							ir_tarval *const rnc = tarval_eor(z, o);
+							ir_tarval *const vnc = tarval_eor(vz, vo);
+							ir_tarval *const nc  = tarval_or(tarval_or(lnc, rnc), vnc);
+							ir_tarval *const az  = tarval_or(vz, nc);
+							ir_tarval *const ao  = tarval_andnot(vz, nc);
+
+							if (tarval_is_null(tarval_andnot(one, ro))) {
+								z = az;
+								o = ao;
+							} else {
+								z = tarval_or(z, az);
+								o = tarval_and(o, ao);
+							}
+						}
+						lz = tarval_shl(lz, one);
+						lo = tarval_shl(lo, one);
+						rz = tarval_shr(rz, one);
+						ro = tarval_shr(ro, one);
 					}
-					break;
 				}
+				break;
+			}
 
-				case iro_Cmp: {
-					bitinfo *const l = get_bitinfo_recursive(get_Cmp_left(irn));
-					bitinfo *const r = get_bitinfo_recursive(get_Cmp_right(irn));
-					if (l == NULL || r == NULL)
-						goto result_unknown; // Cmp compares something we cannot evaluate.
-					ir_tarval  *const lz       = l->z;
-					ir_tarval  *const lo       = l->o;
-					ir_tarval  *const rz       = r->z;
-					ir_tarval  *const ro       = r->o;
-					ir_relation const relation = get_Cmp_relation(irn);
-					switch (relation) {
-						case ir_relation_less_greater:
-							if (!tarval_is_null(tarval_andnot(ro, lz)) ||
-							    !tarval_is_null(tarval_andnot(lo, rz))) {
-								// At least one bit differs.
-								z = o = t;
-							} else if (lz == lo && rz == ro && lz == rz) {
-								z = o = f;
-							} else {
-								goto result_unknown;
-							}
-							break;
-
-						case ir_relation_equal:
-							if (!tarval_is_null(tarval_andnot(ro, lz)) ||
-							    !tarval_is_null(tarval_andnot(lo, rz))) {
-								// At least one bit differs.
-								z = o = f;
-							} else if (lz == lo && rz == ro && lz == rz) {
-								z = o = t;
-							} else {
-								goto result_unknown;
-							}
-							break;
-
-						case ir_relation_less_equal:
-						case ir_relation_less:
-							/* TODO handle negative values */
-							if (tarval_is_negative(lz) || tarval_is_negative(lo) ||
-							    tarval_is_negative(rz) || tarval_is_negative(ro))
-								goto result_unknown;
-
-							if (tarval_cmp(lz, ro) & relation) {
-								/* Left upper bound is smaller(/equal) than right lower bound. */
-								z = o = t;
-							} else if (!(tarval_cmp(lo, rz) & relation)) {
-								/* Left lower bound is not smaller(/equal) than right upper bound. */
-								z = o = f;
-							} else {
-								goto result_unknown;
-							}
-							break;
-
-						case ir_relation_greater_equal:
-						case ir_relation_greater:
-							/* TODO handle negative values */
-							if (tarval_is_negative(lz) || tarval_is_negative(lo) ||
-							    tarval_is_negative(rz) || tarval_is_negative(ro))
-								goto result_unknown;
-
-							if (!(tarval_cmp(lz, ro) & relation)) {
-								/* Left upper bound is not greater(/equal) than right lower bound. */
-								z = o = f;
-							} else if (tarval_cmp(lo, rz) & relation) {
-								/* Left lower bound is greater(/equal) than right upper bound. */
-								z = o = t;
-							} else {
-								goto result_unknown;
-							}
-							break;
+			case iro_Minus: {
+				/* -a = 0 - a */
+				bitinfo   *const b   = get_bitinfo_tarval(get_Minus_op(irn));
+				ir_tarval *const bz  = b->z;
+				ir_tarval *const bo  = b->o;
+				ir_tarval *const vz  = tarval_neg(bz);
+				ir_tarval *const vo  = tarval_neg(bo);
+				ir_tarval *const bnc = tarval_eor(bz, bo);
+				ir_tarval *const vnc = tarval_eor(vz, vo);
+				ir_tarval *const nc  = tarval_or(bnc, vnc);
+				z = tarval_or(vz, nc);
+				o = tarval_andnot(vz, nc);
+				break;
 
-						default:
-							goto cannot_analyse;
-					}
-					break;
+			}
+
+			case iro_And: {
+				bitinfo *const l = get_bitinfo_tarval(get_And_left(irn));
+				bitinfo *const r = get_bitinfo_tarval(get_And_right(irn));
+				z = tarval_and(l->z, r->z);
+				o = tarval_and(l->o, r->o);
+				break;
+			}
+
+			case iro_Or: {
+				bitinfo *const l = get_bitinfo_tarval(get_Or_left(irn));
+				bitinfo *const r = get_bitinfo_tarval(get_Or_right(irn));
+				z = tarval_or(l->z, r->z);
+				o = tarval_or(l->o, r->o);
+				break;
+			}
+
+			case iro_Eor: {
+				bitinfo   *const l  = get_bitinfo_tarval(get_Eor_left(irn));
+				bitinfo   *const r  = get_bitinfo_tarval(get_Eor_right(irn));
+				ir_tarval *const lz = l->z;
+				ir_tarval *const lo = l->o;
+				ir_tarval *const rz = r->z;
+				ir_tarval *const ro = r->o;
+				z = tarval_or(tarval_andnot(lz, ro), tarval_andnot(rz, lo));
+				o = tarval_or(tarval_andnot(ro, lz), tarval_andnot(lo, rz));
+				break;
+			}
+
+			case iro_Not: {
+				bitinfo *const b = get_bitinfo_tarval(get_Not_op(irn));
+				z = tarval_not(b->o);
+				o = tarval_not(b->z);
+				break;
+			}
+
+			case iro_Conv: {
+				bitinfo *const b = get_bitinfo_tarval(get_Conv_op(irn));
+				if (b == NULL) // Happens when converting from float values.
+					goto result_unknown;
+				z = tarval_convert_to(b->z, m);
+				o = tarval_convert_to(b->o, m);
+				break;
+			}
+
+			case iro_Mux: {
+				bitinfo *const bf = get_bitinfo_tarval(get_Mux_false(irn));
+				bitinfo *const bt = get_bitinfo_tarval(get_Mux_true(irn));
+				bitinfo *const c  = get_bitinfo_tarval(get_Mux_sel(irn));
+				if (c->o == t) {
+					z = bt->z;
+					o = bt->o;
+				} else if (c->z == f) {
+					z = bf->z;
+					o = bf->o;
+				} else {
+					z = tarval_or( bf->z, bt->z);
+					o = tarval_and(bf->o, bt->o);
 				}
+				break;
+			}
 
-				case iro_Proj: {
-					ir_node *const pred = get_Proj_pred(irn);
-					if (is_Tuple(pred)) {
-						unsigned       pn = get_Proj_num(irn);
-						ir_node *const op = get_Tuple_pred(pred, pn);
-						bitinfo *const b  = get_bitinfo_recursive(op);
-						z = b->z;
-						o = b->o;
-						goto set_info;
-					}
-					goto cannot_analyse;
+			case iro_Cmp: {
+				bitinfo *const l = get_bitinfo_tarval(get_Cmp_left(irn));
+				bitinfo *const r = get_bitinfo_tarval(get_Cmp_right(irn));
+				if (l == NULL || r == NULL)
+					goto result_unknown; // Cmp compares something we cannot evaluate.
+				ir_tarval  *const lz       = l->z;
+				ir_tarval  *const lo       = l->o;
+				ir_tarval  *const rz       = r->z;
+				ir_tarval  *const ro       = r->o;
+				ir_relation const relation = get_Cmp_relation(irn);
+				switch (relation) {
+					case ir_relation_less_greater:
+						if (!tarval_is_null(tarval_andnot(ro, lz)) ||
+						    !tarval_is_null(tarval_andnot(lo, rz))) {
+							// At least one bit differs.
+							z = o = t;
+						} else if (lz == lo && rz == ro && lz == rz) {
+							z = o = f;
+						} else {
+							goto result_unknown;
+						}
+						break;
+
+					case ir_relation_equal:
+						if (!tarval_is_null(tarval_andnot(ro, lz)) ||
+						    !tarval_is_null(tarval_andnot(lo, rz))) {
+							// At least one bit differs.
+							z = o = f;
+						} else if (lz == lo && rz == ro && lz == rz) {
+							z = o = t;
+						} else {
+							goto result_unknown;
+						}
+						break;
+
+					case ir_relation_less_equal:
+					case ir_relation_less:
+						/* TODO handle negative values */
+						if (tarval_is_negative(lz) || tarval_is_negative(lo) ||
+						    tarval_is_negative(rz) || tarval_is_negative(ro))
+							goto result_unknown;
+
+						if (tarval_cmp(lz, ro) & relation) {
+							/* Left upper bound is smaller(/equal) than right lower bound. */
+							z = o = t;
+						} else if (!(tarval_cmp(lo, rz) & relation)) {
+							/* Left lower bound is not smaller(/equal) than right upper bound. */
+							z = o = f;
+						} else {
+							goto result_unknown;
+						}
+						break;
+
+					case ir_relation_greater_equal:
+					case ir_relation_greater:
+						/* TODO handle negative values */
+						if (tarval_is_negative(lz) || tarval_is_negative(lo) ||
+						    tarval_is_negative(rz) || tarval_is_negative(ro))
+							goto result_unknown;
+
+						if (!(tarval_cmp(lz, ro) & relation)) {
+							/* Left upper bound is not greater(/equal) than right lower bound. */
+							z = o = f;
+						} else if (tarval_cmp(lo, rz) & relation) {
+							/* Left lower bound is greater(/equal) than right upper bound. */
+							z = o = t;
+						} else {
+							goto result_unknown;
+						}
+						break;
+
+					default:
+						goto cannot_analyse;
 				}
+				break;
+			}
 
-				default: {
+			case iro_Proj: {
+				ir_node *const pred = get_Proj_pred(irn);
+				if (is_Tuple(pred)) {
+					unsigned       pn = get_Proj_num(irn);
+					ir_node *const op = get_Tuple_pred(pred, pn);
+					bitinfo *const b  = get_bitinfo_tarval(op);
+					z = b->z;
+					o = b->o;
+					goto set_info;
+				}
+				goto cannot_analyse;
+			}
+
+			default: {
 cannot_analyse:
-					DB((dbg, LEVEL_4, "cannot analyse %+F\n", irn));
+				DB((dbg, LEVEL_4, "cannot analyse %+F\n", irn));
 result_unknown:
-					z = get_mode_all_one(m);
-					o = get_mode_null(m);
-					break;
-				}
+				z = get_mode_all_one(m);
+				o = get_mode_null(m);
+				break;
 			}
-		}
-	} else {
-		return false;
-	}
+		}	}
 
 set_info:;
 	bool changed = set_bitinfo(irn, z, o);
@@ -760,7 +1268,33 @@ set_info:;
 	return changed;
 }
 
-static void trigger_users(ir_node const *irn);
+/** Check whether the tarval transfer function must be used for @p irn. */
+static bool needs_tarval(ir_node const *const irn, ir_mode const *const mode)
+{
+	if (!is_native_mode(mode))
+		return true;
+
+	ir_node const *op;
+	switch (get_irn_opcode(irn)) {
+	case iro_Conv: op = get_Conv_op(irn);      break;
+	case iro_Cmp:  op = get_Cmp_left(irn);     break;
+	case iro_Shl:
+	case iro_Shr:
+	case iro_Shrs: op = get_binop_right(irn);  break;
+	default:       return false;
+	}
+	return !is_native_mode(get_irn_mode(op));
+}
+
+static bool transfer(ir_node const *const irn)
+{
+	ir_mode *const mode = get_bitinfo_mode(irn);
+	if (!mode)
+		return false;
+	if (needs_tarval(irn, mode))
+		return transfer_tarval(irn);
+	return transfer_bits(irn, mode);
+}
 
 static void trigger(ir_node const *const irn, ir_node const *const operand)
 {
@@ -770,13 +1304,13 @@ static void trigger(ir_node const *const irn, ir_node const *const operand)
 	if (b && b->state == BITINFO_VALID) {
 		DB((dbg, LEVEL_5, "%+F triggers %+F\n", operand, irn));
 		b->state = BITINFO_UNSTABLE;
-		trigger_users(irn);
+		ARR_APP1(ir_node const*, trigger_worklist, irn);
 	} else {
 		DB((dbg, LEVEL_5, "%+F does not trigger %+F\n", operand, irn));
 	}
 }
 
-static void trigger_users(ir_node const *const irn)
+static void trigger_users_of(ir_node const *const irn)
 {
 	if (is_Bad(irn))
 		return;
@@ -814,7 +1348,7 @@ static void trigger_users(ir_node const *const irn)
 			if (get_irn_mode(src) == mode_T) {
 				/* Trigger Projs of tuple nodes.  They might contain analysis information,
 				 * but the tuple node does not. */
-				trigger_users(src);
+				ARR_APP1(ir_node const*, trigger_worklist, src);
 			} else {
 				trigger(src, irn);
 			}
@@ -822,6 +1356,24 @@ static void trigger_users(ir_node const *const irn)
 	}
 }
 
+/**
+ * Mark all nodes, which transitively depend on @p irn, as unstable.
+ *
+ * The transitive users are collected in a worklist instead of recursing, so
+ * long dependency chains do not exhaust the stack.
+ */
+static void trigger_users(ir_node const *const irn)
+{
+	assert(ARR_LEN(trigger_worklist) == 0);
+	trigger_users_of(irn);
+	while (ARR_LEN(trigger_worklist) != 0) {
+		size_t         const last = ARR_LEN(trigger_worklist) - 1;
+		ir_node const *const n    = trigger_worklist[last];
+		ARR_SHRINKLEN(trigger_worklist, last);
+		trigger_users_of(n);
+	}
+}
+
 static void calc_bitinfo(ir_node const *const irn, bitinfo *const b)
 {
 	do {
@@ -879,9 +1431,21 @@ void constbits_analyze(ir_graph *const irg)
 
 	obstack_init(&irg->bitinfo.obst);
 	ir_nodemap_init(&irg->bitinfo.map, irg);
+	trigger_worklist = NEW_ARR_F(ir_node const*, 0);
 	get_bitinfo_func = &get_bitinfo_recursive;
 	irg_walk_graph(irg, NULL, calc_bitinfo_walker, NULL);
 	get_bitinfo_func = &get_bitinfo_direct;
+	DEL_ARR_F(trigger_worklist);
+	trigger_worklist = NULL;
+
+	/* Users of the analysis see tarvals, so convert the native masks once the
+	 * fixpoint is reached. */
+	ir_nodemap const *const map = &irg->bitinfo.map;
+	for (size_t i = 0, n = ARR_LEN(map->data); i != n; ++i) {
+		bitinfo *const b = (bitinfo*)map->data[i];
+		if (b)
+			materialize_bitinfo(b);
+	}
 
 #if VERIFY_CONSTBITS
 	verify_constbits(irg);
@@ -2,6 +2,7 @@
 #define CONSTBITS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "tv.h"
 
 typedef enum bitinfo_state {
@@ -15,6 +16,9 @@ typedef struct bitinfo
 {
 	ir_tarval    *z; /**< safe zeroes, 0 = bit is zero,       1 = bit maybe is 1 */
 	ir_tarval    *o; /**< safe ones,   0 = bit maybe is zero, 1 = bit is 1 */
+	ir_mode      *mode; /**< mode of the lattice, mode_b for control flow */
+	uint64_t      zb;   /**< z as native mask during the analysis, modes up to 64 bits */
+	uint64_t      ob;   /**< o as native mask during the analysis, modes up to 64 bits */
 	bitinfo_state state;
 } bitinfo;
 
@@ -14,6 +14,7 @@
 #include "ircons.h"
 #include "irgraph_t.h"
 #include "irgwalk.h"
+#include "irmemstat_t.h"
 #include "irnode_t.h"
 #include "irprog_t.h"
 #include "xmalloc.h"
@@ -286,7 +287,7 @@ static void set_out_edges_node(ir_node *node, struct obstack *obst)
 static void set_out_edges(ir_graph *irg)
 {
 	struct obstack *obst = &irg->out_obst;
-	obstack_init(obst);
+	ir_mem_obstack_init(obst, ir_mem_outs);
 	irg->out_obst_allocated = true;
 
 	inc_irg_visited(irg);
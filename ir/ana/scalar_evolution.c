@@ -0,0 +1,433 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Scalar evolution: add-recurrences and loop trip counts
+ *
+ * Recognizes induction variables of the form {init, +, step}, i.e. header
+ * Phis whose back edge value is the Phi plus a loop invariant, and computes
+ * the trip count of loops whose exit test compares such a variable with a
+ * loop invariant limit.
+ */
+#include "scalar_evolution.h"
+
+#include "debug.h"
+#include "ircons.h"
+#include "irgraph_t.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "irouts_t.h"
+#include "tv.h"
+#include <assert.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+bool scev_block_in_loop(ir_node const *const block, ir_loop const *const loop)
+{
+	for (ir_loop const *l = get_irn_loop(block); l != NULL;) {
+		if (l == loop)
+			return true;
+		ir_loop const *const outer = get_loop_outer_loop(l);
+		if (outer == l)
+			break;
+		l = outer;
+	}
+	return false;
+}
+
+bool scev_is_loop_invariant(ir_node const *const node,
+                            ir_loop const *const loop)
+{
+	return !scev_block_in_loop(get_nodes_block(node), loop);
+}
+
+ir_node *scev_get_loop_header(ir_loop const *const loop)
+{
+	ir_node     *header     = NULL;
+	size_t const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind != k_ir_node)
+			continue;
+
+		ir_node *const block = element.node;
+		assert(is_Block(block));
+		for (int p = get_Block_n_cfgpreds(block); p-- > 0;) {
+			ir_node *const pred = get_Block_cfgpred_block(block, p);
+			if (pred == NULL || is_Bad(pred) || scev_block_in_loop(pred, loop))
+				continue;
+			if (header != NULL && header != block)
+				return NULL;
+			header = block;
+		}
+	}
+	return header;
+}
+
+/**
+ * Skips Phis with a single input, as created by LCSSA construction.
+ */
+static ir_node *skip_trivial_phis(ir_node *node)
+{
+	while (is_Phi(node) && get_Phi_n_preds(node) == 1)
+		node = get_Phi_pred(node, 0);
+	return node;
+}
+
+bool scev_analyze_phi(ir_node *const phi, ir_loop const *const loop,
+                      scev_addrec_t *const rec)
+{
+	if (!is_Phi(phi))
+		return false;
+	ir_mode *const mode = get_irn_mode(phi);
+	if (!mode_is_int(mode) && !mode_is_reference(mode))
+		return false;
+
+	ir_node *const block = get_nodes_block(phi);
+	ir_node       *init  = NULL;
+	ir_node       *next  = NULL;
+	for (int i = 0, n = get_Phi_n_preds(phi); i < n; ++i) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, i);
+		if (pred_block == NULL || is_Bad(pred_block))
+			return false;
+
+		ir_node *const pred = get_Phi_pred(phi, i);
+		if (scev_block_in_loop(pred_block, loop)) {
+			if (next != NULL && next != pred)
+				return false;
+			next = pred;
+		} else {
+			if (init != NULL && init != pred)
+				return false;
+			init = pred;
+		}
+	}
+	if (init == NULL || next == NULL || !scev_is_loop_invariant(init, loop))
+		return false;
+
+	ir_node *const value  = skip_trivial_phis(next);
+	ir_node       *step   = NULL;
+	bool           negate = false;
+	if (is_Add(value)) {
+		ir_node *const left  = get_Add_left(value);
+		ir_node *const right = get_Add_right(value);
+		if (skip_trivial_phis(left) == phi) {
+			step = right;
+		} else if (skip_trivial_phis(right) == phi) {
+			step = left;
+		}
+	} else if (is_Sub(value)) {
+		if (skip_trivial_phis(get_Sub_left(value)) == phi) {
+			step   = get_Sub_right(value);
+			negate = true;
+		}
+	}
+	if (step == NULL || !scev_is_loop_invariant(step, loop))
+		return false;
+
+	rec->phi    = phi;
+	rec->init   = init;
+	rec->step   = step;
+	rec->negate = negate;
+	rec->next   = next;
+	return true;
+}
+
+/**
+ * Returns whether the first value of the induction variable of @p tc failing
+ * the exit test is representable, i.e. whether the induction variable cannot
+ * wrap around before the loop is left.
+ */
+static bool exit_value_representable(scev_trip_count_t const *const tc)
+{
+	ir_mode   *const mode     = get_tarval_mode(tc->step);
+	bool       const strict   = !(tc->relation & ir_relation_equal);
+	bool       const inc      = tc->relation & ir_relation_less;
+	ir_tarval *const abs_step = inc ? tc->step : tarval_neg(tc->step);
+	if (tarval_is_negative(abs_step))
+		return false;
+
+	/* A strict test with step 1 is left at the limit itself. */
+	ir_tarval *const slack = strict ? tarval_sub(abs_step, get_mode_one(mode))
+	                                : abs_step;
+	if (tarval_is_null(slack))
+		return true;
+	if (!is_Const(tc->limit))
+		return false;
+
+	ir_tarval *const tv_limit = get_Const_tarval(tc->limit);
+	if (inc) {
+		ir_tarval *const bound = tarval_sub(get_mode_max(mode), slack);
+		return tarval_cmp(tv_limit, bound) != ir_relation_greater;
+	} else {
+		ir_tarval *const bound = tarval_add(get_mode_min(mode), slack);
+		return tarval_cmp(tv_limit, bound) != ir_relation_less;
+	}
+}
+
+/**
+ * Returns whether @p node is the induction variable of the exit test of
+ * @p loop and cannot wrap around before the loop is left.
+ */
+static bool iv_cannot_wrap(ir_node *const node, ir_loop const *const loop)
+{
+	scev_trip_count_t tc;
+	return scev_get_trip_count(loop, &tc)
+	    && tc.iv.phi == skip_trivial_phis(node)
+	    && exit_value_representable(&tc);
+}
+
+bool scev_get_stride(ir_node *const node, ir_loop const *const loop,
+                     ir_mode *const mode, ir_tarval **const stride)
+{
+	if (scev_is_loop_invariant(node, loop)) {
+		*stride = get_mode_null(mode);
+		return true;
+	}
+
+	ir_tarval *l;
+	ir_tarval *r;
+	switch (get_irn_opcode(node)) {
+	case iro_Phi: {
+		if (get_Phi_n_preds(node) == 1)
+			return scev_get_stride(get_Phi_pred(node, 0), loop, mode, stride);
+		scev_addrec_t rec;
+		if (!scev_analyze_phi(node, loop, &rec) || !is_Const(rec.step))
+			return false;
+		ir_tarval *const step = tarval_convert_to(get_Const_tarval(rec.step), mode);
+		*stride = rec.negate ? tarval_neg(step) : step;
+		return true;
+	}
+
+	case iro_Add:
+		if (!scev_get_stride(get_Add_left(node), loop, mode, &l)
+		 || !scev_get_stride(get_Add_right(node), loop, mode, &r))
+			return false;
+		*stride = tarval_add(l, r);
+		return true;
+
+	case iro_Sub:
+		if (!scev_get_stride(get_Sub_left(node), loop, mode, &l)
+		 || !scev_get_stride(get_Sub_right(node), loop, mode, &r))
+			return false;
+		*stride = tarval_sub(l, r);
+		return true;
+
+	case iro_Mul: {
+		ir_node *left  = get_Mul_left(node);
+		ir_node *right = get_Mul_right(node);
+		if (is_Const(left)) {
+			ir_node *const t = left;
+			left  = right;
+			right = t;
+		}
+		if (!is_Const(right) || !scev_get_stride(left, loop, mode, &l))
+			return false;
+		*stride = tarval_mul(l, tarval_convert_to(get_Const_tarval(right), mode));
+		return true;
+	}
+
+	case iro_Shl: {
+		ir_node *const right = get_Shl_right(node);
+		if (!is_Const(right) || !scev_get_stride(get_Shl_left(node), loop, mode, &l))
+			return false;
+		*stride = tarval_shl(l, get_Const_tarval(right));
+		return true;
+	}
+
+	case iro_Conv: {
+		/* Only widening conversions preserve the stride, and only if the
+		 * narrow value does not wrap around while the loop runs. */
+		ir_node *const op      = get_Conv_op(node);
+		ir_mode *const op_mode = get_irn_mode(op);
+		if (!mode_is_int(op_mode)
+		 || get_mode_size_bits(op_mode) > get_mode_size_bits(get_irn_mode(node)))
+			return false;
+		if (get_mode_size_bits(op_mode) < get_mode_size_bits(mode)
+		 && !iv_cannot_wrap(op, loop))
+			return false;
+		return scev_get_stride(op, loop, mode, stride);
+	}
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * Returns the Cond ending @p block or NULL.
+ */
+static ir_node *find_cond(ir_node *const block)
+{
+	for (unsigned i = 0, n = get_irn_n_outs(block); i < n; ++i) {
+		ir_node *const node = get_irn_out(block, i);
+		if (is_Cond(node) && get_nodes_block(node) == block)
+			return node;
+	}
+	return NULL;
+}
+
+/**
+ * Returns the block the control flow Proj @p proj jumps to or NULL.
+ */
+static ir_node *get_proj_target(ir_node *const proj)
+{
+	if (get_irn_n_outs(proj) != 1)
+		return NULL;
+	ir_node *const target = get_irn_out(proj, 0);
+	return is_Block(target) ? target : NULL;
+}
+
+/**
+ * Computes the constant trip count of @p tc if its initial value and limit
+ * are constant and the induction variable cannot wrap around before the
+ * loop is left.  Returns NULL otherwise.
+ */
+static ir_tarval *compute_constant_count(scev_trip_count_t const *const tc)
+{
+	ir_node *const init  = tc->iv.init;
+	ir_node *const limit = tc->limit;
+	if (!is_Const(init) || !is_Const(limit))
+		return NULL;
+
+	ir_tarval  *const tv_init  = get_Const_tarval(init);
+	ir_tarval  *const tv_limit = get_Const_tarval(limit);
+	ir_mode    *const mode     = get_tarval_mode(tv_init);
+	ir_mode    *const umode    = find_unsigned_mode(mode);
+	bool        const strict   = !(tc->relation & ir_relation_equal);
+	bool        const inc      = tc->relation & ir_relation_less;
+	ir_tarval  *const abs_step = inc ? tc->step : tarval_neg(tc->step);
+
+	if (!(tarval_cmp(tv_init, tv_limit) & tc->relation))
+		return get_mode_null(umode);
+	if (!exit_value_representable(tc))
+		return NULL;
+
+	ir_tarval *const u_init  = tarval_convert_to(tv_init, umode);
+	ir_tarval *const u_limit = tarval_convert_to(tv_limit, umode);
+	ir_tarval *const u_step  = tarval_convert_to(abs_step, umode);
+	ir_tarval *const u_one   = get_mode_one(umode);
+	ir_tarval       *diff    = inc ? tarval_sub(u_limit, u_init)
+	                               : tarval_sub(u_init, u_limit);
+	if (strict)
+		diff = tarval_sub(diff, u_one);
+	return tarval_add(tarval_div(diff, u_step), u_one);
+}
+
+bool scev_get_trip_count(ir_loop const *const loop,
+                         scev_trip_count_t *const tc)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.ana.scev");
+
+	ir_node *const header = scev_get_loop_header(loop);
+	if (header == NULL)
+		return false;
+	ir_node *const cond = find_cond(header);
+	if (cond == NULL)
+		return false;
+	ir_node *const cmp = get_Cond_selector(cond);
+	if (!is_Cmp(cmp))
+		return false;
+
+	ir_node *stay = NULL;
+	ir_node *exit = NULL;
+	for (unsigned i = 0, n = get_irn_n_outs(cond); i < n; ++i) {
+		ir_node *const proj   = get_irn_out(cond, i);
+		ir_node *const target = get_proj_target(proj);
+		if (target == NULL)
+			return false;
+		if (scev_block_in_loop(target, loop)) {
+			stay = proj;
+		} else {
+			exit = proj;
+		}
+	}
+	if (stay == NULL || exit == NULL)
+		return false;
+
+	ir_relation relation = get_Cmp_relation(cmp);
+	if (get_Proj_num(stay) == pn_Cond_false)
+		relation = get_negated_relation(relation);
+	relation &= ir_relation_less_equal_greater;
+
+	ir_node *const left  = get_Cmp_left(cmp);
+	ir_node *const right = get_Cmp_right(cmp);
+	ir_node       *limit;
+	if (get_nodes_block(left) == header
+	    && scev_analyze_phi(left, loop, &tc->iv)) {
+		limit = right;
+	} else if (get_nodes_block(right) == header
+	           && scev_analyze_phi(right, loop, &tc->iv)) {
+		limit    = left;
+		relation = get_inversed_relation(relation);
+	} else {
+		return false;
+	}
+	if (!mode_is_int(get_irn_mode(limit)) || !scev_is_loop_invariant(limit, loop))
+		return false;
+
+	ir_node *const step = tc->iv.step;
+	if (!is_Const(step))
+		return false;
+	ir_tarval *tv_step = get_Const_tarval(step);
+	if (tc->iv.negate)
+		tv_step = tarval_neg(tv_step);
+	if (tarval_is_null(tv_step))
+		return false;
+
+	/* The induction variable must move towards the limit. */
+	if (tarval_is_negative(tv_step)) {
+		if (relation != ir_relation_greater
+		    && relation != ir_relation_greater_equal)
+			return false;
+	} else if (relation != ir_relation_less
+	           && relation != ir_relation_less_equal) {
+		return false;
+	}
+
+	tc->header   = header;
+	tc->cmp      = cmp;
+	tc->stay     = stay;
+	tc->exit     = exit;
+	tc->limit    = limit;
+	tc->relation = relation;
+	tc->step     = tv_step;
+	tc->count    = compute_constant_count(tc);
+	DB((dbg, LEVEL_2, "%+F: iv %+F = {%+F, +, %T} %s %+F, trip count %T\n",
+	    loop, tc->iv.phi, tc->iv.init, tv_step,
+	    get_relation_string(relation), limit, tc->count));
+	return true;
+}
+
+ir_node *scev_build_trip_count(scev_trip_count_t const *const tc,
+                               ir_node *const block)
+{
+	ir_graph *const irg    = get_irn_irg(block);
+	ir_node  *const init   = tc->iv.init;
+	ir_node  *const limit  = tc->limit;
+	ir_mode  *const mode   = get_irn_mode(init);
+	ir_mode  *const umode  = find_unsigned_mode(mode);
+	bool      const strict = !(tc->relation & ir_relation_equal);
+	bool      const inc    = tc->relation & ir_relation_less;
+
+	ir_node *const u_init  = mode == umode ? init : new_r_Conv(block, init, umode);
+	ir_node *const u_limit = mode == umode ? limit : new_r_Conv(block, limit, umode);
+	ir_node *const one     = new_r_Const(irg, get_mode_one(umode));
+	ir_node       *diff    = inc ? new_r_Sub(block, u_limit, u_init)
+	                             : new_r_Sub(block, u_init, u_limit);
+	if (strict)
+		diff = new_r_Sub(block, diff, one);
+
+	ir_tarval *const abs_step = inc ? tc->step : tarval_neg(tc->step);
+	ir_tarval *const u_step   = tarval_convert_to(abs_step, umode);
+	if (!tarval_is_one(u_step)) {
+		ir_node *const nomem = get_irg_no_mem(irg);
+		ir_node *const c     = new_r_Const(irg, u_step);
+		ir_node *const div   = new_r_Div(block, nomem, diff, c, false);
+		diff = new_r_Proj(div, umode, pn_Div_res);
+	}
+	return new_r_Add(block, diff, one);
+}
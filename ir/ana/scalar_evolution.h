@@ -0,0 +1,106 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Scalar evolution: add-recurrences and loop trip counts
+ */
+#ifndef FIRM_ANA_SCALAR_EVOLUTION_H
+#define FIRM_ANA_SCALAR_EVOLUTION_H
+
+#include <stdbool.h>
+#include "firm_types.h"
+
+/**
+ * An add-recurrence {init, +, step} of a loop: the value is @c init on loop
+ * entry and is incremented by @c step on every back edge.
+ */
+typedef struct scev_addrec_t {
+	ir_node *phi;    /**< the Phi in the loop header */
+	ir_node *init;   /**< loop invariant value on loop entry */
+	ir_node *step;   /**< loop invariant increment */
+	bool     negate; /**< step is subtracted instead of added */
+	ir_node *next;   /**< the value on the back edges */
+} scev_addrec_t;
+
+/**
+ * The trip count of a loop which is left by comparing an add-recurrence
+ * against a loop invariant limit in its header.
+ */
+typedef struct scev_trip_count_t {
+	scev_addrec_t iv;
+	ir_node      *header;   /**< the loop header */
+	ir_node      *cmp;      /**< the exit compare in the header */
+	ir_node      *stay;     /**< Cond Proj staying in the loop */
+	ir_node      *exit;     /**< Cond Proj leaving the loop */
+	ir_node      *limit;    /**< loop invariant limit */
+	ir_relation   relation; /**< iv relation limit keeps the loop running */
+	ir_tarval    *step;     /**< constant step, negative if decreasing */
+	ir_tarval    *count;    /**< constant number of iterations or NULL */
+} scev_trip_count_t;
+
+/**
+ * Returns the header of @p loop, the only block with a predecessor outside
+ * of the loop, or NULL if there is none or more than one.
+ */
+ir_node *scev_get_loop_header(ir_loop const *loop);
+
+/**
+ * Returns whether @p block is in @p loop or one of its inner loops.
+ */
+bool scev_block_in_loop(ir_node const *block, ir_loop const *loop);
+
+/**
+ * Returns whether the value of @p node is the same in all iterations of
+ * @p loop, that is whether it is defined outside of the loop.
+ */
+bool scev_is_loop_invariant(ir_node const *node, ir_loop const *loop);
+
+/**
+ * Describes the header Phi @p phi of @p loop as an add-recurrence.  Integer
+ * and reference Phis are handled.
+ *
+ * @return true if @p phi is an add-recurrence, @p rec is filled then
+ */
+bool scev_analyze_phi(ir_node *phi, ir_loop const *loop, scev_addrec_t *rec);
+
+/**
+ * Computes the amount @p node changes by in each iteration of @p loop if it
+ * is an affine function of add-recurrences with constant steps.  The stride
+ * is computed in @p mode.  A value widened to @p mode only has a stride if it
+ * is the induction variable of the exit test of @p loop and provably does not
+ * wrap around before the loop is left.
+ *
+ * @return true if the stride is known, @p stride is set then
+ */
+bool scev_get_stride(ir_node *node, ir_loop const *loop, ir_mode *mode,
+                     ir_tarval **stride);
+
+/**
+ * Computes the trip count of @p loop, the number of times the exit test in
+ * the loop header keeps the loop running, i.e. the number of executions of
+ * the loop body.
+ *
+ * Only loops whose header ends in a Cond comparing an integer add-recurrence
+ * with a constant step against a loop invariant value are handled.  The
+ * count is constant if the initial value and the limit are, it can be
+ * materialized with scev_build_trip_count() otherwise.
+ * Requires consistent outs and loop information.
+ *
+ * @return true if the trip count is known, @p tc is filled then
+ */
+bool scev_get_trip_count(ir_loop const *loop, scev_trip_count_t *tc);
+
+/**
+ * Creates nodes in @p block computing the trip count @p tc at runtime.  The
+ * result has the unsigned mode matching the mode of the induction variable
+ * and is only meaningful if the initial value passes the exit test, i.e. if
+ * the loop body is executed at least once.
+ * @p block must be dominated by the definitions of the initial value and the
+ * limit.
+ */
+ir_node *scev_build_trip_count(scev_trip_count_t const *tc, ir_node *block);
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   amd64 architecture variants
+ */
+#include "amd64_architecture.h"
+
+#include <string.h>
+
+#include "irtools.h"
+#include "lc_opts.h"
+#include "lc_opts_enum.h"
+#include "util.h"
+#include "../ia32/x86_cpuid.h"
+
+amd64_code_gen_config_t amd64_cg_config;
+
+/**
+ * CPU features. Every x86_64 cpu has at least SSE2, so only the extensions
+ * beyond that are listed.
+ */
+typedef enum amd64_arch_features {
+	arch_x86_64           = 1U << 0, /**< baseline x86_64 */
+	arch_feature_sse3     = 1U << 1, /**< SSE3 instructions */
+	arch_feature_ssse3    = 1U << 2, /**< SSSE3 instructions */
+	arch_feature_sse4_1   = 1U << 3, /**< SSE4.1 instructions */
+	arch_feature_sse4_2   = 1U << 4, /**< SSE4.2 instructions */
+	arch_feature_sse4a    = 1U << 5, /**< SSE4a instructions */
+	arch_feature_popcnt   = 1U << 6, /**< popcnt instruction */
+	arch_feature_lzcnt    = 1U << 7, /**< lzcnt instruction */
+	arch_feature_bmi1     = 1U << 8, /**< BMI1 instructions */
+	arch_feature_bmi2     = 1U << 9, /**< BMI2 instructions */
+	arch_feature_avx      = 1U << 10, /**< AVX instructions */
+	arch_feature_avx2     = 1U << 11, /**< AVX2 instructions */
+	arch_feature_fma      = 1U << 12, /**< FMA3 instructions */
+	arch_feature_erms     = 1U << 13, /**< fast rep movsb/stosb */
+
+	arch_ssse3_insn   = arch_feature_sse3   | arch_feature_ssse3,
+	arch_sse4_2_insn  = arch_ssse3_insn     | arch_feature_sse4_1 | arch_feature_sse4_2,
+	arch_v2_insn      = arch_sse4_2_insn    | arch_feature_popcnt,
+	arch_v3_insn      = arch_v2_insn | arch_feature_avx | arch_feature_avx2
+	                  | arch_feature_bmi1 | arch_feature_bmi2
+	                  | arch_feature_lzcnt | arch_feature_fma,
+
+	cpu_generic     = arch_x86_64,
+	cpu_x86_64_v2   = arch_x86_64 | arch_v2_insn,
+	cpu_x86_64_v3   = arch_x86_64 | arch_v3_insn,
+
+	/* intel CPUs */
+	cpu_nocona      = arch_x86_64 | arch_feature_sse3,
+	cpu_core2       = arch_x86_64 | arch_ssse3_insn,
+	cpu_penryn      = arch_x86_64 | arch_ssse3_insn | arch_feature_sse4_1,
+	cpu_nehalem     = arch_x86_64 | arch_v2_insn,
+	cpu_sandybridge = arch_x86_64 | arch_v2_insn | arch_feature_avx,
+	cpu_ivybridge   = cpu_sandybridge | arch_feature_erms,
+	cpu_haswell     = arch_x86_64 | arch_v3_insn | arch_feature_erms,
+
+	/* AMD CPUs */
+	cpu_k8          = arch_x86_64,
+	cpu_k8_sse3     = arch_x86_64 | arch_feature_sse3,
+	cpu_k10         = arch_x86_64 | arch_feature_sse3 | arch_feature_sse4a
+	                | arch_feature_popcnt | arch_feature_lzcnt,
+	cpu_btver2      = cpu_k10 | arch_sse4_2_insn | arch_feature_avx
+	                | arch_feature_bmi1,
+	cpu_bdver2      = cpu_k10 | arch_sse4_2_insn | arch_feature_avx
+	                | arch_feature_bmi1 | arch_feature_fma,
+	cpu_znver1      = cpu_k10 | arch_v3_insn,
+
+	cpu_autodetect  = 0,
+} amd64_arch_features;
+ENUM_BITSET(amd64_arch_features)
+
+static amd64_arch_features arch       = cpu_generic;
+static bool                use_popcnt = false;
+static bool                use_lzcnt  = false;
+static bool                use_bmi    = false;
+static bool                use_bmi2   = false;
+static bool                use_avx    = false;
+static bool                use_fma    = false;
+static bool                use_erms   = false;
+
+/* instruction set architectures. */
+static const lc_opt_enum_int_items_t arch_items[] = {
+	{ "x86-64",      cpu_generic },
+	{ "x86-64-v2",   cpu_x86_64_v2 },
+	{ "x86-64-v3",   cpu_x86_64_v3 },
+
+	{ "nocona",      cpu_nocona },
+	{ "core2",       cpu_core2 },
+	{ "penryn",      cpu_penryn },
+	{ "nehalem",     cpu_nehalem },
+	{ "westmere",    cpu_nehalem },
+	{ "sandybridge", cpu_sandybridge },
+	{ "ivybridge",   cpu_ivybridge },
+	{ "haswell",     cpu_haswell },
+	{ "broadwell",   cpu_haswell },
+	{ "skylake",     cpu_haswell },
+
+	{ "k8",          cpu_k8 },
+	{ "opteron",     cpu_k8 },
+	{ "athlon64",    cpu_k8 },
+	{ "k8-sse3",     cpu_k8_sse3 },
+	{ "k10",         cpu_k10 },
+	{ "barcelona",   cpu_k10 },
+	{ "amdfam10",    cpu_k10 },
+	{ "btver2",      cpu_btver2 },
+	{ "bdver2",      cpu_bdver2 },
+	{ "znver1",      cpu_znver1 },
+	{ "znver2",      cpu_znver1 },
+
+	{ "generic",     cpu_generic },
+
+#ifdef NATIVE_X86
+	{ "native",      cpu_autodetect },
+#endif
+
+	{ NULL,          0 }
+};
+
+static lc_opt_enum_int_var_t arch_var = {
+	(int*) &arch, arch_items
+};
+
+static const lc_opt_table_entry_t amd64_architecture_options[] = {
+	LC_OPT_ENT_ENUM_INT("arch",   "select the instruction architecture", &arch_var),
+	LC_OPT_ENT_BOOL    ("popcnt", "use the popcnt instruction",          &use_popcnt),
+	LC_OPT_ENT_BOOL    ("lzcnt",  "use the lzcnt instruction",           &use_lzcnt),
+	LC_OPT_ENT_BOOL    ("bmi",    "use BMI1 instructions",               &use_bmi),
+	LC_OPT_ENT_BOOL    ("bmi2",   "use BMI2 instructions",               &use_bmi2),
+	LC_OPT_ENT_BOOL    ("avx",    "use VEX encoded AVX instructions",    &use_avx),
+	LC_OPT_ENT_BOOL    ("fma",    "use FMA3 instructions",               &use_fma),
+	LC_OPT_ENT_BOOL    ("erms",   "use rep movsb for block copies",      &use_erms),
+	LC_OPT_LAST
+};
+
+#ifdef NATIVE_X86
+static void autodetect_arch(void)
+{
+	amd64_arch_features auto_arch = cpu_generic;
+
+	x86_cpu_info_t cpu_info;
+	if (x86_get_cpu_info(&cpu_info)) {
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_SSE3)
+			auto_arch |= arch_feature_sse3;
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_SSSE3)
+			auto_arch |= arch_feature_ssse3;
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_SSE4_1)
+			auto_arch |= arch_feature_sse4_1;
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_SSE4_2)
+			auto_arch |= arch_feature_sse4_2;
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_POPCNT)
+			auto_arch |= arch_feature_popcnt;
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_AVX)
+			auto_arch |= arch_feature_avx;
+		if (cpu_info.ecx_features & CPUID_FEAT_ECX_FMA)
+			auto_arch |= arch_feature_fma;
+
+		if (cpu_info.ebx_features_7 & CPUID_FEAT7_EBX_BMI1)
+			auto_arch |= arch_feature_bmi1;
+		if (cpu_info.ebx_features_7 & CPUID_FEAT7_EBX_BMI2)
+			auto_arch |= arch_feature_bmi2;
+		if (cpu_info.ebx_features_7 & CPUID_FEAT7_EBX_AVX2)
+			auto_arch |= arch_feature_avx2;
+		if (cpu_info.ebx_features_7 & CPUID_FEAT7_EBX_ERMS)
+			auto_arch |= arch_feature_erms;
+
+		if (cpu_info.ecx_features_ext & CPUID_FEATEXT_ECX_ABM)
+			auto_arch |= arch_feature_lzcnt;
+		if (cpu_info.ecx_features_ext & CPUID_FEATEXT_ECX_SSE4A)
+			auto_arch |= arch_feature_sse4a;
+	}
+
+	arch = auto_arch;
+}
+#endif  /* NATIVE_X86 */
+
+static bool flags(amd64_arch_features features, amd64_arch_features flags)
+{
+	return (features & flags) != 0;
+}
+
+void amd64_setup_cg_config(void)
+{
+#ifdef NATIVE_X86
+	if (arch == cpu_autodetect)
+		autodetect_arch();
+#endif
+	if (use_popcnt)
+		arch |= arch_feature_popcnt;
+	if (use_lzcnt)
+		arch |= arch_feature_lzcnt;
+	if (use_bmi)
+		arch |= arch_feature_bmi1;
+	if (use_bmi2)
+		arch |= arch_feature_bmi2;
+	if (use_avx)
+		arch |= arch_feature_avx;
+	if (use_fma)
+		arch |= arch_feature_avx | arch_feature_fma;
+	if (use_erms)
+		arch |= arch_feature_erms;
+
+	amd64_code_gen_config_t *const c = &amd64_cg_config;
+	memset(c, 0, sizeof(*c));
+	c->use_popcnt = flags(arch, arch_feature_popcnt);
+	c->use_lzcnt  = flags(arch, arch_feature_lzcnt);
+	c->use_bmi1   = flags(arch, arch_feature_bmi1);
+	c->use_bmi2   = flags(arch, arch_feature_bmi2);
+	c->use_avx    = flags(arch, arch_feature_avx);
+	c->use_fma    = flags(arch, arch_feature_fma);
+	c->use_erms   = flags(arch, arch_feature_erms);
+
+	/* Copies up to two registers use integer moves, up to eight vector
+	 * registers unrolled vector moves.  Beyond that rep movsb beats the call
+	 * overhead of memcpy up to a page on CPUs with fast string operations. */
+	c->copyb_vector_size = c->use_avx ? 32 : 16;
+	c->copyb_max_small   = 16;
+	c->copyb_max_vector  = 8 * c->copyb_vector_size;
+	c->copyb_min_large   = c->use_erms ? 4097 : c->copyb_max_vector + 1;
+}
+
+void amd64_init_architecture(void)
+{
+	memset(&amd64_cg_config, 0, sizeof(amd64_cg_config));
+
+	lc_opt_entry_t *be_grp    = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *amd64_grp = lc_opt_get_grp(be_grp, "amd64");
+	lc_opt_add_table(amd64_grp, amd64_architecture_options);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   amd64 architecture variants
+ */
+#ifndef FIRM_BE_AMD64_ARCHITECTURE_H
+#define FIRM_BE_AMD64_ARCHITECTURE_H
+
+#include <stdbool.h>
+
+typedef struct {
+	/** use the popcnt instruction */
+	bool use_popcnt:1;
+	/** use the lzcnt instruction (ABM) */
+	bool use_lzcnt:1;
+	/** use BMI1 instructions (andn, blsr, blsi, blsmsk, tzcnt) */
+	bool use_bmi1:1;
+	/** use BMI2 instructions (bzhi, shlx, shrx, sarx) */
+	bool use_bmi2:1;
+	/** use VEX encoded three-operand forms for scalar float arithmetic */
+	bool use_avx:1;
+	/** use FMA3 instructions and contract float Mul+Add */
+	bool use_fma:1;
+	/** use rep movsb for medium sized copies (enhanced rep movsb) */
+	bool use_erms:1;
+	/** width of the vector moves used for copies, 16 or 32 bytes */
+	unsigned copyb_vector_size;
+	/** maximum size of a copy lowered to integer moves */
+	unsigned copyb_max_small;
+	/** maximum size of a copy done with vector moves */
+	unsigned copyb_max_vector;
+	/** minimum size of a copy turned into a memcpy call */
+	unsigned copyb_min_large;
+} amd64_code_gen_config_t;
+
+extern amd64_code_gen_config_t amd64_cg_config;
+
+/** Initialize the amd64 architecture module. */
+void amd64_init_architecture(void);
+
+/** Setup the amd64_cg_config structure by inspecting current user settings. */
+void amd64_setup_cg_config(void);
+
+#endif
@@ -8,6 +8,7 @@
  * @brief    The main amd64 backend driver file.
  */
 #include "amd64_abi.h"
+#include "amd64_architecture.h"
 #include "amd64_bearch_t.h"
 
 #include "amd64_emitter.h"
@@ -27,6 +28,7 @@
 #include "gen_amd64_regalloc_if.h"
 #include "irarch.h"
 #include "ircons.h"
+#include "irdom.h"
 #include "iredges_t.h"
 #include "irgmod.h"
 #include "irgopt.h"
@@ -736,15 +738,14 @@ static void amd64_lower_for_target(void)
 	}
 
 	foreach_irp_irg(i, irg) {
-		/* Turn all small CopyBs into loads/stores, and turn all bigger
-		 * CopyBs into memcpy calls, because we cannot handle CopyB nodes
-		 * during code generation yet.
-		 * TODO:  Adapt this once custom CopyB handling is implemented. */
-		lower_CopyB(irg, 64, 65, true);
+		/* Turn small CopyBs into loads/stores and large ones into memcpy
+		 * calls, medium sized ones are handled during code generation. */
+		lower_CopyB(irg, amd64_cg_config.copyb_max_small,
+		            amd64_cg_config.copyb_min_large, true);
 		be_after_transform(irg, "lower-copyb");
 	}
 
-	ir_builtin_kind supported[6];
+	ir_builtin_kind supported[17];
 	size_t  s = 0;
 	supported[s++] = ir_bk_ffs;
 	supported[s++] = ir_bk_clz;
@@ -752,6 +753,26 @@ static void amd64_lower_for_target(void)
 	supported[s++] = ir_bk_compare_swap;
 	supported[s++] = ir_bk_saturating_increment;
 	supported[s++] = ir_bk_va_start;
+	supported[s++] = ir_bk_prefetch;
+	supported[s++] = ir_bk_atomic_fetch_add;
+	supported[s++] = ir_bk_atomic_fetch_sub;
+	supported[s++] = ir_bk_atomic_fetch_and;
+	supported[s++] = ir_bk_atomic_fetch_or;
+	supported[s++] = ir_bk_atomic_fetch_xor;
+	supported[s++] = ir_bk_atomic_exchange;
+	supported[s++] = ir_bk_atomic_load;
+	supported[s++] = ir_bk_atomic_store;
+	supported[s++] = ir_bk_atomic_fence;
+	if (amd64_cg_config.use_popcnt)
+		supported[s++] = ir_bk_popcount;
+
+	/* lock and/or/xor do not produce the previous value */
+	static ir_builtin_kind const no_result[] = {
+		ir_bk_atomic_fetch_and,
+		ir_bk_atomic_fetch_or,
+		ir_bk_atomic_fetch_xor,
+	};
+	lower_atomic_rmw_results(ARRAY_SIZE(no_result), no_result, true);
 
 	assert(s <= ARRAY_SIZE(supported));
 	lower_builtins(s, supported, amd64_lower_va_arg);
@@ -768,8 +789,116 @@ static void amd64_init_types(void)
 	ir_platform.va_list_type = amd64_build_va_list_type();
 }
 
+/** Maximum cost of the computations which may become unconditional by
+ * if-conversion. A mispredicted branch costs far more than this. */
+#define AMD64_IFCONV_MAX_COST 6
+
+/**
+ * Estimates the cost of the computations feeding @p value which are only
+ * executed on one side of the branch in @p cond_block and would become
+ * unconditional after if-conversion. Returns a value above @p budget if the
+ * computation must not be speculated at all.
+ */
+static unsigned get_speculation_cost(ir_node const *const value,
+                                     ir_node const *const cond_block,
+                                     unsigned const budget)
+{
+	if (is_irn_constlike(value))
+		return 0;
+	ir_node const *const block = get_nodes_block(value);
+	if (block_dominates(block, cond_block))
+		return 0;
+	/* memory operations and control flow stay behind the branch */
+	if (is_Proj(value) || is_Phi(value))
+		return budget + 1;
+
+	unsigned cost = is_Mul(value) ? 3 : 1;
+	foreach_irn_in(value, i, pred) {
+		if (cost > budget)
+			break;
+		cost += get_speculation_cost(pred, cond_block, budget - cost);
+	}
+	return cost;
+}
+
+static bool mux_is_float_min_max(ir_node const *const sel,
+                                 ir_node const *const mux_false,
+                                 ir_node const *const mux_true)
+{
+	ir_node const *const cmp_l    = get_Cmp_left(sel);
+	ir_node const *const cmp_r    = get_Cmp_right(sel);
+	ir_relation          relation = get_Cmp_relation(sel);
+	if (relation & ir_relation_unordered)
+		relation = get_negated_relation(relation);
+	if (relation != ir_relation_less && relation != ir_relation_greater)
+		return false;
+	return (cmp_l == mux_true && cmp_r == mux_false)
+	    || (cmp_l == mux_false && cmp_r == mux_true);
+}
+
+static bool mux_is_float_blend(ir_node const *const sel, ir_mode *const mode)
+{
+	/* the compare mask has to cover the selected value */
+	ir_mode *const cmp_mode = get_irn_mode(get_Cmp_left(sel));
+	if (!is_flt(cmp_mode)
+	 || get_mode_size_bits(cmp_mode) < get_mode_size_bits(mode))
+		return false;
+	/* there is no SSE compare predicate for these */
+	switch (get_Cmp_relation(sel)) {
+	case ir_relation_false:
+	case ir_relation_less_greater:
+	case ir_relation_unordered_equal:
+	case ir_relation_true:
+		return false;
+	default:
+		return true;
+	}
+}
+
+static int amd64_is_mux_allowed(ir_node const *const sel,
+                                ir_node const *const mux_false,
+                                ir_node const *const mux_true)
+{
+	/* middleend can handle some things */
+	if (ir_is_optimizable_mux(sel, mux_false, mux_true))
+		return true;
+	if (!is_Cmp(sel))
+		return false;
+	/* no cmov after an x87 compare */
+	ir_mode *const cmp_mode = get_irn_mode(get_Cmp_left(sel));
+	if (cmp_mode == x86_mode_E)
+		return false;
+
+	ir_mode *const mode = get_irn_mode(mux_true);
+	if (mode_is_float(mode)) {
+		if (!is_flt(mode))
+			return false;
+		if (!mux_is_float_min_max(sel, mux_false, mux_true)
+		 && !mux_is_float_blend(sel, mode))
+			return false;
+	} else if (!be_mode_needs_gp_reg(mode)) {
+		return false;
+	}
+
+	/* without dominance information only values computed before the branch
+	 * are known, so do not speculate anything */
+	ir_graph *const irg = get_irn_irg(sel);
+	if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE))
+		return false;
+	ir_node const *const cond_block = get_nodes_block(sel);
+	unsigned       const budget     = AMD64_IFCONV_MAX_COST;
+	unsigned       const cost_true
+		= get_speculation_cost(mux_true, cond_block, budget);
+	if (cost_true > budget)
+		return false;
+	unsigned const cost_false
+		= get_speculation_cost(mux_false, cond_block, budget - cost_true);
+	return cost_true + cost_false <= budget;
+}
+
 static void amd64_init(void)
 {
+	amd64_setup_cg_config();
 	amd64_init_types();
 	amd64_register_init();
 	amd64_create_opcodes();
@@ -778,6 +907,7 @@ static void amd64_init(void)
 
 	ir_target.experimental = "the amd64 backend is experimental and unfinished (consider the ia32 backend)";
 	ir_target.fast_unaligned_memaccess = true;
+	ir_target.allow_ifconv             = amd64_is_mux_allowed;
 	ir_target.float_int_overflow       = ir_overflow_indefinite;
 }
 
@@ -816,6 +946,7 @@ arch_isa_if_t const amd64_isa_if = {
 	.big_endian            = false,
 	.po2_biggest_alignment = 4,
 	.pic_supported         = true,
+	.code_cache_supported  = true,
 	.n_registers           = N_AMD64_REGISTERS,
 	.registers             = amd64_registers,
 	.n_register_classes    = N_AMD64_CLASSES,
@@ -840,5 +971,6 @@ void be_init_arch_amd64(void)
 	lc_opt_entry_t *amd64_grp = lc_opt_get_grp(be_grp, "amd64");
 	lc_opt_add_table(amd64_grp, options);
 
+	amd64_init_architecture();
 	amd64_init_transform();
 }
@@ -9,6 +9,7 @@
  */
 #include "amd64_emitter.h"
 
+#include "amd64_architecture.h"
 #include "amd64_bearch_t.h"
 #include "amd64_new_nodes.h"
 #include "amd64_nodes_attr.h"
@@ -697,14 +698,11 @@ static void emit_copyB_prolog(unsigned size)
 }
 
 /**
- * Emit rep movsq instruction for memcopy.
+ * Emit rep movsb instruction for memcopy, the byte count is in rcx.
  */
 static void emit_amd64_copyB(const ir_node *node)
 {
-	unsigned size = get_amd64_copyb_attr_const(node)->size;
-
-	emit_copyB_prolog(size);
-	amd64_emitf(node, "rep movsd");
+	amd64_emitf(node, "rep movsb");
 }
 
 /**
@@ -722,6 +720,38 @@ static void emit_amd64_copyB_i(const ir_node *node)
 	}
 }
 
+/**
+ * Emits a memcopy with unaligned vector moves through the temporary register.
+ * A remainder smaller than the vector size is copied by a last move ending at
+ * the end of the block, which overlaps the previous one.
+ */
+static void emit_amd64_copyB_vec(const ir_node *node)
+{
+	unsigned               const size  = get_amd64_copyb_attr_const(node)->size;
+	unsigned               const width = size >= 32 ? amd64_cg_config.copyb_vector_size : 16;
+	arch_register_t const *const tmp   = arch_get_irn_register_out(node, pn_amd64_copyB_vec_tmp);
+	assert(size >= width);
+
+	unsigned offset = 0;
+	for (;;) {
+		if (width == 32) {
+			amd64_emitf(node, "vmovdqu %u(%^S1), %%y%s", offset, tmp->name + 1);
+			amd64_emitf(node, "vmovdqu %%y%s, %u(%^S0)", tmp->name + 1, offset);
+		} else {
+			amd64_emitf(node, "movdqu %u(%^S1), %^D0", offset);
+			amd64_emitf(node, "movdqu %^D0, %u(%^S0)", offset);
+		}
+		if (offset + width == size)
+			break;
+		offset += width;
+		if (offset + width > size)
+			offset = size - width;
+	}
+	/* Avoid the penalty of mixing dirty upper ymm halves with SSE code. */
+	if (width == 32)
+		amd64_emitf(node, "vzeroupper");
+}
+
 /**
  * emit copy node
  */
@@ -737,7 +767,10 @@ static void emit_be_Copy(const ir_node *irn)
 	if (cls == &amd64_reg_classes[CLASS_amd64_gp]) {
 		amd64_emitf(irn, "mov %^S0, %^D0");
 	} else if (cls == &amd64_reg_classes[CLASS_amd64_xmm]) {
-		amd64_emitf(irn, "movapd %^S0, %^D0");
+		if (amd64_cg_config.use_avx)
+			amd64_emitf(irn, "vmovapd %^S0, %^D0");
+		else
+			amd64_emitf(irn, "movapd %^S0, %^D0");
 	} else if (cls == &amd64_reg_classes[CLASS_amd64_x87]) {
 		/* nothing to do */
 	} else {
@@ -798,6 +831,7 @@ static void amd64_register_emitters(void)
 	be_set_emitter(op_amd64_mov_gp,     emit_amd64_mov_gp);
 	be_set_emitter(op_amd64_copyB,      emit_amd64_copyB);
 	be_set_emitter(op_amd64_copyB_i,    emit_amd64_copyB_i);
+	be_set_emitter(op_amd64_copyB_vec,  emit_amd64_copyB_vec);
 	be_set_emitter(op_be_Asm,           emit_amd64_asm);
 	be_set_emitter(op_be_Copy,          emit_be_Copy);
 	be_set_emitter(op_be_CopyKeep,      emit_be_Copy);
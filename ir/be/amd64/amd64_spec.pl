@@ -96,7 +96,7 @@ $mode_x87   = "x86_mode_E";
 	amd64_call_addr_attr_t =>
 		"*attr = *attr_init;",
 	amd64_copyb_attr_t =>
-		"init_amd64_attributes(res, AMD64_OP_NONE, size);\n"
+		"init_amd64_attributes(res, AMD64_OP_NONE, X86_SIZE_64);\n"
 		."\tinit_amd64_copyb_attributes(res, size);",
 	amd64_x87_attr_t =>
 		"init_amd64_attributes(res, AMD64_OP_X87, X86_SIZE_80);\n",
@@ -120,6 +120,29 @@ my $binop = {
 	emit      => "{name}%M %AM",
 };
 
+my $lock_binop = {
+	irn_flags => [ "modify_flags" ],
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "flags", "mem" ],
+	outs      => [ "flags", "M" ],
+	attr_type => "amd64_binop_addr_attr_t",
+	attr      => "const amd64_binop_addr_attr_t *attr_init",
+};
+
+my $prefetchop = {
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "mem" ],
+	outs      => [ "M" ],
+	attr_type => "amd64_addr_attr_t",
+	attr      => "x86_addr_t addr",
+	fixed     => "amd64_op_mode_t op_mode = AMD64_OP_ADDR;\n"
+	            ."x86_insn_size_t size    = X86_SIZE_8;\n",
+	emit      => "{name} %A",
+	latency   => 0,
+};
+
 my $binop_commutative = {
 	irn_flags => [ "modify_flags", "rematerializable", "commutative" ],
 	state     => "exc_pinned",
@@ -211,6 +234,19 @@ my $unop_out = {
 	emit      => "{name}%M %AM, %D0",
 };
 
+my $vex_shiftop = {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "gp", "gp" ],
+	out_reqs  => [ "gp" ],
+	ins       => [ "val", "count" ],
+	outs      => [ "res" ],
+	attr_type => "amd64_addr_attr_t",
+	attr      => "x86_insn_size_t size",
+	fixed     => "amd64_op_mode_t op_mode = AMD64_OP_REG;\n"
+	            ."x86_addr_t addr = { .base_input = 0, .variant = X86_ADDR_REG };",
+	emit      => "{name}%M %S1, %S0, %D0",
+};
+
 my $binopx = {
 	irn_flags => [ "rematerializable" ],
 	state     => "exc_pinned",
@@ -233,6 +269,39 @@ my $binopx_commutative = {
 	emit      => "{name}%MX %AM",
 };
 
+my $vex_binopx = {
+	irn_flags => [ "rematerializable" ],
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "xmm", "none", "mem" ],
+	outs      => [ "res", "none", "M" ],
+	attr_type => "amd64_binop_addr_attr_t",
+	attr      => "const amd64_binop_addr_attr_t *attr_init",
+	emit      => "{name}%MX %AM, %D0",
+};
+
+my $vex_binopx_commutative = {
+	irn_flags => [ "rematerializable", "commutative" ],
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "xmm", "none", "mem" ],
+	outs      => [ "res", "none", "M" ],
+	attr_type => "amd64_binop_addr_attr_t",
+	attr      => "const amd64_binop_addr_attr_t *attr_init",
+	emit      => "{name}%MX %AM, %D0",
+};
+
+my $fmaop = {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "xmm", "xmm", "xmm" ],
+	out_reqs  => [ "in_r0 !in_r1 !in_r2" ],
+	ins       => [ "addend", "left", "right" ],
+	outs      => [ "res" ],
+	attr      => "x86_insn_size_t size",
+	fixed     => "amd64_op_mode_t op_mode = AMD64_OP_NONE;",
+	emit      => "{name}%MX %S2, %S1, %D0",
+};
+
 my $cvtop2x = {
 	state     => "exc_pinned",
 	in_reqs   => "...",
@@ -484,6 +553,81 @@ cmpxchg => {
 	emit      => "lock cmpxchg%M %AM",
 },
 
+xadd => {
+	irn_flags => [ "modify_flags" ],
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "gp", "flags", "mem" ],
+	outs      => [ "res", "flags", "M" ],
+	attr_type => "amd64_binop_addr_attr_t",
+	attr      => "const amd64_binop_addr_attr_t *attr_init",
+	emit      => "lock xadd%M %AM",
+},
+
+# xchg with a memory operand is implicitly locked
+xchg => {
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "gp", "mem" ],
+	outs      => [ "res", "M" ],
+	attr_type => "amd64_binop_addr_attr_t",
+	attr      => "const amd64_binop_addr_attr_t *attr_init",
+	emit      => "xchg%M %AM",
+},
+
+lock_and => {
+	template => $lock_binop,
+	emit     => "lock and%M %AM",
+},
+
+lock_or => {
+	template => $lock_binop,
+	emit     => "lock or%M %AM",
+},
+
+lock_xor => {
+	template => $lock_binop,
+	emit     => "lock xor%M %AM",
+},
+
+mfence => {
+	state     => "pinned",
+	in_reqs   => [ "mem" ],
+	out_reqs  => [ "mem" ],
+	ins       => [ "mem" ],
+	outs      => [ "M" ],
+	fixed     => "amd64_op_mode_t op_mode = AMD64_OP_NONE;\n"
+	            ."x86_insn_size_t size    = X86_SIZE_64;\n",
+	emit      => "mfence",
+},
+
+prefetcht0 => {
+	template => $prefetchop,
+},
+
+prefetcht1 => {
+	template => $prefetchop,
+},
+
+prefetcht2 => {
+	template => $prefetchop,
+},
+
+prefetchnta => {
+	template => $prefetchop,
+},
+
+# TODO cmov can also operate on memory
+cmov => {
+	in_reqs   => [ "gp", "gp", "flags" ],
+	out_reqs  => [ "in_r0 !in_r1" ],
+	ins       => [ "val_false", "val_true", "eflags" ],
+	outs      => [ "res" ],
+	attr_type => "amd64_cc_attr_t",
+	attr      => "x86_insn_size_t size, x86_condition_code_t cc",
+	emit      => "cmov%P0 %S1, %D0",
+},
+
 # TODO Setcc can also operate on memory
 setcc => {
 	irn_flags => [  ],
@@ -566,10 +710,92 @@ bsf => { template => $unop_out },
 
 bsr => { template => $unop_out },
 
+# BMI1, BMI2, LZCNT, POPCNT
+
+andn => {
+	template  => $binop,
+	irn_flags => [ "modify_flags", "rematerializable" ],
+	emit      => "{name}%M %AM, %D0",
+},
+
+blsi => { template => $unop_out },
+
+blsmsk => { template => $unop_out },
+
+blsr => { template => $unop_out },
+
+bzhi => {
+	template  => $vex_shiftop,
+	irn_flags => [ "modify_flags", "rematerializable" ],
+	out_reqs  => [ "gp", "flags" ],
+	outs      => [ "res", "flags" ],
+},
+
+lzcnt => { template => $unop_out },
+
+popcnt => { template => $unop_out },
+
+sarx => { template => $vex_shiftop },
+
+shlx => { template => $vex_shiftop },
+
+shrx => { template => $vex_shiftop },
+
+tzcnt => { template => $unop_out },
+
 # SSE
 
 adds => { template => $binopx_commutative },
 
+andnp => {
+	template => $binopx,
+	emit     => "andnp%MX %AM",
+},
+
+andp => { template => $binopx_commutative },
+
+# compares producing an all-ones or all-zeros mask, named after the predicate
+
+cmpeqs => {
+	template => $binopx,
+	emit     => "cmpeqs%MX %AM",
+},
+
+cmples => {
+	template => $binopx,
+	emit     => "cmples%MX %AM",
+},
+
+cmplts => {
+	template => $binopx,
+	emit     => "cmplts%MX %AM",
+},
+
+cmpneqs => {
+	template => $binopx,
+	emit     => "cmpneqs%MX %AM",
+},
+
+cmpnles => {
+	template => $binopx,
+	emit     => "cmpnles%MX %AM",
+},
+
+cmpnlts => {
+	template => $binopx,
+	emit     => "cmpnlts%MX %AM",
+},
+
+cmpords => {
+	template => $binopx,
+	emit     => "cmpords%MX %AM",
+},
+
+cmpunords => {
+	template => $binopx,
+	emit     => "cmpunords%MX %AM",
+},
+
 divs => {
 	template => $binopx,
 	emit     => "divs%MX %AM",
@@ -581,6 +807,16 @@ movs_xmm => {
 	emit     => "movs%MX %AM, %D0",
 },
 
+maxs => {
+	template => $binopx,
+	emit     => "maxs%MX %AM",
+},
+
+mins => {
+	template => $binopx,
+	emit     => "mins%MX %AM",
+},
+
 muls => { template => $binopx_commutative },
 
 movs_store_xmm => {
@@ -594,6 +830,8 @@ movs_store_xmm => {
 	emit      => "movs%MX %^S0, %A",
 },
 
+orp => { template => $binopx_commutative },
+
 subs => {
 	template => $binopx,
 	emit     => "subs%MX %AM",
@@ -622,6 +860,26 @@ xorp_0 => {
 
 xorp => { template => $binopx_commutative },
 
+# AVX, VEX encoded three-operand forms with a separate destination
+
+vadds => { template => $vex_binopx_commutative },
+
+vdivs => { template => $vex_binopx },
+
+vmuls => { template => $vex_binopx_commutative },
+
+vsubs => { template => $vex_binopx },
+
+vxorp => { template => $vex_binopx_commutative },
+
+# FMA3, the addend is overwritten by the result
+
+vfmadd231s => { template => $fmaop },
+
+vfmsub231s => { template => $fmaop },
+
+vfnmadd231s => { template => $fmaop },
+
 movd_xmm_gp => {
 	state     => "exc_pinned",
 	ins       => [ "operand" ],
@@ -689,6 +947,8 @@ movdqu_store => {
 },
 
 copyB => {
+	op_flags  => [ "uses_memory" ],
+	state     => "exc_pinned",
 	in_reqs   => [ "rdi", "rsi", "rcx", "mem" ],
 	out_reqs  => [ "rdi", "rsi", "rcx", "mem" ],
 	ins       => [ "dest", "source", "count", "mem" ],
@@ -699,6 +959,8 @@ copyB => {
 },
 
 copyB_i => {
+	op_flags  => [ "uses_memory" ],
+	state     => "exc_pinned",
 	in_reqs   => [ "rdi", "rsi", "mem" ],
 	out_reqs  => [ "rdi", "rsi", "mem" ],
 	ins       => [ "dest", "source", "mem" ],
@@ -708,6 +970,18 @@ copyB_i => {
 	latency   => 3,
 },
 
+copyB_vec => {
+	op_flags  => [ "uses_memory" ],
+	state     => "exc_pinned",
+	in_reqs   => [ "gp", "gp", "mem" ],
+	out_reqs  => [ "xmm", "mem" ],
+	ins       => [ "dest", "source", "mem" ],
+	outs      => [ "tmp", "M" ],
+	attr_type => "amd64_copyb_attr_t",
+	attr      => "unsigned size",
+	latency   => 3,
+},
+
 l_punpckldq => {
 	ins       => [ "arg0", "arg1" ],
 	outs      => [ "res" ],
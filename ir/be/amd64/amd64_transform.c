@@ -11,6 +11,7 @@
 
 #include "../ia32/x86_address_mode.h"
 #include "../ia32/x86_cconv.h"
+#include "amd64_architecture.h"
 #include "amd64_bearch_t.h"
 #include "amd64_new_nodes.h"
 #include "amd64_nodes_attr.h"
@@ -102,6 +103,13 @@ static const arch_register_req_t amd64_requirement_gp_same_0_not_1 = {
 	.width             = 1,
 };
 
+static const arch_register_req_t amd64_requirement_gp_same_0_not_1_2 = {
+	.cls               = &amd64_reg_classes[CLASS_amd64_gp],
+	.should_be_same    = BIT(0),
+	.must_be_different = BIT(1) | BIT(2),
+	.width             = 1,
+};
+
 static const arch_register_req_t amd64_requirement_xmm_same_0_not_1 = {
 	.cls               = &amd64_reg_classes[CLASS_amd64_xmm],
 	.should_be_same    = BIT(0),
@@ -757,8 +765,10 @@ static ir_node *gen_binop_am(ir_node *node, ir_node *op1, ir_node *op2,
 	fix_node_mem_proj(new_node, args.mem_proj);
 
 	if (mode_is_float(mode)) {
-		arch_set_irn_register_req_out(new_node, 0,
-		                              &amd64_requirement_xmm_same_0);
+		/* VEX encoded forms have a separate destination operand */
+		if (!amd64_cg_config.use_avx)
+			arch_set_irn_register_req_out(new_node, 0,
+			                              &amd64_requirement_xmm_same_0);
 	} else {
 		arch_set_irn_register_req_out(new_node, 0,
 		                              &amd64_requirement_gp_same_0);
@@ -911,9 +921,12 @@ static ir_node *gen_binop_x87(ir_node *const node, ir_node *const op0,
 
 typedef ir_node *(*construct_shift_func)(dbg_info *dbgi, ir_node *block, int arity, ir_node *const *in, arch_register_req_t const **in_reqs, amd64_shift_attr_t const *attr_init);
 
+typedef ir_node *(*construct_vex_shift_func)(dbg_info *dbgi, ir_node *block, ir_node *val, ir_node *count, x86_insn_size_t size);
+
 static ir_node *gen_shift_binop(ir_node *node, ir_node *op1, ir_node *op2,
-                                construct_shift_func func, unsigned pn_res,
-                                match_flags_t flags)
+                                construct_shift_func func,
+                                construct_vex_shift_func vex_func,
+                                unsigned pn_res, match_flags_t flags)
 {
 	ir_mode *mode = get_irn_mode(node);
 	assert(!mode_is_float(mode));
@@ -952,6 +965,13 @@ static ir_node *gen_shift_binop(ir_node *node, ir_node *op1, ir_node *op2,
 		reqs              = reg_reqs;
 		out_req0          = &amd64_requirement_gp_same_0;
 		attr.immediate    = get_Const_long(op2);
+	} else if (amd64_cg_config.use_bmi2 && get_mode_size_bits(mode) >= 32) {
+		/* shlx/shrx/sarx take the count in any register and leave their
+		 * operand intact */
+		dbg_info *const dbgi      = get_irn_dbg_info(node);
+		ir_node  *const new_block = be_transform_nodes_block(node);
+		ir_node  *const new_op2   = be_transform_node(op2);
+		return vex_func(dbgi, new_block, in[0], new_op2, x86_size_from_mode(mode));
 	} else {
 		attr.base.op_mode = AMD64_OP_SHIFT_REG;
 		in[arity++]       = be_transform_node(op2);
@@ -985,6 +1005,32 @@ static x86_insn_size_t get_size_32_64_from_mode(ir_mode *const mode)
 	return get_mode_size_bits(mode) <= 32 ? X86_SIZE_32 : X86_SIZE_64;
 }
 
+/**
+ * Returns @p node, if it is a multiplication, which can be fused into its only
+ * user.  Fusing skips the rounding of the product, so it is only allowed with
+ * imprecise float transformations.
+ */
+static ir_node *get_fusable_Mul(ir_node *const node)
+{
+	return amd64_cg_config.use_fma && is_Mul(node)
+	    && get_irn_n_edges(node) == 1
+	    && ir_imprecise_float_transforms_allowed() ? node : NULL;
+}
+
+typedef ir_node *(*construct_fma_func)(dbg_info *dbgi, ir_node *block, ir_node *addend, ir_node *left, ir_node *right, x86_insn_size_t size);
+
+static ir_node *gen_fma(ir_node *const node, ir_node *const mul,
+                        ir_node *const addend, construct_fma_func const cons)
+{
+	dbg_info       *const dbgi    = get_irn_dbg_info(node);
+	ir_node        *const block   = be_transform_nodes_block(node);
+	ir_node        *const new_add = be_transform_node(addend);
+	ir_node        *const new_l   = be_transform_node(get_Mul_left(mul));
+	ir_node        *const new_r   = be_transform_node(get_Mul_right(mul));
+	x86_insn_size_t const size    = x86_size_from_mode(get_irn_mode(node));
+	return cons(dbgi, block, new_add, new_l, new_r, size);
+}
+
 static ir_node *gen_Add(ir_node *const node)
 {
 	ir_node *const op1   = get_Add_left(node);
@@ -995,6 +1041,16 @@ static ir_node *gen_Add(ir_node *const node)
 	if (mode_is_float(mode)) {
 		if (mode == x86_mode_E)
 			return gen_binop_x87(node, op1, op2, new_bd_amd64_fadd);
+		ir_node *const mul_l = get_fusable_Mul(op1);
+		if (mul_l)
+			return gen_fma(node, mul_l, op2, &new_bd_amd64_vfmadd231s);
+		ir_node *const mul_r = get_fusable_Mul(op2);
+		if (mul_r)
+			return gen_fma(node, mul_r, op1, &new_bd_amd64_vfmadd231s);
+		if (amd64_cg_config.use_avx)
+			return gen_binop_am(node, op1, op2, new_bd_amd64_vadds,
+			                    pn_amd64_vadds_res,
+			                    match_commutative | match_am);
 		return gen_binop_am(node, op1, op2, new_bd_amd64_adds,
 		                    pn_amd64_adds_res, match_commutative | match_am);
 	}
@@ -1035,6 +1091,17 @@ static ir_node *gen_Sub(ir_node *const node)
 	if (mode_is_float(mode)) {
 		if (mode == x86_mode_E)
 			return gen_binop_x87(node, op1, op2, new_bd_amd64_fsub);
+		/* a * b - c -> vfmsub231 */
+		ir_node *const mul_l = get_fusable_Mul(op1);
+		if (mul_l)
+			return gen_fma(node, mul_l, op2, &new_bd_amd64_vfmsub231s);
+		/* c - a * b -> vfnmadd231 */
+		ir_node *const mul_r = get_fusable_Mul(op2);
+		if (mul_r)
+			return gen_fma(node, mul_r, op1, &new_bd_amd64_vfnmadd231s);
+		if (amd64_cg_config.use_avx)
+			return gen_binop_am(node, op1, op2, new_bd_amd64_vsubs,
+			                    pn_amd64_vsubs_res, match_am);
 		return gen_binop_am(node, op1, op2, new_bd_amd64_subs,
 		                    pn_amd64_subs_res, match_am);
 	} else {
@@ -1051,6 +1118,115 @@ typedef ir_node* (*create_mov_func)(dbg_info *dbgi, ir_node *block, int arity,
 
 static ir_node *match_mov(dbg_info *dbgi, ir_node *block, ir_node *value, x86_insn_size_t size, create_mov_func create_mov, unsigned pn_res);
 
+typedef ir_node* (*unop_out_constructor)(dbg_info*, ir_node *block, const int arity, ir_node *const *const in,
+                                         arch_register_req_t const ** const reqs,
+                                         x86_insn_size_t size, amd64_op_mode_t opmode,
+                                         x86_addr_t addr);
+
+static ir_node *gen_unop_out_value(ir_node *node, ir_node *op,
+                                   unop_out_constructor gen, unsigned pn_res);
+
+/**
+ * Returns x, if @p node is x - 1 and has no other users.
+ */
+static ir_node *get_decremented(ir_node *const node)
+{
+	if (get_irn_n_edges(node) != 1)
+		return NULL;
+	if (is_Add(node)) {
+		ir_node *const right = get_Add_right(node);
+		if (is_Const(right) && is_Const_all_one(right))
+			return get_Add_left(node);
+	} else if (is_Sub(node) && is_irn_one(get_Sub_right(node))) {
+		return get_Sub_left(node);
+	}
+	return NULL;
+}
+
+/**
+ * Returns n, if @p node is (1 << n) - 1 and has no other users.
+ */
+static ir_node *get_low_mask_count(ir_node *const node)
+{
+	ir_node *const shl = get_decremented(node);
+	if (!shl || !is_Shl(shl) || get_irn_n_edges(shl) != 1
+	 || !is_irn_one(get_Shl_left(shl)))
+		return NULL;
+	return get_Shl_right(shl);
+}
+
+static ir_node *gen_andn(ir_node *const node, ir_node *const inverted,
+                         ir_node *const other)
+{
+	ir_node *const block = get_nodes_block(node);
+	ir_mode *const mode  = get_irn_mode(node);
+	amd64_args_t args;
+	match_binop(&args, block, mode, inverted, other, match_am);
+
+	dbg_info *const dbgi      = get_irn_dbg_info(node);
+	ir_node  *const new_block = be_transform_node(block);
+	ir_node  *const new_node  = new_bd_amd64_andn(dbgi, new_block, args.arity, args.in, args.reqs, &args.attr);
+	fix_node_mem_proj(new_node, args.mem_proj);
+	return be_new_Proj(new_node, pn_amd64_andn_res);
+}
+
+/**
+ * Matches the BMI idioms for x & y with 32 or 64 bit operands.
+ */
+static ir_node *match_bmi_And(ir_node *const node, ir_node *const x,
+                              ir_node *const y)
+{
+	if (amd64_cg_config.use_bmi1) {
+		/* x & (x - 1) -> blsr x */
+		if (get_decremented(y) == x)
+			return gen_unop_out_value(node, x, new_bd_amd64_blsr, pn_amd64_blsr_res);
+		/* x & -x -> blsi x */
+		if (is_Minus(y) && get_Minus_op(y) == x && get_irn_n_edges(y) == 1)
+			return gen_unop_out_value(node, x, new_bd_amd64_blsi, pn_amd64_blsi_res);
+		/* ~x & y -> andn x, y */
+		if (is_Not(x))
+			return gen_andn(node, get_Not_op(x), y);
+	}
+	if (amd64_cg_config.use_bmi2) {
+		/* x & ((1 << n) - 1) -> bzhi x, n */
+		ir_node *const count = get_low_mask_count(y);
+		if (count) {
+			dbg_info       *const dbgi      = get_irn_dbg_info(node);
+			ir_node        *const new_block = be_transform_nodes_block(node);
+			ir_node        *const new_x     = be_transform_node(x);
+			x86_insn_size_t const size      = x86_size_from_mode(get_irn_mode(node));
+
+			/* bzhi keeps all bits for indices beyond the operand size, while
+			 * Shl uses the count modulo the operand size, so mask the index */
+			ir_node *const in[] = { be_transform_node(count) };
+			amd64_binop_addr_attr_t const attr = {
+				.base = {
+					.base = {
+						.op_mode = AMD64_OP_REG_IMM,
+						.size    = X86_SIZE_32,
+					},
+					.addr = {
+						.base_input = 0,
+						.variant    = X86_ADDR_REG,
+					},
+				},
+				.u = {
+					.immediate = {
+						.offset = x86_bytes_from_size(size) * 8 - 1,
+					},
+				},
+			};
+			ir_node *const and = new_bd_amd64_and(dbgi, new_block, ARRAY_SIZE(in), in, reg_reqs, &attr);
+			arch_set_irn_register_req_out(and, 0, &amd64_requirement_gp_same_0);
+			ir_node *const index = be_new_Proj(and, pn_amd64_and_res);
+
+			ir_node *const bzhi = new_bd_amd64_bzhi(dbgi, new_block, new_x, index, size);
+			return be_new_Proj(bzhi, pn_amd64_bzhi_res);
+		}
+	}
+	return NULL;
+}
+
 static ir_node *gen_And(ir_node *const node)
 {
 	ir_node *const op1 = get_And_left(node);
@@ -1076,6 +1252,14 @@ movzx:;
 		}
 	}
 
+	if (get_mode_size_bits(get_irn_mode(node)) >= 32) {
+		ir_node *res = match_bmi_And(node, op1, op2);
+		if (!res)
+			res = match_bmi_And(node, op2, op1);
+		if (res)
+			return res;
+	}
+
 	return gen_binop_am(node, op1, op2, new_bd_amd64_and, pn_amd64_and_res,
 	                    match_immediate | match_am | match_mode_neutral
 	                    | match_commutative);
@@ -1085,6 +1269,14 @@ static ir_node *gen_Eor(ir_node *const node)
 {
 	ir_node *const op1 = get_Eor_left(node);
 	ir_node *const op2 = get_Eor_right(node);
+
+	/* x ^ (x - 1) -> blsmsk x */
+	if (amd64_cg_config.use_bmi1 && get_mode_size_bits(get_irn_mode(node)) >= 32) {
+		if (get_decremented(op2) == op1)
+			return gen_unop_out_value(node, op1, new_bd_amd64_blsmsk, pn_amd64_blsmsk_res);
+		if (get_decremented(op1) == op2)
+			return gen_unop_out_value(node, op2, new_bd_amd64_blsmsk, pn_amd64_blsmsk_res);
+	}
 	return gen_binop_am(node, op1, op2, new_bd_amd64_xor, pn_amd64_xor_res,
 	                    match_immediate | match_am | match_mode_neutral
 	                    | match_commutative);
@@ -1114,6 +1306,10 @@ static ir_node *gen_Mul(ir_node *const node)
 	} else if (mode_is_float(mode)) {
 		if (mode == x86_mode_E)
 			return gen_binop_x87(node, op1, op2, new_bd_amd64_fmul);
+		if (amd64_cg_config.use_avx)
+			return gen_binop_am(node, op1, op2, new_bd_amd64_vmuls,
+			                    pn_amd64_vmuls_res,
+			                    match_commutative | match_am);
 		return gen_binop_am(node, op1, op2, new_bd_amd64_muls,
 		                    pn_amd64_muls_res, match_commutative | match_am);
 	} else {
@@ -1161,7 +1357,8 @@ static ir_node *gen_Shl(ir_node *const node)
 		return create_add_lea(dbgi, block, size, new_op1, new_op1);
 	}
 
-	return gen_shift_binop(node, op1, op2, new_bd_amd64_shl, pn_amd64_shl_res,
+	return gen_shift_binop(node, op1, op2, new_bd_amd64_shl, new_bd_amd64_shlx,
+	                       pn_amd64_shl_res,
 	                       match_immediate | match_mode_neutral);
 }
 
@@ -1169,16 +1366,16 @@ static ir_node *gen_Shr(ir_node *const node)
 {
 	ir_node *const op1 = get_Shr_left(node);
 	ir_node *const op2 = get_Shr_right(node);
-	return gen_shift_binop(node, op1, op2, new_bd_amd64_shr, pn_amd64_shr_res,
-	                       match_immediate);
+	return gen_shift_binop(node, op1, op2, new_bd_amd64_shr, new_bd_amd64_shrx,
+	                       pn_amd64_shr_res, match_immediate);
 }
 
 static ir_node *gen_Shrs(ir_node *const node)
 {
 	ir_node *const op1 = get_Shrs_left(node);
 	ir_node *const op2 = get_Shrs_right(node);
-	return gen_shift_binop(node, op1, op2, new_bd_amd64_sar, pn_amd64_sar_res,
-	                       match_immediate);
+	return gen_shift_binop(node, op1, op2, new_bd_amd64_sar, new_bd_amd64_sarx,
+	                       pn_amd64_sar_res, match_immediate);
 }
 
 static ir_node *create_div(ir_node *const node, ir_mode *const mode,
@@ -1223,6 +1420,12 @@ static ir_node *create_sse_div(ir_node *const node, ir_mode *const mode,
 	amd64_args_t args;
 	match_binop(&args, block, mode, op1, op2, match_am);
 
+	if (amd64_cg_config.use_avx) {
+		ir_node *const new_node = new_bd_amd64_vdivs(dbgi, new_block, args.arity, args.in, args.reqs, &args.attr);
+		fix_node_mem_proj(new_node, args.mem_proj);
+		return new_node;
+	}
+
 	ir_node *const new_node = new_bd_amd64_divs(dbgi, new_block, args.arity, args.in, args.reqs, &args.attr);
 
 	fix_node_mem_proj(new_node, args.mem_proj);
@@ -1277,7 +1480,8 @@ static ir_node *gen_Proj_Div(ir_node *const node)
 			panic("amd64 exception NIY");
 		}
 		panic("invalid Div Proj");
-	} else if (is_amd64_divs(new_pred)) {
+	} else if (is_amd64_divs(new_pred) || is_amd64_vdivs(new_pred)) {
+		assert((unsigned)pn_amd64_divs_res == (unsigned)pn_amd64_vdivs_res);
 		switch (pn) {
 		case pn_Div_M:
 			/* float divs don't trap, skip memory */
@@ -1353,26 +1557,20 @@ static ir_node *gen_unop(ir_node *const node, int op_pos, unop_constructor gen,
 	return be_new_Proj(new_node, pn_res);
 }
 
-typedef ir_node* (*unop_out_constructor)(dbg_info*, ir_node *block, const int arity, ir_node *const *const in,
-                                         arch_register_req_t const ** const reqs,
-                                         x86_insn_size_t size, amd64_op_mode_t opmode,
-                                         x86_addr_t addr);
-
 /**
  * Generates a back-end node with dedicated output register for a unary
- * builtin node in the middle-end. Takes care of address modes and memory edges.
+ * operation on @p op. Takes care of address modes and memory edges.
  *
  * @param node    The unlowered firm IR middle-end node.
- * @param op_pos  The index of the input operand in the middle-end node.
+ * @param op      The input operand.
  * @param gen     The constructor function that actually creates the node.
  * @param pn_res  The index where the node for the builtin stores its result.
  */
-static ir_node *gen_unop_out(ir_node *const node, int op_pos,
-                             unop_out_constructor gen, unsigned pn_res)
+static ir_node *gen_unop_out_value(ir_node *const node, ir_node *const op,
+                                   unop_out_constructor gen, unsigned pn_res)
 {
 	dbg_info        *const dbgi      = get_irn_dbg_info(node);
 	ir_node         *const block     = get_nodes_block(node);
-	ir_node         *const op        = get_irn_n(node, op_pos);
 	ir_mode         *const op_mode   = get_irn_mode(op);
 	ir_node         *const new_block = be_transform_nodes_block(node);
 	x86_insn_size_t  const size      = x86_size_from_mode(op_mode);
@@ -1408,6 +1606,21 @@ static ir_node *gen_unop_out(ir_node *const node, int op_pos,
 	return be_new_Proj(new_node, pn_res);
 }
 
+/**
+ * Generates a back-end node with dedicated output register for a unary
+ * builtin node in the middle-end. Takes care of address modes and memory edges.
+ *
+ * @param node    The unlowered firm IR middle-end node.
+ * @param op_pos  The index of the input operand in the middle-end node.
+ * @param gen     The constructor function that actually creates the node.
+ * @param pn_res  The index where the node for the builtin stores its result.
+ */
+static ir_node *gen_unop_out(ir_node *const node, int op_pos,
+                             unop_out_constructor gen, unsigned pn_res)
+{
+	return gen_unop_out_value(node, get_irn_n(node, op_pos), gen, pn_res);
+}
+
 /** Create a floating point negation by switching the sign bit using a xor. */
 static ir_node *gen_float_neg(ir_node *const node)
 {
@@ -1432,6 +1645,13 @@ static ir_node *gen_float_neg(ir_node *const node)
 			},
 		},
 	};
+	if (amd64_cg_config.use_avx) {
+		ir_node *const xor
+			= new_bd_amd64_vxorp(dbgi, new_block, ARRAY_SIZE(in), in,
+			                     amd64_xmm_xmm_reqs, &attr);
+		return be_new_Proj(xor, pn_amd64_vxorp_res);
+	}
+
 	ir_node *const xor
 		= new_bd_amd64_xorp(dbgi, new_block, ARRAY_SIZE(in), in,
 		                    amd64_xmm_xmm_reqs, &attr);
@@ -2135,6 +2355,198 @@ static ir_node *gen_Cond(ir_node *const node)
 	return new_bd_amd64_jcc(dbgi, block, flags, cc);
 }
 
+static ir_node *gen_cmov(ir_node *const node, ir_node *const sel,
+                         ir_node *const mux_false, ir_node *const mux_true)
+{
+	x86_condition_code_t  cc;
+	ir_node              *const flags     = get_flags_node(sel, &cc);
+	dbg_info             *const dbgi      = get_irn_dbg_info(node);
+	ir_node              *const new_block = be_transform_nodes_block(node);
+	ir_node              *const new_false = be_transform_node(mux_false);
+	ir_node              *const new_true  = be_transform_node(mux_true);
+	x86_insn_size_t       const size
+		= get_size_32_64_from_mode(get_irn_mode(node));
+
+	ir_node *res = new_bd_amd64_cmov(dbgi, new_block, new_false, new_true,
+	                                 flags, size, cc);
+	if (cc & x86_cc_float_parity_cases) {
+		/* An unordered compare sets the parity flag. A second cmov picks the
+		 * value the relation demands in this case. */
+		ir_node *const unordered = cc & x86_cc_negated ? new_true : new_false;
+		res = new_bd_amd64_cmov(dbgi, new_block, res, unordered, flags, size,
+		                        x86_cc_parity);
+	}
+	return res;
+}
+
+static ir_node *create_xmm_binop(dbg_info *const dbgi, ir_node *const block,
+                                 ir_node *const op0, ir_node *const op1,
+                                 x86_insn_size_t const size,
+                                 construct_binop_func const cons)
+{
+	ir_node *const in[] = { op0, op1 };
+	amd64_binop_addr_attr_t const attr = {
+		.base = {
+			.base = {
+				.op_mode = AMD64_OP_REG_REG,
+				.size    = size,
+			},
+			.addr = {
+				.base_input = 0,
+				.variant    = X86_ADDR_REG,
+			},
+		},
+		.u.reg_input = 1,
+	};
+	ir_node *const res = cons(dbgi, block, ARRAY_SIZE(in), in,
+	                          amd64_xmm_xmm_reqs, &attr);
+	/* leave room for a copy of op0, the operands are not commutative */
+	arch_set_irn_register_req_out(res, 0,
+	                              &amd64_requirement_xmm_same_0_not_1);
+	return be_new_Proj(res, pn_amd64_andp_res);
+}
+
+/**
+ * Selects the SSE compare predicate computing @p relation. Returns NULL if
+ * the relation has no predicate, sets @p swap if the operands of the compare
+ * must be exchanged.
+ */
+static construct_binop_func get_sse_cmp_func(ir_relation const relation,
+                                             bool *const swap)
+{
+	*swap = false;
+	switch (relation) {
+	case ir_relation_equal:                  return new_bd_amd64_cmpeqs;
+	case ir_relation_less:                   return new_bd_amd64_cmplts;
+	case ir_relation_less_equal:             return new_bd_amd64_cmples;
+	case ir_relation_unordered:              return new_bd_amd64_cmpunords;
+	case ir_relation_less_equal_greater:     return new_bd_amd64_cmpords;
+	case ir_relation_unordered_less_greater: return new_bd_amd64_cmpneqs;
+	case ir_relation_unordered_greater_equal: return new_bd_amd64_cmpnlts;
+	case ir_relation_unordered_greater:      return new_bd_amd64_cmpnles;
+	case ir_relation_greater:
+		*swap = true;
+		return new_bd_amd64_cmplts;
+	case ir_relation_greater_equal:
+		*swap = true;
+		return new_bd_amd64_cmples;
+	case ir_relation_unordered_less_equal:
+		*swap = true;
+		return new_bd_amd64_cmpnlts;
+	case ir_relation_unordered_less:
+		*swap = true;
+		return new_bd_amd64_cmpnles;
+	default:
+		return NULL;
+	}
+}
+
+static ir_node *gen_sse_binop(ir_node *const node, ir_mode *const mode,
+                              ir_node *const op1, ir_node *const op2,
+                              construct_binop_func const cons)
+{
+	dbg_info *const dbgi      = get_irn_dbg_info(node);
+	ir_node  *const block     = get_nodes_block(node);
+	ir_node  *const new_block = be_transform_node(block);
+
+	amd64_args_t args;
+	match_binop(&args, block, mode, op1, op2, match_am);
+
+	ir_node *const new_node = cons(dbgi, new_block, args.arity, args.in, args.reqs, &args.attr);
+
+	fix_node_mem_proj(new_node, args.mem_proj);
+
+	/* these operations are not commutative, see create_sse_div() */
+	arch_register_req_t const *const req = args.reqs == amd64_xmm_xmm_reqs
+		? &amd64_requirement_xmm_same_0_not_1
+		: &amd64_requirement_xmm_same_0;
+	arch_set_irn_register_req_out(new_node, 0, req);
+	return be_new_Proj(new_node, pn_amd64_mins_res);
+}
+
+static ir_node *gen_float_Mux(ir_node *const node, ir_node *const sel,
+                              ir_node *mux_false, ir_node *mux_true)
+{
+	ir_node    *const cmp_left  = get_Cmp_left(sel);
+	ir_node    *const cmp_right = get_Cmp_right(sel);
+	ir_relation       relation  = get_Cmp_relation(sel);
+
+	/* minss/maxss return their second operand if the compare is false, so
+	 * only the strict ordered relations match exactly. Turn the unordered
+	 * relations into those by negating the relation. */
+	if (relation & ir_relation_unordered) {
+		ir_node *const tmp = mux_false;
+		mux_false = mux_true;
+		mux_true  = tmp;
+		relation  = get_negated_relation(relation);
+	}
+	ir_mode *const mode = get_irn_mode(node);
+	if (relation == ir_relation_less || relation == ir_relation_greater) {
+		bool const is_min = relation == ir_relation_less;
+		if (cmp_left == mux_true && cmp_right == mux_false) {
+			/* Mux(a < b, a, b) => MIN, Mux(a > b, a, b) => MAX */
+			return gen_sse_binop(node, mode, cmp_left, cmp_right,
+			                     is_min ? new_bd_amd64_mins : new_bd_amd64_maxs);
+		} else if (cmp_left == mux_false && cmp_right == mux_true) {
+			/* Mux(a < b, b, a) => MAX, Mux(a > b, b, a) => MIN */
+			return gen_sse_binop(node, mode, cmp_right, cmp_left,
+			                     is_min ? new_bd_amd64_maxs : new_bd_amd64_mins);
+		}
+	}
+
+	/* mask = cmp(a, b); res = (mask & true) | (~mask & false) */
+	relation  = get_Cmp_relation(sel);
+	mux_false = get_Mux_false(node);
+	mux_true  = get_Mux_true(node);
+	bool                       swap;
+	construct_binop_func const cmp = get_sse_cmp_func(relation, &swap);
+	if (cmp == NULL)
+		panic("cannot transform floating point Mux %+F", node);
+
+	/* the mask has to cover the selected value */
+	ir_mode *const cmp_mode = get_irn_mode(cmp_left);
+	if (!mode_is_float(cmp_mode) || cmp_mode == x86_mode_E
+	 || get_mode_size_bits(cmp_mode) < get_mode_size_bits(mode))
+		panic("cannot transform floating point Mux %+F", node);
+	ir_node *const cmp_node = swap
+		? gen_sse_binop(sel, cmp_mode, cmp_right, cmp_left, cmp)
+		: gen_sse_binop(sel, cmp_mode, cmp_left, cmp_right, cmp);
+
+	dbg_info       *const dbgi      = get_irn_dbg_info(node);
+	ir_node        *const new_block = be_transform_nodes_block(node);
+	x86_insn_size_t const size      = x86_size_from_mode(mode);
+	if (is_irn_null(mux_false)) {
+		return create_xmm_binop(dbgi, new_block, cmp_node,
+		                        be_transform_node(mux_true), size,
+		                        new_bd_amd64_andp);
+	}
+	ir_node *const new_false = create_xmm_binop(dbgi, new_block, cmp_node,
+	                                            be_transform_node(mux_false),
+	                                            size, new_bd_amd64_andnp);
+	if (is_irn_null(mux_true))
+		return new_false;
+	ir_node *const new_true = create_xmm_binop(dbgi, new_block, cmp_node,
+	                                           be_transform_node(mux_true),
+	                                           size, new_bd_amd64_andp);
+	return create_xmm_binop(dbgi, new_block, new_true, new_false, size,
+	                        new_bd_amd64_orp);
+}
+
+static ir_node *gen_Mux(ir_node *const node)
+{
+	ir_node *const sel       = get_Mux_sel(node);
+	ir_node *const mux_false = get_Mux_false(node);
+	ir_node *const mux_true  = get_Mux_true(node);
+	ir_mode *const mode      = get_irn_mode(node);
+	if (mode_is_float(mode)) {
+		if (mode == x86_mode_E)
+			panic("cannot transform x87 Mux %+F", node);
+		return gen_float_Mux(node, sel, mux_false, mux_true);
+	}
+	assert(mode_needs_gp_reg(mode));
+	return gen_cmov(node, sel, mux_false, mux_true);
+}
+
 static ir_node *gen_ASM(ir_node *const node)
 {
 	return x86_match_ASM(node, &amd64_asm_constraints);
@@ -2616,6 +3028,27 @@ static ir_node *gen_Store(ir_node *const node)
 	return make_store_for_mode(mode, dbgi, block, arity, in, &attr, pinned);
 }
 
+static ir_node *gen_CopyB(ir_node *const node)
+{
+	dbg_info *const dbgi    = get_irn_dbg_info(node);
+	ir_node  *const block   = be_transform_nodes_block(node);
+	ir_node  *const new_dst = be_transform_node(get_CopyB_dst(node));
+	ir_node  *const new_src = be_transform_node(get_CopyB_src(node));
+	ir_node  *const new_mem = be_transform_node(get_CopyB_mem(node));
+	unsigned  const size    = get_type_size(get_CopyB_type(node));
+
+	/* Small copies were lowered to integer moves, large ones to memcpy. */
+	if (size <= amd64_cg_config.copyb_max_vector) {
+		ir_node *const copyb = new_bd_amd64_copyB_vec(dbgi, block, new_dst, new_src, new_mem, size);
+		return be_new_Proj(copyb, pn_amd64_copyB_vec_M);
+	}
+
+	assert(amd64_cg_config.use_erms);
+	ir_node *const count = make_const(dbgi, block, size);
+	ir_node *const copyb = new_bd_amd64_copyB(dbgi, block, new_dst, new_src, count, new_mem, size);
+	return be_new_Proj(copyb, pn_amd64_copyB_M);
+}
+
 static bool amd64_mode_needs_gp_reg(ir_mode *const mode)
 {
 	return be_mode_needs_gp_reg(mode) && mode != amd64_mode_xmm;
@@ -2903,6 +3336,10 @@ static ir_node *gen_Proj_Alloc(ir_node *const node)
 
 static ir_node *gen_clz(ir_node *const node)
 {
+	if (amd64_cg_config.use_lzcnt)
+		return gen_unop_out(node, n_Builtin_max + 1, new_bd_amd64_lzcnt,
+		                    pn_amd64_lzcnt_res);
+
 	// https://fgiesen.wordpress.com/2013/10/18/bit-scanning-equivalencies/
 	ir_node         *const bsr   = gen_unop_out(node, n_Builtin_max + 1,
 	                                            new_bd_amd64_bsr, pn_amd64_bsr_res);
@@ -2940,10 +3377,21 @@ static ir_node *gen_clz(ir_node *const node)
 
 static ir_node *gen_ctz(ir_node *const node)
 {
+	if (amd64_cg_config.use_bmi1)
+		return gen_unop_out(node, n_Builtin_max + 1, new_bd_amd64_tzcnt,
+		                    pn_amd64_tzcnt_res);
 	return gen_unop_out(node, n_Builtin_max + 1, new_bd_amd64_bsf,
 	                    pn_amd64_bsf_res);
 }
 
+static ir_node *gen_popcount(ir_node *const node)
+{
+	/* builtin lowerer should have replaced the popcount if !use_popcnt */
+	assert(amd64_cg_config.use_popcnt);
+	return gen_unop_out(node, n_Builtin_max + 1, new_bd_amd64_popcnt,
+	                    pn_amd64_popcnt_res);
+}
+
 static ir_node *gen_ffs(ir_node *const node)
 {
 	/* bsf input, result */
@@ -3066,6 +3514,217 @@ static ir_node *gen_compare_swap(ir_node *const node)
 	return new_bd_amd64_cmpxchg(dbgi, block, arity, in, reqs, &attr);
 }
 
+static ir_node *gen_atomic_xadd_xchg(ir_node *const node)
+{
+	dbg_info       *const dbgi    = get_irn_dbg_info(node);
+	ir_node        *const block   = be_transform_nodes_block(node);
+	ir_node        *const ptr     = get_Builtin_param(node, 0);
+	ir_node        *const val     = get_Builtin_param(node, 1);
+	ir_node        *const mem     = get_Builtin_mem(node);
+	ir_node        *const new_mem = be_transform_node(mem);
+	ir_mode        *const mode    = get_irn_mode(val);
+	ir_builtin_kind const kind    = get_Builtin_kind(node);
+	x86_insn_size_t const size    = x86_size_from_mode(mode);
+
+	ir_node *new_val = be_transform_node(val);
+	if (kind == ir_bk_atomic_fetch_sub) {
+		ir_node *const neg = new_bd_amd64_neg(dbgi, block, new_val, size);
+		new_val = be_new_Proj(neg, pn_amd64_neg_res);
+	}
+
+	/* the value is the first input, so the result can reuse its register */
+	ir_node *in[4];
+	int      arity = 0;
+	in[arity++] = new_val;
+	x86_addr_t addr;
+	perform_address_matching(ptr, &arity, in, &addr);
+	in[arity++] = new_mem;
+	assert((size_t)arity <= ARRAY_SIZE(in));
+
+	amd64_binop_addr_attr_t const attr = {
+		.base = {
+			.base = {
+				.op_mode = AMD64_OP_ADDR_REG,
+				.size    = size,
+			},
+			.addr = addr,
+		},
+		.u = {
+			.reg_input = 0,
+		},
+	};
+	arch_register_req_t const **const reqs = gp_am_reqs[arity - 1];
+	ir_node *const new_node
+		= kind == ir_bk_atomic_exchange || kind == ir_bk_atomic_store
+		? new_bd_amd64_xchg(dbgi, block, arity, in, reqs, &attr)
+		: new_bd_amd64_xadd(dbgi, block, arity, in, reqs, &attr);
+	/* the result must not clobber the address registers */
+	static arch_register_req_t const *const out_reqs[] = {
+		&amd64_requirement_gp_same_0,
+		&amd64_requirement_gp_same_0_not_1,
+		&amd64_requirement_gp_same_0_not_1_2,
+	};
+	arch_set_irn_register_req_out(new_node, 0, out_reqs[arity - 2]);
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	return new_node;
+}
+
+/**
+ * Transform atomic and/or/xor builtins. Their result must be unused, the
+ * ones with a used result have been lowered to compare-and-swap loops.
+ */
+static ir_node *gen_atomic_logic(ir_node *const node)
+{
+	dbg_info *const dbgi    = get_irn_dbg_info(node);
+	ir_node  *const block   = be_transform_nodes_block(node);
+	ir_node  *const ptr     = get_Builtin_param(node, 0);
+	ir_node  *const val     = get_Builtin_param(node, 1);
+	ir_node  *const mem     = get_Builtin_mem(node);
+	ir_node  *const new_mem = be_transform_node(mem);
+	ir_mode  *const mode    = get_irn_mode(val);
+
+	amd64_binop_addr_attr_t attr;
+	memset(&attr, 0, sizeof(attr));
+
+	ir_node *in[4];
+	int      arity = make_store_value(&attr, mode, val, in);
+	perform_address_matching(ptr, &arity, in, &attr.base.addr);
+	in[arity++] = new_mem;
+	assert((size_t)arity <= ARRAY_SIZE(in));
+	attr.base.base.size = x86_size_from_mode(mode);
+
+	construct_binop_func cons;
+	switch (get_Builtin_kind(node)) {
+	case ir_bk_atomic_fetch_and: cons = new_bd_amd64_lock_and; break;
+	case ir_bk_atomic_fetch_or:  cons = new_bd_amd64_lock_or;  break;
+	case ir_bk_atomic_fetch_xor: cons = new_bd_amd64_lock_xor; break;
+	default: panic("unexpected atomic builtin %+F", node);
+	}
+	ir_node *const new_node = cons(dbgi, block, arity, in, gp_am_reqs[arity - 1], &attr);
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	return new_node;
+}
+
+/**
+ * Transform an atomic load. Plain loads already have acquire semantics on
+ * x86, so no fence is needed for any memory order.
+ */
+static ir_node *gen_atomic_load(ir_node *const node)
+{
+	dbg_info *const dbgi    = get_irn_dbg_info(node);
+	ir_node  *const block   = be_transform_nodes_block(node);
+	ir_node  *const ptr     = get_Builtin_param(node, 0);
+	ir_node  *const mem     = get_Builtin_mem(node);
+	ir_node  *const new_mem = be_transform_node(mem);
+	ir_type  *const tp      = get_Builtin_type(node);
+	ir_mode  *const mode    = get_type_mode(get_method_res_type(tp, 0));
+	assert(mode_is_int(mode));
+
+	ir_node *in[3];
+	int      arity = 0;
+	x86_addr_t addr;
+	memset(&addr, 0, sizeof(addr));
+	perform_address_matching(ptr, &arity, in, &addr);
+	arch_register_req_t const **const reqs = gp_am_reqs[arity];
+	in[arity++] = new_mem;
+	assert((size_t)arity <= ARRAY_SIZE(in));
+
+	create_mov_func const cons
+		= get_mode_size_bits(mode) < 64 && mode_is_signed(mode)
+		? &new_bd_amd64_movs : &new_bd_amd64_mov_gp;
+	x86_insn_size_t const size     = x86_size_from_mode(mode);
+	ir_node        *const new_node = cons(dbgi, block, arity, in, reqs, size, AMD64_OP_ADDR, addr);
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	return new_node;
+}
+
+/**
+ * Transform an atomic store. Sequentially consistent stores use the
+ * implicitly locked xchg, weaker ones are plain stores.
+ */
+static ir_node *gen_atomic_store(ir_node *const node)
+{
+	if (get_Builtin_order(node) == ir_memory_order_seq_cst)
+		return gen_atomic_xadd_xchg(node);
+
+	dbg_info *const dbgi    = get_irn_dbg_info(node);
+	ir_node  *const block   = be_transform_nodes_block(node);
+	ir_node  *const ptr     = get_Builtin_param(node, 0);
+	ir_node  *const val     = get_Builtin_param(node, 1);
+	ir_node  *const mem     = get_Builtin_mem(node);
+	ir_node  *const new_mem = be_transform_node(mem);
+	ir_mode  *const mode    = get_irn_mode(val);
+	assert(mode_is_int(mode));
+
+	amd64_binop_addr_attr_t attr;
+	memset(&attr, 0, sizeof(attr));
+
+	ir_node *in[4];
+	int      arity = make_store_value(&attr, mode, val, in);
+	perform_address_matching(ptr, &arity, in, &attr.base.addr);
+	in[arity++] = new_mem;
+	assert((size_t)arity <= ARRAY_SIZE(in));
+	attr.base.base.size = x86_size_from_mode(mode);
+	bool const pinned = get_irn_pinned(node);
+	return make_store_for_mode(mode, dbgi, block, arity, in, &attr, pinned);
+}
+
+/**
+ * Transform an atomic fence. Only sequentially consistent fences need an
+ * instruction on x86, the weaker orders are implied by the memory model.
+ */
+static ir_node *gen_atomic_fence(ir_node *const node)
+{
+	ir_node *const new_mem = be_transform_node(get_Builtin_mem(node));
+	if (get_Builtin_order(node) != ir_memory_order_seq_cst)
+		return new_mem;
+
+	dbg_info *const dbgi  = get_irn_dbg_info(node);
+	ir_node  *const block = be_transform_nodes_block(node);
+	return new_bd_amd64_mfence(dbgi, block, new_mem);
+}
+
+/**
+ * Transform a prefetch builtin. The read/write hint is ignored, the
+ * locality selects the cache level.
+ */
+static ir_node *gen_prefetch(ir_node *const node)
+{
+	dbg_info *const dbgi    = get_irn_dbg_info(node);
+	ir_node  *const block   = be_transform_nodes_block(node);
+	ir_node  *const ptr     = get_Builtin_param(node, 0);
+	ir_node  *const new_mem = be_transform_node(get_Builtin_mem(node));
+	size_t    const n_params = get_Builtin_n_params(node);
+	long      const locality = n_params > 2 ? get_Const_long(get_Builtin_param(node, 2)) : 3;
+
+	ir_node *in[3];
+	int      arity = 0;
+	x86_addr_t addr;
+	memset(&addr, 0, sizeof(addr));
+	perform_address_matching(ptr, &arity, in, &addr);
+	arch_register_req_t const **const reqs = gp_am_reqs[arity];
+	in[arity++] = new_mem;
+	assert((size_t)arity <= ARRAY_SIZE(in));
+
+	ir_node *new_node;
+	switch (locality) {
+	case 0:
+		new_node = new_bd_amd64_prefetchnta(dbgi, block, arity, in, reqs, addr);
+		break;
+	case 1:
+		new_node = new_bd_amd64_prefetcht2(dbgi, block, arity, in, reqs, addr);
+		break;
+	case 2:
+		new_node = new_bd_amd64_prefetcht1(dbgi, block, arity, in, reqs, addr);
+		break;
+	default:
+		new_node = new_bd_amd64_prefetcht0(dbgi, block, arity, in, reqs, addr);
+		break;
+	}
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	return new_node;
+}
+
 static ir_node *gen_saturating_increment(ir_node *const node)
 {
 	dbg_info *const dbgi      = get_irn_dbg_info(node);
@@ -3144,12 +3803,30 @@ static ir_node *gen_Builtin(ir_node *const node)
 		return gen_ctz(node);
 	case ir_bk_ffs:
 		return gen_ffs(node);
+	case ir_bk_popcount:
+		return gen_popcount(node);
 	case ir_bk_compare_swap:
 		return gen_compare_swap(node);
 	case ir_bk_saturating_increment:
 		return gen_saturating_increment(node);
 	case ir_bk_va_start:
 		return gen_va_start(node);
+	case ir_bk_prefetch:
+		return gen_prefetch(node);
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_exchange:
+		return gen_atomic_xadd_xchg(node);
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+		return gen_atomic_logic(node);
+	case ir_bk_atomic_load:
+		return gen_atomic_load(node);
+	case ir_bk_atomic_store:
+		return gen_atomic_store(node);
+	case ir_bk_atomic_fence:
+		return gen_atomic_fence(node);
 	default:
 		break;
 	}
@@ -3167,6 +3844,7 @@ static ir_node *gen_Proj_Builtin(ir_node *const proj)
 	case ir_bk_ctz:
 	case ir_bk_ffs:
 	case ir_bk_parity:
+	case ir_bk_popcount:
 		return new_node;
 	case ir_bk_compare_swap:
 		assert(is_amd64_cmpxchg(new_node));
@@ -3181,6 +3859,42 @@ static ir_node *gen_Proj_Builtin(ir_node *const proj)
 	case ir_bk_va_start:
 		assert(get_Proj_num(proj) == pn_Builtin_M);
 		return new_node;
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_exchange:
+		if (is_amd64_xchg(new_node)) {
+			if (get_Proj_num(proj) == pn_Builtin_M)
+				return be_new_Proj(new_node, pn_amd64_xchg_M);
+			assert(get_Proj_num(proj) == pn_Builtin_max+1);
+			return be_new_Proj(new_node, pn_amd64_xchg_res);
+		}
+		assert(is_amd64_xadd(new_node));
+		if (get_Proj_num(proj) == pn_Builtin_M)
+			return be_new_Proj(new_node, pn_amd64_xadd_M);
+		assert(get_Proj_num(proj) == pn_Builtin_max+1);
+		return be_new_Proj(new_node, pn_amd64_xadd_res);
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+		assert(get_Proj_num(proj) == pn_Builtin_M);
+		assert((int)pn_amd64_lock_and_M == (int)pn_amd64_lock_or_M
+		    && (int)pn_amd64_lock_or_M == (int)pn_amd64_lock_xor_M);
+		return be_new_Proj(new_node, pn_amd64_lock_and_M);
+	case ir_bk_atomic_load:
+		if (get_Proj_num(proj) == pn_Builtin_M)
+			return be_new_Proj(new_node, pn_amd64_mem);
+		assert(get_Proj_num(proj) == pn_Builtin_max+1);
+		assert((int)pn_amd64_mov_gp_res == (int)pn_amd64_movs_res);
+		return be_new_Proj(new_node, pn_amd64_mov_gp_res);
+	case ir_bk_atomic_store:
+		assert(get_Proj_num(proj) == pn_Builtin_M);
+		if (is_amd64_xchg(new_node))
+			return be_new_Proj(new_node, pn_amd64_xchg_M);
+		return new_node;
+	case ir_bk_atomic_fence:
+	case ir_bk_prefetch:
+		assert(get_Proj_num(proj) == pn_Builtin_M);
+		return new_node;
 	default:
 		break;
 	}
@@ -3251,6 +3965,7 @@ static void amd64_register_transformers(void)
 	be_set_transform_function(op_Cond,              gen_Cond);
 	be_set_transform_function(op_Const,             gen_Const);
 	be_set_transform_function(op_Conv,              gen_Conv);
+	be_set_transform_function(op_CopyB,             gen_CopyB);
 	be_set_transform_function(op_Div,               gen_Div);
 	be_set_transform_function(op_Eor,               gen_Eor);
 	be_set_transform_function(op_IJmp,              gen_IJmp);
@@ -3261,6 +3976,7 @@ static void amd64_register_transformers(void)
 	be_set_transform_function(op_Mod,               gen_Mod);
 	be_set_transform_function(op_Mul,               gen_Mul);
 	be_set_transform_function(op_Mulh,              gen_Mulh);
+	be_set_transform_function(op_Mux,               gen_Mux);
 	be_set_transform_function(op_Not,               gen_Not);
 	be_set_transform_function(op_Or,                gen_Or);
 	be_set_transform_function(op_Phi,               gen_Phi);
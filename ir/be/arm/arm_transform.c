@@ -1406,6 +1406,15 @@ static ir_node *gen_Builtin(ir_node *node)
 	case ir_bk_may_alias:
 	case ir_bk_va_start:
 	case ir_bk_va_arg:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
+	case ir_bk_atomic_fence:
 		break;
 	}
 	panic("Builtin %s not implemented", get_builtin_kind_name(kind));
@@ -1443,6 +1452,15 @@ static ir_node *gen_Proj_Builtin(ir_node *proj)
 	case ir_bk_may_alias:
 	case ir_bk_va_start:
 	case ir_bk_va_arg:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
+	case ir_bk_atomic_fence:
 		break;
 	}
 	panic("Builtin %s not implemented", get_builtin_kind_name(kind));
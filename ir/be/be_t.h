@@ -17,6 +17,7 @@
 #include "be.h"
 #include "be_types.h"
 #include "firm_types.h"
+#include "irmemstat.h"
 #include "pmap.h"
 #include "timing.h"
 #include "irdump.h"
@@ -41,6 +42,8 @@ struct be_options_t {
 	bool do_verify;            /**< backend verify option */
 	char ilp_solver[128];      /**< the ilp solver name */
 	bool verbose_asm;          /**< dump verbose assembler */
+	char code_cache[1024];     /**< directory of the code cache, see becache.h */
+	int  code_cache_size;      /**< size limit of the code cache in MiB */
 };
 extern be_options_t be_options;
 
@@ -67,6 +70,12 @@ void be_after_irp_transform(const char *name);
 
 void be_check_verify_result(bool fine, ir_graph *irg);
 
+/**
+ * Returns the number of bytes the backend data of @p irg uses in subsystem
+ * @p kind, see ir_mem_stat_get_graph().
+ */
+size_t be_get_irg_mem_used(ir_graph const *irg, ir_mem_kind kind);
+
 /**
  * Initialize the backend. Must be run first in init_firm();
  */
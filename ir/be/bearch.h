@@ -268,6 +268,9 @@ struct arch_isa_if_t {
 	                                         necessary/recommended for any data
 	                                         type on the target. */
 	bool        pic_supported;
+	bool        code_cache_supported;   /**< The emitted code of a function
+	                                         only depends on its graph, see
+	                                         becache.h */
 
 	unsigned                     n_registers;        /**< number of registers */
 	arch_register_t       const *registers;          /**< register array */
@@ -293,7 +296,31 @@ struct arch_isa_if_t {
 
 	ir_jit_function_t* (*jit_compile)(ir_jit_segment_t *segment, ir_graph *irg);
 
-	void (*emit_function)(char *buffer, ir_jit_function_t *function);
+	/**
+	 * Writes @p function to @p buffer, to be executed at @p address, which
+	 * is @p buffer itself or another mapping of the same memory.
+	 */
+	void (*emit_function)(char *buffer, char const *address,
+	                      ir_jit_function_t *function);
+
+	/** Size of a lazy compilation stub, 0 if stubs are not supported. */
+	unsigned jit_stub_size;
+
+	/**
+	 * Writes a stub to @p buffer, which calls @p resolve with @p data and then
+	 * jumps to the address stored in @p slot.
+	 */
+	void (*emit_jit_stub)(char *buffer, void *data, void (*resolve)(void *data),
+	                      void const *const *slot);
+
+	/** Size of an entry point, 0 if entry points are not supported. */
+	unsigned jit_entry_size;
+
+	/**
+	 * Writes an entry point to @p buffer, which jumps to the address stored in
+	 * @p slot.
+	 */
+	void (*emit_jit_entry)(char *buffer, void const *const *slot);
 
 	/**
 	 * lowers current program for target. See the documentation for
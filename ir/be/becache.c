@@ -0,0 +1,359 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Content addressed cache for the assembler code of functions.
+ */
+#include "becache.h"
+
+#include "array.h"
+#include "be_t.h"
+#include "bearch.h"
+#include "bedwarf.h"
+#include "beemitter.h"
+#include "begnuas.h"
+#include "debug.h"
+#include "ident.h"
+#include "irio_t.h"
+#include "irprog_t.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "obst.h"
+#include "platform_t.h"
+#include "pmap.h"
+#include "target_t.h"
+#include "util.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_MAGIC     "libfirm code cache 1\n"
+#define CACHE_INDEX     "index"
+#define KEY_LENGTH      32
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** A 128 bit hash, made of two independent 64 bit hashes. */
+typedef struct cache_key_t {
+	uint64_t h0;
+	uint64_t h1;
+} cache_key_t;
+
+/** An entry of the cache index. */
+typedef struct cache_entry_t {
+	ident         *name;   /**< key as hex string, also the file name */
+	unsigned long  size;   /**< size of the file in bytes */
+	unsigned long  stamp;  /**< index generation of the last use */
+} cache_entry_t;
+
+static struct {
+	bool           enabled;
+	bool           recording;      /**< code of a function is recorded */
+	FILE          *scratch;        /**< holds the text of graphs to hash */
+	cache_key_t    fingerprint;    /**< hash of target and options */
+	long           max_entity_nr;  /**< entities above are created by the
+	                                    backend */
+	pmap          *index;          /**< maps names to cache_entry_t */
+	unsigned long  stamp;          /**< current index generation */
+	struct obstack obst;           /**< index entries */
+	struct obstack code_obst;      /**< recorded code */
+	char           name[KEY_LENGTH + 1];
+	char           scope[KEY_LENGTH / 2 + 1];
+	unsigned       n_hits;
+	unsigned       n_misses;
+} cache;
+
+static void hash_bytes(cache_key_t *const key, void const *const data,
+                       size_t const size)
+{
+	unsigned char const *const bytes = (unsigned char const*)data;
+	uint64_t h0 = key->h0;
+	uint64_t h1 = key->h1;
+	for (size_t i = 0; i < size; ++i) {
+		/* FNV-1a */
+		h0 = (h0 ^ bytes[i]) * UINT64_C(0x100000001b3);
+		/* multiplicative hash with a xorshift */
+		h1  = (h1 + bytes[i] + 1) * UINT64_C(0x9e3779b97f4a7c15);
+		h1 ^= h1 >> 29;
+	}
+	key->h0 = h0;
+	key->h1 = h1;
+}
+
+/** Hashes everything written to the scratch file since rewinding it. */
+static bool hash_scratch(cache_key_t *const key)
+{
+	FILE *const f    = cache.scratch;
+	long  const size = ftell(f);
+	if (size < 0 || fflush(f) != 0)
+		return false;
+	rewind(f);
+
+	char buf[4096];
+	for (long left = size; left > 0;) {
+		size_t const n    = (size_t)MIN(left, (long)sizeof(buf));
+		size_t const read = fread(buf, 1, n, f);
+		if (read != n)
+			return false;
+		hash_bytes(key, buf, n);
+		left -= n;
+	}
+	rewind(f);
+	return true;
+}
+
+static void write_fingerprint(FILE *const f)
+{
+	fprintf(f, "%u.%u.%u %s\n", ir_get_version_major(),
+	        ir_get_version_minor(), ir_get_version_micro(),
+	        ir_get_version_revision());
+	fprintf(f, "%s %d %d %d %d %d %d %d %d %d\n", ir_target.isa->name,
+	        (int)ir_platform.object_format, (int)ir_platform.pic_style,
+	        ir_platform.user_label_prefix, (int)ir_platform.is_darwin,
+	        (int)ir_platform.amd64_x64abi, (int)ir_platform.ia32_struct_in_regs,
+	        (int)ir_platform.ia32_po2_stackalign,
+	        (int)ir_platform.long_double_size, (int)ir_platform.x87_long_double);
+	lc_opt_entry_t *const be_grp = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_print_help_for_entry(be_grp, '-', f);
+}
+
+typedef char path_t[sizeof(be_options.code_cache) + KEY_LENGTH + 8];
+
+static char const *get_path(path_t path, char const *const name,
+                            char const *const suffix)
+{
+	snprintf(path, sizeof(path_t), "%s/%s%s", be_options.code_cache, name,
+	         suffix);
+	return path;
+}
+
+static cache_entry_t *get_entry(char const *const name)
+{
+	ident         *const id    = new_id_from_str(name);
+	cache_entry_t       *entry = pmap_get(cache_entry_t, cache.index, id);
+	if (entry == NULL) {
+		entry       = OALLOCZ(&cache.obst, cache_entry_t);
+		entry->name = id;
+		pmap_insert(cache.index, id, entry);
+	}
+	return entry;
+}
+
+/** Reads the index file and merges it into the index in memory. */
+static void read_index(void)
+{
+	path_t      path;
+	FILE *const f = fopen(get_path(path, CACHE_INDEX, ""), "r");
+	if (f == NULL)
+		return;
+
+	char          name[KEY_LENGTH + 1];
+	unsigned long size;
+	unsigned long stamp;
+	while (fscanf(f, "%32s %lu %lu", name, &size, &stamp) == 3) {
+		cache_entry_t *const entry = get_entry(name);
+		entry->size  = size;
+		entry->stamp = MAX(entry->stamp, stamp);
+		cache.stamp  = MAX(cache.stamp, stamp);
+	}
+	fclose(f);
+}
+
+static int cmp_entry_stamp(void const *const a, void const *const b)
+{
+	cache_entry_t const *const ea = *(cache_entry_t const**)a;
+	cache_entry_t const *const eb = *(cache_entry_t const**)b;
+	return QSORT_CMP(ea->stamp, eb->stamp);
+}
+
+/** Writes @p size bytes of @p data to the file @p name atomically. */
+static bool write_file(char const *const name, char const *const header,
+                       void const *const data, size_t const size)
+{
+	path_t            path_buf;
+	path_t            tmp_buf;
+	char const *const path = get_path(path_buf, name, "");
+	char const *const tmp  = get_path(tmp_buf, name, ".tmp");
+
+	/* Another compiler may write the same file, so create it exclusively. */
+	FILE *const f = fopen(tmp, "wbx");
+	if (f == NULL)
+		return false;
+	bool ok = fputs(header, f) >= 0 && fwrite(data, 1, size, f) == size;
+	ok &= fclose(f) == 0;
+	if (ok && rename(tmp, path) != 0) {
+		/* rename does not replace existing files everywhere */
+		remove(path);
+		ok = rename(tmp, path) == 0;
+	}
+	if (!ok)
+		remove(tmp);
+	return ok;
+}
+
+/** Evicts the least recently used entries and writes the index file. */
+static void write_index(void)
+{
+	/* entries added by other compilers in the meantime */
+	read_index();
+
+	cache_entry_t **entries = NEW_ARR_F(cache_entry_t*, 0);
+	unsigned long   total   = 0;
+	foreach_pmap(cache.index, e) {
+		cache_entry_t *const entry = (cache_entry_t*)e->value;
+		ARR_APP1(cache_entry_t*, entries, entry);
+		total += entry->size;
+	}
+	size_t const n_entries = ARR_LEN(entries);
+	QSORT(entries, n_entries, cmp_entry_stamp);
+
+	unsigned long const limit = (unsigned long)MAX(be_options.code_cache_size, 0)
+	                          * 1024 * 1024;
+	size_t first = 0;
+	for (; first < n_entries && total > limit; ++first) {
+		cache_entry_t *const entry = entries[first];
+		path_t path;
+		remove(get_path(path, get_id_str(entry->name), ""));
+		total -= entry->size;
+		DB((dbg, LEVEL_2, "evicted %s\n", get_id_str(entry->name)));
+	}
+
+	for (size_t i = first; i < n_entries; ++i) {
+		cache_entry_t const *const entry = entries[i];
+		obstack_printf(&cache.code_obst, "%s %lu %lu\n",
+		               get_id_str(entry->name), entry->size, entry->stamp);
+	}
+	size_t const size = obstack_object_size(&cache.code_obst);
+	char  *const text = (char*)obstack_finish(&cache.code_obst);
+	write_file(CACHE_INDEX, "", text, size);
+	obstack_free(&cache.code_obst, text);
+	DEL_ARR_F(entries);
+}
+
+void be_cache_begin(void)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.be.cache");
+
+	memset(&cache, 0, sizeof(cache));
+	if (be_options.code_cache[0] == '\0'
+	 || !ir_target.isa->code_cache_supported
+	 || ir_platform.object_format != OBJECT_FORMAT_ELF
+	 || be_options.opt_profile_generate || be_options.opt_profile_use
+	 || be_dwarf_enabled())
+		return;
+
+	cache.scratch = tmpfile();
+	if (cache.scratch == NULL)
+		return;
+
+	write_fingerprint(cache.scratch);
+	if (!hash_scratch(&cache.fingerprint)) {
+		fclose(cache.scratch);
+		return;
+	}
+
+	obstack_init(&cache.obst);
+	obstack_init(&cache.code_obst);
+	cache.index         = pmap_create();
+	cache.max_entity_nr = irp->max_node_nr;
+	cache.enabled       = true;
+	read_index();
+	++cache.stamp;
+}
+
+void be_cache_finish(void)
+{
+	if (!cache.enabled)
+		return;
+	assert(!cache.recording);
+
+	write_index();
+	DB((dbg, LEVEL_1, "%u hits, %u misses\n", cache.n_hits, cache.n_misses));
+
+	fclose(cache.scratch);
+	pmap_destroy(cache.index);
+	obstack_free(&cache.code_obst, NULL);
+	obstack_free(&cache.obst, NULL);
+	cache.enabled = false;
+}
+
+/** Emits the cached code in file @p name. */
+static bool emit_cached(char const *const name)
+{
+	path_t      path;
+	FILE *const f = fopen(get_path(path, name, ""), "rb");
+	if (f == NULL)
+		return false;
+
+	char buf[4096];
+	for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) != 0;)
+		obstack_grow(&cache.code_obst, buf, n);
+	bool   const ok   = !ferror(f);
+	size_t const size = obstack_object_size(&cache.code_obst);
+	char  *const text = (char*)obstack_finish(&cache.code_obst);
+	fclose(f);
+
+	size_t const magic_len = sizeof(CACHE_MAGIC) - 1;
+	bool   const valid     = ok && size >= magic_len
+	                      && memcmp(text, CACHE_MAGIC, magic_len) == 0;
+	if (valid)
+		be_gas_emit_reused_function(text + magic_len, size - magic_len);
+	obstack_free(&cache.code_obst, text);
+	return valid;
+}
+
+bool be_cache_lookup(ir_graph *const irg)
+{
+	if (!cache.enabled)
+		return false;
+
+	rewind(cache.scratch);
+	cache_key_t key = cache.fingerprint;
+	if (!write_irg_stable(cache.scratch, irg) || !hash_scratch(&key)) {
+		DB((dbg, LEVEL_2, "%+F can not be cached\n", irg));
+		return false;
+	}
+	snprintf(cache.name, sizeof(cache.name), "%016" PRIx64 "%016" PRIx64,
+	         key.h0, key.h1);
+
+	if (emit_cached(cache.name)) {
+		DB((dbg, LEVEL_2, "hit for %+F (%s)\n", irg, cache.name));
+		get_entry(cache.name)->stamp = cache.stamp;
+		++cache.n_hits;
+		return true;
+	}
+
+	DB((dbg, LEVEL_2, "miss for %+F (%s)\n", irg, cache.name));
+	++cache.n_misses;
+	cache.recording = true;
+	be_emit_begin_capture(&cache.code_obst);
+	/* half of the key is unique enough to separate block labels */
+	snprintf(cache.scope, sizeof(cache.scope), "%016" PRIx64, key.h0);
+	be_gas_begin_reusable_function(cache.scope, cache.max_entity_nr);
+	return false;
+}
+
+void be_cache_store(ir_graph *const irg)
+{
+	if (!cache.recording)
+		return;
+	cache.recording = false;
+
+	be_emit_end_capture();
+	bool   const reusable = be_gas_end_reusable_function();
+	size_t const size     = obstack_object_size(&cache.code_obst);
+	char  *const text     = (char*)obstack_finish(&cache.code_obst);
+	if (!reusable) {
+		DB((dbg, LEVEL_2, "%+F references code generation entities\n", irg));
+	} else if (write_file(cache.name, CACHE_MAGIC, text, size)) {
+		cache_entry_t *const entry = get_entry(cache.name);
+		entry->size  = size + sizeof(CACHE_MAGIC) - 1;
+		entry->stamp = cache.stamp;
+	}
+	obstack_free(&cache.code_obst, text);
+}
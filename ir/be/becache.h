@@ -0,0 +1,45 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Content addressed cache for the assembler code of functions.
+ *
+ * A function is identified by a hash of a stable textual form of its graph
+ * (see write_irg_stable()), the target, the backend options and the libFirm
+ * version.  If the cache directory contains code for the hash, the code is
+ * emitted and the backend is skipped for the function.  Otherwise the emitted
+ * code is recorded and stored, unless it references labels or entities, which
+ * were created during code generation.
+ *
+ * The cache is enabled with the backend option cachedir and limited to
+ * cachesize MiB, least recently used functions are evicted first.  It is only
+ * used for targets, whose emitted code only depends on the graph, and without
+ * debug information or profiling.
+ */
+#ifndef FIRM_BE_BECACHE_H
+#define FIRM_BE_BECACHE_H
+
+#include <stdbool.h>
+#include "firm_types.h"
+
+/** Opens the code cache for a compilation unit. */
+void be_cache_begin(void);
+
+/** Writes the index of the code cache and evicts old entries. */
+void be_cache_finish(void);
+
+/**
+ * Looks up the code of @p irg.  On a hit the code is emitted, otherwise the
+ * code emitted until be_cache_store() is recorded.
+ *
+ * @return true if the code was found in the cache
+ */
+bool be_cache_lookup(ir_graph *irg);
+
+/** Stores the code of @p irg recorded since be_cache_lookup(). */
+void be_cache_store(ir_graph *irg);
+
+#endif
@@ -29,6 +29,7 @@
 static int      time_limit = 60;
 static bool     solve_log  = false;
 static unsigned dump_flags = 0;
+static bool     seed_heur4 = false;
 
 static const lc_opt_enum_mask_items_t dump_items[] = {
 	{ "ilp", DUMP_ILP },
@@ -43,6 +44,7 @@ static const lc_opt_table_entry_t options[] = {
 	LC_OPT_ENT_INT      ("limit", "time limit for solving in seconds (0 for unlimited)", &time_limit),
 	LC_OPT_ENT_BOOL     ("log",   "show ilp solving log", &solve_log),
 	LC_OPT_ENT_ENUM_MASK("dump",  "dump flags", &dump_var),
+	LC_OPT_ENT_BOOL     ("heur4", "start the solver from the heur4 coalescing", &seed_heur4),
 	LC_OPT_LAST
 };
 
@@ -185,6 +187,11 @@ static void sr_reinsert(ilp_env_t *const ienv)
 
 ilp_env_t *new_ilp_env(copy_opt_t *const co, ilp_callback const build, ilp_callback const apply, void *const env)
 {
+	/* The formulations use the current coloring as start solution, so
+	 * coalesce heuristically first to give the solver a good incumbent. */
+	if (seed_heur4)
+		co_solve_heuristic_mst(co);
+
 	ilp_env_t *const res = XMALLOC(ilp_env_t);
 	res->co       = co;
 	res->build    = build;
@@ -63,6 +63,13 @@ int co_get_lower_bound(const copy_opt_t *co);
  */
 bool co_gs_is_optimizable(copy_opt_t const *co, ir_node *irn);
 
+/**
+ * Runs the heur4 (mst safe) coalescing heuristic on @p co and assigns the
+ * resulting registers.
+ * Uses the GRAPH data structure
+ */
+int co_solve_heuristic_mst(copy_opt_t *co);
+
 typedef struct unit_t {
 	struct list_head units;            /**< chain for all units */
 	int              node_count;       /**< size of the nodes array */
@@ -11,11 +11,14 @@
  */
 #include "beemitter.h"
 
+#include <assert.h>
+
 #include "irprintf.h"
 #include "panic.h"
 
-static FILE    *emit_file;
-struct obstack  emit_obst;
+static FILE           *emit_file;
+static struct obstack *capture_obst;
+struct obstack         emit_obst;
 
 void be_emit_init(FILE *file)
 {
@@ -46,5 +49,18 @@ void be_emit_write_line(void)
 	size_t const len  = obstack_object_size(&emit_obst);
 	char  *const line = (char*)obstack_finish(&emit_obst);
 	fwrite(line, 1, len, emit_file);
+	if (capture_obst != NULL)
+		obstack_grow(capture_obst, line, len);
 	obstack_free(&emit_obst, line);
 }
+
+void be_emit_begin_capture(struct obstack *const obst)
+{
+	assert(capture_obst == NULL);
+	capture_obst = obst;
+}
+
+void be_emit_end_capture(void)
+{
+	capture_obst = NULL;
+}
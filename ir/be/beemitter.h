@@ -90,6 +90,16 @@ void be_emit_irvprintf(const char *fmt, va_list args);
  */
 void be_emit_write_line(void);
 
+/**
+ * Start copying all lines written to the emitter file to @p obst as well.
+ */
+void be_emit_begin_capture(struct obstack *obst);
+
+/**
+ * Stop copying lines started by be_emit_begin_capture().
+ */
+void be_emit_end_capture(void);
+
 /** Return column in current line. Counting starts at 0. */
 static inline size_t be_emit_get_column(void)
 {
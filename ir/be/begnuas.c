@@ -39,6 +39,14 @@ static be_gas_section_t current_section = (be_gas_section_t) -1;
 static pmap            *block_numbers;
 static unsigned         next_block_nr;
 
+/** State of a function emitted by be_gas_begin_reusable_function(). */
+static struct {
+	char const *scope;           /**< prefix of block labels, NULL if none */
+	long        max_entity_nr;   /**< entities above are not reusable */
+	unsigned    saved_block_nr;  /**< next_block_nr outside of the function */
+	bool        reusable;
+} reusable;
+
 static bool is_macho(void)
 {
 	return ir_platform.object_format == OBJECT_FORMAT_MACH_O;
@@ -1295,6 +1303,11 @@ static bool check_needs_quotes(char const *const s)
 
 void be_gas_emit_entity(const ir_entity *entity)
 {
+	if (reusable.scope != NULL
+	 && (entity->kind == IR_ENTITY_LABEL
+	  || get_entity_nr(entity) > reusable.max_entity_nr))
+		reusable.reusable = false;
+
 	if (entity->kind == IR_ENTITY_LABEL) {
 		ir_label_t label = get_entity_label(entity);
 		be_emit_irprintf("%s_%lu", be_gas_get_private_prefix(), label);
@@ -1326,10 +1339,44 @@ void be_gas_emit_block_name(const ir_node *block)
 		} else {
 			nr = PTR_TO_INT(nr_val) - 1;
 		}
-		be_emit_irprintf("%s%d", be_gas_get_private_prefix(), nr);
+		if (reusable.scope != NULL) {
+			be_emit_irprintf("%s%s_%d", be_gas_get_private_prefix(),
+			                 reusable.scope, nr);
+		} else {
+			be_emit_irprintf("%s%d", be_gas_get_private_prefix(), nr);
+		}
 	}
 }
 
+void be_gas_begin_reusable_function(char const *const scope,
+                                    long const max_entity_nr)
+{
+	assert(reusable.scope == NULL);
+	reusable.scope          = scope;
+	reusable.max_entity_nr  = max_entity_nr;
+	reusable.saved_block_nr = next_block_nr;
+	reusable.reusable       = true;
+	next_block_nr   = 0;
+	current_section = (be_gas_section_t)-1;
+}
+
+void be_gas_emit_reused_function(char const *const text, size_t const len)
+{
+	be_emit_string_len(text, len);
+	be_emit_write_line();
+	current_section = (be_gas_section_t)-1;
+}
+
+bool be_gas_end_reusable_function(void)
+{
+	assert(reusable.scope != NULL);
+	reusable.scope  = NULL;
+	next_block_nr   = reusable.saved_block_nr;
+	/* the section after a reused function is unknown */
+	current_section = (be_gas_section_t)-1;
+	return reusable.reusable;
+}
+
 static bool block_needs_label(ir_node const *const block)
 {
 	if (get_Block_entity(block))
@@ -81,6 +81,32 @@ char const *be_gas_get_private_prefix(void);
  */
 void be_gas_emit_entity(const ir_entity *entity);
 
+/**
+ * Starts emitting a function, whose output may be reused in a later
+ * compilation unit.  Block labels are made unique by @p scope instead of a
+ * counter of the compilation unit and the output does not depend on the
+ * section of the previous function.
+ *
+ * @param scope            a name, which is unique for the function
+ * @param max_entity_nr    the highest number of an entity, which exists
+ *                         independently of code generation
+ */
+void be_gas_begin_reusable_function(char const *scope, long max_entity_nr);
+
+/**
+ * Ends a function started by be_gas_begin_reusable_function().
+ *
+ * @return whether the output is reusable, which is not the case if it
+ *         references labels or entities created during code generation
+ */
+bool be_gas_end_reusable_function(void);
+
+/**
+ * Emits the output of a function recorded between
+ * be_gas_begin_reusable_function() and be_gas_end_reusable_function().
+ */
+void be_gas_emit_reused_function(char const *text, size_t len);
+
 /**
  * Emit (a private) symbol name for a firm block
  */
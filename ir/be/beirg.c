@@ -11,6 +11,7 @@
  */
 #include "beirg.h"
 
+#include "be_t.h"
 #include "belive.h"
 #include "execfreq.h"
 
@@ -47,3 +48,18 @@ void be_free_birg(ir_graph *irg)
 	obstack_free(&birg->obst, NULL);
 	irg->be_data = NULL;
 }
+
+size_t be_get_irg_mem_used(ir_graph const *const irg, ir_mem_kind const kind)
+{
+	be_irg_t *const birg = be_birg_from_irg(irg);
+	if (birg == NULL)
+		return 0;
+	switch (kind) {
+	case ir_mem_backend:
+		return obstack_memory_used(&birg->obst);
+	case ir_mem_liveness:
+		return birg->lv != NULL ? obstack_memory_used(&birg->lv->obst) : 0;
+	default:
+		return 0;
+	}
+}
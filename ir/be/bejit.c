@@ -14,11 +14,14 @@
 #include "array.h"
 #include "beemitter.h"
 #include "begnuas.h"
+#include "bejitheap.h"
 #include "bitfiddle.h"
 #include "compiler.h"
 #include "entity_t.h"
 #include "obst.h"
 #include "panic.h"
+#include "pmap.h"
+#include "target_t.h"
 #include <assert.h>
 #include <limits.h>
 
@@ -48,11 +51,23 @@ typedef struct fragment_info_t {
 } fragment_info_t;
 
 struct ir_jit_segment_t {
-	struct obstack code_obst;
-	struct obstack fragment_info_obst;
-	struct obstack fragment_info_arr_obst;
+	struct obstack    code_obst;
+	struct obstack    fragment_info_obst;
+	struct obstack    fragment_info_arr_obst;
+	struct obstack    stub_obst;
+	ir_jit_resolver_t resolver;
+	void             *resolver_data;
+	jit_heap_t        heap;
+	pmap             *entry_slots; /**< entity -> slot of its entry point */
 };
 
+/** A lazy compilation stub, see be_jit_emit_stub(). */
+typedef struct jit_stub_t {
+	ir_jit_segment_t *segment;
+	ir_entity        *entity;
+	void const      **slot;    /**< slot of the entry point of the entity */
+} jit_stub_t;
+
 struct ir_jit_function_t {
 	unsigned          size;
 	unsigned          n_fragments;
@@ -70,6 +85,9 @@ ir_jit_segment_t *be_new_jit_segment(void)
 	obstack_init(&segment->code_obst);
 	obstack_init(&segment->fragment_info_obst);
 	obstack_init(&segment->fragment_info_arr_obst);
+	obstack_init(&segment->stub_obst);
+	jit_heap_init(&segment->heap);
+	segment->entry_slots = pmap_create();
 	return segment;
 }
 
@@ -78,6 +96,9 @@ void be_destroy_jit_segment(ir_jit_segment_t *segment)
 	obstack_free(&segment->code_obst, NULL);
 	obstack_free(&segment->fragment_info_obst, NULL);
 	obstack_free(&segment->fragment_info_arr_obst, NULL);
+	obstack_free(&segment->stub_obst, NULL);
+	jit_heap_destroy(&segment->heap);
+	pmap_destroy(segment->entry_slots);
 	free(segment);
 }
 
@@ -93,6 +114,110 @@ void const *be_jit_get_entity_addr(ir_entity const *const entity)
 	return entity->attr.global.jit_addr;
 }
 
+void be_jit_set_resolver(ir_jit_segment_t *const segment,
+                         ir_jit_resolver_t const resolver, void *const data)
+{
+	segment->resolver      = resolver;
+	segment->resolver_data = data;
+}
+
+int be_jit_supports_stubs(void)
+{
+	return ir_target.isa->jit_stub_size != 0;
+}
+
+/** Makes the entry point using @p slot jump to @p code. */
+static void set_slot(void const **const slot, void const *const code)
+{
+	/* The entry point jumps through the slot, so a single store redirects all
+	 * callers. */
+#if defined(_MSC_VER)
+	_InterlockedExchangePointer((void *volatile*)slot, (void*)code);
+#else
+	__atomic_store_n(slot, code, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Creates the entry point of @p entity jumping to @p code and returns its
+ * slot.
+ */
+static void const **new_entry(ir_jit_segment_t *const segment,
+                              ir_entity *const entity, void const *const code)
+{
+	assert(!pmap_contains(segment->entry_slots, entity));
+	unsigned const size = ir_target.isa->jit_entry_size;
+	assert(size != 0);
+	void const **const slot = OALLOC(&segment->stub_obst, void const*);
+	*slot = code;
+	char       *buffer;
+	char *const entry = jit_heap_alloc(&segment->heap, size, &buffer);
+	ir_target.isa->emit_jit_entry(buffer, slot);
+	jit_heap_seal(&segment->heap, entry);
+	pmap_insert(segment->entry_slots, entity, slot);
+	be_jit_set_entity_addr(entity, entry);
+	return slot;
+}
+
+/**
+ * Called by a stub on its first execution: materializes the entity and
+ * makes its entry point jump to the code.
+ */
+static void resolve_stub(void *const data)
+{
+	jit_stub_t       *const stub    = (jit_stub_t*)data;
+	ir_jit_segment_t *const segment = stub->segment;
+	ir_entity        *const entity  = stub->entity;
+	void const *const address = segment->resolver(entity,
+	                                              segment->resolver_data);
+	if (address == NULL)
+		panic("Could not materialize %+F", entity);
+
+	set_slot(stub->slot, address);
+}
+
+void be_jit_emit_stub(ir_jit_segment_t *const segment, ir_entity *const entity)
+{
+	unsigned const size = ir_target.isa->jit_stub_size;
+	assert(size != 0);
+	assert(segment->resolver != NULL);
+
+	char       *buffer;
+	char *const code = jit_heap_alloc(&segment->heap, size, &buffer);
+	jit_stub_t *const stub = OALLOC(&segment->stub_obst, jit_stub_t);
+	stub->segment = segment;
+	stub->entity  = entity;
+	stub->slot    = new_entry(segment, entity, code);
+	ir_target.isa->emit_jit_stub(buffer, stub, resolve_stub, stub->slot);
+	jit_heap_seal(&segment->heap, code);
+}
+
+void const *be_jit_install_function(ir_jit_segment_t *const segment,
+                                    ir_jit_function_t *const function)
+{
+	char       *buffer;
+	char *const code = jit_heap_alloc(&segment->heap, function->size, &buffer);
+	ir_target.isa->emit_function(buffer, code, function);
+	jit_heap_seal(&segment->heap, code);
+	return code;
+}
+
+void be_jit_free_function(ir_jit_segment_t *const segment,
+                          void const *const code)
+{
+	jit_heap_free(&segment->heap, code);
+}
+
+void be_jit_set_entry(ir_jit_segment_t *const segment, ir_entity *const entity,
+                      void const *const code)
+{
+	void const **const slot = pmap_get(void const*, segment->entry_slots, entity);
+	if (slot != NULL)
+		set_slot(slot, code);
+	else
+		new_entry(segment, entity, code);
+}
+
 void be_jit_begin_function(ir_jit_segment_t *const segment)
 {
 	assert(obstack_object_size(&segment->code_obst) == 0);
@@ -256,16 +381,18 @@ static unsigned emit_relocation(ir_jit_function_t const *const function,
                                 relocation_t const *const relocation,
                                 unsigned const relocation_address,
                                 char *const relocation_abs,
+                                char const *const relocation_exec,
                                 emit_relocation_func const emit)
 {
 	switch (relocation->dest_kind) {
 	case RELOC_DEST_CODE_FRAGMENT: {
 		int32_t const dest = resolve_relocation_code(function, relocation,
 		                                             relocation_address);
-		return emit(relocation_abs, relocation->be_kind, NULL, dest);
+		return emit(relocation_abs, relocation_exec, relocation->be_kind, NULL,
+		            dest);
 	}
 	case RELOC_DEST_ENTITY:
-		return emit(relocation_abs, relocation->be_kind,
+		return emit(relocation_abs, relocation_exec, relocation->be_kind,
 		            relocation->dest.entity, relocation->dest_offset);
 	}
 	panic("Invalid relocation");
@@ -293,7 +420,8 @@ static void emit_fragment_as_asm(ir_jit_function_t const *const function,
 		emit_bytes_as_asm(b, fragment_code + offset);
 		unsigned const reloc_address = fragment_address + offset;
 		unsigned const reloc_size
-			= emit_relocation(function, relocation, reloc_address, NULL, emit);
+			= emit_relocation(function, relocation, reloc_address, NULL, NULL,
+			                  emit);
 		b = fragment_code + relocation->offset + reloc_size;
 	}
 	char const *const end = fragment_code + fragment->len;
@@ -324,6 +452,7 @@ void be_jit_emit_as_asm(ir_jit_function_t *const function,
 static void emit_fragment(ir_jit_function_t const *const function,
 						  fragment_info_t const *const fragment,
                           char const *const fragment_code, char *const buffer,
+                          char const *const address,
                           emit_relocation_func const emit)
 {
 	unsigned        const fragment_address = fragment->address;
@@ -340,7 +469,8 @@ static void emit_fragment(ir_jit_function_t const *const function,
 		b += len;
 		unsigned const reloc_address = fragment_address + offset;
 		unsigned const reloc_size
-			= emit_relocation(function, relocation, reloc_address, d, emit);
+			= emit_relocation(function, relocation, reloc_address, d,
+			                  address + (d - buffer), emit);
 		d += reloc_size;
 		b += reloc_size;
 		last_offset = offset + reloc_size;
@@ -350,7 +480,8 @@ static void emit_fragment(ir_jit_function_t const *const function,
 	memcpy(d, b, end-b);
 }
 
-void be_jit_emit_memory(char *const buffer, ir_jit_function_t *const function,
+void be_jit_emit_memory(char *const buffer, char const *const exec_address,
+                        ir_jit_function_t *const function,
                         be_jit_emit_interface_t const *const emitter)
 {
 	/* Copy fragments and resolve relocations. */
@@ -366,7 +497,7 @@ void be_jit_emit_memory(char *const buffer, ir_jit_function_t *const function,
 			emitter->nops(buffer + last_address, nop_bytes);
 
 		emit_fragment(function, fragment, code+orig_address, buffer+address,
-		              emitter->relocation);
+		              exec_address+address, emitter->relocation);
 
 		orig_address += fragment->len;
 		last_address = address + fragment->len;
@@ -18,8 +18,10 @@
 #include "jit.h"
 #include "obst.h"
 
-typedef unsigned (*emit_relocation_func) (char *buffer, uint8_t be_kind,
-                                          ir_entity *entity, int32_t offset);
+/** Writes a relocation to @p buffer, which is executed at @p address. */
+typedef unsigned (*emit_relocation_func) (char *buffer, char const *address,
+                                          uint8_t be_kind, ir_entity *entity,
+                                          int32_t offset);
 
 typedef struct be_jit_emit_interface_t {
 	/** create @p size of NOP instructions for alignment */
@@ -30,7 +32,12 @@ typedef struct be_jit_emit_interface_t {
 	emit_relocation_func relocation;
 } be_jit_emit_interface_t;
 
-void be_jit_emit_memory(char *buffer, ir_jit_function_t *function,
+/**
+ * Writes @p function to @p buffer.  Relocations are resolved for executing
+ * the code at @p exec_address, which may be a different mapping of @p buffer.
+ */
+void be_jit_emit_memory(char *buffer, char const *exec_address,
+                        ir_jit_function_t *function,
                         be_jit_emit_interface_t const *emitter);
 
 void be_jit_emit_as_asm(ir_jit_function_t *function, emit_relocation_func emit);
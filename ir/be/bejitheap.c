@@ -0,0 +1,394 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Executable memory for just in time compiled code.
+ *
+ * Small allocations are served from slabs, each of which is split into slots
+ * of one power of two size class.  Larger allocations get their own mapping.
+ * The bookkeeping lives outside of the executable memory, so freeing does not
+ * need to write to code pages.
+ *
+ * Where the system allows it, each slab is mapped twice from one memory
+ * object: once writable for emitting code and once executable.  So emitting
+ * a function never changes the protection of pages, which hold running
+ * functions.  Otherwise every allocation gets pages of its own, which are
+ * switched between writable and executable.
+ */
+#include "bejitheap.h"
+
+#include "array.h"
+#include "bitfiddle.h"
+#include "panic.h"
+#include "raw_bitset.h"
+#include "statev_t.h"
+#include "util.h"
+#include "xmalloc.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#define MIN_CLASS_LOG 5
+#define SLAB_SIZE     (64 * 1024)
+
+struct jit_slab_t {
+	char     *mem;        /**< executable mapping */
+	char     *writable;   /**< writable mapping of the same memory */
+	size_t    size;       /**< size of the mapping */
+	size_t    index;      /**< index in the slab array of the size class */
+	unsigned  slot_size;  /**< 0 for a slab holding a large allocation */
+	unsigned  n_slots;
+	unsigned  n_used;
+	unsigned *used;       /**< raw bitset of used slots */
+	unsigned *requested;  /**< requested size of each used slot */
+};
+
+static size_t page_size;
+
+static size_t get_page_size(void)
+{
+	if (page_size == 0) {
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		page_size = info.dwPageSize;
+#else
+		page_size = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+	return page_size;
+}
+
+static size_t round_up_pages(size_t const size)
+{
+	size_t const page = get_page_size();
+	return (size + page - 1) & ~(page - 1);
+}
+
+/**
+ * Maps @p size bytes twice, executable into @p slab->mem and writable into
+ * @p slab->writable.  Returns false if the system does not support this.
+ */
+static bool map_dual(jit_slab_t *const slab, size_t const size)
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+	int const fd = (int)syscall(SYS_memfd_create, "libfirm-jit", 1u /* MFD_CLOEXEC */);
+	if (fd < 0)
+		return false;
+	bool ok = false;
+	if (ftruncate(fd, (off_t)size) == 0) {
+		char *const exec = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED,
+		                        fd, 0);
+		if (exec != MAP_FAILED) {
+			char *const writable = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			                            MAP_SHARED, fd, 0);
+			if (writable != MAP_FAILED) {
+				slab->mem      = exec;
+				slab->writable = writable;
+				ok             = true;
+			} else {
+				munmap(exec, size);
+			}
+		}
+	}
+	close(fd);
+	return ok;
+#else
+	(void)slab;
+	(void)size;
+	return false;
+#endif
+}
+
+/** 1 if dual mappings work, 0 if not, -1 if not determined yet. */
+static int dual_mapping = -1;
+
+/** Returns whether slabs are mapped twice instead of switching protection. */
+static bool have_dual_mapping(void)
+{
+	if (dual_mapping < 0) {
+		jit_slab_t   probe;
+		size_t const size = get_page_size();
+		dual_mapping = map_dual(&probe, size);
+#ifndef _WIN32
+		if (dual_mapping) {
+			munmap(probe.mem, size);
+			munmap(probe.writable, size);
+		}
+#endif
+	}
+	return dual_mapping;
+}
+
+static void map_pages(jit_slab_t *const slab, size_t const size)
+{
+	if (have_dual_mapping()) {
+		if (!map_dual(slab, size))
+			panic("could not map %zu bytes of JIT code memory", size);
+		return;
+	}
+#ifdef _WIN32
+	char *const mem = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT,
+	                               PAGE_EXECUTE_READ);
+	if (mem == NULL)
+		panic("could not map %zu bytes of JIT code memory", size);
+#else
+	char *const mem = mmap(NULL, size, PROT_READ | PROT_EXEC,
+	                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		panic("could not map %zu bytes of JIT code memory", size);
+#endif
+	slab->mem      = mem;
+	slab->writable = mem;
+}
+
+static void unmap_pages(jit_slab_t const *const slab)
+{
+#ifdef _WIN32
+	VirtualFree(slab->mem, 0, MEM_RELEASE);
+#else
+	munmap(slab->mem, slab->size);
+	if (slab->writable != slab->mem)
+		munmap(slab->writable, slab->size);
+#endif
+}
+
+/** Switches the pages overlapping [@p mem, @p mem + @p size) between writable
+ * and executable. */
+static void protect(char *const mem, size_t const size, bool const writable)
+{
+	size_t const page  = get_page_size();
+	char  *const begin = (char*)((uintptr_t)mem & ~(uintptr_t)(page - 1));
+	size_t const len   = round_up_pages(mem + size - begin);
+#ifdef _WIN32
+	DWORD old;
+	if (!VirtualProtect(begin, len,
+	                    writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &old))
+		panic("could not change protection of JIT code memory");
+#else
+	if (mprotect(begin, len,
+	             writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) != 0)
+		panic("could not change protection of JIT code memory");
+#endif
+}
+
+static void flush_instruction_cache(char *const mem, size_t const size)
+{
+#ifdef _WIN32
+	FlushInstructionCache(GetCurrentProcess(), mem, size);
+#else
+	__builtin___clear_cache(mem, mem + size);
+#endif
+}
+
+/**
+ * Returns the index of the first slab in @p heap->by_address, which starts
+ * after @p code.
+ */
+static size_t upper_bound(jit_heap_t const *const heap, char const *const code)
+{
+	jit_slab_t *const *const slabs = heap->by_address;
+	size_t                   lo    = 0;
+	size_t                   hi    = ARR_LEN(slabs);
+	while (lo < hi) {
+		size_t const mid = lo + (hi - lo) / 2;
+		if (slabs[mid]->mem <= code)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static jit_slab_t *new_slab(jit_heap_t *const heap, jit_slab_t ***const array,
+                            size_t const size, unsigned const slot_size)
+{
+	jit_slab_t *const slab = XMALLOCZ(jit_slab_t);
+	slab->size      = round_up_pages(size);
+	map_pages(slab, slab->size);
+	slab->slot_size = slot_size;
+	slab->n_slots   = slot_size != 0 ? slab->size / slot_size : 1;
+	slab->used      = rbitset_malloc(slab->n_slots);
+	slab->requested = XMALLOCNZ(unsigned, slab->n_slots);
+	heap->mapped   += slab->size;
+
+	slab->index = ARR_LEN(*array);
+	ARR_APP1(jit_slab_t*, *array, slab);
+
+	size_t const pos = upper_bound(heap, slab->mem);
+	size_t const n   = ARR_LEN(heap->by_address);
+	ARR_SETLEN(jit_slab_t*, heap->by_address, n + 1);
+	memmove(&heap->by_address[pos + 1], &heap->by_address[pos],
+	        (n - pos) * sizeof(*heap->by_address));
+	heap->by_address[pos] = slab;
+	return slab;
+}
+
+static void free_slab(jit_heap_t *const heap, jit_slab_t *const slab)
+{
+	heap->mapped -= slab->size;
+	unmap_pages(slab);
+	free(slab->used);
+	free(slab->requested);
+	free(slab);
+}
+
+static void emit_stats(jit_heap_t const *const heap)
+{
+	if (!stat_ev_enabled)
+		return;
+	stat_ev_ull("jit_heap_live",   heap->live);
+	stat_ev_ull("jit_heap_mapped", heap->mapped);
+	if (heap->mapped != 0)
+		stat_ev_dbl("jit_heap_fragmentation",
+		            1.0 - (double)heap->live / heap->mapped);
+}
+
+void jit_heap_init(jit_heap_t *const heap)
+{
+	for (unsigned i = 0; i < JIT_HEAP_N_CLASSES; ++i)
+		heap->slabs[i] = NEW_ARR_F(jit_slab_t*, 0);
+	heap->large      = NEW_ARR_F(jit_slab_t*, 0);
+	heap->by_address = NEW_ARR_F(jit_slab_t*, 0);
+	heap->live       = 0;
+	heap->mapped     = 0;
+}
+
+void jit_heap_destroy(jit_heap_t *const heap)
+{
+	for (size_t s = 0, n = ARR_LEN(heap->by_address); s < n; ++s)
+		free_slab(heap, heap->by_address[s]);
+	for (unsigned i = 0; i < JIT_HEAP_N_CLASSES; ++i)
+		DEL_ARR_F(heap->slabs[i]);
+	DEL_ARR_F(heap->large);
+	DEL_ARR_F(heap->by_address);
+}
+
+static unsigned get_size_class(size_t const size)
+{
+	unsigned const log = size <= 1u << MIN_CLASS_LOG
+	                   ? MIN_CLASS_LOG : log2_ceil((uint32_t)size);
+	return log - MIN_CLASS_LOG;
+}
+
+static bool is_small(size_t const size)
+{
+	/* Without dual mappings allocations must not share pages, as changing
+	 * the protection would affect the code in the other slots. */
+	if (!have_dual_mapping())
+		return false;
+	size_t const max_slot = (size_t)1 << (MIN_CLASS_LOG + JIT_HEAP_N_CLASSES - 1);
+	/* Slots must not cross page boundaries. */
+	return size <= max_slot && size <= get_page_size();
+}
+
+char *jit_heap_alloc(jit_heap_t *const heap, size_t const size,
+                     char **const writable)
+{
+	assert(size > 0);
+	jit_slab_t *slab;
+	unsigned    slot;
+	if (is_small(size)) {
+		unsigned      const cls   = get_size_class(size);
+		jit_slab_t  **const slabs = heap->slabs[cls];
+		slab = NULL;
+		for (size_t s = 0, n = ARR_LEN(slabs); s < n; ++s) {
+			if (slabs[s]->n_used < slabs[s]->n_slots) {
+				slab = slabs[s];
+				break;
+			}
+		}
+		if (slab == NULL) {
+			slab = new_slab(heap, &heap->slabs[cls], SLAB_SIZE,
+			                1u << (cls + MIN_CLASS_LOG));
+		}
+		slot = (unsigned)rbitset_next(slab->used, 0, false);
+	} else {
+		slab = new_slab(heap, &heap->large, size, 0);
+		slot = 0;
+	}
+	assert(slot < slab->n_slots);
+	rbitset_set(slab->used, slot);
+	slab->requested[slot] = (unsigned)size;
+	++slab->n_used;
+	heap->live += size;
+
+	size_t const offset = (size_t)slot * slab->slot_size;
+	if (slab->writable == slab->mem)
+		protect(slab->mem + offset, size, true);
+	*writable = slab->writable + offset;
+	return slab->mem + offset;
+}
+
+/** Returns the index of the slab containing @p code in @p heap->by_address. */
+static size_t lookup(jit_heap_t const *const heap, char const *const code)
+{
+	size_t const pos = upper_bound(heap, code);
+	if (pos > 0) {
+		jit_slab_t const *const slab = heap->by_address[pos - 1];
+		if (code < slab->mem + slab->size)
+			return pos - 1;
+	}
+	panic("%p was not allocated in the JIT heap", (void const*)code);
+}
+
+static unsigned get_slot(jit_slab_t const *const slab, char const *const code)
+{
+	if (slab->slot_size == 0)
+		return 0;
+	size_t const offset = code - slab->mem;
+	assert(offset % slab->slot_size == 0);
+	return offset / slab->slot_size;
+}
+
+void jit_heap_seal(jit_heap_t *const heap, char *const code)
+{
+	jit_slab_t *const slab = heap->by_address[lookup(heap, code)];
+	unsigned    const slot = get_slot(slab, code);
+	size_t      const size = slab->requested[slot];
+	assert(rbitset_is_set(slab->used, slot));
+	if (slab->writable == slab->mem)
+		protect(code, size, false);
+	flush_instruction_cache(code, size);
+	emit_stats(heap);
+}
+
+void jit_heap_free(jit_heap_t *const heap, void const *const code)
+{
+	size_t      const pos  = lookup(heap, code);
+	jit_slab_t *const slab = heap->by_address[pos];
+	unsigned    const slot = get_slot(slab, code);
+	assert(rbitset_is_set(slab->used, slot));
+	rbitset_clear(slab->used, slot);
+	heap->live -= slab->requested[slot];
+	--slab->n_used;
+
+	if (slab->n_used == 0) {
+		/* Return empty slabs to the system. */
+		jit_slab_t ***const array = slab->slot_size == 0 ? &heap->large
+			: &heap->slabs[get_size_class(slab->slot_size)];
+		jit_slab_t  **const slabs = *array;
+		size_t        const last  = ARR_LEN(slabs) - 1;
+		slabs[slab->index]        = slabs[last];
+		slabs[slab->index]->index = slab->index;
+		ARR_SETLEN(jit_slab_t*, *array, last);
+
+		size_t const n = ARR_LEN(heap->by_address);
+		memmove(&heap->by_address[pos], &heap->by_address[pos + 1],
+		        (n - pos - 1) * sizeof(*heap->by_address));
+		ARR_SETLEN(jit_slab_t*, heap->by_address, n - 1);
+		free_slab(heap, slab);
+	}
+	emit_stats(heap);
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Executable memory for just in time compiled code.
+ */
+#ifndef FIRM_BE_BEJITHEAP_H
+#define FIRM_BE_BEJITHEAP_H
+
+#include <stddef.h>
+
+/** Number of size classes, the smallest class holds 32 bytes. */
+#define JIT_HEAP_N_CLASSES 8
+
+typedef struct jit_slab_t jit_slab_t;
+
+/**
+ * A heap of executable memory.  Memory is never writable and executable at
+ * the same address: code is written through a separate writable mapping, or,
+ * where the system does not support this, jit_heap_alloc() makes the pages
+ * of the allocation writable and jit_heap_seal() makes them executable again.
+ */
+typedef struct jit_heap_t {
+	jit_slab_t **slabs[JIT_HEAP_N_CLASSES]; /**< slabs of each size class */
+	jit_slab_t **large;      /**< slabs holding a single large allocation */
+	jit_slab_t **by_address; /**< all slabs sorted by address */
+	size_t       live;       /**< bytes requested by live allocations */
+	size_t       mapped;     /**< bytes of mapped memory */
+} jit_heap_t;
+
+void jit_heap_init(jit_heap_t *heap);
+
+void jit_heap_destroy(jit_heap_t *heap);
+
+/**
+ * Allocates @p size bytes and returns their executable address.  Until
+ * jit_heap_seal() the code is written to the address returned in
+ * @p writable.
+ */
+char *jit_heap_alloc(jit_heap_t *heap, size_t size, char **writable);
+
+/** Makes the allocation @p code executable. */
+void jit_heap_seal(jit_heap_t *heap, char *code);
+
+/** Frees the allocation @p code. */
+void jit_heap_free(jit_heap_t *heap, void const *code);
+
+#endif
@@ -15,6 +15,7 @@
 #include "debug.h"
 #include "iredges_t.h"
 #include "irgwalk.h"
+#include "irmemstat_t.h"
 #include "irprintf.h"
 #include "irdump_t.h"
 #include "irnodeset.h"
@@ -265,7 +266,7 @@ void be_liveness_compute_sets(be_lv_t *lv)
 
 	be_timer_push(T_LIVE);
 	ir_nodehashmap_init(&lv->map);
-	obstack_init(&lv->obst);
+	ir_mem_obstack_init(&lv->obst, ir_mem_liveness);
 
 	ir_graph *irg = lv->irg;
 	unsigned n = get_irg_last_idx(irg);
@@ -11,6 +11,7 @@
  */
 #include "be_t.h"
 #include "beasm.h"
+#include "becache.h"
 #include "bechordal_t.h"
 #include "bediagnostic.h"
 #include "beemitter.h"
@@ -38,6 +39,7 @@
 #include "iredges_t.h"
 #include "irgopt.h"
 #include "irloop_t.h"
+#include "irmemstat_t.h"
 #include "iroptimize.h"
 #include "irprofile.h"
 #include "irprog.h"
@@ -64,6 +66,8 @@ be_options_t be_options = {
 	.do_verify            = true,
 	.ilp_solver           = "",
 	.verbose_asm          = true,
+	.code_cache           = "",
+	.code_cache_size      = 256,
 };
 
 /* possible dumping options */
@@ -93,6 +97,8 @@ static const lc_opt_table_entry_t be_main_options[] = {
 	LC_OPT_ENT_BOOL     ("verboseasm", "enable verbose assembler output",                        &be_options.verbose_asm),
 
 	LC_OPT_ENT_STR("ilp.solver", "the ilp solver name", &be_options.ilp_solver),
+	LC_OPT_ENT_STR("cachedir",   "directory of the code cache for unchanged functions", &be_options.code_cache),
+	LC_OPT_ENT_INT("cachesize",  "size limit of the code cache in MiB",                 &be_options.code_cache_size),
 	LC_OPT_LAST
 };
 
@@ -266,7 +272,7 @@ static void initialize_birg(be_irg_t *birg, ir_graph *irg, be_main_env_t *env)
 
 	memset(birg, 0, sizeof(*birg));
 	birg->main_env = env;
-	obstack_init(&birg->obst);
+	ir_mem_obstack_init(&birg->obst, ir_mem_backend);
 	irg->be_data = birg;
 
 	be_info_init_irg(irg);
@@ -383,6 +389,7 @@ void be_begin(FILE *file_handle, const char *cup_name)
 		initialize_birg(&birgs[num_birgs++], prof_init_irg, &env);
 
 	be_gas_begin_compilation_unit(&env);
+	be_cache_begin();
 }
 
 void firm_be_finish(void)
@@ -465,11 +472,17 @@ bool be_step_first(ir_graph *irg)
 	if (get_entity_linkage(entity) & IR_LINKAGE_NO_CODEGEN)
 		return false;
 
+	if (be_cache_lookup(irg)) {
+		be_free_birg(irg);
+		return false;
+	}
+
 	be_timer_push(T_OTHER);
 	if (stat_ev_enabled) {
 		stat_ev_ctx_push_fmt("bemain_irg", "%+F", irg);
 		stat_ev_ull("bemain_insns_start", be_count_insns(irg));
 		stat_ev_ull("bemain_blocks_start", be_count_blocks(irg));
+		ir_mem_stat_ev("bemain_mem_start_");
 	}
 	cse_setting = get_opt_cse();
 	return true;
@@ -495,6 +508,7 @@ void be_step_regalloc(ir_graph *irg, const regalloc_if_t *regif)
 		stat_ev_dbl("bemain_costs_before_ra", be_estimate_irg_costs(irg));
 		stat_ev_ull("bemain_insns_before_ra", be_count_insns(irg));
 		stat_ev_ull("bemain_blocks_before_ra", be_count_blocks(irg));
+		ir_mem_stat_ev("bemain_mem_before_ra_");
 		be_stat_values(irg);
 	}
 
@@ -506,6 +520,7 @@ void be_step_regalloc(ir_graph *irg, const regalloc_if_t *regif)
 		stat_ev_dbl("bemain_costs_after_ra", be_estimate_irg_costs(irg));
 		stat_ev_ull("bemain_insns_after_ra", be_count_insns(irg));
 		stat_ev_ull("bemain_blocks_after_ra", be_count_blocks(irg));
+		ir_mem_stat_ev("bemain_mem_after_ra_");
 	}
 
 	be_dump(DUMP_RA, irg, "ra");
@@ -513,9 +528,12 @@ void be_step_regalloc(ir_graph *irg, const regalloc_if_t *regif)
 
 void be_step_last(ir_graph *irg)
 {
+	be_cache_store(irg);
+
 	if (stat_ev_enabled) {
 		stat_ev_ull("bemain_insns_finish", be_count_insns(irg));
 		stat_ev_ull("bemain_blocks_finish", be_count_blocks(irg));
+		ir_mem_stat_ev("bemain_mem_finish_");
 	}
 
 	be_dump(DUMP_FINAL, irg, "final");
@@ -552,6 +570,7 @@ void be_step_last(ir_graph *irg)
 void be_finish(void)
 {
 	be_gas_end_compilation_unit(&env);
+	be_cache_finish();
 
 	if (be_options.timing) {
 		ir_timer_stop(bemain_timer);
@@ -605,5 +624,5 @@ ir_jit_function_t *be_jit_compile(ir_jit_segment_t *const segment,
 
 void be_emit_function(char *const buffer, ir_jit_function_t *const function)
 {
-	ir_target.isa->emit_function(buffer, function);
+	ir_target.isa->emit_function(buffer, buffer, function);
 }
@@ -571,6 +571,7 @@ static void be_pbqp_coloring(be_chordal_env_t *env)
 	/* set costs */
 	for (unsigned row = 0, col = 0; row < colors_n; row++, col++)
 		pbqp_matrix_set(ife_matrix, row, col, INF_COSTS);
+	pbqp_matrix_classify(ife_matrix);
 
 	pbqp_alloc_env.ife_matrix_template = ife_matrix;
 
@@ -585,6 +586,7 @@ static void be_pbqp_coloring(be_chordal_env_t *env)
 					pbqp_matrix_set(afe_matrix, row, col, 2);
 			}
 		}
+		pbqp_matrix_classify(afe_matrix);
 		pbqp_alloc_env.aff_matrix_template = afe_matrix;
 	}
 
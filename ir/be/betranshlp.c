@@ -27,6 +27,7 @@
 #include "irgraph_t.h"
 #include "irgwalk.h"
 #include "irhooks.h"
+#include "irmemstat_t.h"
 #include "irnode_t.h"
 #include "irnodemap.h"
 #include "irop_t.h"
@@ -321,7 +322,7 @@ void be_transform_graph(ir_graph *irg, arch_pretrans_nodes *func)
 {
 	/* create a new obstack */
 	struct obstack old_obst = irg->obst;
-	obstack_init(&irg->obst);
+	ir_mem_obstack_init(&irg->obst, ir_mem_nodes);
 	irg->last_node_idx = 0;
 
 	free_vrp_data(irg);
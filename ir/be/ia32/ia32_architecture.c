@@ -19,19 +19,7 @@
 #include "irtools.h"
 #include "tv.h"
 #include "util.h"
-
-#undef NATIVE_X86
-
-#ifdef _MSC_VER
-#if defined(_M_IX86) || defined(_M_X64)
-#include <intrin.h>
-#define NATIVE_X86
-#endif
-#else
-#if defined(__i386__) || defined(__x86_64__)
-#define NATIVE_X86
-#endif
-#endif
+#include "x86_cpuid.h"
 
 ia32_code_gen_config_t ia32_cg_config;
 
@@ -75,6 +63,7 @@ typedef enum cpu_arch_features {
 	arch_feature_sse4_2   = 0x02000000, /**< SSE4.2 instructions */
 	arch_feature_sse4a    = 0x04000000, /**< SSE4a instructions */
 	arch_feature_popcnt   = 0x08000000, /**< popcnt instruction */
+	arch_feature_erms     = 0x10000000, /**< enhanced rep movsb/stosb */
 
 	arch_mmx_insn     = arch_feature_mmx,                         /**< MMX instructions */
 	arch_sse1_insn    = arch_feature_sse1   | arch_mmx_insn,      /**< SSE1 instructions, include MMX */
@@ -150,6 +139,7 @@ static bool              use_sse4_2           = false;
 static bool              use_sse4a            = false;
 static bool              use_sse5             = false;
 static bool              use_ssse3            = false;
+static bool              use_erms             = false;
 static cpu_arch_features arch                 = cpu_generic;
 static cpu_arch_features opt_arch             = 0;
 static int               fpu_arch             = 0;
@@ -260,6 +250,7 @@ static const lc_opt_table_entry_t ia32_architecture_options[] = {
 	LC_OPT_ENT_BOOL    ("sse4a",            "gcc compatibility",                                  &use_sse4a),
 	LC_OPT_ENT_BOOL    ("sse5",             "gcc compatibility",                                  &use_sse5),
 	LC_OPT_ENT_BOOL    ("ssse3",            "gcc compatibility",                                  &use_ssse3),
+	LC_OPT_ENT_BOOL    ("erms",             "use rep movsb for block copies",                     &use_erms),
 	LC_OPT_LAST
 };
 
@@ -508,77 +499,6 @@ int ia32_evaluate_insn(insn_kind kind, const ir_mode *mode, ir_tarval *tv)
 
 /* auto detection code only works if we're on an x86 cpu obviously */
 #ifdef NATIVE_X86
-typedef struct x86_cpu_info_t {
-	unsigned char cpu_stepping;
-	unsigned char cpu_model;
-	unsigned char cpu_family;
-	unsigned char cpu_type;
-	unsigned char cpu_ext_model;
-	unsigned char cpu_ext_family;
-	unsigned      edx_features;
-	unsigned      ecx_features;
-	unsigned      add_features;
-} x86_cpu_info_t;
-
-enum {
-	CPUID_FEAT_ECX_SSE3      = 1 << 0,
-	CPUID_FEAT_ECX_PCLMUL    = 1 << 1,
-	CPUID_FEAT_ECX_DTES64    = 1 << 2,
-	CPUID_FEAT_ECX_MONITOR   = 1 << 3,
-	CPUID_FEAT_ECX_DS_CPL    = 1 << 4,
-	CPUID_FEAT_ECX_VMX       = 1 << 5,
-	CPUID_FEAT_ECX_SMX       = 1 << 6,
-	CPUID_FEAT_ECX_EST       = 1 << 7,
-	CPUID_FEAT_ECX_TM2       = 1 << 8,
-	CPUID_FEAT_ECX_SSSE3     = 1 << 9,
-	CPUID_FEAT_ECX_CID       = 1 << 10,
-	CPUID_FEAT_ECX_FMA       = 1 << 12,
-	CPUID_FEAT_ECX_CX16      = 1 << 13,
-	CPUID_FEAT_ECX_ETPRD     = 1 << 14,
-	CPUID_FEAT_ECX_PDCM      = 1 << 15,
-	CPUID_FEAT_ECX_DCA       = 1 << 18,
-	CPUID_FEAT_ECX_SSE4_1    = 1 << 19,
-	CPUID_FEAT_ECX_SSE4_2    = 1 << 20,
-	CPUID_FEAT_ECX_x2APIC    = 1 << 21,
-	CPUID_FEAT_ECX_MOVBE     = 1 << 22,
-	CPUID_FEAT_ECX_POPCNT    = 1 << 23,
-	CPUID_FEAT_ECX_AES       = 1 << 25,
-	CPUID_FEAT_ECX_XSAVE     = 1 << 26,
-	CPUID_FEAT_ECX_OSXSAVE   = 1 << 27,
-	CPUID_FEAT_ECX_AVX       = 1 << 28,
-
-	CPUID_FEAT_EDX_FPU       = 1 << 0,
-	CPUID_FEAT_EDX_VME       = 1 << 1,
-	CPUID_FEAT_EDX_DE        = 1 << 2,
-	CPUID_FEAT_EDX_PSE       = 1 << 3,
-	CPUID_FEAT_EDX_TSC       = 1 << 4,
-	CPUID_FEAT_EDX_MSR       = 1 << 5,
-	CPUID_FEAT_EDX_PAE       = 1 << 6,
-	CPUID_FEAT_EDX_MCE       = 1 << 7,
-	CPUID_FEAT_EDX_CX8       = 1 << 8,
-	CPUID_FEAT_EDX_APIC      = 1 << 9,
-	CPUID_FEAT_EDX_SEP       = 1 << 11,
-	CPUID_FEAT_EDX_MTRR      = 1 << 12,
-	CPUID_FEAT_EDX_PGE       = 1 << 13,
-	CPUID_FEAT_EDX_MCA       = 1 << 14,
-	CPUID_FEAT_EDX_CMOV      = 1 << 15,
-	CPUID_FEAT_EDX_PAT       = 1 << 16,
-	CPUID_FEAT_EDX_PSE36     = 1 << 17,
-	CPUID_FEAT_EDX_PSN       = 1 << 18,
-	CPUID_FEAT_EDX_CLF       = 1 << 19,
-	CPUID_FEAT_EDX_DTES      = 1 << 21,
-	CPUID_FEAT_EDX_ACPI      = 1 << 22,
-	CPUID_FEAT_EDX_MMX       = 1 << 23,
-	CPUID_FEAT_EDX_FXSR      = 1 << 24,
-	CPUID_FEAT_EDX_SSE       = 1 << 25,
-	CPUID_FEAT_EDX_SSE2      = 1 << 26,
-	CPUID_FEAT_EDX_SS        = 1 << 27,
-	CPUID_FEAT_EDX_HTT       = 1 << 28,
-	CPUID_FEAT_EDX_TM1       = 1 << 29,
-	CPUID_FEAT_EDX_IA64      = 1 << 30,
-	CPUID_FEAT_EDX_PBE       = 1 << 31
-};
-
 static cpu_arch_features auto_detect_Intel(x86_cpu_info_t const *info)
 {
 	cpu_arch_features auto_arch = cpu_generic;
@@ -726,117 +646,18 @@ static cpu_arch_features auto_detect_AMD(x86_cpu_info_t const *info)
 	return auto_arch;
 }
 
-typedef union {
-	struct {
-		unsigned eax;
-		unsigned ebx;
-		unsigned ecx;
-		unsigned edx;
-	} r;
-	int bulk[4];
-} cpuid_registers;
-
-static void x86_cpuid(cpuid_registers *regs, unsigned level)
-{
-#if defined(__GNUC__)
-#	if defined(__PIC__) && !defined(__amd64) // GCC cannot handle EBX in PIC
-	__asm (
-		"movl %%ebx, %1\n\t"
-		"cpuid\n\t"
-		"xchgl %%ebx, %1"
-	: "=a" (regs->r.eax), "=r" (regs->r.ebx), "=c" (regs->r.ecx), "=d" (regs->r.edx)
-	: "a" (level)
-	);
-#	else
-	__asm ("cpuid\n\t"
-	: "=a" (regs->r.eax), "=b" (regs->r.ebx), "=c" (regs->r.ecx), "=d" (regs->r.edx)
-	: "a" (level)
-	);
-#	endif
-#elif defined(_MSC_VER)
-	__cpuid(regs->bulk, level);
-#else
-#	error CPUID is missing
-#endif
-}
-
-static bool x86_toggle_cpuid(void)
-{
-	unsigned eflags_before = 0;
-	unsigned eflags_after = 0;
-
-#if defined(__GNUC__)
-#ifdef __i386__
-	/* If bit 21 of the EFLAGS register can be changed, the cpuid instruction is available */
-	__asm__(
-		"pushf\n\t"
-		"popl %0\n\t"
-		"movl %0, %1\n\t"
-		"xorl $0x00200000, %1\n\t"
-		"pushl %1\n\t"
-		"popf\n\t"
-		"pushf\n\t"
-		"popl %1"
-		: "=r" (eflags_before), "=r" (eflags_after) :: "cc"
-		);
-#else
-	eflags_after = 0x00200000;
-#endif
-#elif defined(_MSC_VER)
-#if defined(_M_IX86)
-	__asm {
-		pushfd
-		pop eax
-		mov eflags_before, eax
-		xor eax, 0x00200000
-		push eax
-		popfd
-		pushfd
-		pop eax
-		mov eflags_after, eax
-	}
-#else
-	eflags_after = 0x00200000;
-#endif
-#endif
-	return (eflags_before ^ eflags_after) & 0x00200000;
-}
-
 static void autodetect_arch(void)
 {
 	cpu_arch_features auto_arch = cpu_generic;
 
 	/* We use the cpuid instruction to detect the CPU features */
-	if (x86_toggle_cpuid()) {
-
-		/* get vendor ID */
-		cpuid_registers regs;
-		x86_cpuid(&regs, 0);
-		char vendorid[13];
-		memcpy(&vendorid[0], &regs.r.ebx, 4);
-		memcpy(&vendorid[4], &regs.r.edx, 4);
-		memcpy(&vendorid[8], &regs.r.ecx, 4);
-		vendorid[12] = '\0';
-
-		/* get processor info and feature bits */
-		x86_cpuid(&regs, 1);
-
-		x86_cpu_info_t cpu_info;
-		cpu_info.cpu_stepping   = (regs.r.eax >>  0) & 0x0F;
-		cpu_info.cpu_model      = (regs.r.eax >>  4) & 0x0F;
-		cpu_info.cpu_family     = (regs.r.eax >>  8) & 0x0F;
-		cpu_info.cpu_type       = (regs.r.eax >> 12) & 0x03;
-		cpu_info.cpu_ext_model  = (regs.r.eax >> 16) & 0x0F;
-		cpu_info.cpu_ext_family = (regs.r.eax >> 20) & 0xFF;
-		cpu_info.edx_features   = regs.r.edx;
-		cpu_info.ecx_features   = regs.r.ecx;
-		cpu_info.add_features   = regs.r.ebx;
-
-		if        (streq(vendorid, "GenuineIntel")) {
+	x86_cpu_info_t cpu_info;
+	if (x86_get_cpu_info(&cpu_info)) {
+		if        (streq(cpu_info.vendor, "GenuineIntel")) {
 			auto_arch = auto_detect_Intel(&cpu_info);
-		} else if (streq(vendorid, "AuthenticAMD")) {
+		} else if (streq(cpu_info.vendor, "AuthenticAMD")) {
 			auto_arch = auto_detect_AMD(&cpu_info);
-		} else if (streq(vendorid, "Geode by NSC")) {
+		} else if (streq(cpu_info.vendor, "Geode by NSC")) {
 			auto_arch = cpu_geode_generic;
 		}
 
@@ -859,6 +680,9 @@ static void autodetect_arch(void)
 			auto_arch |= arch_feature_sse4_2;
 		if (cpu_info.ecx_features & CPUID_FEAT_ECX_POPCNT)
 			auto_arch |= arch_feature_popcnt;
+
+		if (cpu_info.ebx_features_7 & CPUID_FEAT7_EBX_ERMS)
+			auto_arch |= arch_feature_erms;
 	}
 
 	arch     = auto_arch;
@@ -915,12 +739,21 @@ void ia32_setup_cg_config(void)
 	c->use_sse_prefetch     = flags(arch, (arch_feature_3DNowE | arch_feature_sse1));
 	c->use_3dnow_prefetch   = flags(arch, arch_feature_3DNow);
 	c->use_popcnt           = flags(arch, arch_feature_popcnt);
+	c->use_erms             = flags(arch, arch_feature_erms) || use_erms;
 	c->use_bswap            = (arch & arch_mask) >= arch_i486;
 	c->use_cmpxchg          = (arch & arch_mask) != arch_i386;
 	c->optimize_cc          = opt_cc;
 	c->use_unsafe_floatconv = opt_unsafe_floatconv;
 	c->emit_machcode        = emit_machcode;
 
+	/* Small copies are lowered to integer loads/stores.  With SSE2 the medium
+	 * range is covered by unaligned 16 byte moves with an overlapping tail,
+	 * above that rep movs is used up to the size where a memcpy call wins. */
+	bool const vector_copy = flags(arch, arch_feature_sse2);
+	c->copyb_max_small  = vector_copy ? 16 : 64;
+	c->copyb_max_vector = vector_copy ? 128 : 0;
+	c->copyb_min_large  = 8193;
+
 	c->function_alignment       = arch_costs->function_alignment;
 	c->label_alignment          = arch_costs->label_alignment;
 	c->label_alignment_max_skip = arch_costs->label_alignment_max_skip;
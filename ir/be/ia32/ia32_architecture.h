@@ -68,6 +68,8 @@ typedef struct {
 	bool use_3dnow_prefetch:1;
 	/** use SSE4.2 or SSE4a popcnt instruction */
 	bool use_popcnt:1;
+	/** use rep movsb for block copies (fast on CPUs with ERMS) */
+	bool use_erms:1;
 	/** use i486 instructions */
 	bool use_bswap:1;
 	/** use cmpxchg */
@@ -93,6 +95,12 @@ typedef struct {
 	/** if a blocks execfreq is factor higher than its predecessor then align
 	 *  the blocks label (0 switches off label alignment) */
 	double label_alignment_factor;
+	/** CopyBs up to this size are lowered to loads/stores */
+	unsigned copyb_max_small;
+	/** CopyBs up to this size are copied with SSE moves */
+	unsigned copyb_max_vector;
+	/** CopyBs from this size on are turned into memcpy calls */
+	unsigned copyb_min_large;
 } ia32_code_gen_config_t;
 
 extern ia32_code_gen_config_t ia32_cg_config;
@@ -1605,8 +1605,29 @@ static void ia32_lower_for_target(void)
 	supported[s++] = ir_bk_va_start;
 	if (ia32_cg_config.use_popcnt)
 		supported[s++] = ir_bk_popcount;
-	if (ia32_cg_config.use_cmpxchg)
+	/* the atomic instructions work on at most 32 bits, without cmpxchg
+	 * libatomic has to implement all of them */
+	lower_wide_atomics(ia32_cg_config.use_cmpxchg ? 32 : 0);
+	if (ia32_cg_config.use_cmpxchg) {
 		supported[s++] = ir_bk_compare_swap;
+		supported[s++] = ir_bk_atomic_fetch_add;
+		supported[s++] = ir_bk_atomic_fetch_sub;
+		supported[s++] = ir_bk_atomic_fetch_and;
+		supported[s++] = ir_bk_atomic_fetch_or;
+		supported[s++] = ir_bk_atomic_fetch_xor;
+		supported[s++] = ir_bk_atomic_exchange;
+		supported[s++] = ir_bk_atomic_load;
+		supported[s++] = ir_bk_atomic_store;
+		supported[s++] = ir_bk_atomic_fence;
+
+		/* lock and/or/xor do not produce the previous value */
+		static ir_builtin_kind const no_result[] = {
+			ir_bk_atomic_fetch_and,
+			ir_bk_atomic_fetch_or,
+			ir_bk_atomic_fetch_xor,
+		};
+		lower_atomic_rmw_results(ARRAY_SIZE(no_result), no_result, true);
+	}
 	assert(s < ARRAY_SIZE(supported));
 	lower_builtins(s, supported, ia32_lower_va_arg);
 	be_after_irp_transform("lower-builtins");
@@ -1630,9 +1651,10 @@ static void ia32_lower_for_target(void)
 
 	foreach_irp_irg(i, irg) {
 		/* Turn all small CopyBs into loads/stores, keep medium-sized CopyBs,
-		 * so we can generate rep movs later, and turn all big CopyBs into
-		 * memcpy calls. */
-		lower_CopyB(irg, 64, 8193, true);
+		 * so we can generate SSE moves or rep movs later, and turn all big
+		 * CopyBs into memcpy calls. */
+		lower_CopyB(irg, ia32_cg_config.copyb_max_small,
+		            ia32_cg_config.copyb_min_large, true);
 		be_after_transform(irg, "lower-copyb");
 	}
 }
@@ -1669,6 +1691,10 @@ arch_isa_if_t const ia32_isa_if = {
 	.generate_code         = ia32_generate_code,
 	.jit_compile           = ia32_jit_compile,
 	.emit_function         = ia32_emit_jit_function,
+	.jit_stub_size         = IA32_JIT_STUB_SIZE,
+	.emit_jit_stub         = ia32_emit_jit_stub,
+	.jit_entry_size        = IA32_JIT_ENTRY_SIZE,
+	.emit_jit_entry        = ia32_emit_jit_entry,
 	.lower_for_target      = ia32_lower_for_target,
 	.additional_reg_names  = ia32_additional_reg_names,
 	.get_op_estimated_cost = ia32_get_op_estimated_cost,
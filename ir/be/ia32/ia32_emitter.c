@@ -824,6 +824,11 @@ static void emit_CopyB_prolog(unsigned size)
  */
 static void emit_ia32_CopyB(const ir_node *node)
 {
+	if (ia32_cg_config.use_erms) {
+		ia32_emitf(node, "rep movsb");
+		return;
+	}
+
 	unsigned size = get_ia32_copyb_size(node);
 
 	emit_CopyB_prolog(size);
@@ -845,6 +850,22 @@ static void emit_ia32_CopyB_i(const ir_node *node)
 	}
 }
 
+/**
+ * Emits a memcopy with unaligned 16 byte moves.  A remainder is handled by
+ * a last move overlapping the previous one.
+ */
+static void emit_ia32_CopyB_vec(const ir_node *node)
+{
+	unsigned const size = get_ia32_copyb_size(node);
+	assert(size >= 16);
+	for (unsigned offset = 0; offset < size; offset += 16) {
+		if (offset + 16 > size)
+			offset = size - 16;
+		ia32_emitf(node, "movdqu %u(%S1), %D0", offset);
+		ia32_emitf(node, "movdqu %D0, %u(%S0)", offset);
+	}
+}
+
 
 /**
  * Emit code for conversions (I, FP), (FP, I) and (FP, FP).
@@ -1142,6 +1163,7 @@ static void ia32_register_emitters(void)
 	be_set_emitter(op_ia32_Conv_I2FP,  emit_ia32_Conv_I2FP);
 	be_set_emitter(op_ia32_CopyB,      emit_ia32_CopyB);
 	be_set_emitter(op_ia32_CopyB_i,    emit_ia32_CopyB_i);
+	be_set_emitter(op_ia32_CopyB_vec,  emit_ia32_CopyB_vec);
 	be_set_emitter(op_ia32_GetEIP,     emit_ia32_GetEIP);
 	be_set_emitter(op_ia32_Jcc,        emit_ia32_Jcc);
 	be_set_emitter(op_ia32_Jmp,        emit_ia32_Jmp);
@@ -1417,11 +1439,13 @@ static const lc_opt_table_entry_t ia32_emitter_options[] = {
 };
 
 static unsigned emit_jit_entity_relocation_asm(char *const buffer,
+                                               char const *const address,
                                                uint8_t const be_kind,
                                                ir_entity *const entity,
                                                int32_t const offset)
 {
 	(void)buffer;
+	(void)address;
 	assert(buffer == NULL);
 	if (be_kind == IA32_RELOCATION_RELJUMP) {
 		be_emit_irprintf("\t.long %"PRId32"\n", offset);
@@ -575,6 +575,49 @@ void ia32_enc_0f_unop_reg(ir_node const *const node, uint8_t const code,
 	enc_unop_reg(node, code, input);
 }
 
+static void enc_lock_xadd_xchg(ir_node const *const node, uint8_t const op)
+{
+	x86_insn_size_t const size = get_ia32_attr_const(node)->size;
+	if (size == X86_SIZE_16)
+		be_emit8(0x66);
+	if (op == 0xC0)
+		be_emit8(0x0F);
+	be_emit8(op | (size == X86_SIZE_8 ? OP_8 : OP_16_32));
+	ir_node const *const val = get_irn_n(node, n_ia32_unary_op);
+	enc_mod_am(arch_get_irn_register(val)->encoding, node);
+}
+
+static void enc_xaddmem(ir_node const *const node)
+{
+	be_emit8(0xF0);
+	enc_lock_xadd_xchg(node, 0xC0);
+}
+
+static void enc_xchgmem(ir_node const *const node)
+{
+	/* xchg with a memory operand needs no lock prefix */
+	enc_lock_xadd_xchg(node, 0x86);
+}
+
+static void enc_mfence(ir_node const *const node)
+{
+	(void)node;
+	be_emit8(0x0F);
+	be_emit8(0xAE);
+	be_emit8(0xF0);
+}
+
+static void enc_lockorstack(ir_node const *const node)
+{
+	(void)node;
+	/* lock orl $0, (%esp) */
+	be_emit8(0xF0);
+	be_emit8(0x80 | OP_16_32_IMM8);
+	be_emit8(MOD_IND | ENC_REG(1, REG_LOW) | ENC_RM(0x04, REG_LOW));
+	be_emit8(ENC_SIB(0, 0x04, 0x04));
+	be_emit8(0x00);
+}
+
 static void enc_bswap(ir_node const *const node)
 {
 	be_emit8(0x0F);
@@ -1301,6 +1344,8 @@ static void ia32_register_binary_emitters(void)
 	be_set_emitter(op_ia32_LdTls,         enc_ldtls);
 	be_set_emitter(op_ia32_Lea,           enc_lea);
 	be_set_emitter(op_ia32_Load,          enc_load);
+	be_set_emitter(op_ia32_LockOrStack,   enc_lockorstack);
+	be_set_emitter(op_ia32_MFence,        enc_mfence);
 	be_set_emitter(op_ia32_Minus64,       enc_minus64);
 	be_set_emitter(op_ia32_Pop,           enc_pop);
 	be_set_emitter(op_ia32_PopMem,        enc_popmem);
@@ -1315,6 +1360,8 @@ static void ia32_register_binary_emitters(void)
 	be_set_emitter(op_ia32_SubSP,         enc_subsp);
 	be_set_emitter(op_ia32_SwitchJmp,     enc_switchjmp);
 	be_set_emitter(op_ia32_Test,          enc_test);
+	be_set_emitter(op_ia32_XAddMem,       enc_xaddmem);
+	be_set_emitter(op_ia32_XchgMem,       enc_xchgmem);
 	be_set_emitter(op_ia32_Xor0,          enc_xor0);
 	be_set_emitter(op_ia32_fild,          enc_fild);
 	be_set_emitter(op_ia32_fist,          enc_fist);
@@ -1422,6 +1469,7 @@ static void enc_nop_callback(char *buffer, unsigned size)
 }
 
 static unsigned enc_relocation_callback(char *const buffer,
+                                        char const *const address,
                                         uint8_t const be_kind,
                                         ir_entity *const entity,
                                         int32_t const offset)
@@ -1436,7 +1484,7 @@ static unsigned enc_relocation_callback(char *const buffer,
 			panic("Could not resolve address of entity %+F", entity);
 		intptr_t addr = entity_addr + offset;
 		if (be_kind == X86_IMM_PCREL)
-			addr -= (intptr_t)buffer;
+			addr -= (intptr_t)address;
 		value = (uint32_t)addr;
 		if ((intptr_t)value != addr)
 			panic("Overflow in relocation");
@@ -1446,11 +1494,56 @@ static unsigned enc_relocation_callback(char *const buffer,
 	return 4;
 }
 
-void ia32_emit_jit_function(char *buffer, ir_jit_function_t *const function)
+void ia32_emit_jit_function(char *const buffer, char const *const address,
+                            ir_jit_function_t *const function)
 {
 	static const be_jit_emit_interface_t jit_emit_interface = {
 		.nops       = enc_nop_callback,
 		.relocation = enc_relocation_callback,
 	};
-	be_jit_emit_memory(buffer, function, &jit_emit_interface);
+	be_jit_emit_memory(buffer, address, function, &jit_emit_interface);
+}
+
+static uint32_t abs32(void const *const address)
+{
+	uint32_t const value = (uint32_t)(uintptr_t)address;
+	if ((uintptr_t)value != (uintptr_t)address)
+		panic("Address %p does not fit into 32 bits", address);
+	return value;
+}
+
+static char *put32(char *const buffer, uint32_t const value)
+{
+	memcpy(buffer, &value, 4);
+	return buffer + 4;
+}
+
+void ia32_emit_jit_stub(char *const buffer, void *const data,
+                        void (*const resolve)(void *data),
+                        void const *const *const slot)
+{
+	/* All arguments are passed on the stack, so the stub only has to keep the
+	 * stack intact.  The resolver runs on a 16 byte aligned stack and stores
+	 * the materialized function in the slot, so the stub never changes and
+	 * does not depend on the address it is executed at. */
+	char *b = buffer;
+	*b++ = 0x55;                                 /* push %ebp */
+	*b++ = 0x89; *b++ = 0xE5;                    /* mov %esp, %ebp */
+	*b++ = 0x83; *b++ = 0xE4; *b++ = 0xF0;       /* and $-16, %esp */
+	*b++ = 0x83; *b++ = 0xEC; *b++ = 0x0C;       /* sub $12, %esp */
+	*b++ = 0x68; b = put32(b, abs32(data));      /* push $data */
+	*b++ = 0xB8; b = put32(b, abs32((void const*)(uintptr_t)resolve));
+	                                             /* mov $resolve, %eax */
+	*b++ = 0xFF; *b++ = 0xD0;                    /* call *%eax */
+	*b++ = 0xC9;                                 /* leave */
+	*b++ = 0xFF; *b++ = 0x25; b = put32(b, abs32(slot)); /* jmp *slot */
+	assert(b - buffer <= IA32_JIT_STUB_SIZE);
+	enc_nop_callback(b, IA32_JIT_STUB_SIZE - (b - buffer));
+}
+
+void ia32_emit_jit_entry(char *const buffer, void const *const *const slot)
+{
+	char *b = buffer;
+	*b++ = 0xFF; *b++ = 0x25; b = put32(b, abs32(slot)); /* jmp *slot */
+	enc_nop_callback(b, IA32_JIT_ENTRY_SIZE - (b - buffer));
 }
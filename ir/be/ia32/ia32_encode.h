@@ -19,9 +19,20 @@ enum {
 	IA32_RELOCATION_RELJUMP = 128,
 };
 
+enum {
+	IA32_JIT_STUB_SIZE  = 32,
+	IA32_JIT_ENTRY_SIZE = 8,
+};
+
 ir_jit_function_t *ia32_emit_jit(ir_jit_segment_t *segment, ir_graph *irg);
 
-void ia32_emit_jit_function(char *buffer, ir_jit_function_t *function);
+void ia32_emit_jit_function(char *buffer, char const *address,
+                            ir_jit_function_t *function);
+
+void ia32_emit_jit_stub(char *buffer, void *data, void (*resolve)(void *data),
+                        void const *const *slot);
+
+void ia32_emit_jit_entry(char *buffer, void const *const *slot);
 
 void ia32_enc_simple(uint8_t opcode);
 
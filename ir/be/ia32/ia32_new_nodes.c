@@ -216,7 +216,8 @@ void ia32_dump_node(FILE *F, const ir_node *n, dump_reason_t reason)
 				}
 				fprintf(F, "ins_permuted = %s\n",
 				        be_dump_yesno(attr->ins_permuted));
-			} else if (is_ia32_CopyB(n) || is_ia32_CopyB_i(n)) {
+			} else if (is_ia32_CopyB(n) || is_ia32_CopyB_i(n)
+			           || is_ia32_CopyB_vec(n)) {
 				fprintf(F, "size = %u\n", get_ia32_copyb_size(n));
 			} else if (has_ia32_x87_attr(n)) {
 				ia32_x87_attr_t const *const attr = get_ia32_x87_attr_const(n);
@@ -111,7 +111,7 @@ $custom_init_attr_func = \&ia32_custom_init_attr;
 		"init_ia32_attributes(res, size);\n".
 		"\tinit_ia32_switch_attributes(res, switch_table, table_entity);",
 	ia32_copyb_attr_t =>
-		"init_ia32_attributes(res, size);\n".
+		"init_ia32_attributes(res, X86_SIZE_32);\n".
 		"\tinit_ia32_copyb_attributes(res, size);",
 	ia32_immediate_attr_t =>
 		"init_ia32_attributes(res, size);\n".
@@ -178,6 +178,20 @@ my $binop_mem = {
 	emit      => "{name}%M %S3, %AM",
 };
 
+my $lock_binop_mem = {
+	irn_flags => [ "modify_flags" ],
+	state     => "exc_pinned",
+	constructors => {
+		""     => { in_reqs => [ "gp", "gp", "mem", "gp" ] },
+		"8bit" => { in_reqs => [ "gp", "gp", "mem", "eax ebx ecx edx" ] },
+	},
+	out_reqs  => [ "none", "flags", "mem" ],
+	ins       => [ "base", "index", "mem", "val" ],
+	outs      => [ "unused", "flags", "M" ],
+	attr      => "x86_insn_size_t size",
+	emit      => "lock {name}%M %S3, %AM",
+};
+
 my $shiftop = {
 	irn_flags => [ "modify_flags", "rematerializable" ],
 	constructors => {
@@ -1308,6 +1322,71 @@ CmpXChgMem => {
 	latency   => 2,
 },
 
+XAddMem => {
+	irn_flags => [ "modify_flags" ],
+	state     => "exc_pinned",
+	constructors => {
+		""     => { in_reqs => [ "gp", "gp", "mem", "gp" ] },
+		"8bit" => { in_reqs => [ "gp", "gp", "mem", "eax ebx ecx edx" ] },
+	},
+	out_reqs  => [ "in_r3 !in_r0 !in_r1", "flags", "mem" ],
+	ins       => [ "base", "index", "mem", "val" ],
+	outs      => [ "res", "flags", "M" ],
+	attr      => "x86_insn_size_t size",
+	emit      => "lock xadd%M %S3, %AM",
+	latency   => 2,
+},
+
+# xchg with a memory operand is implicitly locked
+XchgMem => {
+	state     => "exc_pinned",
+	constructors => {
+		""     => { in_reqs => [ "gp", "gp", "mem", "gp" ] },
+		"8bit" => { in_reqs => [ "gp", "gp", "mem", "eax ebx ecx edx" ] },
+	},
+	out_reqs  => [ "in_r3 !in_r0 !in_r1", "mem" ],
+	ins       => [ "base", "index", "mem", "val" ],
+	outs      => [ "res", "M" ],
+	attr      => "x86_insn_size_t size",
+	emit      => "xchg%M %S3, %AM",
+	latency   => 2,
+},
+
+LockAndMem => {
+	template => $lock_binop_mem,
+	name     => "and",
+	encode   => "ia32_enc_simple(0xF0); ia32_enc_binop_mem(node, 4)",
+	latency  => 2,
+},
+
+LockOrMem => {
+	template => $lock_binop_mem,
+	name     => "or",
+	encode   => "ia32_enc_simple(0xF0); ia32_enc_binop_mem(node, 1)",
+	latency  => 2,
+},
+
+LockXorMem => {
+	template => $lock_binop_mem,
+	name     => "xor",
+	encode   => "ia32_enc_simple(0xF0); ia32_enc_binop_mem(node, 6)",
+	latency  => 2,
+},
+
+MFence => {
+	template => $memop,
+	latency  => 3,
+	emit     => "mfence",
+},
+
+# sequentially consistent fence for CPUs without SSE2
+LockOrStack => {
+	template  => $memop,
+	irn_flags => [ "modify_flags" ],
+	latency   => 3,
+	emit      => "lock orl \$0, (%%esp)",
+},
+
 Breakpoint => {
 	template => $memop,
 	latency  => 0,
@@ -1554,6 +1633,16 @@ CopyB_i => {
 	latency   => 3,
 },
 
+CopyB_vec => {
+	in_reqs   => [ "gp", "gp", "mem" ],
+	out_reqs  => [ "xmm", "mem" ],
+	ins       => [ "dest", "source", "mem" ],
+	outs      => [ "tmp", "M" ],
+	attr_type => "ia32_copyb_attr_t",
+	attr      => "unsigned size",
+	latency   => 3,
+},
+
 Cwtl => {
 	in_reqs  => [ "eax" ],
 	out_reqs => [ "eax" ],
@@ -4539,14 +4539,24 @@ static ir_node *gen_CopyB(ir_node *node)
 	ir_node  *mem      = get_CopyB_mem(node);
 	ir_node  *new_mem  = be_transform_node(mem);
 	dbg_info *dbgi     = get_irn_dbg_info(node);
-	int      size      = get_type_size(get_CopyB_type(node));
-	int      rem;
+	unsigned  size     = get_type_size(get_CopyB_type(node));
 
-	/* If we have to copy more than 32 bytes, we use REP MOVSx and */
-	/* then we need the size explicitly in ECX.                    */
 	ir_node *projm;
-	if (size >= 32 * 4) {
-		rem = size & 0x3; /* size % 4 */
+	if (size <= ia32_cg_config.copyb_max_vector) {
+		ir_node *copyb = new_bd_ia32_CopyB_vec(dbgi, block, new_dst, new_src,
+		                                       new_mem, size);
+		projm = be_new_Proj(copyb, pn_ia32_CopyB_vec_M);
+	} else if (ia32_cg_config.use_erms) {
+		/* With fast strings REP MOVSB copies the whole block at once. */
+		x86_imm32_t imm = { .offset = size };
+		ir_node *cnst  = new_bd_ia32_Const(dbgi, block, &imm);
+		ir_node *copyb = new_bd_ia32_CopyB(dbgi, block, new_dst, new_src, cnst,
+		                                   new_mem, 0);
+		projm = be_new_Proj(copyb, pn_ia32_CopyB_M);
+	} else if (size >= 32 * 4) {
+		/* If we have to copy more than 32 bytes, we use REP MOVSx and */
+		/* then we need the size explicitly in ECX.                    */
+		unsigned rem = size & 0x3; /* size % 4 */
 		size >>= 2;
 
 		x86_imm32_t imm = { .offset = size };
@@ -5146,6 +5156,158 @@ static ir_node *gen_compare_swap(ir_node *node)
 	return new_node;
 }
 
+/**
+ * Transform atomic fetch_add, fetch_sub and exchange builtins.
+ */
+static ir_node *gen_atomic_xadd_xchg(ir_node *node)
+{
+	dbg_info       *dbgi  = get_irn_dbg_info(node);
+	ir_node        *block = be_transform_nodes_block(node);
+	ir_node        *ptr   = get_Builtin_param(node, 0);
+	ir_node        *val   = get_Builtin_param(node, 1);
+	ir_node        *mem   = get_Builtin_mem(node);
+	ir_builtin_kind kind  = get_Builtin_kind(node);
+	ir_mode        *mode  = get_irn_mode(val);
+	assert(mode_is_int(mode) && get_mode_size_bits(mode) <= 32);
+
+	x86_address_t addr;
+	build_address_ptr(&addr, ptr, mem, x86_create_am_normal);
+	x86_insn_size_t size    = x86_size_from_mode(mode);
+	ir_node        *new_val = be_transform_node(val);
+	if (kind == ir_bk_atomic_fetch_sub)
+		new_val = new_bd_ia32_Neg(dbgi, block, new_val, size);
+
+	ir_node *new_node;
+	if (kind == ir_bk_atomic_exchange || kind == ir_bk_atomic_store) {
+		new_node = size == X86_SIZE_8
+			? new_bd_ia32_XchgMem_8bit(dbgi, block, addr.base, addr.index, addr.mem, new_val, size)
+			: new_bd_ia32_XchgMem     (dbgi, block, addr.base, addr.index, addr.mem, new_val, size);
+	} else {
+		new_node = size == X86_SIZE_8
+			? new_bd_ia32_XAddMem_8bit(dbgi, block, addr.base, addr.index, addr.mem, new_val, size)
+			: new_bd_ia32_XAddMem     (dbgi, block, addr.base, addr.index, addr.mem, new_val, size);
+	}
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	set_ia32_op_type(new_node, ia32_AddrModeD);
+	set_address(new_node, &addr);
+	return new_node;
+}
+
+/**
+ * Transform atomic and/or/xor builtins. Their result must be unused, the
+ * ones with a used result have been lowered to compare-and-swap loops.
+ */
+static ir_node *gen_atomic_logic(ir_node *node)
+{
+	dbg_info *dbgi  = get_irn_dbg_info(node);
+	ir_node  *block = be_transform_nodes_block(node);
+	ir_node  *ptr   = get_Builtin_param(node, 0);
+	ir_node  *val   = get_Builtin_param(node, 1);
+	ir_node  *mem   = get_Builtin_mem(node);
+	ir_mode  *mode  = get_irn_mode(val);
+	assert(mode_is_int(mode) && get_mode_size_bits(mode) <= 32);
+
+	x86_address_t addr;
+	build_address_ptr(&addr, ptr, mem, x86_create_am_normal);
+	x86_insn_size_t size    = x86_size_from_mode(mode);
+	ir_node        *new_val = try_create_Immediate(val, 'i');
+	if (!new_val)
+		new_val = be_transform_node(val);
+
+	construct_binop_dest_func *cons;
+	construct_binop_dest_func *cons8;
+	switch (get_Builtin_kind(node)) {
+	case ir_bk_atomic_fetch_and:
+		cons  = new_bd_ia32_LockAndMem;
+		cons8 = new_bd_ia32_LockAndMem_8bit;
+		break;
+	case ir_bk_atomic_fetch_or:
+		cons  = new_bd_ia32_LockOrMem;
+		cons8 = new_bd_ia32_LockOrMem_8bit;
+		break;
+	case ir_bk_atomic_fetch_xor:
+		cons  = new_bd_ia32_LockXorMem;
+		cons8 = new_bd_ia32_LockXorMem_8bit;
+		break;
+	default:
+		panic("unexpected atomic builtin %+F", node);
+	}
+	ir_node *new_node = (size == X86_SIZE_8 ? cons8 : cons)(dbgi, block,
+		addr.base, addr.index, addr.mem, new_val, size);
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	set_ia32_op_type(new_node, ia32_AddrModeD);
+	set_address(new_node, &addr);
+	return new_node;
+}
+
+/**
+ * Transform an atomic load. Plain loads already have acquire semantics on
+ * x86, so no fence is needed for any memory order.
+ */
+static ir_node *gen_atomic_load(ir_node *node)
+{
+	dbg_info *dbgi  = get_irn_dbg_info(node);
+	ir_node  *block = be_transform_nodes_block(node);
+	ir_node  *ptr   = get_Builtin_param(node, 0);
+	ir_node  *mem   = get_Builtin_mem(node);
+	ir_type  *tp    = get_Builtin_type(node);
+	ir_type  *res_tp = get_method_res_type(tp, 0);
+	ir_mode  *mode  = get_type_mode(res_tp);
+	assert(mode_is_int(mode) && get_mode_size_bits(mode) <= 32);
+
+	x86_address_t addr;
+	build_address_ptr(&addr, ptr, mem, x86_create_am_normal);
+	x86_insn_size_t size     = x86_size_from_mode(mode);
+	ir_node        *new_node = new_bd_ia32_Load(dbgi, block, addr.base,
+	                                            addr.index, addr.mem, size,
+	                                            mode_is_signed(mode));
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	set_ia32_op_type(new_node, ia32_AddrModeS);
+	set_address(new_node, &addr);
+	return new_node;
+}
+
+/**
+ * Transform an atomic store. Sequentially consistent stores use the
+ * implicitly locked xchg, weaker ones are plain stores.
+ */
+static ir_node *gen_atomic_store(ir_node *node)
+{
+	if (get_Builtin_order(node) == ir_memory_order_seq_cst)
+		return gen_atomic_xadd_xchg(node);
+
+	dbg_info *dbgi  = get_irn_dbg_info(node);
+	ir_node  *block = be_transform_nodes_block(node);
+	ir_node  *ptr   = get_Builtin_param(node, 0);
+	ir_node  *val   = get_Builtin_param(node, 1);
+	ir_node  *mem   = get_Builtin_mem(node);
+	assert(mode_is_int(get_irn_mode(val)));
+
+	x86_address_t addr;
+	build_address_ptr(&addr, ptr, mem, x86_create_am_normal);
+	ir_node *new_node = create_store(dbgi, block, val, &addr);
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	return new_node;
+}
+
+/**
+ * Transform an atomic fence. Only sequentially consistent fences need an
+ * instruction on x86, the weaker orders are implied by the memory model.
+ */
+static ir_node *gen_atomic_fence(ir_node *node)
+{
+	ir_node *mem     = get_Builtin_mem(node);
+	ir_node *new_mem = be_transform_node(mem);
+	if (get_Builtin_order(node) != ir_memory_order_seq_cst)
+		return new_mem;
+
+	dbg_info *dbgi  = get_irn_dbg_info(node);
+	ir_node  *block = be_transform_nodes_block(node);
+	if (ia32_cg_config.use_sse2)
+		return new_bd_ia32_MFence(dbgi, block, new_mem);
+	return new_bd_ia32_LockOrStack(dbgi, block, new_mem);
+}
+
 static ir_node *create_lea_frameaddress(dbg_info *const dbgi,
                                         ir_node *const block,
                                         ir_entity *const entity)
@@ -5218,6 +5380,20 @@ static ir_node *gen_Builtin(ir_node *node)
 		return gen_compare_swap(node);
 	case ir_bk_va_start:
 		return gen_va_start(node);
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_exchange:
+		return gen_atomic_xadd_xchg(node);
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+		return gen_atomic_logic(node);
+	case ir_bk_atomic_load:
+		return gen_atomic_load(node);
+	case ir_bk_atomic_store:
+		return gen_atomic_store(node);
+	case ir_bk_atomic_fence:
+		return gen_atomic_fence(node);
 	case ir_bk_may_alias:
 	case ir_bk_va_arg:
 		break;
@@ -5277,6 +5453,40 @@ static ir_node *gen_Proj_Builtin(ir_node *proj)
 			return new_node;
 		}
 		break;
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_exchange:
+		if (is_ia32_XchgMem(new_node)) {
+			if (get_Proj_num(proj) == pn_Builtin_M)
+				return be_new_Proj(new_node, pn_ia32_XchgMem_M);
+			assert(get_Proj_num(proj) == pn_Builtin_max + 1);
+			return be_new_Proj(new_node, pn_ia32_XchgMem_res);
+		}
+		assert(is_ia32_XAddMem(new_node));
+		if (get_Proj_num(proj) == pn_Builtin_M)
+			return be_new_Proj(new_node, pn_ia32_XAddMem_M);
+		assert(get_Proj_num(proj) == pn_Builtin_max + 1);
+		return be_new_Proj(new_node, pn_ia32_XAddMem_res);
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+		assert(get_Proj_num(proj) == pn_Builtin_M);
+		assert((int)pn_ia32_LockAndMem_M == (int)pn_ia32_LockOrMem_M
+		    && (int)pn_ia32_LockOrMem_M == (int)pn_ia32_LockXorMem_M);
+		return be_new_Proj(new_node, pn_ia32_LockAndMem_M);
+	case ir_bk_atomic_load:
+		if (get_Proj_num(proj) == pn_Builtin_M)
+			return be_new_Proj(new_node, pn_ia32_Load_M);
+		assert(get_Proj_num(proj) == pn_Builtin_max + 1);
+		return be_new_Proj(new_node, pn_ia32_Load_res);
+	case ir_bk_atomic_store:
+		assert(get_Proj_num(proj) == pn_Builtin_M);
+		if (is_ia32_XchgMem(new_node))
+			return be_new_Proj(new_node, pn_ia32_XchgMem_M);
+		return be_new_Proj(new_node, pn_ia32_Store_M);
+	case ir_bk_atomic_fence:
+		assert(get_Proj_num(proj) == pn_Builtin_M);
+		return new_node;
 	case ir_bk_may_alias:
 	case ir_bk_va_arg:
 		break;
@@ -0,0 +1,161 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Querying the features of the host x86 cpu.
+ * @author  Michael Beck, Matthias Braun
+ */
+#include "x86_cpuid.h"
+
+#ifdef NATIVE_X86
+
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+typedef union {
+	struct {
+		unsigned eax;
+		unsigned ebx;
+		unsigned ecx;
+		unsigned edx;
+	} r;
+	int bulk[4];
+} cpuid_registers;
+
+static void x86_cpuid(cpuid_registers *regs, unsigned level, unsigned subleaf)
+{
+#if defined(__GNUC__)
+#	if defined(__PIC__) && !defined(__amd64) // GCC cannot handle EBX in PIC
+	__asm (
+		"movl %%ebx, %1\n\t"
+		"cpuid\n\t"
+		"xchgl %%ebx, %1"
+	: "=a" (regs->r.eax), "=r" (regs->r.ebx), "=c" (regs->r.ecx), "=d" (regs->r.edx)
+	: "a" (level), "c" (subleaf)
+	);
+#	else
+	__asm ("cpuid\n\t"
+	: "=a" (regs->r.eax), "=b" (regs->r.ebx), "=c" (regs->r.ecx), "=d" (regs->r.edx)
+	: "a" (level), "c" (subleaf)
+	);
+#	endif
+#elif defined(_MSC_VER)
+	__cpuidex(regs->bulk, level, subleaf);
+#else
+#	error CPUID is missing
+#endif
+}
+
+static bool x86_toggle_cpuid(void)
+{
+	unsigned eflags_before = 0;
+	unsigned eflags_after = 0;
+
+#if defined(__GNUC__)
+#ifdef __i386__
+	/* If bit 21 of the EFLAGS register can be changed, the cpuid instruction is available */
+	__asm__(
+		"pushf\n\t"
+		"popl %0\n\t"
+		"movl %0, %1\n\t"
+		"xorl $0x00200000, %1\n\t"
+		"pushl %1\n\t"
+		"popf\n\t"
+		"pushf\n\t"
+		"popl %1"
+		: "=r" (eflags_before), "=r" (eflags_after) :: "cc"
+		);
+#else
+	eflags_after = 0x00200000;
+#endif
+#elif defined(_MSC_VER)
+#if defined(_M_IX86)
+	__asm {
+		pushfd
+		pop eax
+		mov eflags_before, eax
+		xor eax, 0x00200000
+		push eax
+		popfd
+		pushfd
+		pop eax
+		mov eflags_after, eax
+	}
+#else
+	eflags_after = 0x00200000;
+#endif
+#endif
+	return (eflags_before ^ eflags_after) & 0x00200000;
+}
+
+/** Returns true if the operating system saves the xmm and ymm state. */
+static bool x86_os_saves_ymm(void)
+{
+	unsigned xcr0;
+#if defined(__GNUC__)
+	unsigned edx;
+	/* xgetbv, spelled out for assemblers which do not know it */
+	__asm (".byte 0x0f, 0x01, 0xd0"
+	: "=a" (xcr0), "=d" (edx)
+	: "c" (0)
+	);
+	(void)edx;
+#elif defined(_MSC_VER)
+	xcr0 = (unsigned)_xgetbv(0);
+#endif
+	return (xcr0 & 0x6) == 0x6;
+}
+
+bool x86_get_cpu_info(x86_cpu_info_t *info)
+{
+	memset(info, 0, sizeof(*info));
+	if (!x86_toggle_cpuid())
+		return false;
+
+	/* get vendor ID */
+	cpuid_registers regs;
+	x86_cpuid(&regs, 0, 0);
+	unsigned const max_level = regs.r.eax;
+	memcpy(&info->vendor[0], &regs.r.ebx, 4);
+	memcpy(&info->vendor[4], &regs.r.edx, 4);
+	memcpy(&info->vendor[8], &regs.r.ecx, 4);
+	info->vendor[12] = '\0';
+
+	/* get processor info and feature bits */
+	x86_cpuid(&regs, 1, 0);
+	info->cpu_stepping   = (regs.r.eax >>  0) & 0x0F;
+	info->cpu_model      = (regs.r.eax >>  4) & 0x0F;
+	info->cpu_family     = (regs.r.eax >>  8) & 0x0F;
+	info->cpu_type       = (regs.r.eax >> 12) & 0x03;
+	info->cpu_ext_model  = (regs.r.eax >> 16) & 0x0F;
+	info->cpu_ext_family = (regs.r.eax >> 20) & 0xFF;
+	info->edx_features   = regs.r.edx;
+	info->ecx_features   = regs.r.ecx;
+	info->add_features   = regs.r.ebx;
+
+	if (max_level >= 7) {
+		x86_cpuid(&regs, 7, 0);
+		info->ebx_features_7 = regs.r.ebx;
+	}
+
+	x86_cpuid(&regs, 0x80000000, 0);
+	if (regs.r.eax >= 0x80000001) {
+		x86_cpuid(&regs, 0x80000001, 0);
+		info->ecx_features_ext = regs.r.ecx;
+	}
+
+	/* VEX encoded instructions fault unless the OS enabled the ymm state */
+	if (!(info->ecx_features & CPUID_FEAT_ECX_OSXSAVE) || !x86_os_saves_ymm()) {
+		info->ecx_features   &= ~(unsigned)(CPUID_FEAT_ECX_AVX | CPUID_FEAT_ECX_FMA);
+		info->ebx_features_7 &= ~(unsigned)CPUID_FEAT7_EBX_AVX2;
+	}
+	return true;
+}
+
+#endif /* NATIVE_X86 */
@@ -0,0 +1,123 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Querying the features of the host x86 cpu.
+ * @author  Michael Beck, Matthias Braun
+ */
+#ifndef FIRM_BE_IA32_X86_CPUID_H
+#define FIRM_BE_IA32_X86_CPUID_H
+
+#include <stdbool.h>
+
+#undef NATIVE_X86
+
+#ifdef _MSC_VER
+#if defined(_M_IX86) || defined(_M_X64)
+#define NATIVE_X86
+#endif
+#else
+#if defined(__i386__) || defined(__x86_64__)
+#define NATIVE_X86
+#endif
+#endif
+
+/* auto detection code only works if we're on an x86 cpu obviously */
+#ifdef NATIVE_X86
+typedef struct x86_cpu_info_t {
+	char          vendor[13];       /**< vendor id string */
+	unsigned char cpu_stepping;
+	unsigned char cpu_model;
+	unsigned char cpu_family;
+	unsigned char cpu_type;
+	unsigned char cpu_ext_model;
+	unsigned char cpu_ext_family;
+	unsigned      edx_features;     /**< leaf 1, edx */
+	unsigned      ecx_features;     /**< leaf 1, ecx */
+	unsigned      add_features;     /**< leaf 1, ebx */
+	unsigned      ebx_features_7;   /**< leaf 7 subleaf 0, ebx */
+	unsigned      ecx_features_ext; /**< leaf 0x80000001, ecx */
+} x86_cpu_info_t;
+
+enum {
+	CPUID_FEAT_ECX_SSE3      = 1 << 0,
+	CPUID_FEAT_ECX_PCLMUL    = 1 << 1,
+	CPUID_FEAT_ECX_DTES64    = 1 << 2,
+	CPUID_FEAT_ECX_MONITOR   = 1 << 3,
+	CPUID_FEAT_ECX_DS_CPL    = 1 << 4,
+	CPUID_FEAT_ECX_VMX       = 1 << 5,
+	CPUID_FEAT_ECX_SMX       = 1 << 6,
+	CPUID_FEAT_ECX_EST       = 1 << 7,
+	CPUID_FEAT_ECX_TM2       = 1 << 8,
+	CPUID_FEAT_ECX_SSSE3     = 1 << 9,
+	CPUID_FEAT_ECX_CID       = 1 << 10,
+	CPUID_FEAT_ECX_FMA       = 1 << 12,
+	CPUID_FEAT_ECX_CX16      = 1 << 13,
+	CPUID_FEAT_ECX_ETPRD     = 1 << 14,
+	CPUID_FEAT_ECX_PDCM      = 1 << 15,
+	CPUID_FEAT_ECX_DCA       = 1 << 18,
+	CPUID_FEAT_ECX_SSE4_1    = 1 << 19,
+	CPUID_FEAT_ECX_SSE4_2    = 1 << 20,
+	CPUID_FEAT_ECX_x2APIC    = 1 << 21,
+	CPUID_FEAT_ECX_MOVBE     = 1 << 22,
+	CPUID_FEAT_ECX_POPCNT    = 1 << 23,
+	CPUID_FEAT_ECX_AES       = 1 << 25,
+	CPUID_FEAT_ECX_XSAVE     = 1 << 26,
+	CPUID_FEAT_ECX_OSXSAVE   = 1 << 27,
+	CPUID_FEAT_ECX_AVX       = 1 << 28,
+
+	CPUID_FEAT_EDX_FPU       = 1 << 0,
+	CPUID_FEAT_EDX_VME       = 1 << 1,
+	CPUID_FEAT_EDX_DE        = 1 << 2,
+	CPUID_FEAT_EDX_PSE       = 1 << 3,
+	CPUID_FEAT_EDX_TSC       = 1 << 4,
+	CPUID_FEAT_EDX_MSR       = 1 << 5,
+	CPUID_FEAT_EDX_PAE       = 1 << 6,
+	CPUID_FEAT_EDX_MCE       = 1 << 7,
+	CPUID_FEAT_EDX_CX8       = 1 << 8,
+	CPUID_FEAT_EDX_APIC      = 1 << 9,
+	CPUID_FEAT_EDX_SEP       = 1 << 11,
+	CPUID_FEAT_EDX_MTRR      = 1 << 12,
+	CPUID_FEAT_EDX_PGE       = 1 << 13,
+	CPUID_FEAT_EDX_MCA       = 1 << 14,
+	CPUID_FEAT_EDX_CMOV      = 1 << 15,
+	CPUID_FEAT_EDX_PAT       = 1 << 16,
+	CPUID_FEAT_EDX_PSE36     = 1 << 17,
+	CPUID_FEAT_EDX_PSN       = 1 << 18,
+	CPUID_FEAT_EDX_CLF       = 1 << 19,
+	CPUID_FEAT_EDX_DTES      = 1 << 21,
+	CPUID_FEAT_EDX_ACPI      = 1 << 22,
+	CPUID_FEAT_EDX_MMX       = 1 << 23,
+	CPUID_FEAT_EDX_FXSR      = 1 << 24,
+	CPUID_FEAT_EDX_SSE       = 1 << 25,
+	CPUID_FEAT_EDX_SSE2      = 1 << 26,
+	CPUID_FEAT_EDX_SS        = 1 << 27,
+	CPUID_FEAT_EDX_HTT       = 1 << 28,
+	CPUID_FEAT_EDX_TM1       = 1 << 29,
+	CPUID_FEAT_EDX_IA64      = 1 << 30,
+	CPUID_FEAT_EDX_PBE       = 1 << 31,
+
+	CPUID_FEAT7_EBX_BMI1     = 1 << 3,
+	CPUID_FEAT7_EBX_AVX2     = 1 << 5,
+	CPUID_FEAT7_EBX_BMI2     = 1 << 8,
+	CPUID_FEAT7_EBX_ERMS     = 1 << 9,
+
+	CPUID_FEATEXT_ECX_ABM    = 1 << 5, /**< lzcnt */
+	CPUID_FEATEXT_ECX_SSE4A  = 1 << 6,
+};
+
+/**
+ * Fills @p info with the vendor, family and feature bits of the host cpu.
+ *
+ * The AVX, AVX2 and FMA bits are cleared if the operating system does not
+ * save the ymm state on context switches.
+ *
+ * @return false if the cpuid instruction is not available
+ */
+bool x86_get_cpu_info(x86_cpu_info_t *info);
+#endif
+
+#endif
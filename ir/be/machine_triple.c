@@ -121,6 +121,8 @@ ir_machine_triple_t *ir_get_host_machine_triple(void)
 		"i386";
 #elif defined(__mips__)
 		"mips";
+#elif defined(__riscv) && __riscv_xlen == 64
+		"riscv64";
 #elif defined(__riscv)
 		"riscv32";
 #elif defined(__sparc__)
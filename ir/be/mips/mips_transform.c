@@ -370,6 +370,15 @@ static ir_node *gen_Builtin(ir_node *const node)
 	switch (kind) {
 	case ir_bk_saturating_increment: return gen_saturating_increment(node);
 
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_fence:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
 	case ir_bk_bswap:
 	case ir_bk_clz:
 	case ir_bk_compare_swap:
@@ -842,6 +851,15 @@ static ir_node *gen_Proj_Builtin(ir_node *const node)
 		assert(get_Proj_num(node) == pn_Builtin_max + 1);
 		return new_pred;
 
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_fence:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
 	case ir_bk_bswap:
 	case ir_bk_clz:
 	case ir_bk_compare_swap:
@@ -1,6 +1,7 @@
 /**
  * @file
- * @brief       Implements function parameter lowering for the RISC-V ILP32 ABI
+ * @brief       Implements function parameter lowering for the RISC-V ILP32,
+ *              ILP32D, LP64 and LP64D ABIs
  * @author      Johannes Bucher
  */
 #include "riscv_abi.h"
@@ -76,20 +77,20 @@ static ir_mode *classify_slice_for_ilp32(ir_type const *const tp, unsigned min,
 			}
 		}
 		case tpo_primitive: {
-			ir_mode *mode = get_type_mode(tp);
 			if (min >= get_type_size(tp)) {
 				return mode_BAD;
-			} else if (mode_is_float(mode)) {
-				panic("RISC-V ILP32 ABI has no hardware floating point support");
 			} else {
-				return mode_Iu;
+				/* Floating point members are passed according to the integer
+				 * calling convention, unless the aggregate qualifies for
+				 * floating point registers, see classify_for_ilp32d(). */
+				return riscv_mode_gp;
 			}
 		}
 		case tpo_pointer:
 			if (min >= get_type_size(tp)) {
 				return mode_BAD;
 			} else {
-				return mode_Iu;
+				return riscv_mode_gp;
 			}
 
 		case tpo_code:
@@ -125,8 +126,10 @@ static aggregate_spec_t classify_for_ilp32(ir_type const *const type) {
 
 	/* if type has 8 byte alignment and result is two (4-byte) mode_Iu slices we have to convert this into
 	 * a single 8 byte mode_Lu slice to ensure correct alignment when passing the argument.
-	 * (Variadic arguments with 2*XLEN-bit alignment and size at most 2*XLEN bits are passed in an aligned register pair) */
-	if (result.length == 2 && result.modes[0] == mode_Iu && result.modes[1] == mode_Iu &&
+	 * (Variadic arguments with 2*XLEN-bit alignment and size at most 2*XLEN bits are passed in an aligned register pair)
+	 * TODO RV64 has no 128 bit mode to express this for 16 byte aligned types. */
+	if (!riscv_cg_config.rv64 &&
+	    result.length == 2 && result.modes[0] == mode_Iu && result.modes[1] == mode_Iu &&
 	    (get_type_alignment(type) == 2 * RISCV_REGISTER_SIZE)) {
 		result.length = 1;
 		result.modes[0] = mode_Lu;
@@ -135,11 +138,104 @@ static aggregate_spec_t classify_for_ilp32(ir_type const *const type) {
 	return result;
 }
 
+/**
+ * Collects the scalar fields of @p tp in @p modes and their offsets in
+ * @p offsets.  Returns false if there are more than two fields or a field is a
+ * bitfield.
+ */
+static bool flatten_fields(ir_type const *const tp, unsigned const offset,
+                           ir_mode **const modes, unsigned *const offsets,
+                           unsigned *const n)
+{
+	switch (get_type_opcode(tp)) {
+	case tpo_class:
+	case tpo_struct:
+	case tpo_union:
+		for (size_t i = 0, n_members = get_compound_n_members(tp); i < n_members; ++i) {
+			ir_entity *const member = get_compound_member(tp, i);
+			if (get_entity_bitfield_size(member) != 0)
+				return false;
+			ir_type const *const member_type = get_entity_type(member);
+			if (!flatten_fields(member_type, offset + get_entity_offset(member), modes, offsets, n))
+				return false;
+		}
+		return true;
+
+	case tpo_array: {
+		ir_type const *const elem_type = get_array_element_type(tp);
+		unsigned       const elem_size = get_type_size(elem_type);
+		if (elem_size == 0)
+			return true;
+		for (unsigned o = 0, size = get_type_size(tp); o < size; o += elem_size) {
+			if (!flatten_fields(elem_type, offset + o, modes, offsets, n))
+				return false;
+		}
+		return true;
+	}
+
+	case tpo_primitive:
+	case tpo_pointer:
+		if (*n == 2)
+			return false;
+		modes[*n]   = is_Pointer_type(tp) ? riscv_mode_gp : get_type_mode(tp);
+		offsets[*n] = offset;
+		++*n;
+		return true;
+
+	case tpo_code:
+	case tpo_method:
+	case tpo_segment:
+	case tpo_uninitialized:
+	case tpo_unknown:
+		break;
+	}
+	panic("invalid type");
+}
+
+/** Checks whether a field of mode @p mode may be passed in a register. */
+static bool fits_register(ir_mode *const mode)
+{
+	unsigned const size = mode_is_float(mode) ? 8 : RISCV_REGISTER_SIZE;
+	return get_mode_size_bytes(mode) <= size;
+}
+
+/**
+ * The ILP32D ABI passes aggregates consisting of one or two floating point
+ * fields in floating point registers, and aggregates consisting of one
+ * floating point and one integer field in a floating point and an integer
+ * register.  Other aggregates use the integer calling convention.
+ */
+static aggregate_spec_t classify_for_ilp32d(ir_type const *const type)
+{
+	ir_mode *modes[2];
+	unsigned offsets[2];
+	unsigned n = 0;
+	if (!flatten_fields(type, 0, modes, offsets, &n) || n == 0 ||
+	    !fits_register(modes[0]) || (n == 2 && !fits_register(modes[1])) ||
+	    !(mode_is_float(modes[0]) || (n == 2 && mode_is_float(modes[1]))))
+		return classify_for_ilp32(type);
+
+	if (n == 1) {
+		return (aggregate_spec_t) {
+			.length = 1,
+			.modes  = { modes[0] },
+		};
+	}
+	/* The lowering expects the fields to be adjacent. */
+	if (offsets[0] != 0 || offsets[1] != get_mode_size_bytes(modes[0]))
+		panic("passing %+F with padding between its fields is not implemented",
+		      type);
+	return (aggregate_spec_t) {
+		.length = 2,
+		.modes  = { modes[0], modes[1] },
+	};
+}
+
 aggregate_spec_t riscv_lower_parameter(void *env, ir_type const *type) {
 	(void)env;
 
 	if (is_aggregate_type(type)) {
-		return classify_for_ilp32(type);
+		return riscv_cg_config.use_softfloat ? classify_for_ilp32(type) : classify_for_ilp32d(type);
 	} else {
 		return (aggregate_spec_t) {
 				.length = 1,
@@ -40,45 +40,72 @@
 #include "util.h"
 
 typedef enum {
-	ilp32d,
-	ilp32,
+	abi_double,
+	abi_soft,
 } riscv_abi_t;
-static const lc_opt_enum_int_items_t abi_items[] = {
-		{ "ilp32d", ilp32d },
-		{ "ilp32",  ilp32  },
-		{ NULL,     0      },
+static const lc_opt_enum_int_items_t abi32_items[] = {
+		{ "ilp32d", abi_double },
+		{ "ilp32",  abi_soft   },
+		{ NULL,     0          },
+};
+static const lc_opt_enum_int_items_t abi64_items[] = {
+		{ "lp64d", abi_double },
+		{ "lp64",  abi_soft   },
+		{ NULL,    0          },
 };
 
 static int abi;
-static lc_opt_enum_int_var_t abi_var = {
-		&abi, abi_items
+static lc_opt_enum_int_var_t abi32_var = {
+		&abi, abi32_items
+};
+static lc_opt_enum_int_var_t abi64_var = {
+		&abi, abi64_items
 };
 
 typedef enum {
-	rv32imafd,
-	rv32ima,
+	isa_imafd,
+	isa_ima,
 } riscv_isa_t;
-static const lc_opt_enum_int_items_t isa_items[] = {
-		{ "rv32g",     rv32imafd },
-		{ "rv32imafd", rv32imafd },
-		{ "rv32ima",   rv32ima   },
+static const lc_opt_enum_int_items_t isa32_items[] = {
+		{ "rv32g",     isa_imafd },
+		{ "rv32imafd", isa_imafd },
+		{ "rv32ima",   isa_ima   },
+		{ NULL,        0         },
+};
+static const lc_opt_enum_int_items_t isa64_items[] = {
+		{ "rv64g",     isa_imafd },
+		{ "rv64imafd", isa_imafd },
+		{ "rv64ima",   isa_ima   },
 		{ NULL,        0         },
 };
 
 static int isa;
-static lc_opt_enum_int_var_t isa_var = {
-		&isa, isa_items
+static lc_opt_enum_int_var_t isa32_var = {
+		&isa, isa32_items
+};
+static lc_opt_enum_int_var_t isa64_var = {
+		&isa, isa64_items
 };
 
-static const lc_opt_table_entry_t riscv_options[] = {
-		LC_OPT_ENT_ENUM_INT("arch", "Generate code for given RISC-V ISA", &isa_var),
-		LC_OPT_ENT_ENUM_INT("abi",  "Specify integer and floating-point calling convention",  &abi_var),
+static const lc_opt_table_entry_t riscv32_options[] = {
+		LC_OPT_ENT_ENUM_INT("arch", "Generate code for given RISC-V ISA", &isa32_var),
+		LC_OPT_ENT_ENUM_INT("abi",  "Specify integer and floating-point calling convention",  &abi32_var),
 		LC_OPT_LAST
 };
 
-static bool use_softfloat;
+static const lc_opt_table_entry_t riscv64_options[] = {
+		LC_OPT_ENT_ENUM_INT("arch", "Generate code for given RISC-V ISA", &isa64_var),
+		LC_OPT_ENT_ENUM_INT("abi",  "Specify integer and floating-point calling convention",  &abi64_var),
+		LC_OPT_LAST
+};
+
+riscv_codegen_config_t riscv_cg_config;
+
+ir_mode *riscv_mode_gp;
 
-static ir_settings_arch_dep_t const riscv_arch_dep = {
+pmap *riscv_constants;
+
+static ir_settings_arch_dep_t riscv_arch_dep = {
 	.replace_muls         = true,
 	.replace_divs         = true,
 	.replace_mods         = true,
@@ -88,7 +115,7 @@ static ir_settings_arch_dep_t const riscv_arch_dep = {
 	.maximum_shifts       = 4,
 	.highest_shift_amount = 63,
 	.evaluate             = NULL,
-	.max_bits_for_mulh    = RISCV_MACHINE_SIZE,
+	.max_bits_for_mulh    = 0, /* set by riscv_init() */
 };
 
 /**
@@ -122,6 +149,9 @@ static int riscv_ifconv(ir_node const *const sel, ir_node const *const mux_false
 
 static void riscv_init(void)
 {
+	riscv_mode_gp = riscv_cg_config.rv64 ? mode_Lu : mode_Iu;
+	riscv_arch_dep.max_bits_for_mulh = RISCV_MACHINE_SIZE;
+
 	riscv_init_asm_constraints();
 	riscv_create_opcodes();
 	riscv_register_init();
@@ -132,14 +162,27 @@ static void riscv_init(void)
 	ir_target.float_int_overflow = ir_overflow_min_max;
 	ir_platform_set_va_list_type_pointer();
 
-	use_softfloat = ((riscv_isa_t)isa == rv32ima);
-	if (use_softfloat && (riscv_abi_t)abi == ilp32d) {
+	bool const use_softfloat = (riscv_isa_t)isa == isa_ima;
+	riscv_cg_config.use_softfloat = use_softfloat;
+	if (use_softfloat && (riscv_abi_t)abi == abi_double) {
 		panic("requested ABI requires -march to subsume the 'D' extension");
-	} else if (!use_softfloat && (riscv_abi_t)abi == ilp32) {
+	} else if (!use_softfloat && (riscv_abi_t)abi == abi_soft) {
 		panic("Use of hard-float instructions with soft-float ABI not supported yet");
 	}
 }
 
+static void riscv32_init(void)
+{
+	riscv_cg_config.rv64 = false;
+	riscv_init();
+}
+
+static void riscv64_init(void)
+{
+	riscv_cg_config.rv64 = true;
+	riscv_init();
+}
+
 static void riscv_finish(void)
 {
 	riscv_free_opcodes();
@@ -164,7 +207,17 @@ static ir_node *riscv_new_spill(ir_node *const value, ir_node *const after)
 		ir_graph *const irg   = get_irn_irg(after);
 		ir_node  *const nomem = get_irg_no_mem(irg);
 		ir_node  *const frame = get_irg_frame(irg);
-		ir_node  *const store = new_bd_riscv_sw(NULL, block, nomem, frame, value, NULL, 0);
+		ir_node  *const store = riscv_new_gp_store(NULL, block, nomem, frame, value, NULL, 0);
+		sched_add_after(after, store);
+		return store;
+	} else if (mode_is_float(mode)) {
+		/* Always spill the whole register, this preserves the NaN-boxing of
+		 * single precision values. */
+		ir_node  *const block = get_block(after);
+		ir_graph *const irg   = get_irn_irg(after);
+		ir_node  *const nomem = get_irg_no_mem(irg);
+		ir_node  *const frame = get_irg_frame(irg);
+		ir_node  *const store = new_bd_riscv_fsd(NULL, block, nomem, frame, value, NULL, 0);
 		sched_add_after(after, store);
 		return store;
 	}
@@ -178,9 +231,16 @@ static ir_node *riscv_new_reload(ir_node *const value, ir_node *const spill, ir_
 		ir_node  *const block = get_block(before);
 		ir_graph *const irg   = get_irn_irg(before);
 		ir_node  *const frame = get_irg_frame(irg);
-		ir_node  *const load  = new_bd_riscv_lw(NULL, block, spill, frame, NULL, 0);
+		ir_node  *const load  = riscv_new_gp_load(NULL, block, spill, frame, NULL, 0);
 		sched_add_before(before, load);
 		return be_new_Proj(load, pn_riscv_lw_res);
+	} else if (mode_is_float(mode)) {
+		ir_node  *const block = get_block(before);
+		ir_graph *const irg   = get_irn_irg(before);
+		ir_node  *const frame = get_irg_frame(irg);
+		ir_node  *const load  = new_bd_riscv_fld(NULL, block, spill, frame, NULL, 0);
+		sched_add_before(before, load);
+		return be_new_Proj(load, pn_riscv_fld_res);
 	}
 	TODO(value);
 }
@@ -196,14 +256,14 @@ static void riscv_collect_frame_entity_nodes(ir_node *const node, void *const da
 {
 	be_fec_env_t *const env = (be_fec_env_t*)data;
 
-	if (is_riscv_lw(node)) {
+	if (is_riscv_ld(node) || is_riscv_lw(node) || is_riscv_fld(node)) {
 		ir_node  *const base  = get_irn_n(node, n_riscv_lw_base);
 		ir_graph *const irg   = get_irn_irg(node);
 		ir_node  *const frame = get_irg_frame(irg);
 		if (base == frame) {
 			riscv_immediate_attr_t const *const attr = get_riscv_immediate_attr_const(node);
 			if (!attr->ent) {
-				unsigned const size     = RISCV_REGISTER_SIZE;
+				unsigned const size     = is_riscv_fld(node) ? RISCV_FP_REGISTER_SIZE : RISCV_REGISTER_SIZE;
 				unsigned const po2align = log2_floor(size);
 				be_load_needs_frame_entity(env, node, size, po2align);
 			}
@@ -272,7 +332,7 @@ static void riscv_introduce_prologue(ir_graph *const irg, unsigned size, bool om
 			sched_add_after(res, add);
 
 			/* save fp to stack */
-			ir_node *const store_fp = new_bd_riscv_sw(NULL, block, mem, add, start_fp, NULL, fp_save_offset);
+			ir_node *const store_fp = riscv_new_gp_store(NULL, block, mem, add, start_fp, NULL, fp_save_offset);
 			sched_add_after(add, store_fp);
 			edges_reroute_except(mem, store_fp, store_fp);
 
@@ -283,7 +343,7 @@ static void riscv_introduce_prologue(ir_graph *const irg, unsigned size, bool om
 			edges_reroute_except(start_fp, curr_fp, store_fp);
 		} else {
 			/* save fp to stack */
-			ir_node *const store_fp = new_bd_riscv_sw(NULL, block, mem, start_sp, start_fp, NULL, aligned + fp_save_offset);
+			ir_node *const store_fp = riscv_new_gp_store(NULL, block, mem, start_sp, start_fp, NULL, aligned + fp_save_offset);
 			sched_add_after(inc_sp, store_fp);
 			edges_reroute_except(mem, store_fp, store_fp);
 
@@ -312,7 +372,7 @@ static void riscv_introduce_epilogue(ir_node *const ret, unsigned const size, bo
 
 		/* restore old fp */
 		int fp_save_offset = is_variadic ? -(RISCV_N_PARAM_REGS + 1) * RISCV_REGISTER_SIZE : -RISCV_REGISTER_SIZE;
-		ir_node *const load_old_fp = new_bd_riscv_lw(NULL, block, curr_mem, curr_fp, NULL, fp_save_offset);
+		ir_node *const load_old_fp = riscv_new_gp_load(NULL, block, curr_mem, curr_fp, NULL, fp_save_offset);
 		curr_mem = be_new_Proj(load_old_fp, pn_riscv_lw_M);
 		ir_node *const old_fp  = be_new_Proj_reg(load_old_fp, pn_riscv_lw_res, &riscv_registers[REG_T0]);
 		sched_add_before(ret, load_old_fp);
@@ -355,7 +415,7 @@ static void riscv_introduce_prologue_epilogue(ir_graph *const irg, bool omit_fp)
 	}
 
 	if (is_variadic) {
-		size += 32;
+		size += RISCV_N_PARAM_REGS * RISCV_REGISTER_SIZE;
 	}
 
 	foreach_irn_in(get_irg_end_block(irg), i, ret) {
@@ -378,13 +438,20 @@ static void riscv_sp_sim(ir_node *const node, stack_pointer_state_t *const state
 	if (is_riscv_irn(node)) {
 		switch ((riscv_opcodes)get_riscv_irn_opcode(node)) {
 		case iro_riscv_addi:
+		case iro_riscv_fld:
+		case iro_riscv_flw:
 		case iro_riscv_FrameAddr:
+		case iro_riscv_fsd:
+		case iro_riscv_fsw:
 		case iro_riscv_lb:
 		case iro_riscv_lbu:
+		case iro_riscv_ld:
 		case iro_riscv_lh:
 		case iro_riscv_lhu:
 		case iro_riscv_lw:
+		case iro_riscv_lwu:
 		case iro_riscv_sb:
+		case iro_riscv_sd:
 		case iro_riscv_sh:
 		case iro_riscv_sw: {
 			riscv_immediate_attr_t *const imm = get_riscv_immediate_attr(node);
@@ -410,6 +477,7 @@ static void riscv_sp_sim(ir_node *const node, stack_pointer_state_t *const state
 
 static void riscv_generate_code(FILE *const output, char const *const cup_name)
 {
+	riscv_constants = pmap_create();
 	be_begin(output, cup_name);
 
 	unsigned *const sp_is_non_ssa = rbitset_alloca(N_RISCV_REGISTERS);
@@ -457,6 +525,7 @@ static void riscv_generate_code(FILE *const output, char const *const cup_name)
 	}
 
 	be_finish();
+	pmap_destroy(riscv_constants);
 }
 
 static void riscv32_lower_va_arg(ir_node *node)
@@ -532,7 +601,7 @@ static void riscv_lower_for_target(void)
 		be_after_transform(irg, "lower-copyb");
 	}
 
-	if (use_softfloat) {
+	if (riscv_cg_config.use_softfloat) {
 		lower_floating_point();
 		be_after_irp_transform("lower-fp");
 	}
@@ -552,8 +621,11 @@ static void riscv_lower_for_target(void)
 		be_after_transform(irg, "lower-switch");
 	}
 
-	riscv_lower64();
-	be_after_irp_transform("lower-64");
+	/* RV64 handles 64 bit values natively. */
+	if (!riscv_cg_config.rv64) {
+		riscv_lower64();
+		be_after_irp_transform("lower-64");
+	}
 
 	foreach_irp_irg(i, irg) {
 		lower_alloc(irg, RISCV_PO2_STACK_ALIGNMENT);
@@ -578,17 +650,37 @@ arch_isa_if_t const riscv32_isa_if = {
 	.registers             = riscv_registers,
 	.n_register_classes    = N_RISCV_CLASSES,
 	.register_classes      = riscv_reg_classes,
-	.init                  = riscv_init,
+	.init                  = riscv32_init,
+	.finish                = riscv_finish,
+	.generate_code         = riscv_generate_code,
+	.lower_for_target      = riscv_lower_for_target,
+	.get_op_estimated_cost = riscv_get_op_estimated_cost,
+};
+
+arch_isa_if_t const riscv64_isa_if = {
+	.name                  = "riscv64",
+	.pointer_size          = 8,
+	.modulo_shift          = 64,
+	.big_endian            = false,
+	.po2_biggest_alignment = 4,
+	.pic_supported         = false,
+	.n_registers           = N_RISCV_REGISTERS,
+	.registers             = riscv_registers,
+	.n_register_classes    = N_RISCV_CLASSES,
+	.register_classes      = riscv_reg_classes,
+	.init                  = riscv64_init,
 	.finish                = riscv_finish,
 	.generate_code         = riscv_generate_code,
 	.lower_for_target      = riscv_lower_for_target,
 	.get_op_estimated_cost = riscv_get_op_estimated_cost,
 };
 
-BE_REGISTER_MODULE_CONSTRUCTOR(be_init_arch_riscv32)
-void be_init_arch_riscv32(void)
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_arch_riscv)
+void be_init_arch_riscv(void)
 {
 	lc_opt_entry_t *be_grp = lc_opt_get_grp(firm_opt_get_root(), "be");
-	lc_opt_entry_t *riscv_grp = lc_opt_get_grp(be_grp, "riscv32");
-	lc_opt_add_table(riscv_grp, riscv_options);
+	lc_opt_entry_t *riscv32_grp = lc_opt_get_grp(be_grp, "riscv32");
+	lc_opt_add_table(riscv32_grp, riscv32_options);
+	lc_opt_entry_t *riscv64_grp = lc_opt_get_grp(be_grp, "riscv64");
+	lc_opt_add_table(riscv64_grp, riscv64_options);
 }
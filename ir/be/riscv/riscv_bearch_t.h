@@ -6,17 +6,30 @@
 #ifndef FIRM_BE_RISCV_RISCV_BEARCH_T_H
 #define FIRM_BE_RISCV_RISCV_BEARCH_T_H
 
-#define RISCV_MACHINE_SIZE 32
-#define RISCV_PO2_STACK_ALIGNMENT 4
-#define RISCV_REGISTER_SIZE 4
-#define RISCV_PARAM_STACK_ALIGN 4
-#define RISCV_N_PARAM_REGS  8
-
 #include <stdbool.h>
 #include <stdint.h>
 
 #include "beirg.h"
 #include "firm_types.h"
+#include "pmap.h"
+
+typedef struct riscv_codegen_config_t {
+	bool rv64;          /**< 64 bit registers (RV64), else RV32 */
+	bool use_softfloat; /**< no F and D extension */
+} riscv_codegen_config_t;
+
+extern riscv_codegen_config_t riscv_cg_config;
+
+#define RISCV_MACHINE_SIZE (riscv_cg_config.rv64 ? 64 : 32)
+#define RISCV_PO2_STACK_ALIGNMENT 4
+#define RISCV_REGISTER_SIZE (RISCV_MACHINE_SIZE / 8)
+#define RISCV_FP_REGISTER_SIZE 8
+#define RISCV_PARAM_STACK_ALIGN RISCV_REGISTER_SIZE
+#define RISCV_N_PARAM_REGS  8
+
+extern ir_mode *riscv_mode_gp; /**< mode_Iu on RV32, mode_Lu on RV64 */
+
+extern pmap *riscv_constants; /**< map from tarvals to their constant entities */
 
 typedef struct riscv_irg_data_t {
 	bool     omit_fp;        /**< No frame pointer is used. */
@@ -32,9 +45,19 @@ static inline bool is_uimm5(long const val)
 	return 0 <= val && val < 32;
 }
 
+static inline bool is_uimm6(long const val)
+{
+	return 0 <= val && val < 64;
+}
+
 static inline bool is_simm12(long const val)
 {
-	return -2048 <= (int32_t)val && (int32_t)val < 2048;
+	return -2048 <= val && val < 2048;
+}
+
+static inline bool is_simm32(long const val)
+{
+	return INT32_MIN <= val && val <= INT32_MAX;
 }
 
 typedef struct riscv_hi_lo_imm {
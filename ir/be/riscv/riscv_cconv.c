@@ -29,6 +29,22 @@ static unsigned const regs_result_gp[] = {
 	REG_A1,
 };
 
+static unsigned const regs_param_fp[] = {
+	REG_FA0,
+	REG_FA1,
+	REG_FA2,
+	REG_FA3,
+	REG_FA4,
+	REG_FA5,
+	REG_FA6,
+	REG_FA7,
+};
+
+static unsigned const regs_result_fp[] = {
+	REG_FA0,
+	REG_FA1,
+};
+
 static void check_omit_fp(ir_node *node, void *env)
 {
 	/* omit-fp is not possible if:
@@ -57,20 +73,27 @@ void riscv_determine_calling_convention(riscv_calling_convention_t *const cconv,
 	/* Handle parameters. */
 	riscv_reg_or_slot_t *params   = NULL;
 	size_t               gp_param = 0;
+	size_t               fp_param = 0;
+	size_t               va_param = 0;
 	size_t         const n_params = get_method_n_params(fun_type);
 	assert(is_method_variadic(fun_type) || named_parameters == n_params);
 	if (n_params != 0) {
 		params = XMALLOCNZ(riscv_reg_or_slot_t, n_params);
 
 		for (size_t i = 0; i != n_params; ++i) {
+			if (i == named_parameters)
+				va_param = gp_param;
 			ir_type *const param_type = get_method_param_type(fun_type, i);
 			ir_mode *const param_mode = get_type_mode(param_type);
 			if (!param_mode) {
 				panic("TODO");
-			} else if (mode_is_float(param_mode)) {
-				panic("TODO");
+			} else if (mode_is_float(param_mode) && i < named_parameters && fp_param < ARRAY_SIZE(regs_param_fp)) {
+				params[i].reg = &riscv_registers[regs_param_fp[fp_param++]];
 			} else {
-				if (i >= named_parameters && param_type->flags & tf_lowered_dw && gp_param % 2 != 0) {
+				/* Floating point values are passed according to the integer calling
+				 * convention if they are variadic or no fp register is left. */
+				bool const is_double = mode_is_float(param_mode) && get_mode_size_bytes(param_mode) > RISCV_REGISTER_SIZE;
+				if (i >= named_parameters && (param_type->flags & tf_lowered_dw || is_double) && gp_param % 2 != 0) {
 					// variadic arguments with 2 x XLEN size have to be passed in an aligned register pair / stack slots
 					++gp_param;
 				}
@@ -78,15 +101,23 @@ void riscv_determine_calling_convention(riscv_calling_convention_t *const cconv,
 					params[i].reg = &riscv_registers[regs_param_gp[gp_param]];
 				params[i].offset = (gp_param - offset) * RISCV_REGISTER_SIZE;
 				++gp_param;
+				if (is_double) {
+					if (gp_param < ARRAY_SIZE(regs_param_gp))
+						params[i].reg_hi = &riscv_registers[regs_param_gp[gp_param]];
+					++gp_param;
+				}
 			}
 		}
 	}
 
+	if (named_parameters >= n_params)
+		va_param = gp_param;
 	unsigned n_mem_param = gp_param > ARRAY_SIZE(regs_param_gp) ? gp_param - offset : 0;
 	cconv->param_stack_size  = n_mem_param * RISCV_REGISTER_SIZE;
 	cconv->n_mem_param       = n_mem_param;
+	cconv->n_param_regs_gp   = MIN(gp_param, ARRAY_SIZE(regs_param_gp));
 	cconv->parameters        = params;
-	cconv->va_arg_first_slot = named_parameters;
+	cconv->va_arg_first_slot = va_param;
 
 	/* Handle results. */
 	riscv_reg_or_slot_t *results   = NULL;
@@ -95,13 +126,16 @@ void riscv_determine_calling_convention(riscv_calling_convention_t *const cconv,
 		results = XMALLOCNZ(riscv_reg_or_slot_t, n_results);
 
 		size_t gp_res = 0;
+		size_t fp_res = 0;
 		for (size_t i = 0; i != n_results; ++i) {
 			ir_type *const res_type = get_method_res_type(fun_type, i);
 			ir_mode *const res_mode = get_type_mode(res_type);
 			if (!res_mode) {
 				panic("TODO");
 			} else if (mode_is_float(res_mode)) {
-				panic("TODO");
+				if (fp_res == ARRAY_SIZE(regs_result_fp))
+					panic("too many fp results");
+				results[i].reg = &riscv_registers[regs_result_fp[fp_res++]];
 			} else {
 				if (gp_res == ARRAY_SIZE(regs_result_gp))
 					panic("too many gp results");
@@ -132,13 +166,24 @@ void riscv_layout_parameter_entities(riscv_calling_convention_t *const cconv, ir
 		if (!is_atomic_type(param_type))
 			panic("unhandled parameter type");
 		ir_entity *param_ent = param_map[i];
-		if (!param->reg || is_method_variadic(fun_type)) {
+		bool const in_fp_reg = param->reg && param->reg->cls == &riscv_reg_classes[CLASS_riscv_fp];
+		if (!param->reg || (is_method_variadic(fun_type) && !in_fp_reg)) {
 			if (!param_ent)
 				param_ent = new_parameter_entity(frame_type, i, param_type);
 			assert(get_entity_offset(param_ent) == INVALID_OFFSET);
 			set_entity_offset(param_ent, param->offset);
 		}
 		param->entity = param_ent;
+
+		ir_mode *const param_mode = get_type_mode(param_type);
+		bool     const is_double  = mode_is_float(param_mode) && get_mode_size_bytes(param_mode) > RISCV_REGISTER_SIZE;
+		if (is_double && param->reg && !in_fp_reg && !param->reg_hi) {
+			/* The upper half of a double, whose lower half is passed in a7. */
+			ir_type   *const gp_type = get_type_for_mode(riscv_reg_classes[CLASS_riscv_gp].mode);
+			ir_entity *const hi_ent  = new_entity(frame_type, id_unique("param_hi"), gp_type);
+			set_entity_offset(hi_ent, param->offset + RISCV_REGISTER_SIZE);
+			param->entity_hi = hi_ent;
+		}
 	}
 	free(param_map);
 
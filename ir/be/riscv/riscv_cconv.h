@@ -11,8 +11,10 @@
 
 typedef struct riscv_reg_or_slot_t {
 	arch_register_t const *reg;
+	arch_register_t const *reg_hi;    /**< upper half of a double passed in gp registers */
 	unsigned               offset;
 	ir_entity             *entity;
+	ir_entity             *entity_hi; /**< stack slot of the upper half, if only the lower half is passed in a register */
 } riscv_reg_or_slot_t;
 
 typedef struct riscv_calling_convention_t {
@@ -20,6 +22,7 @@ typedef struct riscv_calling_convention_t {
 	                                           save/restore) */
 	unsigned             param_stack_size;
 	unsigned             n_mem_param;
+	unsigned             n_param_regs_gp;  /**< gp registers used by parameters */
 	unsigned             va_arg_first_slot;
 	riscv_reg_or_slot_t *parameters;
 	riscv_reg_or_slot_t *results;
@@ -14,6 +14,7 @@
 #include "beemitter.h"
 #include "begnuas.h"
 #include "besched.h"
+#include "entity_t.h"
 #include "gen_riscv_new_nodes.h"
 #include "gen_riscv_emitter.h"
 #include "gen_riscv_regalloc_if.h"
@@ -76,6 +77,12 @@ void riscv_emitf(ir_node const *const node, char const *fmt, ...)
 		case 'I': emit_immediate("%lo", node); break;
 		case 'J': emit_immediate(NULL,  node); break;
 
+		case 'M': {
+			ir_mode *const mode = get_riscv_fp_attr_const(node)->fp_mode;
+			be_emit_char(get_mode_size_bits(mode) == 32 ? 's' : 'd');
+			break;
+		}
+
 		case 'R':
 			emit_register(va_arg(ap, arch_register_t const*));
 			break;
@@ -180,6 +187,8 @@ static void emit_be_Copy(ir_node const *const node)
 
 	if (in->cls == &riscv_reg_classes[CLASS_riscv_gp]) {
 		riscv_emitf(node, "mv\t%R, %R", out, in);
+	} else if (in->cls == &riscv_reg_classes[CLASS_riscv_fp]) {
+		riscv_emitf(node, "fmv.d\t%R, %R", out, in);
 	} else {
 		panic("unexpected register class");
 	}
@@ -204,40 +213,63 @@ static void emit_be_Perm(ir_node const *const node)
 			"xor\t%D1, %D0, %D1\n"
 			"xor\t%D0, %D0, %D1"
 		);
+	} else if (out->cls == &riscv_reg_classes[CLASS_riscv_fp]) {
+		/* ft11 is not allocatable and serves as scratch register. */
+		riscv_emitf(node,
+			"fmv.d\tft11, %D0\n"
+			"fmv.d\t%D0, %D1\n"
+			"fmv.d\t%D1, ft11"
+		);
 	} else {
 		panic("unexpected register class");
 	}
 }
 
+/** Returns the number of words of a spill slot, fp spill slots occupy two. */
+static int get_spill_slot_words(ir_entity const *const entity)
+{
+	return entity->attr.spillslot.size / RISCV_REGISTER_SIZE;
+}
+
 static void emit_be_MemPerm(ir_node const *const node)
 {
 	/* TODO: this implementation is slower than necessary. */
 
 	bool const omit_fp      = riscv_get_irg_data(get_irn_irg(node))->omit_fp;
 	int const memperm_arity = be_get_MemPerm_entity_arity(node);
-	int const max_arity     = 23;
-	if (memperm_arity > max_arity)
-		panic("memperm with more than %d inputs not supported yet", max_arity);
+	int const max_words     = 23;
+	int       n_words       = 0;
+	for (int i = 0; i < memperm_arity; ++i) {
+		n_words += get_spill_slot_words(be_get_MemPerm_in_entity(node, i));
+	}
+	if (n_words > max_words)
+		panic("memperm with more than %d words not supported yet", max_words);
 
 	char const *const frame_base = omit_fp ? "sp" : "fp";
+	char const *const load       = riscv_cg_config.rv64 ? "ld" : "lw";
+	char const *const store      = riscv_cg_config.rv64 ? "sd" : "sw";
 
 	int const memperm_offset = be_get_MemPerm_offset(node);
 	int ent_offset = memperm_offset;
 
-	riscv_emitf(node, "addi\tsp, sp, -%d", memperm_arity * RISCV_REGISTER_SIZE);
+	riscv_emitf(node, "addi\tsp, sp, -%d", n_words * RISCV_REGISTER_SIZE);
+	int r = 0;
 	for (int i = 0; i < memperm_arity; ++i) {
-		/* spill register */
-		arch_register_t const *const reg = arch_register_for_index(&riscv_reg_classes[CLASS_riscv_gp], i + 9);
+		ir_entity *entity = be_get_MemPerm_in_entity(node, i);
+		int const  words  = get_spill_slot_words(entity);
+		for (int w = 0; w < words; ++w, ++r) {
+			/* spill register */
+			arch_register_t const *const reg = arch_register_for_index(&riscv_reg_classes[CLASS_riscv_gp], r + 9);
 
-		riscv_emitf(node, "sw\t%s, %d(sp)", reg->name, i * RISCV_REGISTER_SIZE);
+			riscv_emitf(node, "%s\t%s, %d(sp)", store, reg->name, r * RISCV_REGISTER_SIZE);
 
-		/* load from entity */
-		ir_entity *entity = be_get_MemPerm_in_entity(node, i);
-		int        offset = get_entity_offset(entity) + ent_offset;
-		if (omit_fp) {
-			offset += (memperm_arity * RISCV_REGISTER_SIZE);
+			/* load from entity */
+			int offset = get_entity_offset(entity) + ent_offset + w * RISCV_REGISTER_SIZE;
+			if (omit_fp) {
+				offset += (n_words * RISCV_REGISTER_SIZE);
+			}
+			riscv_emitf(node, "%s\t%s, %d(%s)", load, reg->name, offset, frame_base);
 		}
-		riscv_emitf(node, "lw\t%s, %d(%s)", reg->name, offset, frame_base);
 		ent_offset += 4;
 	}
 
@@ -245,17 +277,22 @@ static void emit_be_MemPerm(ir_node const *const node)
 		/* store to new entity */
 		ent_offset -= 4;
 		ir_entity *entity = be_get_MemPerm_out_entity(node, i);
-		int        offset = get_entity_offset(entity) + ent_offset;
-		if (omit_fp) {
-			offset += (memperm_arity * RISCV_REGISTER_SIZE);
+		int const  words  = get_spill_slot_words(be_get_MemPerm_in_entity(node, i));
+		for (int w = words; w-- > 0; ) {
+			--r;
+			int offset = get_entity_offset(entity) + ent_offset + w * RISCV_REGISTER_SIZE;
+			if (omit_fp) {
+				offset += (n_words * RISCV_REGISTER_SIZE);
+			}
+			arch_register_t const *const reg = arch_register_for_index(&riscv_reg_classes[CLASS_riscv_gp], r + 9);
+			riscv_emitf(node, "%s\t%s, %d(%s)", store, reg->name, offset, frame_base);
+			/* restore register */
+			riscv_emitf(node, "%s\t%s, %d(sp)", load, reg->name, r * RISCV_REGISTER_SIZE);
 		}
-		arch_register_t const *const reg = arch_register_for_index(&riscv_reg_classes[CLASS_riscv_gp], i + 9);
-		riscv_emitf(node, "sw\t%s, %d(%s)", reg->name, offset, frame_base);
-		/* restore register */
-		riscv_emitf(node, "lw\t%s, %d(sp)", reg->name, i * RISCV_REGISTER_SIZE);
 	}
-	riscv_emitf(node, "addi\tsp, sp, %d", memperm_arity * RISCV_REGISTER_SIZE);
+	riscv_emitf(node, "addi\tsp, sp, %d", n_words * RISCV_REGISTER_SIZE);
 	assert(ent_offset == memperm_offset);
+	assert(r == 0);
 }
 
 static void emit_riscv_bcc(ir_node const *const node)
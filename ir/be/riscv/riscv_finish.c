@@ -135,10 +135,10 @@ static void peephole_riscv_shift(ir_node *const node)
 	if (get_riscv_irn_opcode(pred) == opcode) {
 		riscv_immediate_attr_t *const node_attr_imm = get_riscv_immediate_attr(node);
 		riscv_immediate_attr_t *const pred_attr_imm = get_riscv_immediate_attr(pred);
-		if (!is_uimm5(node_attr_imm->val + pred_attr_imm->val)) {
+		int new_val = node_attr_imm->val + pred_attr_imm->val;
+		if (new_val >= RISCV_MACHINE_SIZE) {
 			return;
 		}
-		int new_val = node_attr_imm->val + pred_attr_imm->val;
 
 		dbg_info *dbgi  = get_irn_dbg_info(node);
 		ir_node  *block = get_nodes_block(node);
@@ -176,12 +176,19 @@ void riscv_finish_graph(ir_graph *irg)
 	/* perform legalizations (mostly fix nodes with too big immediates) */
 	ir_clear_opcodes_generic_func();
 	register_peephole_optimization(op_riscv_FrameAddr, finish_riscv_FrameAddr);
+	register_peephole_optimization(op_riscv_fld, finish_riscv_load_store_offsets);
+	register_peephole_optimization(op_riscv_flw, finish_riscv_load_store_offsets);
+	register_peephole_optimization(op_riscv_fsd, finish_riscv_load_store_offsets);
+	register_peephole_optimization(op_riscv_fsw, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_lb, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_lbu, finish_riscv_load_store_offsets);
+	register_peephole_optimization(op_riscv_ld, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_lh, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_lhu, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_lw, finish_riscv_load_store_offsets);
+	register_peephole_optimization(op_riscv_lwu, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_sb, finish_riscv_load_store_offsets);
+	register_peephole_optimization(op_riscv_sd, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_sh, finish_riscv_load_store_offsets);
 	register_peephole_optimization(op_riscv_sw, finish_riscv_load_store_offsets);
 
@@ -34,6 +34,15 @@ int riscv_cond_attrs_equal(ir_node const *const a, ir_node const *const b)
 		a_attr->cond == b_attr->cond;
 }
 
+int riscv_fp_attrs_equal(ir_node const *const a, ir_node const *const b)
+{
+	riscv_fp_attr_t const *const a_attr = get_riscv_fp_attr_const(a);
+	riscv_fp_attr_t const *const b_attr = get_riscv_fp_attr_const(b);
+	return
+		riscv_attrs_equal_(&a_attr->attr, &b_attr->attr) &&
+		a_attr->fp_mode == b_attr->fp_mode;
+}
+
 int riscv_immediate_attrs_equal(ir_node const *const a, ir_node const *const b)
 {
 	riscv_immediate_attr_t const *const a_attr = get_riscv_immediate_attr_const(a);
@@ -85,17 +94,28 @@ void riscv_dump_node(FILE *const F, ir_node const *const n, dump_reason_t const
 			fprintf(F, "%s", get_irn_opname(n));
 			switch ((riscv_opcodes)get_riscv_irn_opcode(n)) {
 			case iro_riscv_addi:
+			case iro_riscv_addiw:
+			case iro_riscv_fld:
+			case iro_riscv_flw:
+			case iro_riscv_fsd:
+			case iro_riscv_fsw:
 			case iro_riscv_lb:
 			case iro_riscv_lbu:
+			case iro_riscv_ld:
 			case iro_riscv_lh:
 			case iro_riscv_lhu:
 			case iro_riscv_lw:
+			case iro_riscv_lwu:
 			case iro_riscv_sb:
+			case iro_riscv_sd:
 			case iro_riscv_sh:
 			case iro_riscv_slli:
+			case iro_riscv_slliw:
 			case iro_riscv_sltiu:
 			case iro_riscv_srai:
+			case iro_riscv_sraiw:
 			case iro_riscv_srli:
+			case iro_riscv_srliw:
 			case iro_riscv_sw:
 				dump_immediate(F, "%lo", n);
 				break;
@@ -114,6 +134,31 @@ void riscv_dump_node(FILE *const F, ir_node const *const n, dump_reason_t const
 				break;
 			}
 
+			case iro_riscv_fadd:
+			case iro_riscv_fcvt_f_l:
+			case iro_riscv_fcvt_f_lu:
+			case iro_riscv_fcvt_f_w:
+			case iro_riscv_fcvt_f_wu:
+			case iro_riscv_fcvt_l_f:
+			case iro_riscv_fcvt_lu_f:
+			case iro_riscv_fcvt_w_f:
+			case iro_riscv_fcvt_wu_f:
+			case iro_riscv_fdiv:
+			case iro_riscv_feq:
+			case iro_riscv_fle:
+			case iro_riscv_flt:
+			case iro_riscv_fmadd:
+			case iro_riscv_fmsub:
+			case iro_riscv_fmul:
+			case iro_riscv_fneg:
+			case iro_riscv_fnmadd:
+			case iro_riscv_fnmsub:
+			case iro_riscv_fsub: {
+				riscv_fp_attr_t const *const attr = get_riscv_fp_attr_const(n);
+				fprintf(F, " %s", get_mode_name(attr->fp_mode));
+				break;
+			}
+
 			case iro_riscv_jal:
 				dump_immediate(F, NULL, n);
 				break;
@@ -123,9 +168,18 @@ void riscv_dump_node(FILE *const F, ir_node const *const n, dump_reason_t const
 				break;
 
 			case iro_riscv_add:
+			case iro_riscv_addw:
 			case iro_riscv_and:
 			case iro_riscv_div:
 			case iro_riscv_divu:
+			case iro_riscv_divuw:
+			case iro_riscv_divw:
+			case iro_riscv_fcvt_d_s:
+			case iro_riscv_fcvt_s_d:
+			case iro_riscv_fmv_d_x:
+			case iro_riscv_fmv_w_x:
+			case iro_riscv_fmv_x_d:
+			case iro_riscv_fmv_x_w:
 			case iro_riscv_FrameAddr:
 			case iro_riscv_ijmp:
 			case iro_riscv_j:
@@ -134,16 +188,23 @@ void riscv_dump_node(FILE *const F, ir_node const *const n, dump_reason_t const
 			case iro_riscv_mul:
 			case iro_riscv_mulh:
 			case iro_riscv_mulhu:
+			case iro_riscv_mulw:
 			case iro_riscv_or:
 			case iro_riscv_rem:
 			case iro_riscv_remu:
+			case iro_riscv_remuw:
+			case iro_riscv_remw:
 			case iro_riscv_ret:
 			case iro_riscv_sll:
+			case iro_riscv_sllw:
 			case iro_riscv_slt:
 			case iro_riscv_sltu:
 			case iro_riscv_sra:
+			case iro_riscv_sraw:
 			case iro_riscv_srl:
+			case iro_riscv_srlw:
 			case iro_riscv_sub:
+			case iro_riscv_subw:
 			case iro_riscv_SubSP:
 			case iro_riscv_SubSPimm:
 			case iro_riscv_switch:
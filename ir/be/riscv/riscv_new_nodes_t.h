@@ -21,6 +21,7 @@ void riscv_dump_node(FILE *F, const ir_node *n, dump_reason_t reason);
 int riscv_attrs_equal(ir_node const *a, ir_node const *b);
 int riscv_immediate_attrs_equal(ir_node const *a, ir_node const *b);
 int riscv_cond_attrs_equal(ir_node const *a, ir_node const *b);
+int riscv_fp_attrs_equal(ir_node const *a, ir_node const *b);
 int riscv_switch_attrs_equal(ir_node const *a, ir_node const *b);
 
 void riscv_set_attr_imm(ir_node *res, ir_entity *entity, int32_t immediate_value);
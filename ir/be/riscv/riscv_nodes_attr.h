@@ -40,6 +40,11 @@ typedef struct riscv_cond_attr_t {
 	riscv_cond_t cond;
 } riscv_cond_attr_t;
 
+typedef struct riscv_fp_attr_t {
+	riscv_attr_t attr;
+	ir_mode     *fp_mode; /**< mode_F or mode_D */
+} riscv_fp_attr_t;
+
 typedef struct riscv_immediate_attr_t {
 	riscv_attr_t attr;
 	ir_entity   *ent;
@@ -61,6 +66,11 @@ static inline riscv_cond_attr_t const *get_riscv_cond_attr_const(ir_node const *
 	return (riscv_cond_attr_t const*)get_irn_generic_attr_const(node);
 }
 
+static inline riscv_fp_attr_t const *get_riscv_fp_attr_const(ir_node const *const node)
+{
+	return (riscv_fp_attr_t const*)get_irn_generic_attr_const(node);
+}
+
 static inline riscv_immediate_attr_t *get_riscv_immediate_attr(ir_node *const node)
 {
 	return (riscv_immediate_attr_t*)get_irn_generic_attr(node);
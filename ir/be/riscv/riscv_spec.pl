@@ -3,7 +3,8 @@
 
 $arch = "riscv";
 
-my $mode_gp = "mode_Iu";
+my $mode_gp = "riscv_mode_gp";
+my $mode_fp = "mode_D";
 
 %reg_classes = (
 	gp => {
@@ -43,12 +44,51 @@ my $mode_gp = "mode_Iu";
 			{ name => "t6",   encoding => 31 },
 		]
 	},
+	fp => {
+		mode => $mode_fp,
+		registers => [
+			{ name => "ft0",  encoding =>  0 },
+			{ name => "ft1",  encoding =>  1 },
+			{ name => "ft2",  encoding =>  2 },
+			{ name => "ft3",  encoding =>  3 },
+			{ name => "ft4",  encoding =>  4 },
+			{ name => "ft5",  encoding =>  5 },
+			{ name => "ft6",  encoding =>  6 },
+			{ name => "ft7",  encoding =>  7 },
+			{ name => "fs0",  encoding =>  8 },
+			{ name => "fs1",  encoding =>  9 },
+			{ name => "fa0",  encoding => 10 },
+			{ name => "fa1",  encoding => 11 },
+			{ name => "fa2",  encoding => 12 },
+			{ name => "fa3",  encoding => 13 },
+			{ name => "fa4",  encoding => 14 },
+			{ name => "fa5",  encoding => 15 },
+			{ name => "fa6",  encoding => 16 },
+			{ name => "fa7",  encoding => 17 },
+			{ name => "fs2",  encoding => 18 },
+			{ name => "fs3",  encoding => 19 },
+			{ name => "fs4",  encoding => 20 },
+			{ name => "fs5",  encoding => 21 },
+			{ name => "fs6",  encoding => 22 },
+			{ name => "fs7",  encoding => 23 },
+			{ name => "fs8",  encoding => 24 },
+			{ name => "fs9",  encoding => 25 },
+			{ name => "fs10", encoding => 26 },
+			{ name => "fs11", encoding => 27 },
+			{ name => "ft8",  encoding => 28 },
+			{ name => "ft9",  encoding => 29 },
+			{ name => "ft10", encoding => 30 },
+			{ name => "ft11", encoding => 31 },
+		]
+	},
 );
 
 %init_attr = (
 	riscv_attr_t => "",
 	riscv_cond_attr_t =>
 		"attr->cond = cond;",
+	riscv_fp_attr_t =>
+		"attr->fp_mode = fp_mode;",
 	riscv_immediate_attr_t =>
 		"attr->ent = ent;\n".
 		"\tattr->val = val;",
@@ -106,12 +146,51 @@ my $storeOp = {
 	emit      => "{name}\t%S2, %A",
 };
 
+# The mode of floating point operations selects between the single (.s) and
+# double (.d) precision variant of the instruction.
+my $fpBinOp = {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp", "cls-fp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "left", "right" ],
+	outs      => [ "res" ],
+	attr_type => "riscv_fp_attr_t",
+	attr      => "ir_mode *const fp_mode",
+	emit      => "{name}.%M\t%D0, %S0, %S1",
+};
+
+my $fpFmaOp = {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp", "cls-fp", "cls-fp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "left", "right", "addend" ],
+	outs      => [ "res" ],
+	attr_type => "riscv_fp_attr_t",
+	attr      => "ir_mode *const fp_mode",
+	emit      => "{name}.%M\t%D0, %S0, %S1, %S2",
+};
+
+my $fpUnOp = {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	attr_type => "riscv_fp_attr_t",
+	attr      => "ir_mode *const fp_mode",
+	emit      => "{name}.%M\t%D0, %S0",
+};
+
 %nodes = (
 
 add => { template => $binOp },
 
 addi => { template => $immediateOp },
 
+addiw => { template => $immediateOp },
+
+addw => { template => $binOp },
+
 and => { template => $binOp },
 
 andi => { template => $immediateOp },
@@ -131,6 +210,165 @@ div => { template => $binOp, },
 
 divu => { template => $binOp, },
 
+divuw => { template => $binOp, },
+
+divw => { template => $binOp, },
+
+fadd => { template => $fpBinOp },
+
+fcvt_d_s => {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	emit      => "fcvt.d.s\t%D0, %S0",
+},
+
+fcvt_f_l => {
+	template  => $fpUnOp,
+	in_reqs   => [ "cls-gp" ],
+	emit      => "fcvt.%M.l\t%D0, %S0",
+},
+
+fcvt_f_lu => {
+	template  => $fpUnOp,
+	in_reqs   => [ "cls-gp" ],
+	emit      => "fcvt.%M.lu\t%D0, %S0",
+},
+
+fcvt_f_w => {
+	template  => $fpUnOp,
+	in_reqs   => [ "cls-gp" ],
+	emit      => "fcvt.%M.w\t%D0, %S0",
+},
+
+fcvt_f_wu => {
+	template  => $fpUnOp,
+	in_reqs   => [ "cls-gp" ],
+	emit      => "fcvt.%M.wu\t%D0, %S0",
+},
+
+fcvt_l_f => {
+	template  => $fpUnOp,
+	out_reqs  => [ "cls-gp" ],
+	emit      => "fcvt.l.%M\t%D0, %S0, rtz",
+},
+
+fcvt_lu_f => {
+	template  => $fpUnOp,
+	out_reqs  => [ "cls-gp" ],
+	emit      => "fcvt.lu.%M\t%D0, %S0, rtz",
+},
+
+fcvt_s_d => {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	emit      => "fcvt.s.d\t%D0, %S0",
+},
+
+fcvt_w_f => {
+	template  => $fpUnOp,
+	out_reqs  => [ "cls-gp" ],
+	emit      => "fcvt.w.%M\t%D0, %S0, rtz",
+},
+
+fcvt_wu_f => {
+	template  => $fpUnOp,
+	out_reqs  => [ "cls-gp" ],
+	emit      => "fcvt.wu.%M\t%D0, %S0, rtz",
+},
+
+fdiv => { template => $fpBinOp },
+
+feq => {
+	template  => $fpBinOp,
+	out_reqs  => [ "cls-gp" ],
+},
+
+fld => {
+	template  => $loadOp,
+	out_reqs  => [ "mem", "cls-fp" ],
+},
+
+fle => {
+	template  => $fpBinOp,
+	out_reqs  => [ "cls-gp" ],
+},
+
+flt => {
+	template  => $fpBinOp,
+	out_reqs  => [ "cls-gp" ],
+},
+
+flw => {
+	template  => $loadOp,
+	out_reqs  => [ "mem", "cls-fp" ],
+},
+
+fmadd => { template => $fpFmaOp },
+
+fmsub => { template => $fpFmaOp },
+
+fmul => { template => $fpBinOp },
+
+fmv_d_x => {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-gp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	emit      => "fmv.d.x\t%D0, %S0",
+},
+
+fmv_w_x => {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-gp" ],
+	out_reqs  => [ "cls-fp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	emit      => "fmv.w.x\t%D0, %S0",
+},
+
+fmv_x_d => {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp" ],
+	out_reqs  => [ "cls-gp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	emit      => "fmv.x.d\t%D0, %S0",
+},
+
+fmv_x_w => {
+	irn_flags => [ "rematerializable" ],
+	in_reqs   => [ "cls-fp" ],
+	out_reqs  => [ "cls-gp" ],
+	ins       => [ "val" ],
+	outs      => [ "res" ],
+	emit      => "fmv.x.w\t%D0, %S0",
+},
+
+fneg => { template => $fpUnOp },
+
+fnmadd => { template => $fpFmaOp },
+
+fnmsub => { template => $fpFmaOp },
+
+fsd => {
+	template  => $storeOp,
+	in_reqs   => [ "mem", "cls-gp", "cls-fp" ],
+},
+
+fsub => { template => $fpBinOp },
+
+fsw => {
+	template  => $storeOp,
+	in_reqs   => [ "mem", "cls-gp", "cls-fp" ],
+},
+
 ijmp => {
 	state    => "pinned",
 	op_flags => [ "cfopcode", "unknown_jump" ],
@@ -162,6 +400,8 @@ lb => { template => $loadOp },
 
 lbu => { template => $loadOp },
 
+ld => { template => $loadOp },
+
 lh => { template => $loadOp },
 
 lhu => { template => $loadOp },
@@ -175,12 +415,16 @@ lui => {
 
 lw => { template => $loadOp },
 
+lwu => { template => $loadOp },
+
 mul => { template => $binOp, },
 
 mulh => { template => $binOp, },
 
 mulhu => { template => $binOp, },
 
+mulw => { template => $binOp, },
+
 or => { template => $binOp },
 
 ori => { template => $immediateOp },
@@ -189,6 +433,10 @@ rem => { template => $binOp, },
 
 remu => { template => $binOp, },
 
+remuw => { template => $binOp, },
+
+remw => { template => $binOp, },
+
 ret => {
 	state    => "pinned",
 	op_flags => [ "cfopcode" ],
@@ -200,12 +448,18 @@ ret => {
 
 sb => { template => $storeOp },
 
+sd => { template => $storeOp },
+
 sh => { template => $storeOp },
 
 sll => { template => $binOp },
 
 slli => { template => $immediateOp },
 
+slliw => { template => $immediateOp },
+
+sllw => { template => $binOp },
+
 slt => { template => $binOp },
 
 sltiu => { template => $immediateOp },
@@ -216,12 +470,22 @@ sra => { template => $binOp },
 
 srai => { template => $immediateOp },
 
+sraiw => { template => $immediateOp },
+
+sraw => { template => $binOp },
+
 srl => { template => $binOp },
 
 srli => { template => $immediateOp },
 
+srliw => { template => $immediateOp },
+
+srlw => { template => $binOp },
+
 sub => { template => $binOp },
 
+subw => { template => $binOp },
+
 sw => { template => $storeOp },
 
 switch => {
@@ -9,8 +9,11 @@
 #include "beirg.h"
 #include "benode.h"
 #include "betranshlp.h"
+#include "entity_t.h"
+#include "iredges.h"
 #include "gen_riscv_new_nodes.h"
 #include "gen_riscv_regalloc_if.h"
+#include "iropt.h"
 #include "irprog_t.h"
 #include "nodes.h"
 #include "riscv_bearch_t.h"
@@ -23,6 +26,7 @@ static be_stack_env_t stack_env;
 
 static const unsigned ignore_regs[] = {
 	REG_T0,
+	REG_FT11,
 };
 
 static unsigned const regs_param_gp[] = {
@@ -51,6 +55,18 @@ static unsigned const callee_saves[] = {
 	REG_S9,
 	REG_S10,
 	REG_S11,
+	REG_FS0,
+	REG_FS1,
+	REG_FS2,
+	REG_FS3,
+	REG_FS4,
+	REG_FS5,
+	REG_FS6,
+	REG_FS7,
+	REG_FS8,
+	REG_FS9,
+	REG_FS10,
+	REG_FS11,
 };
 
 static unsigned const caller_saves[] = {
@@ -69,6 +85,25 @@ static unsigned const caller_saves[] = {
 	REG_T4,
 	REG_T5,
 	REG_T6,
+	REG_FT0,
+	REG_FT1,
+	REG_FT2,
+	REG_FT3,
+	REG_FT4,
+	REG_FT5,
+	REG_FT6,
+	REG_FT7,
+	REG_FA0,
+	REG_FA1,
+	REG_FA2,
+	REG_FA3,
+	REG_FA4,
+	REG_FA5,
+	REG_FA6,
+	REG_FA7,
+	REG_FT8,
+	REG_FT9,
+	REG_FT10,
 };
 
 static ir_node *get_Start_sp(ir_graph *const irg)
@@ -86,6 +121,88 @@ ir_node *get_Start_zero(ir_graph *const irg)
 	return be_get_Start_proj(irg, &riscv_registers[REG_ZERO]);
 }
 
+static ir_node *get_frame_base(ir_graph *const irg)
+{
+	return cur_cconv.omit_fp ? get_Start_sp(irg) : get_Start_fp(irg);
+}
+
+static bool is_fp_reg(arch_register_t const *const reg)
+{
+	return reg->cls == &riscv_reg_classes[CLASS_riscv_fp];
+}
+
+/**
+ * Returns whether operations in @p mode use the 32 bit instructions of RV64.
+ * 32 bit values are kept sign extended to 64 bit in registers on RV64.
+ */
+static bool is_rv64_word(ir_mode *const mode)
+{
+	return riscv_cg_config.rv64 && get_mode_size_bits(mode) < 64;
+}
+
+/**
+ * Returns the value of @p node, sign extended if its mode has 32 bit.
+ */
+static long get_Const_sext(ir_node const *const node)
+{
+	long const val = get_Const_long(node);
+	return get_mode_size_bits(get_irn_mode(node)) == 32 ? (int32_t)val : val;
+}
+
+ir_node *riscv_new_gp_load(dbg_info *const dbgi, ir_node *const block, ir_node *const mem, ir_node *const base, ir_entity *const ent, int32_t const val)
+{
+	return riscv_cg_config.rv64
+		? new_bd_riscv_ld(dbgi, block, mem, base, ent, val)
+		: new_bd_riscv_lw(dbgi, block, mem, base, ent, val);
+}
+
+ir_node *riscv_new_gp_store(dbg_info *const dbgi, ir_node *const block, ir_node *const mem, ir_node *const base, ir_node *const value, ir_entity *const ent, int32_t const val)
+{
+	return riscv_cg_config.rv64
+		? new_bd_riscv_sd(dbgi, block, mem, base, value, ent, val)
+		: new_bd_riscv_sw(dbgi, block, mem, base, value, ent, val);
+}
+
+/**
+ * Materializes the constant @p val.  Values fitting into 32 bit take lui and
+ * addi(w).  On RV64 larger values are built from their upper bits, which are
+ * shifted into place, followed by adding the lower 12 bits.
+ */
+static ir_node *make_constant(dbg_info *const dbgi, ir_node *const block, int64_t const val)
+{
+	if (is_simm32(val)) {
+		riscv_hi_lo_imm const imm = calc_hi_lo((int32_t)val);
+		ir_node              *res;
+		if (imm.hi != 0) {
+			res = new_bd_riscv_lui(dbgi, block, NULL, imm.hi);
+		} else {
+			ir_graph *const irg = get_irn_irg(block);
+			res = get_Start_zero(irg);
+		}
+		if (imm.lo != 0) {
+			/* addiw keeps the result sign extended from 32 bit on RV64. */
+			res = riscv_cg_config.rv64
+				? new_bd_riscv_addiw(dbgi, block, res, NULL, imm.lo)
+				: new_bd_riscv_addi( dbgi, block, res, NULL, imm.lo);
+		}
+		return res;
+	}
+
+	assert(riscv_cg_config.rv64);
+	int64_t const lo    = (int64_t)(((uint64_t)val & 0xFFF) ^ 0x800) - 0x800;
+	int64_t       hi    = (int64_t)((uint64_t)val - (uint64_t)lo) >> 12;
+	int32_t       shift = 12;
+	while ((hi & 1) == 0) {
+		hi >>= 1;
+		++shift;
+	}
+	ir_node *res = make_constant(dbgi, block, hi);
+	res = new_bd_riscv_slli(dbgi, block, res, NULL, shift);
+	if (lo != 0)
+		res = new_bd_riscv_addi(dbgi, block, res, NULL, lo);
+	return res;
+}
+
 typedef struct riscv_addr {
 	ir_node   *base;
 	ir_entity *ent;
@@ -100,7 +217,7 @@ static riscv_addr make_addr(ir_node *addr)
 	if (is_Add(addr)) {
 		ir_node *const r = get_Add_right(addr);
 		if (is_Const(r)) {
-			long const v = get_Const_long(r);
+			long const v = get_Const_sext(r);
 			if (is_simm12(v)) {
 				val  = v;
 				addr = get_Add_left(addr);
@@ -134,6 +251,17 @@ static ir_node *make_extension(dbg_info *const dbgi, ir_node *const op, unsigned
 	if (op_size >= to_size)
 		return new_op;
 
+	ir_node *const block = get_nodes_block(new_op);
+	if (op_size == 32) {
+		/* 32 bit values are sign extended on RV64 already. */
+		assert(riscv_cg_config.rv64 && to_size == 64);
+		if (mode_is_signed(op_mode))
+			return new_op;
+		ir_node *const sll = new_bd_riscv_slli(dbgi, block, new_op, NULL, 32);
+		ir_node *const srl = new_bd_riscv_srli(dbgi, block, sll,    NULL, 32);
+		return srl;
+	}
+
 	/* Check whether the value is correctly extended already. */
 	if (is_Proj(op)) {
 		ir_node *const pred = get_Proj_pred(op);
@@ -142,7 +270,6 @@ static ir_node *make_extension(dbg_info *const dbgi, ir_node *const op, unsigned
 	}
 
 	assert(op_size <= 16);
-	ir_node *const block = get_nodes_block(new_op);
 	if (mode_is_signed(op_mode)) {
 		int32_t  const val = RISCV_MACHINE_SIZE - op_size;
 		ir_node *const sll = new_bd_riscv_slli(dbgi, block, new_op, NULL, val);
@@ -160,7 +287,9 @@ static ir_node *make_extension(dbg_info *const dbgi, ir_node *const op, unsigned
 
 static ir_node *extend_value(ir_node *const val)
 {
-	return make_extension(NULL, val, RISCV_MACHINE_SIZE);
+	/* 32 bit values are kept sign extended on RV64, which is the form the
+	 * calling convention, comparisons and conversions expect. */
+	return make_extension(NULL, val, 32);
 }
 
 static void riscv_parse_constraint_letter(void const *const env, be_asm_constraint_t* const c, char const l)
@@ -224,7 +353,11 @@ static bool riscv_match_immediate(riscv_asm_operand_t *const operand, ir_node *c
 
 	long value;
 	if (offset) {
+		/* 32 bit values are sign extended like get_Const_sext() does, so
+		 * unsigned constants like -1u still match. */
 		value = get_tarval_long(offset);
+		if (get_mode_size_bits(get_tarval_mode(offset)) == 32)
+			value = (int32_t)value;
 		if (!riscv_check_immediate_constraint(value, imm_type))
 			return false;
 	} else {
@@ -279,6 +412,39 @@ static ir_node *gen_ASM(ir_node *const node)
 	return be_make_asm(node, &info, operands);
 }
 
+typedef ir_node *cons_fp_binop(dbg_info*, ir_node*, ir_node*, ir_node*, ir_mode*);
+typedef ir_node *cons_fp_fma(dbg_info*, ir_node*, ir_node*, ir_node*, ir_node*, ir_mode*);
+
+static ir_node *gen_fp_binop(ir_node *const node, ir_node *const l, ir_node *const r, cons_fp_binop *const cons)
+{
+	dbg_info *const dbgi  = get_irn_dbg_info(node);
+	ir_node  *const block = be_transform_nodes_block(node);
+	ir_node  *const new_l = be_transform_node(l);
+	ir_node  *const new_r = be_transform_node(r);
+	return cons(dbgi, block, new_l, new_r, get_irn_mode(node));
+}
+
+/**
+ * Returns @p node, if it is a multiplication, which can be fused into its only
+ * user.  Fusing skips the rounding of the product, so it is only allowed with
+ * imprecise float transformations.
+ */
+static ir_node *get_fusable_Mul(ir_node *const node)
+{
+	return is_Mul(node) && get_irn_n_edges(node) == 1
+	    && ir_imprecise_float_transforms_allowed() ? node : NULL;
+}
+
+static ir_node *gen_fma(ir_node *const node, ir_node *const mul, ir_node *const addend, cons_fp_fma *const cons)
+{
+	dbg_info *const dbgi    = get_irn_dbg_info(node);
+	ir_node  *const block   = be_transform_nodes_block(node);
+	ir_node  *const new_l   = be_transform_node(get_Mul_left(mul));
+	ir_node  *const new_r   = be_transform_node(get_Mul_right(mul));
+	ir_node  *const new_add = be_transform_node(addend);
+	return cons(dbgi, block, new_l, new_r, new_add, get_irn_mode(node));
+}
+
 static ir_node *gen_Add(ir_node *const node)
 {
 	ir_tarval *tv;
@@ -297,13 +463,27 @@ static ir_node *gen_Add(ir_node *const node)
 		dbg_info *const dbgi  = get_irn_dbg_info(node);
 		ir_node  *const block = be_transform_nodes_block(node);
 		ir_node  *const new_l = be_transform_node(l);
+		bool      const word  = is_rv64_word(mode);
 		if (is_Const(r)) {
-			long const val = get_Const_long(r);
-			if (is_simm12(val))
-				return new_bd_riscv_addi(dbgi, block, new_l, NULL, val);
+			long const val = get_Const_sext(r);
+			if (is_simm12(val)) {
+				return word
+					? new_bd_riscv_addiw(dbgi, block, new_l, NULL, val)
+					: new_bd_riscv_addi( dbgi, block, new_l, NULL, val);
+			}
 		}
 		ir_node *const new_r = be_transform_node(r);
-		return new_bd_riscv_add(dbgi, block, new_l, new_r);
+		return word
+			? new_bd_riscv_addw(dbgi, block, new_l, new_r)
+			: new_bd_riscv_add( dbgi, block, new_l, new_r);
+	} else if (mode_is_float(mode)) {
+		ir_node *const mul_l = get_fusable_Mul(l);
+		if (mul_l)
+			return gen_fma(node, mul_l, r, &new_bd_riscv_fmadd);
+		ir_node *const mul_r = get_fusable_Mul(r);
+		if (mul_r)
+			return gen_fma(node, mul_r, l, &new_bd_riscv_fmadd);
+		return gen_fp_binop(node, l, r, &new_bd_riscv_fadd);
 	}
 	TODO(node);
 }
@@ -365,7 +545,7 @@ static ir_node *gen_logic_op(ir_node *const node, cons_binop *const cons, cons_b
 	ir_node  *const new_l = be_transform_node(l);
 	ir_node  *const r     = get_binop_right(node);
 	if (is_Const(r)) {
-		long const val = get_Const_long(r);
+		long const val = get_Const_sext(r);
 		if (is_simm12(val))
 			return cons_imm(dbgi, block, new_l, NULL, val);
 	}
@@ -382,11 +562,16 @@ static ir_node *gen_saturating_increment(ir_node *const node)
 {
   dbg_info *const dbgi    = get_irn_dbg_info(node);
   ir_node  *const block   = be_transform_nodes_block(node);
-  ir_node  *const operand = be_transform_node(get_Builtin_param(node, 0));
-  assert(get_mode_size_bits(get_irn_mode(operand)) == 32);
+  ir_node  *const param   = get_Builtin_param(node, 0);
+  ir_mode  *const mode    = get_irn_mode(param);
+  ir_node  *const operand = be_transform_node(param);
+  assert(get_mode_size_bits(mode) == 32 || get_mode_size_bits(mode) == RISCV_MACHINE_SIZE);
 
+  /* The sign extended 32 bit value is all ones exactly if the 32 bit value is. */
   ir_node *const sltiu = new_bd_riscv_sltiu(dbgi, block, operand, NULL, -1);
-  ir_node *const addu  = new_bd_riscv_add(  dbgi, block, operand, sltiu);
+  ir_node *const addu  = is_rv64_word(mode)
+    ? new_bd_riscv_addw(dbgi, block, operand, sltiu)
+    : new_bd_riscv_add( dbgi, block, operand, sltiu);
   return addu;
 }
 
@@ -410,6 +595,15 @@ static ir_node *gen_Builtin(ir_node *const node)
 	switch (kind) {
 	case ir_bk_saturating_increment: return gen_saturating_increment(node);
 
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_fence:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
 	case ir_bk_bswap:
 	case ir_bk_clz:
 	case ir_bk_compare_swap:
@@ -433,26 +627,49 @@ static ir_node *gen_Builtin(ir_node *const node)
 	panic("unexpected Builtin");
 }
 
+typedef ir_node *cons_storeop(dbg_info*, ir_node*, ir_node*, ir_node*, ir_node*, ir_entity*, int32_t);
+
+/**
+ * Splits the double precision value @p val into its lower and upper word by
+ * going through a stack slot.
+ */
+static void split_double(dbg_info *const dbgi, ir_node *const block, ir_node *const val, ir_node **const lo, ir_node **const hi)
+{
+	ir_graph  *const irg   = get_irn_irg(block);
+	ir_entity *const slot  = new_spillslot(get_irg_frame_type(irg), RISCV_FP_REGISTER_SIZE, 3);
+	ir_node   *const frame = get_frame_base(irg);
+	ir_node   *const nomem = get_irg_no_mem(irg);
+	ir_node   *const store = new_bd_riscv_fsd(dbgi, block, nomem, frame, val, slot, 0);
+	ir_node   *const ld_lo = new_bd_riscv_lw(dbgi, block, store, frame, slot, 0);
+	ir_node   *const ld_hi = new_bd_riscv_lw(dbgi, block, store, frame, slot, RISCV_REGISTER_SIZE);
+	*lo = be_new_Proj(ld_lo, pn_riscv_lw_res);
+	*hi = be_new_Proj(ld_hi, pn_riscv_lw_res);
+}
+
+/**
+ * Combines the words @p lo and @p hi to a double precision value by going
+ * through a stack slot.
+ */
+static ir_node *combine_double(dbg_info *const dbgi, ir_node *const block, ir_node *const lo, ir_node *const hi)
+{
+	ir_graph  *const irg      = get_irn_irg(block);
+	ir_entity *const slot     = new_spillslot(get_irg_frame_type(irg), RISCV_FP_REGISTER_SIZE, 3);
+	ir_node   *const frame    = get_frame_base(irg);
+	ir_node   *const nomem    = get_irg_no_mem(irg);
+	ir_node   *const st_lo    = new_bd_riscv_sw(dbgi, block, nomem, frame, lo, slot, 0);
+	ir_node   *const st_hi    = new_bd_riscv_sw(dbgi, block, nomem, frame, hi, slot, RISCV_REGISTER_SIZE);
+	ir_node         *stores[] = { st_lo, st_hi };
+	ir_node   *const mem      = be_make_Sync(block, ARRAY_SIZE(stores), stores);
+	ir_node   *const load     = new_bd_riscv_fld(dbgi, block, mem, frame, slot, 0);
+	return be_new_Proj(load, pn_riscv_fld_res);
+}
+
 static ir_node *gen_Call(ir_node *const node)
 {
 	ir_graph *const irg = get_irn_irg(node);
 
-	unsigned                          p        = n_riscv_jal_first_argument;
-	unsigned                    const n_params = get_Call_n_params(node);
-	unsigned                    const n_ins    = p + 1 + n_params;
-	arch_register_req_t const **const reqs     = be_allocate_in_reqs(irg, n_ins);
-	ir_node                          *ins[n_ins];
-
-	ir_entity     *callee;
-	ir_node *const ptr = get_Call_ptr(node);
-	if (is_Address(ptr)) {
-		callee = get_Address_entity(ptr);
-	} else {
-		callee  = NULL;
-		ins[p]  = be_transform_node(ptr);
-		reqs[p] = &riscv_class_reg_req_gp;
-		++p;
-	}
+	ir_node   *const ptr    = get_Call_ptr(node);
+	ir_entity *const callee = is_Address(ptr) ? get_Address_entity(ptr) : NULL;
 
 	ir_type *const fun_type = get_Call_type(node);
 	record_returns_twice(irg, fun_type);
@@ -467,6 +684,22 @@ static ir_node *gen_Call(ir_node *const node)
 	riscv_calling_convention_t cconv;
 	riscv_determine_calling_convention(&cconv, fun_type, named_params, NULL);
 
+	unsigned                          p        = n_riscv_jal_first_argument;
+	unsigned                    const n_params = get_Call_n_params(node);
+	unsigned                          n_ins    = p + 1 + n_params;
+	for (size_t i = 0; i != n_params; ++i) {
+		if (cconv.parameters[i].reg_hi)
+			++n_ins;
+	}
+	arch_register_req_t const **const reqs     = be_allocate_in_reqs(irg, n_ins);
+	ir_node                          *ins[n_ins];
+
+	if (!callee) {
+		ins[p]  = be_transform_node(ptr);
+		reqs[p] = &riscv_class_reg_req_gp;
+		++p;
+	}
+
 	ir_node *mems[1 + cconv.n_mem_param];
 	unsigned m = 0;
 
@@ -487,13 +720,44 @@ static ir_node *gen_Call(ir_node *const node)
 		ir_node *const val = extend_value(arg);
 
 		riscv_reg_or_slot_t const *const param = &cconv.parameters[i];
-		if (param->reg) {
+		ir_mode             *const       mode  = get_irn_mode(arg);
+		if (mode_is_float(mode) && param->reg && !is_fp_reg(param->reg)) {
+			/* Pass the value according to the integer calling convention. */
+			if (get_mode_size_bits(mode) == 32) {
+				ins[p]  = new_bd_riscv_fmv_x_w(dbgi, block, val);
+				reqs[p] = param->reg->single_req;
+				++p;
+			} else if (riscv_cg_config.rv64) {
+				ins[p]  = new_bd_riscv_fmv_x_d(dbgi, block, val);
+				reqs[p] = param->reg->single_req;
+				++p;
+			} else {
+				ir_node *lo;
+				ir_node *hi;
+				split_double(dbgi, block, val, &lo, &hi);
+				ins[p]  = lo;
+				reqs[p] = param->reg->single_req;
+				++p;
+				if (param->reg_hi) {
+					ins[p]  = hi;
+					reqs[p] = param->reg_hi->single_req;
+					++p;
+				} else {
+					ir_node *const nomem = get_irg_no_mem(irg);
+					mems[m++] = new_bd_riscv_sw(dbgi, block, nomem, call_frame, hi, NULL, param->offset + RISCV_REGISTER_SIZE);
+				}
+			}
+		} else if (param->reg) {
 			ins[p]  = val;
 			reqs[p] = param->reg->single_req;
 			++p;
+		} else if (mode_is_float(mode)) {
+			ir_node      *const nomem = get_irg_no_mem(irg);
+			cons_storeop *const cons  = get_mode_size_bits(mode) == 32 ? &new_bd_riscv_fsw : &new_bd_riscv_fsd;
+			mems[m++] = cons(dbgi, block, nomem, call_frame, val, NULL, param->offset);
 		} else {
 			ir_node *const nomem = get_irg_no_mem(irg);
-			mems[m++] = new_bd_riscv_sw(dbgi, block, nomem, call_frame, val, NULL, param->offset);
+			mems[m++] = riscv_new_gp_store(dbgi, block, nomem, call_frame, val, NULL, param->offset);
 		}
 	}
 
@@ -521,6 +785,50 @@ static ir_node *gen_Call(ir_node *const node)
 	return jal;
 }
 
+/**
+ * Compares the floating point values @p l and @p r.  The result is 1 if the
+ * relation @p rel holds, or 0 if it holds and @p negated is set.
+ */
+static ir_node *gen_fp_cmp(dbg_info *const dbgi, ir_node *const block, ir_node *const l, ir_node *const r, ir_relation rel, bool *const negated)
+{
+	/* The comparison instructions are false for unordered operands, so test the
+	 * negated relation instead. */
+	*negated = rel & ir_relation_unordered;
+	if (*negated)
+		rel = get_negated_relation(rel);
+
+	/* Constant relations are usually folded, but are not guaranteed to be.
+	 * ir_relation_true ends up here as negated ir_relation_false. */
+	if (rel == ir_relation_false)
+		return get_Start_zero(get_irn_irg(block));
+
+	ir_mode *const mode  = get_irn_mode(l);
+	ir_node *const new_l = be_transform_node(l);
+	ir_node *const new_r = be_transform_node(r);
+	switch (rel) {
+	case ir_relation_equal:         return new_bd_riscv_feq(dbgi, block, new_l, new_r, mode);
+	case ir_relation_less:          return new_bd_riscv_flt(dbgi, block, new_l, new_r, mode);
+	case ir_relation_less_equal:    return new_bd_riscv_fle(dbgi, block, new_l, new_r, mode);
+	case ir_relation_greater:       return new_bd_riscv_flt(dbgi, block, new_r, new_l, mode);
+	case ir_relation_greater_equal: return new_bd_riscv_fle(dbgi, block, new_r, new_l, mode);
+
+	case ir_relation_less_greater: {
+		ir_node *const lt = new_bd_riscv_flt(dbgi, block, new_l, new_r, mode);
+		ir_node *const gt = new_bd_riscv_flt(dbgi, block, new_r, new_l, mode);
+		return new_bd_riscv_or(dbgi, block, lt, gt);
+	}
+
+	case ir_relation_less_equal_greater: {
+		ir_node *const ord_l = new_bd_riscv_feq(dbgi, block, new_l, new_l, mode);
+		ir_node *const ord_r = new_bd_riscv_feq(dbgi, block, new_r, new_r, mode);
+		return new_bd_riscv_and(dbgi, block, ord_l, ord_r);
+	}
+
+	default:
+		panic("unexpected relation");
+	}
+}
+
 static ir_node *gen_Cmp(ir_node *const node)
 {
 	ir_node       *l    = get_Cmp_left(node);
@@ -562,6 +870,13 @@ static ir_node *gen_Cmp(ir_node *const node)
 		case ir_relation_unordered_less_greater:
 			panic("unexpected relation");
 		}
+	} else if (mode_is_float(mode)) {
+		dbg_info   *const dbgi  = get_irn_dbg_info(node);
+		ir_node    *const block = be_transform_nodes_block(node);
+		ir_relation const rel   = get_Cmp_relation(node);
+		bool              negated;
+		ir_node    *const cmp   = gen_fp_cmp(dbgi, block, l, r, rel, &negated);
+		return negated ? new_bd_riscv_xori(dbgi, block, cmp, NULL, 1) : cmp;
 	}
 	TODO(node);
 }
@@ -619,11 +934,33 @@ bcc:;
 			case ir_relation_unordered_less_greater:
 				panic("unexpected relation");
 			}
+		} else if (mode_is_float(mode)) {
+			dbg_info   *const dbgi  = get_irn_dbg_info(node);
+			ir_node    *const block = be_transform_nodes_block(node);
+			ir_relation const rel   = get_Cmp_relation(sel);
+			ir_node    *const r     = get_Cmp_right(sel);
+			bool              negated;
+			ir_node    *const cmp   = gen_fp_cmp(dbgi, block, l, r, rel, &negated);
+			ir_node    *const zero  = get_Start_zero(get_irn_irg(node));
+			return new_bd_riscv_bcc(dbgi, block, cmp, zero, negated ? riscv_cc_eq : riscv_cc_ne);
 		}
 	}
 	TODO(node);
 }
 
+static ir_entity *get_float_const_entity(ir_tarval *const tv)
+{
+	ir_entity *entity = pmap_get(ir_entity, riscv_constants, tv);
+	if (entity)
+		return entity;
+
+	ir_type *const type = get_type_for_mode(get_tarval_mode(tv));
+	entity = new_global_entity(get_glob_type(), id_unique("C"), type, ir_visibility_private, IR_LINKAGE_CONSTANT | IR_LINKAGE_NO_IDENTITY);
+	set_entity_initializer(entity, create_initializer_tarval(tv));
+	pmap_insert(riscv_constants, tv, entity);
+	return entity;
+}
+
 static ir_node *gen_Const(ir_node *const node)
 {
 	ir_mode *const mode = get_irn_mode(node);
@@ -635,19 +972,25 @@ static ir_node *gen_Const(ir_node *const node)
 		} else {
 			dbg_info *const dbgi  = get_irn_dbg_info(node);
 			ir_node  *const block = be_transform_nodes_block(node);
-
-			riscv_hi_lo_imm imm = calc_hi_lo((int32_t)val);
-			ir_node      *res;
-			if (imm.hi != 0) {
-				res = new_bd_riscv_lui(dbgi, block, NULL, imm.hi);
-			} else {
-				ir_graph *const irg = get_irn_irg(node);
-				res = get_Start_zero(irg);
-			}
-			if (imm.lo != 0)
-				res = new_bd_riscv_addi(dbgi, block, res, NULL, imm.lo);
-			return res;
+			return make_constant(dbgi, block, get_Const_sext(node));
 		}
+	} else if (mode_is_float(mode)) {
+		dbg_info  *const dbgi  = get_irn_dbg_info(node);
+		ir_node   *const block = be_transform_nodes_block(node);
+		ir_graph  *const irg   = get_irn_irg(node);
+		ir_tarval *const tv    = get_Const_tarval(node);
+		if (tarval_is_null(tv) && !tarval_is_negative(tv)) {
+			/* +0.0 is all bits clear. */
+			return new_bd_riscv_fcvt_f_w(dbgi, block, get_Start_zero(irg), mode);
+		}
+		ir_entity *const ent   = get_float_const_entity(tv);
+		ir_node   *const lui   = new_bd_riscv_lui(dbgi, block, ent, 0);
+		ir_node   *const nomem = get_irg_no_mem(irg);
+		ir_node   *const load  = get_mode_size_bits(mode) == 32
+			? new_bd_riscv_flw(dbgi, block, nomem, lui, ent, 0)
+			: new_bd_riscv_fld(dbgi, block, nomem, lui, ent, 0);
+		set_irn_pinned(load, false);
+		return be_new_Proj(load, pn_riscv_flw_res);
 	}
 	TODO(node);
 }
@@ -659,7 +1002,48 @@ static ir_node *gen_Conv(ir_node *const node)
 	ir_mode *const mode    = get_irn_mode(node);
 	if (be_mode_needs_gp_reg(op_mode) && be_mode_needs_gp_reg(mode)) {
 		dbg_info *const dbgi = get_irn_dbg_info(node);
-		return make_extension(dbgi, op, get_mode_size_bits(mode));
+		unsigned  const size = get_mode_size_bits(mode);
+		if (riscv_cg_config.rv64 && size == 32 && get_mode_size_bits(op_mode) == 64) {
+			/* Truncating to 32 bit has to restore the sign extension. */
+			ir_node *const block  = be_transform_nodes_block(node);
+			ir_node *const new_op = be_transform_node(op);
+			return new_bd_riscv_addiw(dbgi, block, new_op, NULL, 0);
+		}
+		return make_extension(dbgi, op, size);
+	} else if (mode_is_float(mode)) {
+		dbg_info *const dbgi  = get_irn_dbg_info(node);
+		ir_node  *const block = be_transform_nodes_block(node);
+		if (mode_is_float(op_mode)) {
+			ir_node *const new_op = be_transform_node(op);
+			unsigned const size   = get_mode_size_bits(mode);
+			if (size == get_mode_size_bits(op_mode))
+				return new_op;
+			return size == 64
+				? new_bd_riscv_fcvt_d_s(dbgi, block, new_op)
+				: new_bd_riscv_fcvt_s_d(dbgi, block, new_op);
+		} else if (be_mode_needs_gp_reg(op_mode)) {
+			ir_node *const new_op = extend_value(op);
+			if (get_mode_size_bits(op_mode) == 64) {
+				return mode_is_signed(op_mode)
+					? new_bd_riscv_fcvt_f_l( dbgi, block, new_op, mode)
+					: new_bd_riscv_fcvt_f_lu(dbgi, block, new_op, mode);
+			}
+			return mode_is_signed(op_mode)
+				? new_bd_riscv_fcvt_f_w( dbgi, block, new_op, mode)
+				: new_bd_riscv_fcvt_f_wu(dbgi, block, new_op, mode);
+		}
+	} else if (mode_is_float(op_mode) && be_mode_needs_gp_reg(mode)) {
+		dbg_info *const dbgi   = get_irn_dbg_info(node);
+		ir_node  *const block  = be_transform_nodes_block(node);
+		ir_node  *const new_op = be_transform_node(op);
+		if (get_mode_size_bits(mode) == 64) {
+			return mode_is_signed(mode)
+				? new_bd_riscv_fcvt_l_f( dbgi, block, new_op, op_mode)
+				: new_bd_riscv_fcvt_lu_f(dbgi, block, new_op, op_mode);
+		}
+		return mode_is_signed(mode)
+			? new_bd_riscv_fcvt_w_f( dbgi, block, new_op, op_mode)
+			: new_bd_riscv_fcvt_wu_f(dbgi, block, new_op, op_mode);
 	}
 	TODO(node);
 }
@@ -667,7 +1051,17 @@ static ir_node *gen_Conv(ir_node *const node)
 static ir_node *gen_Div(ir_node *const node)
 {
 	ir_mode *const mode = get_Div_resmode(node);
-	if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == RISCV_MACHINE_SIZE) {
+	if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == 32 && riscv_cg_config.rv64) {
+		dbg_info *const dbgi  = get_irn_dbg_info(node);
+		ir_node  *const block = be_transform_nodes_block(node);
+		ir_node  *const l     = be_transform_node(get_Div_left(node));
+		ir_node  *const r     = be_transform_node(get_Div_right(node));
+		if (mode_is_signed(mode)) {
+			return new_bd_riscv_divw(dbgi, block, l, r);
+		} else {
+			return new_bd_riscv_divuw(dbgi, block, l, r);
+		}
+	} else if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == RISCV_MACHINE_SIZE) {
 		dbg_info *const dbgi  = get_irn_dbg_info(node);
 		ir_node  *const block = be_transform_nodes_block(node);
 		ir_node  *const l     = be_transform_node(get_Div_left(node));
@@ -677,6 +1071,12 @@ static ir_node *gen_Div(ir_node *const node)
 		} else {
 			return new_bd_riscv_divu(dbgi, block, l, r);
 		}
+	} else if (mode_is_float(mode)) {
+		dbg_info *const dbgi  = get_irn_dbg_info(node);
+		ir_node  *const block = be_transform_nodes_block(node);
+		ir_node  *const l     = be_transform_node(get_Div_left(node));
+		ir_node  *const r     = be_transform_node(get_Div_right(node));
+		return new_bd_riscv_fdiv(dbgi, block, l, r, mode);
 	}
 	TODO(node);
 }
@@ -714,7 +1114,11 @@ static ir_node *gen_Load(ir_node *const node)
 		} else if (size == 16) {
 			cons = mode_is_signed(mode) ? &new_bd_riscv_lh : &new_bd_riscv_lhu;
 		} else if (size == 32) {
+			/* lw sign extends, which is the canonical form also for unsigned
+			 * 32 bit values on RV64. */
 			cons = new_bd_riscv_lw;
+		} else if (size == 64 && riscv_cg_config.rv64) {
+			cons = new_bd_riscv_ld;
 		} else {
 			panic("invalid load");
 		}
@@ -723,6 +1127,13 @@ static ir_node *gen_Load(ir_node *const node)
 		ir_node   *const mem   = be_transform_node(get_Load_mem(node));
 		riscv_addr const addr  = make_addr(get_Load_ptr(node));
 		return cons(dbgi, block, mem, addr.base, addr.ent, addr.val);
+	} else if (mode_is_float(mode)) {
+		cons_loadop *const cons  = get_mode_size_bits(mode) == 32 ? &new_bd_riscv_flw : &new_bd_riscv_fld;
+		dbg_info    *const dbgi  = get_irn_dbg_info(node);
+		ir_node     *const block = be_transform_nodes_block(node);
+		ir_node     *const mem   = be_transform_node(get_Load_mem(node));
+		riscv_addr   const addr  = make_addr(get_Load_ptr(node));
+		return cons(dbgi, block, mem, addr.base, addr.ent, addr.val);
 	}
 	TODO(node);
 }
@@ -748,7 +1159,25 @@ static ir_node *gen_Minus(ir_node *const node)
 		ir_graph *const irg   = get_irn_irg(node);
 		ir_node  *const new_l = get_Start_zero(irg);
 		ir_node  *const new_r = be_transform_node(val);
-		return new_bd_riscv_sub(dbgi, block, new_l, new_r);
+		return is_rv64_word(mode)
+			? new_bd_riscv_subw(dbgi, block, new_l, new_r)
+			: new_bd_riscv_sub( dbgi, block, new_l, new_r);
+	} else if (mode_is_float(mode)) {
+		/* -(a * b + c) -> fnmadd */
+		if (is_Add(val) && get_irn_n_edges(val) == 1) {
+			ir_node *const l     = get_Add_left(val);
+			ir_node *const r     = get_Add_right(val);
+			ir_node *const mul_l = get_fusable_Mul(l);
+			if (mul_l)
+				return gen_fma(node, mul_l, r, &new_bd_riscv_fnmadd);
+			ir_node *const mul_r = get_fusable_Mul(r);
+			if (mul_r)
+				return gen_fma(node, mul_r, l, &new_bd_riscv_fnmadd);
+		}
+		dbg_info *const dbgi   = get_irn_dbg_info(node);
+		ir_node  *const block  = be_transform_nodes_block(node);
+		ir_node  *const new_op = be_transform_node(val);
+		return new_bd_riscv_fneg(dbgi, block, new_op, mode);
 	}
 	TODO(node);
 }
@@ -756,7 +1185,17 @@ static ir_node *gen_Minus(ir_node *const node)
 static ir_node *gen_Mod(ir_node *const node)
 {
 	ir_mode *const mode = get_Mod_resmode(node);
-	if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == RISCV_MACHINE_SIZE) {
+	if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == 32 && riscv_cg_config.rv64) {
+		dbg_info *const dbgi  = get_irn_dbg_info(node);
+		ir_node  *const block = be_transform_nodes_block(node);
+		ir_node  *const l     = be_transform_node(get_Mod_left(node));
+		ir_node  *const r     = be_transform_node(get_Mod_right(node));
+		if (mode_is_signed(mode)) {
+			return new_bd_riscv_remw(dbgi, block, l, r);
+		} else {
+			return new_bd_riscv_remuw(dbgi, block, l, r);
+		}
+	} else if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == RISCV_MACHINE_SIZE) {
 		dbg_info *const dbgi  = get_irn_dbg_info(node);
 		ir_node  *const block = be_transform_nodes_block(node);
 		ir_node  *const l     = be_transform_node(get_Mod_left(node));
@@ -778,7 +1217,11 @@ static ir_node *gen_Mul(ir_node *const node)
 		ir_node  *const block = be_transform_nodes_block(node);
 		ir_node  *const l     = be_transform_node(get_Mul_left(node));
 		ir_node  *const r     = be_transform_node(get_Mul_right(node));
-		return new_bd_riscv_mul(dbgi, block, l, r);
+		return is_rv64_word(mode)
+			? new_bd_riscv_mulw(dbgi, block, l, r)
+			: new_bd_riscv_mul( dbgi, block, l, r);
+	} else if (mode_is_float(mode)) {
+		return gen_fp_binop(node, get_Mul_left(node), get_Mul_right(node), &new_bd_riscv_fmul);
 	}
 	TODO(node);
 }
@@ -796,6 +1239,22 @@ static ir_node *gen_Mulh(ir_node *const node)
 		} else {
 			return new_bd_riscv_mulhu(dbgi, block, l, r);
 		}
+	} else if (be_mode_needs_gp_reg(mode) && get_mode_size_bits(mode) == 32 && riscv_cg_config.rv64) {
+		/* The upper half of the 64 bit product.  For unsigned operands shifting
+		 * both into the upper word makes mulhu return the whole product. */
+		dbg_info *const dbgi  = get_irn_dbg_info(node);
+		ir_node  *const block = be_transform_nodes_block(node);
+		ir_node        *l     = be_transform_node(get_Mulh_left(node));
+		ir_node        *r     = be_transform_node(get_Mulh_right(node));
+		ir_node        *mul;
+		if (mode_is_signed(mode)) {
+			mul = new_bd_riscv_mul(dbgi, block, l, r);
+		} else {
+			l   = new_bd_riscv_slli(dbgi, block, l, NULL, 32);
+			r   = new_bd_riscv_slli(dbgi, block, r, NULL, 32);
+			mul = new_bd_riscv_mulhu(dbgi, block, l, r);
+		}
+		return new_bd_riscv_srai(dbgi, block, mul, NULL, 32);
 	}
 	TODO(node);
 }
@@ -807,6 +1266,8 @@ static ir_node *gen_Mux(ir_node *const node)
 		if (is_irn_null(get_Mux_false(node)) && is_irn_one(get_Mux_true(node))) {
 			ir_node *const sel = get_Mux_sel(node);
 			if (is_Cmp(sel)) {
+				if (mode_is_float(get_irn_mode(get_Cmp_left(sel))))
+					return be_transform_node(sel);
 				ir_relation const rel = get_Cmp_relation(sel) & ir_relation_less_equal_greater;
 				if (rel == ir_relation_less || rel == ir_relation_greater)
 					return be_transform_node(sel);
@@ -837,6 +1298,8 @@ static ir_node *gen_Phi(ir_node *const node)
 	ir_mode            *const  mode = get_irn_mode(node);
 	if (be_mode_needs_gp_reg(mode)) {
 		req = &riscv_class_reg_req_gp;
+	} else if (mode_is_float(mode)) {
+		req = &riscv_class_reg_req_fp;
 	} else if (mode == mode_M) {
 		req = arch_memory_req;
 	} else {
@@ -856,6 +1319,15 @@ static ir_node *gen_Proj_Builtin(ir_node *const node)
 		assert(get_Proj_num(node) == pn_Builtin_max + 1);
 		return new_pred;
 
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_fence:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
 	case ir_bk_bswap:
 	case ir_bk_clz:
 	case ir_bk_compare_swap:
@@ -973,14 +1445,39 @@ static ir_node *gen_Proj_Proj_Start(ir_node *const node)
 	ir_graph            *const irg   = get_irn_irg(node);
 	unsigned             const num   = get_Proj_num(node);
 	riscv_reg_or_slot_t *const param = &cur_cconv.parameters[num];
-	if (param->reg) {
-		return be_get_Start_proj(irg, param->reg);
-	} else {
+	ir_mode             *const mode  = get_irn_mode(node);
+	if (mode_is_float(mode) && param->reg && !is_fp_reg(param->reg)) {
+		/* The value is passed according to the integer calling convention. */
 		dbg_info *const dbgi  = get_irn_dbg_info(node);
 		ir_node  *const block = be_transform_nodes_block(node);
-		ir_node  *const mem   = be_get_Start_mem(irg);
-		ir_node  *const base  = cur_cconv.omit_fp ? get_Start_sp(irg) : get_Start_fp(irg);
-		ir_node  *const load  = new_bd_riscv_lw(dbgi, block, mem, base, param->entity, 0);
+		ir_node  *const lo    = be_get_Start_proj(irg, param->reg);
+		if (get_mode_size_bits(mode) == 32)
+			return new_bd_riscv_fmv_w_x(dbgi, block, lo);
+		if (riscv_cg_config.rv64)
+			return new_bd_riscv_fmv_d_x(dbgi, block, lo);
+		ir_node *hi;
+		if (param->reg_hi) {
+			hi = be_get_Start_proj(irg, param->reg_hi);
+		} else {
+			ir_node *const mem  = be_get_Start_mem(irg);
+			ir_node *const base = get_frame_base(irg);
+			ir_node *const load = new_bd_riscv_lw(dbgi, block, mem, base, param->entity_hi, 0);
+			hi = be_new_Proj(load, pn_riscv_lw_res);
+		}
+		return combine_double(dbgi, block, lo, hi);
+	} else if (param->reg) {
+		return be_get_Start_proj(irg, param->reg);
+	} else {
+		dbg_info    *const dbgi  = get_irn_dbg_info(node);
+		ir_node     *const block = be_transform_nodes_block(node);
+		ir_node     *const mem   = be_get_Start_mem(irg);
+		ir_node     *const base  = get_frame_base(irg);
+		unsigned     const size  = get_mode_size_bits(mode);
+		cons_loadop *const cons  =
+			!mode_is_float(mode) ? (size == 64 ? &new_bd_riscv_ld : &new_bd_riscv_lw) :
+			size == 32           ? &new_bd_riscv_flw :
+			&new_bd_riscv_fld;
+		ir_node     *const load  = cons(dbgi, block, mem, base, param->entity, 0);
 		return be_new_Proj(load, pn_riscv_lw_res);
 	}
 }
@@ -1001,7 +1498,7 @@ static ir_node *gen_Proj_Start(ir_node *const node)
 	ir_graph *const irg = get_irn_irg(node);
 	switch ((pn_Start)get_Proj_num(node)) {
 	case pn_Start_M:            return be_get_Start_mem(irg);
-	case pn_Start_P_frame_base: return cur_cconv.omit_fp ? get_Start_sp(irg): get_Start_fp(irg);
+	case pn_Start_P_frame_base: return get_frame_base(irg);
 	case pn_Start_T_args:       return new_r_Bad(irg, mode_T);
 	}
 	panic("unexpected Proj");
@@ -1064,7 +1561,7 @@ static ir_node *gen_Return(ir_node *const node)
 	return ret;
 }
 
-static ir_node *gen_shift_op(ir_node *const node, cons_binop *const cons, cons_binop_imm *const cons_imm, bool needs_extension)
+static ir_node *gen_shift_op(ir_node *const node, cons_binop *cons, cons_binop_imm *cons_imm, cons_binop *const cons_w, cons_binop_imm *const cons_imm_w, bool needs_extension)
 {
 	dbg_info *const dbgi  = get_irn_dbg_info(node);
 	ir_node  *const block = be_transform_nodes_block(node);
@@ -1074,8 +1571,16 @@ static ir_node *gen_shift_op(ir_node *const node, cons_binop *const cons, cons_b
 	ir_mode *const mode   = get_irn_mode(node);
 	unsigned const size   = get_mode_size_bits(mode);
 
-	needs_extension = needs_extension && (size != RISCV_MACHINE_SIZE);
-	int extend = RISCV_MACHINE_SIZE - size;
+	/* On RV64 modes smaller than 64 bit use the 32 bit shifts. */
+	bool const word = is_rv64_word(mode);
+	if (word) {
+		cons     = cons_w;
+		cons_imm = cons_imm_w;
+	}
+	int const width = word ? 32 : RISCV_MACHINE_SIZE;
+
+	needs_extension = needs_extension && (size != width);
+	int extend = width - size;
 	/* right shift operations with mode sizes < 32 Bit require correct sign/zero extension.
 	 * This is done by first shifting the operand to the left by 32-size bits and then shifting back to the
 	 * right (arithmetic/logical) by the same amount. Finally the actual shift operation is performed.
@@ -1087,16 +1592,18 @@ static ir_node *gen_shift_op(ir_node *const node, cons_binop *const cons, cons_b
 			new_l = new_bd_riscv_andi(dbgi, block, new_l, NULL, (1U << size) - 1);
 			needs_extension = false;
 		} else {
-			new_l = new_bd_riscv_slli(dbgi, block, new_l, NULL, extend);
+			new_l = word
+				? new_bd_riscv_slliw(dbgi, block, new_l, NULL, extend)
+				: new_bd_riscv_slli( dbgi, block, new_l, NULL, extend);
 		}
 	}
 	if (is_Const(r)) {
 		long val = get_Const_long(r);
-		if (needs_extension && is_uimm5(extend + val)) {
+		if (needs_extension && extend + val < width) {
 			val = extend + val;
 			needs_extension = false;
 		}
-		if (is_uimm5(val)) {
+		if (0 <= val && val < width) {
 			if (needs_extension) {
 				new_l = cons_imm(dbgi, block, new_l, NULL, extend);
 			}
@@ -1112,17 +1619,17 @@ static ir_node *gen_shift_op(ir_node *const node, cons_binop *const cons, cons_b
 
 static ir_node *gen_Shl(ir_node *const node)
 {
-	return gen_shift_op(node, &new_bd_riscv_sll, &new_bd_riscv_slli, false);
+	return gen_shift_op(node, &new_bd_riscv_sll, &new_bd_riscv_slli, &new_bd_riscv_sllw, &new_bd_riscv_slliw, false);
 }
 
 static ir_node *gen_Shr(ir_node *const node)
 {
-	return gen_shift_op(node, &new_bd_riscv_srl, &new_bd_riscv_srli, true);
+	return gen_shift_op(node, &new_bd_riscv_srl, &new_bd_riscv_srli, &new_bd_riscv_srlw, &new_bd_riscv_srliw, true);
 }
 
 static ir_node *gen_Shrs(ir_node *const node)
 {
-	return gen_shift_op(node, &new_bd_riscv_sra, &new_bd_riscv_srai, true);
+	return gen_shift_op(node, &new_bd_riscv_sra, &new_bd_riscv_srai, &new_bd_riscv_sraw, &new_bd_riscv_sraiw, true);
 }
 
 static ir_node *gen_Start(ir_node *const node)
@@ -1140,9 +1647,11 @@ static ir_node *gen_Start(ir_node *const node)
 	ir_entity *const ent  = get_irg_entity(irg);
 	ir_type   *const type = get_entity_type(ent);
 	for (size_t i = 0, n = get_method_n_params(type); i != n; ++i) {
-		arch_register_t const *const reg = cur_cconv.parameters[i].reg;
-		if (reg)
-			outs[reg->global_index] = BE_START_REG;
+		riscv_reg_or_slot_t const *const param = &cur_cconv.parameters[i];
+		if (param->reg)
+			outs[param->reg->global_index] = BE_START_REG;
+		if (param->reg_hi)
+			outs[param->reg_hi->global_index] = BE_START_REG;
 	}
 	if (!cur_cconv.omit_fp)
 		outs[REG_FP] = BE_START_IGNORE;
@@ -1150,8 +1659,6 @@ static ir_node *gen_Start(ir_node *const node)
 	return be_new_Start(irg, outs);
 }
 
-typedef ir_node *cons_storeop(dbg_info*, ir_node*, ir_node*, ir_node*, ir_node*, ir_entity*, int32_t);
-
 static ir_node *gen_Store(ir_node *const node)
 {
 	ir_node       *old_val = get_Store_value(node);
@@ -1165,6 +1672,8 @@ static ir_node *gen_Store(ir_node *const node)
 			cons = &new_bd_riscv_sh;
 		} else if (size == 32) {
 			cons = &new_bd_riscv_sw;
+		} else if (size == 64 && riscv_cg_config.rv64) {
+			cons = &new_bd_riscv_sd;
 		} else {
 			panic("invalid store");
 		}
@@ -1177,6 +1686,14 @@ static ir_node *gen_Store(ir_node *const node)
 		ir_node *const store = cons(dbgi, block, mem, addr.base, val, addr.ent, addr.val);
 
 		return store;
+	} else if (mode_is_float(mode)) {
+		cons_storeop *const cons  = get_mode_size_bits(mode) == 32 ? &new_bd_riscv_fsw : &new_bd_riscv_fsd;
+		dbg_info     *const dbgi  = get_irn_dbg_info(node);
+		ir_node      *const block = be_transform_nodes_block(node);
+		ir_node      *const mem   = be_transform_node(get_Store_mem(node));
+		ir_node      *const val   = be_transform_node(old_val);
+		riscv_addr    const addr  = make_addr(get_Store_ptr(node));
+		return cons(dbgi, block, mem, addr.base, val, addr.ent, addr.val);
 	}
 	TODO(node);
 }
@@ -1191,7 +1708,19 @@ static ir_node *gen_Sub(ir_node *const node)
 		ir_node  *const block = be_transform_nodes_block(node);
 		ir_node  *const new_l = be_transform_node(l);
 		ir_node  *const new_r = be_transform_node(r);
-		return new_bd_riscv_sub(dbgi, block, new_l, new_r);
+		return is_rv64_word(mode)
+			? new_bd_riscv_subw(dbgi, block, new_l, new_r)
+			: new_bd_riscv_sub( dbgi, block, new_l, new_r);
+	} else if (mode_is_float(mode)) {
+		/* a * b - c -> fmsub */
+		ir_node *const mul_l = get_fusable_Mul(l);
+		if (mul_l)
+			return gen_fma(node, mul_l, r, &new_bd_riscv_fmsub);
+		/* c - a * b -> fnmsub */
+		ir_node *const mul_r = get_fusable_Mul(r);
+		if (mul_r)
+			return gen_fma(node, mul_r, l, &new_bd_riscv_fnmsub);
+		return gen_fp_binop(node, l, r, &new_bd_riscv_fsub);
 	}
 	TODO(node);
 }
@@ -1209,10 +1738,11 @@ static ir_node *gen_Switch(ir_node *const node)
 	ir_node   *const block  = be_transform_nodes_block(node);
 	ir_node   *const nomem  = get_irg_no_mem(irg);
 	ir_node   *const sel    = be_transform_node(get_Switch_selector(node));
-	ir_node   *const sll    = new_bd_riscv_slli(dbgi, block, sel, NULL, 2);
+	int32_t    const shift  = riscv_cg_config.rv64 ? 3 : 2;
+	ir_node   *const sll    = new_bd_riscv_slli(dbgi, block, sel, NULL, shift);
 	ir_node   *const lui    = new_bd_riscv_lui(dbgi, block, entity, 0);
 	ir_node   *const add    = new_bd_riscv_add(dbgi, block, sll, lui);
-	ir_node   *const load   = new_bd_riscv_lw(dbgi, block, nomem, add, entity, 0);
+	ir_node   *const load   = riscv_new_gp_load(dbgi, block, nomem, add, entity, 0);
 	ir_node   *const res    = be_new_Proj(load, pn_riscv_lw_res);
 	unsigned   const n_outs = get_Switch_n_outs(node);
 	return new_bd_riscv_switch(dbgi, block, res, n_outs, table, entity);
@@ -1224,6 +1754,8 @@ static ir_node *gen_Unknown(ir_node *const node)
 	ir_mode *const mode  = get_irn_mode(node);
 	if (be_mode_needs_gp_reg(mode)) {
 		return be_new_Unknown(block, &riscv_class_reg_req_gp);
+	} else if (mode_is_float(mode)) {
+		return be_new_Unknown(block, &riscv_class_reg_req_fp);
 	} else {
 		TODO(node);
 	}
@@ -1287,10 +1819,14 @@ static bool riscv_variadic_fixups(ir_graph *const irg)
 		return false;
 
 	size_t                    const n_params     = get_method_n_params(mtp);
-	if (n_params >= ARRAY_SIZE(regs_param_gp))
+	riscv_calling_convention_t cconv;
+	riscv_determine_calling_convention(&cconv, mtp, n_params, NULL);
+	size_t                    const n_gp_params  = cconv.n_param_regs_gp;
+	riscv_free_calling_convention(&cconv);
+	if (n_gp_params >= ARRAY_SIZE(regs_param_gp))
 		return false;
 	size_t                    const n_ress       = get_method_n_ress(mtp);
-	size_t                    const new_n_params = ARRAY_SIZE(regs_param_gp);
+	size_t                    const new_n_params = n_params + ARRAY_SIZE(regs_param_gp) - n_gp_params;
 	unsigned                  const cc_mask      = get_method_calling_convention(mtp);
 	mtp_additional_properties const props        = get_method_additional_properties(mtp);
 	ir_type                  *const new_mtp      = new_type_method(new_n_params, n_ress, true, cc_mask, props);
@@ -1359,10 +1895,10 @@ void riscv_transform_graph(ir_graph *const irg)
 	unsigned n_stores = 0;
 	ir_entity *entity;
 	if (is_method_variadic(fun_type)) {
-		for (size_t i = 0; i < ARRAY_SIZE(regs_param_gp); ++i) {
+		for (size_t i = 0, n = get_method_n_params(fun_type); i < n; ++i) {
 			riscv_reg_or_slot_t const *const param = &cur_cconv.parameters[i];
 			entity = param->entity;
-			if (entity == NULL)
+			if (entity == NULL || !param->reg || is_fp_reg(param->reg))
 				continue;
 			assert(n_stores < ARRAY_SIZE(regs_param_gp));
 			need_stores[n_stores++] = entity;
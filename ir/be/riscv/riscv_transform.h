@@ -6,10 +6,18 @@
 #ifndef FIRM_BE_RISCV_TRANSFORM_H
 #define FIRM_BE_RISCV_TRANSFORM_H
 
+#include <stdint.h>
+
 #include "firm_types.h"
 
 ir_node *get_Start_zero(ir_graph *irg);
 
+/** Creates a load of a whole general purpose register (lw or ld). */
+ir_node *riscv_new_gp_load(dbg_info *dbgi, ir_node *block, ir_node *mem, ir_node *base, ir_entity *ent, int32_t val);
+
+/** Creates a store of a whole general purpose register (sw or sd). */
+ir_node *riscv_new_gp_store(dbg_info *dbgi, ir_node *block, ir_node *mem, ir_node *base, ir_node *value, ir_entity *ent, int32_t val);
+
 void riscv_transform_graph(ir_graph *irg);
 
 #endif
@@ -1981,6 +1981,15 @@ static ir_node *gen_Builtin(ir_node *node)
 		return gen_va_start(node);
 	case ir_bk_may_alias:
 	case ir_bk_va_arg:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
+	case ir_bk_atomic_fence:
 		break;
 	}
 	panic("Builtin %s not implemented", get_builtin_kind_name(kind));
@@ -2031,6 +2040,15 @@ static ir_node *gen_Proj_Builtin(ir_node *proj)
 		}
 	case ir_bk_may_alias:
 	case ir_bk_va_arg:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
+	case ir_bk_atomic_fence:
 		break;
 	}
 	panic("Builtin %s not implemented", get_builtin_kind_name(kind));
@@ -39,6 +39,8 @@ int ir_target_set_triple(ir_machine_triple_t const *machine)
 		isa = &mips_isa_if;
 	} else if (streq(cpu, "riscv32")) {
 		isa = &riscv32_isa_if;
+	} else if (streq(cpu, "riscv64")) {
+		isa = &riscv64_isa_if;
 	} else if (streq(cpu, "TEMPLATE")) {
 		isa = &TEMPLATE_isa_if;
 	} else {
@@ -31,6 +31,7 @@
 #include "irprog_t.h"
 #include "irtools.h"
 #include "lc_opts.h"
+#include "obst.h"
 #include "opt_init.h"
 #include "target_t.h"
 #include "tv_t.h"
@@ -97,9 +98,16 @@ void ir_finish(void)
 	finish_mode();
 	finish_ident();
 	finish_target();
+	obstack_arena_release();
 	initialized = false;
 }
 
+void ir_enable_threads(void)
+{
+	ident_enable_threads();
+	tarval_enable_threads();
+}
+
 unsigned ir_get_version_major(void)
 {
 	return libfirm_VERSION_MAJOR;
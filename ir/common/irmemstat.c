@@ -0,0 +1,245 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Memory usage accounting per subsystem.
+ *
+ * The counters are updated with relaxed atomic operations, as idents and
+ * tarvals may be created by several threads at once.  As even these are
+ * measurable, nothing is accounted unless the accounting is enabled.
+ */
+#include "irmemstat_t.h"
+
+#include <stdint.h>
+
+#include "be_t.h"
+#include "irgraph_t.h"
+#include "obst.h"
+#include "panic.h"
+#include "statev_t.h"
+#include "util.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef struct mem_counter_t {
+	int64_t current;
+	int64_t peak;
+} mem_counter_t;
+
+static mem_counter_t counters[ir_mem_last + 1];
+static mem_counter_t total;
+
+bool ir_mem_stat_enabled;
+
+void ir_mem_stat_enable(void)
+{
+	ir_mem_stat_enabled = true;
+}
+
+static int64_t atomic_load(int64_t const *const value)
+{
+#if defined(_MSC_VER)
+	return *(__int64 const volatile*)value;
+#else
+	return __atomic_load_n(value, __ATOMIC_RELAXED);
+#endif
+}
+
+static void atomic_store(int64_t *const value, int64_t const new_value)
+{
+#if defined(_MSC_VER)
+	_InterlockedExchange64((__int64 volatile*)value, new_value);
+#else
+	__atomic_store_n(value, new_value, __ATOMIC_RELAXED);
+#endif
+}
+
+/** Adds @p delta to @p value and returns the new value. */
+static int64_t atomic_add(int64_t *const value, int64_t const delta)
+{
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd64((__int64 volatile*)value, delta) + delta;
+#else
+	return __atomic_add_fetch(value, delta, __ATOMIC_RELAXED);
+#endif
+}
+
+/** Raises @p value to at least @p candidate. */
+static void atomic_max(int64_t *const value, int64_t const candidate)
+{
+	int64_t old = atomic_load(value);
+	while (old < candidate) {
+#if defined(_MSC_VER)
+		int64_t const seen = _InterlockedCompareExchange64(
+			(__int64 volatile*)value, candidate, old);
+		if (seen == old)
+			return;
+		old = seen;
+#else
+		if (__atomic_compare_exchange_n(value, &old, candidate, true,
+		                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return;
+#endif
+	}
+}
+
+static void count(mem_counter_t *const counter, int64_t const delta)
+{
+	int64_t const current = atomic_add(&counter->current, delta);
+	if (delta > 0)
+		atomic_max(&counter->peak, current);
+}
+
+static void account(mem_counter_t *const counter, ptrdiff_t const bytes)
+{
+	count(counter, bytes);
+	count(&total, bytes);
+}
+
+void ir_mem_account(ir_mem_kind const kind, ptrdiff_t const bytes)
+{
+	account(&counters[kind], bytes);
+}
+
+static void *chunk_alloc(void *const arg, ptrdiff_t const size)
+{
+	void *const chunk = obstack_arena_chunk_alloc(size);
+	if (chunk != NULL)
+		account((mem_counter_t*)arg, size);
+	return chunk;
+}
+
+static void chunk_free(void *const arg, void *const chunk)
+{
+	struct _obstack_chunk const *const c = (struct _obstack_chunk const*)chunk;
+	account((mem_counter_t*)arg, -(c->limit - (char const*)c));
+	obstack_arena_chunk_free(chunk);
+}
+
+void ir_mem_obstack_init(struct obstack *const obst, ir_mem_kind const kind)
+{
+	if (!ir_mem_stat_enabled) {
+		obstack_init(obst);
+		return;
+	}
+	obstack_specify_allocation_with_arg(obst, 0, 0, chunk_alloc, chunk_free,
+	                                    &counters[kind]);
+}
+
+char const *get_ir_mem_kind_name(ir_mem_kind const kind)
+{
+	switch (kind) {
+	case ir_mem_nodes:    return "nodes";
+	case ir_mem_outs:     return "outs";
+	case ir_mem_edges:    return "edges";
+	case ir_mem_tarvals:  return "tarvals";
+	case ir_mem_idents:   return "idents";
+	case ir_mem_types:    return "types";
+	case ir_mem_backend:  return "backend";
+	case ir_mem_liveness: return "liveness";
+	case ir_mem_sets:     return "sets";
+	}
+	panic("invalid memory kind");
+}
+
+static size_t to_size(int64_t const value)
+{
+	return value < 0 ? 0 : (size_t)value;
+}
+
+size_t ir_mem_stat_get_current(ir_mem_kind const kind)
+{
+	return to_size(atomic_load(&counters[kind].current));
+}
+
+size_t ir_mem_stat_get_peak(ir_mem_kind const kind)
+{
+	return to_size(atomic_load(&counters[kind].peak));
+}
+
+size_t ir_mem_stat_get_total(void)
+{
+	return to_size(atomic_load(&total.current));
+}
+
+size_t ir_mem_stat_get_total_peak(void)
+{
+	return to_size(atomic_load(&total.peak));
+}
+
+void ir_mem_stat_reset_peaks(void)
+{
+	for (ir_mem_kind k = (ir_mem_kind)0; k <= ir_mem_last; ++k) {
+		mem_counter_t *const counter = &counters[k];
+		atomic_store(&counter->peak, atomic_load(&counter->current));
+	}
+	atomic_store(&total.peak, atomic_load(&total.current));
+}
+
+static size_t get_obstack_used(struct obstack const *const obst)
+{
+	return (size_t)obstack_memory_used((struct obstack*)obst);
+}
+
+size_t ir_mem_stat_get_graph(ir_graph const *const irg, ir_mem_kind const kind)
+{
+	switch (kind) {
+	case ir_mem_nodes:
+		return get_obstack_used(&irg->obst);
+
+	case ir_mem_outs:
+		return irg->out_obst_allocated ? get_obstack_used(&irg->out_obst) : 0;
+
+	case ir_mem_edges: {
+		size_t used = 0;
+		for (ir_edge_kind_t k = EDGE_KIND_FIRST; k <= EDGE_KIND_LAST; ++k) {
+			irg_edge_info_t const *const info = &irg->edge_info[k];
+			if (info->allocated) {
+				used += get_obstack_used(&info->edges_obst);
+				used += info->edges.num_buckets * sizeof(*info->edges.entries);
+			}
+		}
+		return used;
+	}
+
+	case ir_mem_backend:
+	case ir_mem_liveness:
+		return be_get_irg_mem_used(irg, kind);
+
+	case ir_mem_tarvals:
+	case ir_mem_idents:
+	case ir_mem_types:
+	case ir_mem_sets:
+		return 0;
+	}
+	panic("invalid memory kind");
+}
+
+void ir_mem_stat_print(FILE *const out)
+{
+	fprintf(out, "%-10s %12s %12s\n", "memory", "current", "peak");
+	for (ir_mem_kind k = (ir_mem_kind)0; k <= ir_mem_last; ++k) {
+		fprintf(out, "%-10s %12zu %12zu\n", get_ir_mem_kind_name(k),
+		        ir_mem_stat_get_current(k), ir_mem_stat_get_peak(k));
+	}
+	fprintf(out, "%-10s %12zu %12zu\n", "total", ir_mem_stat_get_total(),
+	        ir_mem_stat_get_total_peak());
+}
+
+void ir_mem_stat_ev(char const *const prefix)
+{
+	if (!stat_ev_enabled || !ir_mem_stat_enabled)
+		return;
+	char buf[128];
+	for (ir_mem_kind k = (ir_mem_kind)0; k <= ir_mem_last; ++k) {
+		snprintf(buf, sizeof(buf), "%s%s", prefix, get_ir_mem_kind_name(k));
+		stat_ev_ull(buf, ir_mem_stat_get_current(k));
+	}
+	snprintf(buf, sizeof(buf), "%speak", prefix);
+	stat_ev_ull(buf, ir_mem_stat_get_total_peak());
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Memory usage accounting per subsystem.
+ */
+#ifndef FIRM_COMMON_IRMEMSTAT_T_H
+#define FIRM_COMMON_IRMEMSTAT_T_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "irmemstat.h"
+#include "obstack.h"
+#include "xmalloc.h"
+
+/** Whether memory is accounted, see ir_mem_stat_enable(). */
+extern bool ir_mem_stat_enabled;
+
+/** Adds @p bytes (which may be negative) to the usage of subsystem @p kind. */
+void ir_mem_account(ir_mem_kind kind, ptrdiff_t bytes);
+
+/**
+ * Initializes an obstack, whose chunks are accounted to subsystem @p kind if
+ * the accounting is enabled.  Such an obstack is used and freed like any other
+ * obstack.
+ */
+void ir_mem_obstack_init(struct obstack *obst, ir_mem_kind kind);
+
+/** Allocates @p bytes and accounts them to subsystem @p kind. */
+static inline void *ir_mem_alloc(ir_mem_kind const kind, size_t const bytes)
+{
+	if (ir_mem_stat_enabled)
+		ir_mem_account(kind, (ptrdiff_t)bytes);
+	return xmalloc(bytes);
+}
+
+/** Frees @p ptr of @p bytes, which was allocated with ir_mem_alloc(). */
+static inline void ir_mem_free(ir_mem_kind const kind, void *const ptr,
+                               size_t const bytes)
+{
+	if (ir_mem_stat_enabled)
+		ir_mem_account(kind, -(ptrdiff_t)bytes);
+	free(ptr);
+}
+
+/**
+ * Emits the current usage of each subsystem as statistic events named
+ * @p prefix followed by the subsystem name, and the total peak as
+ * @p prefix followed by "peak".
+ */
+void ir_mem_stat_ev(char const *prefix);
+
+#endif
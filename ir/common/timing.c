@@ -13,6 +13,7 @@
 #include "timing.h"
 #include "xmalloc.h"
 #include "panic.h"
+#include "compiler.h"
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -54,8 +55,8 @@ struct ir_timer_t {
 	unsigned       running : 1; /**< set if this timer is running */
 };
 
-/** The top of the timer stack */
-static ir_timer_t *timer_stack;
+/** The top of the timer stack of this thread */
+static THREAD_LOCAL ir_timer_t *timer_stack;
 
 ir_timer_t *ir_timer_new(void)
 {
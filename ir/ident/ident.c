@@ -12,27 +12,24 @@
 
 #include "hashptr.h"
 #include "obst.h"
-#include "set.h"
+#include "shardset.h"
 #include <stdio.h>
 #include <string.h>
 
-static set *id_set;
-
-/** An obstack used for temporary space */
-static struct obstack id_obst;
+/** All idents.  Sharded once threads are used, so idents can be created from
+ * several threads. */
+static shardset_t id_set;
 
 void init_ident(void)
 {
 	/* it's ok to use memcmp here, we check only strings */
-	id_set = new_set(memcmp, 128);
-	obstack_init(&id_obst);
+	shardset_init(&id_set, memcmp, 4096, ir_mem_idents);
 }
 
 ident *new_id_from_chars(const char *str, size_t len)
 {
-	unsigned   hash   = hash_data((const unsigned char*)str, len);
-	set_entry *result = set_hinsert0(id_set, str, len, hash);
-	return (ident*)result->dptr;
+	unsigned hash = hash_data((const unsigned char*)str, len);
+	return (ident*)shardset_insert0(&id_set, str, len, hash);
 }
 
 ident *new_id_from_str(const char *str)
@@ -40,22 +37,20 @@ ident *new_id_from_str(const char *str)
 	return new_id_from_chars(str, strlen(str));
 }
 
-static ident *new_ident_from_obst(struct obstack *const obst)
-{
-	size_t const len    = obstack_object_size(obst);
-	char  *const string = (char*)obstack_finish(obst);
-	ident *const res    = new_id_from_chars(string, len);
-	obstack_free(obst, string);
-	return res;
-}
-
 ident *new_id_fmt(char const *const fmt, ...)
 {
+	/* Use a local obstack, so this is safe to call from several threads. */
+	struct obstack obst;
+	obstack_init(&obst);
 	va_list ap;
 	va_start(ap, fmt);
-	obstack_vprintf(&id_obst, fmt, ap);
+	obstack_vprintf(&obst, fmt, ap);
 	va_end(ap);
-	return new_ident_from_obst(&id_obst);
+	size_t const len    = obstack_object_size(&obst);
+	char  *const string = (char*)obstack_finish(&obst);
+	ident *const res    = new_id_from_chars(string, len);
+	obstack_free(&obst, NULL);
+	return res;
 }
 
 const char *(get_id_str)(ident *id)
@@ -63,15 +58,22 @@ const char *(get_id_str)(ident *id)
 	return get_id_str_(id);
 }
 
+void ident_enable_threads(void)
+{
+	shardset_enable_threads(&id_set);
+}
+
 void finish_ident(void)
 {
-	obstack_free(&id_obst, NULL);
-	del_set(id_set);
-	id_set = NULL;
+	shardset_destroy(&id_set);
 }
 
 ident *id_unique(const char *tag)
 {
-	static unsigned unique_id = 0;
-	return new_id_fmt("%s.%u", tag, unique_id++);
+	static unsigned   unique_id = 0;
+	static spinlock_t unique_lock;
+	spin_lock(&unique_lock);
+	unsigned const id = unique_id++;
+	spin_unlock(&unique_lock);
+	return new_id_fmt("%s.%u", tag, id);
 }
@@ -25,6 +25,11 @@ static inline const char *get_id_str_(ident *ident)
  */
 void init_ident(void);
 
+/**
+ * Prepares the ident module for creating idents from several threads.
+ */
+void ident_enable_threads(void);
+
 /**
  * Finishes the ident module, frees all entries.
  */
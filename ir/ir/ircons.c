@@ -34,6 +34,126 @@
  */
 static uninitialized_local_variable_func_t *default_initialize_local_variable = NULL;
 
+/** Graphs with at most this many local variables use dense value tables. */
+#define DENSE_VALUES_MAX  32
+/** Initial number of entries of a sparse block value table. */
+#define SPARSE_VALUES_MIN 8
+
+typedef struct value_entry_t {
+	int      pos;   /**< the value number */
+	ir_node *value; /**< the value, NULL for a free entry */
+} value_entry_t;
+
+/**
+ * The values of the local variables in a block.  For graphs with few locals
+ * this is a dense array indexed by value number.  Frontends producing
+ * thousands of locals and blocks would leave most of such arrays empty, so
+ * there blocks start with a linear probing hash table which only records the
+ * values set or looked up in the block.  A table which would grow larger
+ * than the dense array is replaced by one.
+ */
+struct block_values_t {
+	unsigned       size;      /**< number of entries (a power of two) */
+	unsigned       n_entries; /**< number of used entries */
+	value_entry_t *entries;   /**< the hash table, NULL if dense */
+	ir_node      **dense;     /**< the dense array, NULL if sparse */
+};
+
+void alloc_block_values(ir_node *block)
+{
+	ir_graph       *const irg    = get_irn_irg(block);
+	struct obstack *const obst   = get_irg_obstack(irg);
+	unsigned        const n_loc  = irg->n_loc;
+	block_values_t *const values = OALLOCZ(obst, block_values_t);
+	if (n_loc <= DENSE_VALUES_MAX) {
+		values->dense   = OALLOCNZ(obst, ir_node*, n_loc);
+	} else {
+		values->size    = SPARSE_VALUES_MIN;
+		values->entries = OALLOCNZ(obst, value_entry_t, SPARSE_VALUES_MIN);
+	}
+	block->attr.block.values = values;
+}
+
+/**
+ * Returns the entry for value number @p pos in a sparse table or the free
+ * entry where it would have to be inserted.
+ */
+static value_entry_t *find_value_entry(block_values_t const *const values,
+                                       int const pos)
+{
+	unsigned const mask = values->size - 1;
+	for (unsigned i = (unsigned)pos & mask;; i = (i + 1) & mask) {
+		value_entry_t *const entry = &values->entries[i];
+		if (entry->value == NULL || entry->pos == pos)
+			return entry;
+	}
+}
+
+static ir_node *get_block_value(ir_node const *const block, int const pos)
+{
+	block_values_t const *const values = block->attr.block.values;
+	if (values->dense != NULL)
+		return values->dense[pos];
+	return find_value_entry(values, pos)->value;
+}
+
+/**
+ * Doubles the size of a sparse table or turns it into a dense array if that
+ * needs less memory.
+ */
+static void grow_block_values(ir_node const *const block,
+                              block_values_t *const values)
+{
+	ir_graph       *const irg         = get_irn_irg(block);
+	struct obstack *const obst        = get_irg_obstack(irg);
+	value_entry_t  *const old_entries = values->entries;
+	unsigned        const old_size    = values->size;
+	unsigned        const n_loc       = irg->n_loc;
+
+	if (2 * old_size * sizeof(value_entry_t) >= n_loc * sizeof(ir_node*)) {
+		values->dense = OALLOCNZ(obst, ir_node*, n_loc);
+		for (unsigned i = 0; i < old_size; ++i) {
+			value_entry_t const *const entry = &old_entries[i];
+			if (entry->value != NULL)
+				values->dense[entry->pos] = entry->value;
+		}
+		values->entries = NULL;
+		return;
+	}
+
+	values->size    = 2 * old_size;
+	values->entries = OALLOCNZ(obst, value_entry_t, values->size);
+	for (unsigned i = 0; i < old_size; ++i) {
+		value_entry_t const *const entry = &old_entries[i];
+		if (entry->value != NULL)
+			*find_value_entry(values, entry->pos) = *entry;
+	}
+}
+
+static void set_block_value(ir_node *const block, int const pos,
+                            ir_node *const value)
+{
+	block_values_t *const values = block->attr.block.values;
+	if (values->dense == NULL) {
+		value_entry_t *entry = find_value_entry(values, pos);
+		if (entry->value == NULL) {
+			/* keep the load factor below 3/4 */
+			if (4 * (values->n_entries + 1) > 3 * values->size) {
+				grow_block_values(block, values);
+				if (values->dense != NULL)
+					goto dense;
+				entry = find_value_entry(values, pos);
+			}
+			entry->pos = pos;
+			++values->n_entries;
+		}
+		entry->value = value;
+		return;
+	}
+dense:
+	values->dense[pos] = value;
+}
+
 ir_node *new_rd_Const_long(dbg_info *db, ir_graph *irg, ir_mode *mode,
                            long value)
 {
@@ -155,7 +275,7 @@ static ir_node *set_phi_arguments(ir_node *phi, int pos)
  */
 static ir_node *get_r_value_internal(ir_node *block, int pos, ir_mode *mode)
 {
-	ir_node *res = block->attr.block.graph_arr[pos];
+	ir_node *res = get_block_value(block, pos);
 	if (res != NULL)
 		return res;
 
@@ -192,7 +312,7 @@ bad:
 			res = new_rd_Phi0(NULL, block, mode, pos);
 			/* enter phi0 into our variable value table to break cycles
 			 * arising from set_phi_arguments */
-			block->attr.block.graph_arr[pos] = res;
+			set_block_value(block, pos, res);
 			res = set_phi_arguments(res, pos);
 		}
 	} else {
@@ -202,7 +322,7 @@ bad:
 		res->attr.phi.next     = block->attr.block.phis;
 		block->attr.block.phis = res;
 	}
-	block->attr.block.graph_arr[pos] = res;
+	set_block_value(block, pos, res);
 	return res;
 }
 
@@ -242,8 +362,8 @@ void mature_immBlock(ir_node *block)
 		ir_node *const next      = phi->attr.phi.next;
 		int      const pos       = phi->attr.phi.u.pos;
 		ir_node *const new_value = set_phi_arguments(phi, pos);
-		if (block->attr.block.graph_arr[pos] == phi)
-			block->attr.block.graph_arr[pos] = new_value;
+		if (get_block_value(block, pos) == phi)
+			set_block_value(block, pos, new_value);
 		phi = next;
 	}
 
@@ -339,8 +459,8 @@ ir_node *new_rd_immBlock(dbg_info *dbgi, ir_graph *irg)
 
 	set_Block_block_visited(res, 0);
 
-	/* Create and initialize array for Phi-node construction. */
-	res->attr.block.graph_arr = NEW_ARR_DZ(ir_node*, get_irg_obstack(irg), irg->n_loc);
+	/* Create and initialize the values for Phi-node construction. */
+	alloc_block_values(res);
 
 	/* Immature block may not be optimized! */
 	verify_new_node(res);
@@ -419,7 +539,7 @@ static ir_mode *guess_recursively(ir_node *block, int pos)
 		return NULL;
 
 	/* already have a definition -> we can simply look at its mode */
-	ir_node *const value = block->attr.block.graph_arr[pos];
+	ir_node *const value = get_block_value(block, pos);
 	if (value != NULL)
 		return get_irn_mode(value);
 
@@ -441,7 +561,7 @@ ir_mode *ir_r_guess_mode(ir_graph *irg, int pos)
 {
 	/* already have a definition -> we can simply look at its mode */
 	ir_node *const block = irg->current_block;
-	ir_node *const value = block->attr.block.graph_arr[pos+1];
+	ir_node *const value = get_block_value(block, pos + 1);
 	if (value != NULL)
 		return get_irn_mode(value);
 
@@ -464,7 +584,7 @@ void set_r_value(ir_graph *irg, int pos, ir_node *value)
 	assert(pos >= 0);
 	assert(pos + 1 < irg->n_loc);
 	assert(value->kind == k_ir_node);
-	irg->current_block->attr.block.graph_arr[pos + 1] = value;
+	set_block_value(irg->current_block, pos + 1, value);
 }
 
 void set_value(int pos, ir_node *value)
@@ -487,7 +607,7 @@ void set_r_store(ir_graph *const irg, ir_node *store)
 {
 	assert(irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION));
 	assert(get_irn_mode(store) == mode_M && "storing non-memory node");
-	irg->current_block->attr.block.graph_arr[0] = store;
+	set_block_value(irg->current_block, 0, store);
 }
 
 void set_store(ir_node *store)
@@ -542,10 +662,9 @@ ir_node *new_r_Block_noopt(ir_graph *irg, int arity, ir_node *in[])
 	ir_node *res = new_ir_node(NULL, irg, NULL, op_Block, mode_BB, arity, in);
 	res->attr.block.backedge = new_backedge_arr(get_irg_obstack(irg), arity);
 	set_Block_matured(res, 1);
-	/* Create and initialize array for Phi-node construction. */
-	if (irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION)) {
-		res->attr.block.graph_arr = NEW_ARR_DZ(ir_node*, get_irg_obstack(irg), irg->n_loc);
-	}
+	/* Create and initialize the values for Phi-node construction. */
+	if (irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION))
+		alloc_block_values(res);
 	verify_new_node(res);
 	return res;
 }
@@ -55,6 +55,12 @@ ir_node *new_r_Block_noopt(ir_graph *irg, int arity, ir_node *in[]);
  */
 void firm_alloc_frag_arr(ir_node *irn, ir_op *op, ir_node ***frag_store);
 
+/**
+ * Allocates the table of local variable values used for SSA construction
+ * in @p block.
+ */
+void alloc_block_values(ir_node *block);
+
 /**
  * Restarts SSA construction on the given graph with n_loc
  * new values.
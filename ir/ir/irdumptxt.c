@@ -194,7 +194,7 @@ void dump_irnode_to_file(FILE *const F, const ir_node *const n)
 			fprintf(F, "  max pdomsubtree pre num %u\n", get_Block_pdom_max_subtree_pre_num(n));
 		}
 
-		/* not dumped: graph_arr */
+		/* not dumped: values    */
 		/* not dumped: mature    */
 		break;
 	}
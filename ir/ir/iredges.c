@@ -21,6 +21,7 @@
 #include "iredgekinds.h"
 #include "iredgeset.h"
 #include "irgwalk.h"
+#include "irmemstat_t.h"
 #include "irnode_t.h"
 #include "irnodemap.h"
 #include "iropt_t.h"
@@ -37,6 +38,7 @@
 #define Hash(this,key)            (hash_ptr(key->src) ^ (key->pos * 40013))
 #define KeysEqual(this,key1,key2) ((key1->src) == (key2->src) && (key1->pos == key2->pos))
 #define SetRangeEmpty(ptr,size)   memset(ptr, 0, (size) * sizeof((ptr)[0]))
+#define MemKind                   ir_mem_edges
 
 #define hashset_init            ir_edgeset_init
 void ir_edgeset_init_size(ir_edgeset_t *self, size_t size);
@@ -146,7 +148,7 @@ void edges_init_graph_kind(ir_graph *irg, ir_edge_kind_t kind)
 			ir_edgeset_destroy(&info->edges);
 			obstack_free(&info->edges_obst, NULL);
 		}
-		obstack_init(&info->edges_obst);
+		ir_mem_obstack_init(&info->edges_obst, ir_mem_edges);
 		INIT_LIST_HEAD(&info->free_edges);
 		ir_edgeset_init_size(&info->edges, amount);
 		info->allocated = 1;
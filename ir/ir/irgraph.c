@@ -20,12 +20,14 @@
 #include "irgwalk.h"
 #include "irhooks.h"
 #include "irmemory.h"
+#include "irmemstat_t.h"
 #include "irnode_t.h"
 #include "iropt_t.h"
 #include "iroptimize.h"
 #include "irouts.h"
 #include "irprog_t.h"
 #include "irtools.h"
+#include "statev_t.h"
 #include "type_t.h"
 #include "util.h"
 #include "xmalloc.h"
@@ -61,7 +63,7 @@ static ir_graph *alloc_graph(void)
 	/* initialize the idx->node map. */
 	res->idx_irn_map = NEW_ARR_FZ(ir_node*, INITIAL_IDX_IRN_MAP_SIZE);
 
-	obstack_init(&res->obst);
+	ir_mem_obstack_init(&res->obst, ir_mem_nodes);
 
 	/* value table for global value numbering for optimizing use in iropt.c */
 	new_identities(res);
@@ -457,20 +459,39 @@ ir_visited_t (get_irg_visited)(const ir_graph *irg)
 /** maximum visited flag content of all ir_graph visited fields. */
 static ir_visited_t max_irg_visited = 0;
 
+/**
+ * Raises max_irg_visited to at least @p visited.  Graphs may be walked by
+ * several threads at once, so this is done atomically.
+ */
+static void raise_max_irg_visited(ir_visited_t const visited)
+{
+#if defined(_MSC_VER)
+	for (;;) {
+		ir_visited_t const old = max_irg_visited;
+		if (old >= visited
+		    || (ir_visited_t)_InterlockedCompareExchange(
+		        (long volatile*)&max_irg_visited, (long)visited, (long)old) == old)
+			return;
+	}
+#else
+	ir_visited_t old = __atomic_load_n(&max_irg_visited, __ATOMIC_RELAXED);
+	while (old < visited) {
+		if (__atomic_compare_exchange_n(&max_irg_visited, &old, visited, true,
+		                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return;
+	}
+#endif
+}
+
 void set_irg_visited(ir_graph *irg, ir_visited_t visited)
 {
 	irg->visited = visited;
-	if (irg->visited > max_irg_visited) {
-		max_irg_visited = irg->visited;
-	}
+	raise_max_irg_visited(visited);
 }
 
 void inc_irg_visited(ir_graph *irg)
 {
-	++irg->visited;
-	if (irg->visited > max_irg_visited) {
-		max_irg_visited = irg->visited;
-	}
+	raise_max_irg_visited(++irg->visited);
 }
 
 ir_visited_t get_max_irg_visited(void)
@@ -612,8 +633,19 @@ void confirm_irg_properties(ir_graph *irg, ir_graph_properties_t props)
 	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_OUTS)
 	    && (irg->properties & IR_GRAPH_PROPERTY_CONSISTENT_OUTS))
 	    free_irg_outs(irg);
-	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE))
+	/* Only write the global state if it changes, passes may run on different
+	 * graphs at the same time. */
+	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE)
+	    && get_irp_globals_entity_usage_state() != ir_entity_usage_not_computed)
 		set_irp_globals_entity_usage_state(ir_entity_usage_not_computed);
 	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE_FRONTIERS))
 		ir_free_dominance_frontiers(irg);
+
+	/* Optimizations confirm the properties when they are done, so this reports
+	 * the memory after each of them. */
+	if (stat_ev_enabled && ir_mem_stat_enabled) {
+		stat_ev_ctx_push_fmt("opt_irg", "%+F", irg);
+		ir_mem_stat_ev("opt_mem_");
+		stat_ev_ctx_pop("opt_irg");
+	}
 }
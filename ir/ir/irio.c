@@ -23,6 +23,7 @@
 #include "pmap.h"
 #include "tv_t.h"
 #include "util.h"
+#include "xmalloc.h"
 #include <ctype.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -38,6 +39,7 @@ typedef enum typetag_t {
 	tt_keyword,
 	tt_linkage,
 	tt_loop,
+	tt_memory_order,
 	tt_mode_arithmetic,
 	tt_pin_state,
 	tt_segment,
@@ -145,7 +147,7 @@ parse_error(read_env_t *env, const char *fmt, ...)
 	va_end(ap);
 }
 
-COMPILETIME_ASSERT(ir_bk_va_arg == ir_bk_last, complete_builtin_list)
+COMPILETIME_ASSERT(ir_bk_atomic_fence == ir_bk_last, complete_builtin_list)
 
 /** Initializes the symbol table. May be called more than once without problems. */
 static void symtbl_init(void)
@@ -241,11 +243,26 @@ static void symtbl_init(void)
 	INSERTENUM(tt_builtin_kind, ir_bk_may_alias);
 	INSERTENUM(tt_builtin_kind, ir_bk_va_start);
 	INSERTENUM(tt_builtin_kind, ir_bk_va_arg);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_fetch_add);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_fetch_sub);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_fetch_and);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_fetch_or);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_fetch_xor);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_exchange);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_load);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_store);
+	INSERTENUM(tt_builtin_kind, ir_bk_atomic_fence);
 
 	INSERTENUM(tt_cond_jmp_predicate, COND_JMP_PRED_NONE);
 	INSERTENUM(tt_cond_jmp_predicate, COND_JMP_PRED_TRUE);
 	INSERTENUM(tt_cond_jmp_predicate, COND_JMP_PRED_FALSE);
 
+	INSERTENUM(tt_memory_order, ir_memory_order_relaxed);
+	INSERTENUM(tt_memory_order, ir_memory_order_acquire);
+	INSERTENUM(tt_memory_order, ir_memory_order_release);
+	INSERTENUM(tt_memory_order, ir_memory_order_acq_rel);
+	INSERTENUM(tt_memory_order, ir_memory_order_seq_cst);
+
 	INSERTENUM(tt_initializer, IR_INITIALIZER_CONST);
 	INSERTENUM(tt_initializer, IR_INITIALIZER_TARVAL);
 	INSERTENUM(tt_initializer, IR_INITIALIZER_NULL);
@@ -344,13 +361,24 @@ void write_symbol(write_env_t *env, const char *symbol)
 	fputc(' ', env->file);
 }
 
+static void write_entity_stable(write_env_t *env, ir_entity *entity);
+static void write_type_stable(write_env_t *env, ir_type *type);
+
 void write_entity_ref(write_env_t *env, ir_entity *entity)
 {
+	if (env->stable) {
+		write_entity_stable(env, entity);
+		return;
+	}
 	write_long(env, get_entity_nr(entity));
 }
 
 void write_type_ref(write_env_t *env, ir_type *type)
 {
+	if (env->stable) {
+		write_type_stable(env, type);
+		return;
+	}
 	switch (get_type_opcode(type)) {
 	case tpo_unknown:
 		write_symbol(env, "unknown");
@@ -433,6 +461,12 @@ void write_cond_jmp_predicate(write_env_t *env, cond_jmp_predicate pred)
 	fputc(' ', env->file);
 }
 
+void write_memory_order(write_env_t *env, ir_memory_order order)
+{
+	fputs(get_memory_order_name(order), env->file);
+	fputc(' ', env->file);
+}
+
 void write_relation(write_env_t *env, ir_relation relation)
 {
 	write_long(env, (long)relation);
@@ -470,7 +504,7 @@ static void write_scope_end(write_env_t *env)
 
 void write_node_ref(write_env_t *env, const ir_node *node)
 {
-	write_long(env, get_irn_node_nr(node));
+	write_node_nr(env, node);
 }
 
 void write_initializer(write_env_t *const env,
@@ -774,6 +808,124 @@ end_line:
 	fputc('\n', env->file);
 }
 
+/**
+ * Describes @p type by its structure.  Pointers are not followed, so
+ * recursive types terminate.
+ */
+static void write_type_stable(write_env_t *env, ir_type *type)
+{
+	tp_opcode const opcode = get_type_opcode(type);
+	write_symbol(env, get_type_opcode_name(opcode));
+	switch (opcode) {
+	case tpo_unknown:
+	case tpo_code:
+	case tpo_uninitialized:
+		return;
+	default:
+		break;
+	}
+
+	write_unsigned(env, get_type_size(type));
+	write_unsigned(env, get_type_alignment(type));
+	write_unsigned(env, type->flags);
+	switch (opcode) {
+	case tpo_primitive:
+	case tpo_pointer:
+		write_mode_ref(env, get_type_mode(type));
+		return;
+
+	case tpo_array:
+		write_unsigned(env, get_array_size(type));
+		write_type_stable(env, get_array_element_type(type));
+		return;
+
+	case tpo_method: {
+		size_t const n_params = get_method_n_params(type);
+		size_t const n_ress   = get_method_n_ress(type);
+		write_unsigned(env, get_method_calling_convention(type));
+		write_unsigned(env, get_method_additional_properties(type));
+		write_unsigned(env, is_method_variadic(type));
+		write_list_begin(env);
+		for (size_t i = 0; i < n_params; ++i)
+			write_type_stable(env, get_method_param_type(type, i));
+		write_list_end(env);
+		write_list_begin(env);
+		for (size_t i = 0; i < n_ress; ++i)
+			write_type_stable(env, get_method_res_type(type, i));
+		write_list_end(env);
+		return;
+	}
+
+	case tpo_segment:
+		/* the members of segments are described when they are referenced */
+		write_ident_null(env, get_compound_ident(type));
+		return;
+
+	case tpo_struct:
+	case tpo_union:
+	case tpo_class:
+		write_ident_null(env, get_compound_ident(type));
+		write_list_begin(env);
+		for (size_t i = 0, n = get_compound_n_members(type); i < n; ++i)
+			write_entity_stable(env, get_compound_member(type, i));
+		write_list_end(env);
+		return;
+
+	case tpo_unknown:
+	case tpo_code:
+	case tpo_uninitialized:
+		break;
+	}
+	panic("can't write invalid type %+F", type);
+}
+
+/**
+ * Describes @p entity by its names and properties.  Each entity is described
+ * once, later references only repeat its name.
+ */
+static void write_entity_stable(write_env_t *env, ir_entity *entity)
+{
+	write_unsigned(env, entity->kind);
+	/* label numbers are global, there is nothing stable to write */
+	if (entity->kind == IR_ENTITY_LABEL || entity->kind == IR_ENTITY_UNKNOWN)
+		return;
+
+	if (entity->kind == IR_ENTITY_PARAMETER) {
+		write_size_t(env, get_entity_parameter_number(entity));
+	} else {
+		write_ident_null(env, get_entity_ident(entity));
+		write_ident_null(env, entity_has_ld_ident(entity)
+		                      ? get_entity_ld_ident(entity) : NULL);
+	}
+	if (pset_find_ptr(env->written, entity) != NULL)
+		return;
+	pset_insert_ptr(env->written, entity);
+
+	write_visibility(env, get_entity_visibility(entity));
+	write_unsigned(env, get_entity_linkage(entity));
+	write_volatility(env, get_entity_volatility(entity));
+	switch ((ir_entity_kind)entity->kind) {
+	case IR_ENTITY_COMPOUND_MEMBER:
+	case IR_ENTITY_PARAMETER:
+		write_long(env, get_entity_offset(entity));
+		write_unsigned(env, get_entity_bitfield_offset(entity));
+		write_unsigned(env, get_entity_bitfield_size(entity));
+		break;
+	case IR_ENTITY_METHOD:
+		write_unsigned(env, get_entity_additional_properties(entity));
+		break;
+	case IR_ENTITY_ALIAS:
+		write_entity_stable(env, get_entity_alias(entity));
+		break;
+	case IR_ENTITY_NORMAL:
+	case IR_ENTITY_LABEL:
+	case IR_ENTITY_UNKNOWN:
+	case IR_ENTITY_SPILLSLOT:
+		break;
+	}
+	write_type_stable(env, get_entity_type(entity));
+}
+
 void write_switch_table_ref(write_env_t *env, const ir_switch_table *table)
 {
 	size_t n_entries = ir_switch_table_get_n_entries(table);
@@ -802,7 +954,10 @@ void write_pred_refs(write_env_t *env, const ir_node *node, int from)
 
 void write_node_nr(write_env_t *env, const ir_node *node)
 {
-	write_long(env, get_irn_node_nr(node));
+	/* node numbers are global in debug builds, indices are per graph */
+	long const nr = env->stable ? (long)get_irn_idx(node)
+	                            : get_irn_node_nr(node);
+	write_long(env, nr);
 }
 
 static void write_ASM(write_env_t *env, const ir_node *node)
@@ -891,9 +1046,14 @@ static void write_node(const ir_node *node, write_env_t *env)
 	write_node_func *const func = get_generic_function_ptr(write_node_func, op);
 
 	fputc('\t', env->file);
-	if (func == NULL)
-		panic("no write_node_func for %+F", node);
-	func(env, node);
+	if (func == NULL) {
+		if (!env->stable)
+			panic("no write_node_func for %+F", node);
+		write_symbol(env, get_irn_opname(node));
+		env->incomplete = true;
+	} else {
+		func(env, node);
+	}
 	fputc('\n', env->file);
 }
 
@@ -1072,6 +1232,38 @@ static void write_irg(write_env_t *env, ir_graph *irg)
 	write_scope_end(env);
 }
 
+bool write_irg_stable(FILE *const file, ir_graph *const irg)
+{
+	write_env_t env = {
+		.file    = file,
+		.stable  = true,
+		.written = pset_new_ptr_default(),
+	};
+	deq_init(&env.write_queue);
+
+	/* The writers are registered as generic functions of the ops, which are
+	 * used by other phases as well, so restore them afterwards. */
+	unsigned const n_ops   = ir_get_n_opcodes();
+	op_func *const generic = XMALLOCN(op_func, n_ops);
+	for (unsigned i = 0; i < n_ops; ++i) {
+		ir_op *const op = ir_get_opcode(i);
+		generic[i] = op != NULL ? get_generic_function_ptr_(op) : NULL;
+	}
+	writers_init();
+
+	write_irg(&env, irg);
+
+	for (unsigned i = 0; i < n_ops; ++i) {
+		ir_op *const op = ir_get_opcode(i);
+		if (op != NULL)
+			set_generic_function_ptr_(op, generic[i]);
+	}
+	free(generic);
+	deq_free(&env.write_queue);
+	del_pset(env.written);
+	return !env.incomplete;
+}
+
 /* Exports the whole irp to the given file in a textual form. */
 void ir_export_file(FILE *file)
 {
@@ -1444,6 +1636,7 @@ static const char *get_typetag_name(typetag_t typetag)
 	case tt_keyword:             return "keyword";
 	case tt_linkage:             return "linkage";
 	case tt_loop:                return "loop";
+	case tt_memory_order:        return "memory order";
 	case tt_mode_arithmetic:     return "mode_arithmetic";
 	case tt_pin_state:           return "pin state";
 	case tt_segment:             return "segment";
@@ -1488,6 +1681,11 @@ cond_jmp_predicate read_cond_jmp_predicate(read_env_t *env)
 	return (cond_jmp_predicate)read_enum(env, tt_cond_jmp_predicate);
 }
 
+ir_memory_order read_memory_order(read_env_t *env)
+{
+	return (ir_memory_order)read_enum(env, tt_memory_order);
+}
+
 static ir_initializer_kind_t read_initializer_kind(read_env_t *env)
 {
 	return (ir_initializer_kind_t)read_enum(env, tt_initializer);
@@ -6,6 +6,7 @@
 #include "irnode_t.h"
 #include "obst.h"
 #include "pdeq.h"
+#include "pset.h"
 #include "set.h"
 #include "type_t.h"
 #include "typerep.h"
@@ -43,6 +44,10 @@ typedef struct write_env_t {
 	FILE *file;
 	deq_t write_queue;
 	deq_t entity_queue;
+	bool  stable;      /**< write references without entity, type and
+	                        global node numbers, see write_irg_stable() */
+	bool  incomplete;  /**< a node without writer was skipped */
+	pset *written;     /**< entities already described in stable mode */
 } write_env_t;
 
 void write_align(write_env_t *env, ir_align align);
@@ -55,6 +60,7 @@ void write_initializer(write_env_t *env, ir_initializer_t const *ini);
 void write_int(write_env_t *env, int value);
 void write_long(write_env_t *env, long value);
 void write_loop(write_env_t *env, bool loop);
+void write_memory_order(write_env_t *env, ir_memory_order order);
 void write_mode_ref(write_env_t *env, ir_mode *mode);
 void write_node_nr(write_env_t *env, const ir_node *node);
 void write_node_ref(write_env_t *env, const ir_node *node);
@@ -89,6 +95,7 @@ size_t read_size_t(read_env_t *env);
 int read_int(read_env_t *env);
 ir_builtin_kind read_builtin_kind(read_env_t *env);
 cond_jmp_predicate read_cond_jmp_predicate(read_env_t *env);
+ir_memory_order read_memory_order(read_env_t *env);
 ir_align read_align(read_env_t *env);
 bool read_pinned(read_env_t *env);
 int read_preds(read_env_t *env);
@@ -105,6 +112,16 @@ typedef void write_node_func(write_env_t *env, ir_node const *node);
 void register_node_writer(ir_op *op, write_node_func *func);
 
 void register_generated_node_writers(void);
+
+/**
+ * Writes @p irg to @p file in a form, which only depends on the graph itself
+ * and the entities and types it references, but not on the numbering of
+ * entities, types or nodes in other graphs.  Two equal graphs produce the same
+ * output in different runs, so the output can be used as a key for caches.
+ *
+ * @return false if some nodes could not be written
+ */
+bool write_irg_stable(FILE *file, ir_graph *irg);
 void register_generated_node_readers(void);
 
 #endif
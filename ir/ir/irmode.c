@@ -16,6 +16,7 @@
 #include "irprog_t.h"
 #include "obst.h"
 #include "panic.h"
+#include "spinlock.h"
 #include "strcalc.h"
 #include "tv_t.h"
 #include "util.h"
@@ -28,6 +29,10 @@ static struct obstack modes;
 /** The list of all currently existing modes. */
 static ir_mode **mode_list;
 
+/** Protects modes and mode_list, taken by alloc_mode(), released by
+ * register_mode(). */
+static spinlock_t modes_lock;
+
 static bool modes_are_equal(const ir_mode *m, const ir_mode *n)
 {
 	if (m->sort != n->sort)
@@ -104,15 +109,18 @@ void set_modeP(ir_mode *p)
 }
 
 /*
- * Creates a new mode.
+ * Creates a new mode.  The mode lock is held until the mode is passed to
+ * register_mode().
  */
 static ir_mode *alloc_mode(const char *name, ir_mode_sort sort,
                            ir_mode_arithmetic arithmetic, unsigned bit_size,
                            int sign, unsigned modulo_shift)
 {
+	ident *const id = new_id_from_str(name);
+	spin_lock(&modes_lock);
 	ir_mode *mode_tmpl = OALLOCZ(&modes, ir_mode);
 
-	mode_tmpl->name         = new_id_from_str(name);
+	mode_tmpl->name         = id;
 	mode_tmpl->sort         = sort;
 	mode_tmpl->size         = bit_size;
 	mode_tmpl->sign         = sign ? 1 : 0;
@@ -128,6 +136,7 @@ static ir_mode *register_mode(ir_mode *mode)
 	if (old != NULL) {
 		/* remove new mode from obstack */
 		obstack_free(&modes, mode);
+		spin_unlock(&modes_lock);
 		return old;
 	}
 
@@ -135,6 +144,7 @@ static ir_mode *register_mode(ir_mode *mode)
 	mode->type = new_type_primitive(mode);
 	ARR_APP1(ir_mode*, mode_list, mode);
 	init_mode_values(mode);
+	spin_unlock(&modes_lock);
 	hook_new_mode(mode);
 	return mode;
 }
@@ -582,6 +582,29 @@ const char *get_builtin_kind_name(ir_builtin_kind kind)
 		X(ir_bk_may_alias);
 		X(ir_bk_va_start);
 		X(ir_bk_va_arg);
+		X(ir_bk_atomic_fetch_add);
+		X(ir_bk_atomic_fetch_sub);
+		X(ir_bk_atomic_fetch_and);
+		X(ir_bk_atomic_fetch_or);
+		X(ir_bk_atomic_fetch_xor);
+		X(ir_bk_atomic_exchange);
+		X(ir_bk_atomic_load);
+		X(ir_bk_atomic_store);
+		X(ir_bk_atomic_fence);
+	}
+	return "<unknown>";
+#undef X
+}
+
+const char *get_memory_order_name(ir_memory_order order)
+{
+#define X(a)    case a: return #a
+	switch (order) {
+		X(ir_memory_order_relaxed);
+		X(ir_memory_order_acquire);
+		X(ir_memory_order_release);
+		X(ir_memory_order_acq_rel);
+		X(ir_memory_order_seq_cst);
 	}
 	return "<unknown>";
 #undef X
@@ -842,7 +865,19 @@ int is_irn_const_memory(const ir_node *node)
 		case ir_bk_compare_swap:
 		case ir_bk_va_start:
 		case ir_bk_va_arg:
+		case ir_bk_atomic_fetch_add:
+		case ir_bk_atomic_fetch_sub:
+		case ir_bk_atomic_fetch_and:
+		case ir_bk_atomic_fetch_or:
+		case ir_bk_atomic_fetch_xor:
+		case ir_bk_atomic_exchange:
+		case ir_bk_atomic_store:
+		case ir_bk_atomic_fence:
 			return false;
+		case ir_bk_atomic_load:
+			/* Only relaxed loads may be reordered with other memory
+			 * operations, stronger orderings act as barriers. */
+			return get_Builtin_order(node) == ir_memory_order_relaxed;
 		case ir_bk_return_address:
 		case ir_bk_frame_address:
 		case ir_bk_prefetch:
@@ -85,13 +85,16 @@ struct ir_switch_table {
 	ir_switch_table_entry entries[];
 };
 
+/** Values of the local variables of a block during SSA construction. */
+typedef struct block_values_t block_values_t;
+
 /** Attributes for Block nodes. */
 typedef struct block_attr {
 	ir_visited_t block_visited; /**< Visited flag for block walker. */
 	unsigned    is_matured : 1; /**< If set, all inputs are fixed. */
 	unsigned    dynamic_ins: 1; /**< If set in-array is an ARR_F on the heap. */
 	unsigned    marked     : 1; /**< Can be used to temporary mark the block. */
-	ir_node   **graph_arr;      /**< An array to store construction values. */
+	block_values_t *values;     /**< Construction values of local variables. */
 	ir_dom_info dom;            /**< Information about dominators. */
 	ir_dom_info pdom;           /**< Information about post-dominators. */
 	bitset_t   *backedge;       /**< Bit n set to true if pred n is backedge.*/
@@ -149,6 +152,7 @@ typedef struct builtin_attr {
 	except_attr     exc;   /**< Exception attribute. MUST be first. */
 	ir_builtin_kind kind;  /**< kind of the called builtin procedure */
 	ir_type         *type; /**< type of called builtin procedure */
+	ir_memory_order order; /**< memory ordering of atomic builtins */
 } builtin_attr;
 
 /** Attributes for Alloc nodes. */
@@ -384,6 +384,7 @@ static int attrs_equal_Builtin(const ir_node *a, const ir_node *b)
 	const builtin_attr *attr_a = &a->attr.builtin;
 	const builtin_attr *attr_b = &b->attr.builtin;
 	return attr_a->kind == attr_b->kind && attr_a->type == attr_b->type
+	    && attr_a->order == attr_b->order
 	    && except_attrs_equal(&attr_a->exc, &attr_b->exc);
 }
 
@@ -20,6 +20,10 @@
 #include "pmap.h"
 #include "typerep.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 /* Inline functions. */
 #define get_irp_n_irgs()                      get_irp_n_irgs_()
 #define get_irp_irg(pos)                      get_irp_irg_(pos)
@@ -116,10 +120,17 @@ static inline ir_type *get_irp_type_(size_t pos)
 	return irp->types[pos];
 }
 
-/** Returns a new, unique number to number nodes or the like. */
+/**
+ * Returns a new, unique number to number nodes or the like.  This may be
+ * called by passes running on different graphs at the same time.
+ */
 static inline long get_irp_new_node_nr(void)
 {
-	return irp->max_node_nr++;
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd((long volatile*)&irp->max_node_nr, 1);
+#else
+	return __atomic_fetch_add(&irp->max_node_nr, 1, __ATOMIC_RELAXED);
+#endif
 }
 
 static inline size_t get_irp_new_irg_idx(void)
@@ -58,6 +58,7 @@ ir_valueset_entry_t *ir_valueset_find_(const ir_valueset_t *self,
 static void resize(HashSet *self, size_t new_size)
 {
 	HashSetEntry *old_entries = self->entries;
+	size_t        num_buckets = self->num_buckets;
 	HashSetEntry *new_entries;
 	list_head    list = self->elem_list;
 	int          res = 1;
@@ -90,7 +91,7 @@ static void resize(HashSet *self, size_t new_size)
 	(void)res;
 
 	/* now we can free the old array */
-	Free(old_entries);
+	Free(old_entries, num_buckets);
 }
 
 int ir_valueset_insert(ir_valueset_t *valueset, ir_node *value, ir_node *expr)
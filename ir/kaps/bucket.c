@@ -146,3 +146,100 @@ void node_bucket_deep_copy(pbqp_t *pbqp, pbqp_node_bucket_t *dst, pbqp_node_buck
 		node_bucket_insert(dst, pbqp_node_deep_copy(pbqp, *dst, src[bucket_index]));
 	}
 }
+
+/*
+ * The heap functions order the nodes by the degree they had when they were
+ * last inserted or updated.  Callers may change the degree of several nodes
+ * before updating them one after another, comparing the current degrees would
+ * break the heap order then.
+ */
+
+static void node_bucket_heap_set(pbqp_node_bucket_t bucket, unsigned index,
+                                 pbqp_node_t *node)
+{
+	bucket[index]      = node;
+	node->bucket_index = index;
+}
+
+static void node_bucket_heap_sift_up(pbqp_node_bucket_t bucket, unsigned index)
+{
+	pbqp_node_t *node   = bucket[index];
+	unsigned     degree = node->heap_degree;
+
+	while (index > 0) {
+		unsigned     parent_index = (index - 1) / 2;
+		pbqp_node_t *parent       = bucket[parent_index];
+
+		if (parent->heap_degree >= degree)
+			break;
+
+		node_bucket_heap_set(bucket, index, parent);
+		index = parent_index;
+	}
+
+	node_bucket_heap_set(bucket, index, node);
+}
+
+static void node_bucket_heap_sift_down(pbqp_node_bucket_t bucket, unsigned index)
+{
+	unsigned     len    = node_bucket_get_length(bucket);
+	pbqp_node_t *node   = bucket[index];
+	unsigned     degree = node->heap_degree;
+
+	for (;;) {
+		unsigned child_index = 2 * index + 1;
+		if (child_index >= len)
+			break;
+
+		unsigned child_degree = bucket[child_index]->heap_degree;
+		if (child_index + 1 < len) {
+			unsigned right_degree = bucket[child_index + 1]->heap_degree;
+			if (right_degree > child_degree) {
+				++child_index;
+				child_degree = right_degree;
+			}
+		}
+
+		if (child_degree <= degree)
+			break;
+
+		node_bucket_heap_set(bucket, index, bucket[child_index]);
+		index = child_index;
+	}
+
+	node_bucket_heap_set(bucket, index, node);
+}
+
+static void node_bucket_heap_restore(pbqp_node_bucket_t bucket, unsigned index)
+{
+	pbqp_node_t *node = bucket[index];
+
+	node_bucket_heap_sift_up(bucket, index);
+	node_bucket_heap_sift_down(bucket, node->bucket_index);
+}
+
+void node_bucket_heap_insert(pbqp_node_bucket_t *bucket, pbqp_node_t *node)
+{
+	node->heap_degree = pbqp_node_get_degree(node);
+	node_bucket_insert(bucket, node);
+	node_bucket_heap_sift_up(*bucket, node->bucket_index);
+}
+
+void node_bucket_heap_remove(pbqp_node_bucket_t *bucket, pbqp_node_t *node)
+{
+	unsigned node_index = node->bucket_index;
+
+	node_bucket_remove(bucket, node);
+
+	/* The last node took the place of the removed one. */
+	if (node_index < node_bucket_get_length(*bucket))
+		node_bucket_heap_restore(*bucket, node_index);
+}
+
+void node_bucket_heap_update(pbqp_node_bucket_t bucket, pbqp_node_t *node)
+{
+	assert(node_bucket_contains(bucket, node));
+
+	node->heap_degree = pbqp_node_get_degree(node);
+	node_bucket_heap_restore(bucket, node->bucket_index);
+}
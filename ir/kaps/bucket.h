@@ -33,4 +33,9 @@ void node_bucket_remove(pbqp_node_bucket_t *bucket, pbqp_node_t *node);
 void node_bucket_shrink(pbqp_node_bucket_t *bucket, unsigned len);
 void node_bucket_update(pbqp_t *pbqp, pbqp_node_bucket_t bucket);
 
+/* Node buckets kept as binary max-heap ordered by node degree. */
+void node_bucket_heap_insert(pbqp_node_bucket_t *bucket, pbqp_node_t *node);
+void node_bucket_heap_remove(pbqp_node_bucket_t *bucket, pbqp_node_t *node);
+void node_bucket_heap_update(pbqp_node_bucket_t bucket, pbqp_node_t *node);
+
 #endif
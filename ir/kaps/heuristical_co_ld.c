@@ -227,7 +227,7 @@ static void apply_RN_co_without_selection(pbqp_t *pbqp)
 	}
 
 	/* Remove node from old bucket */
-	node_bucket_remove(&node_buckets[3], node);
+	node_bucket_heap_remove(&node_buckets[3], node);
 
 	/* Add node to back propagation list. */
 	node_bucket_insert(&reduced_bucket, node);
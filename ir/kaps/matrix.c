@@ -14,6 +14,7 @@
 #include "pbqp_t.h"
 #include "vector.h"
 #include <assert.h>
+#include <stdbool.h>
 #include <string.h>
 
 pbqp_matrix_t *pbqp_matrix_alloc(pbqp_t *pbqp, unsigned rows, unsigned cols)
@@ -26,6 +27,7 @@ pbqp_matrix_t *pbqp_matrix_alloc(pbqp_t *pbqp, unsigned rows, unsigned cols)
 
 	mat->cols = cols;
 	mat->rows = rows;
+	mat->kind = PBQP_MATRIX_DENSE;
 	memset(mat->entries, 0, sizeof(*mat->entries) * length);
 
 	return mat;
@@ -55,6 +57,7 @@ pbqp_matrix_t *pbqp_matrix_copy_and_transpose(pbqp_t *pbqp, pbqp_matrix_t *m)
 
 	copy->cols = rows;
 	copy->rows = cols;
+	copy->kind = m->kind;
 
 	return copy;
 }
@@ -76,15 +79,28 @@ void pbqp_matrix_add(pbqp_matrix_t *sum, pbqp_matrix_t *summand)
 
 	unsigned len = sum->rows * sum->cols;
 
+	if (summand->kind == PBQP_MATRIX_ZERO)
+		return;
+	if (sum->kind == PBQP_MATRIX_ZERO) {
+		memcpy(sum->entries, summand->entries, sizeof(*sum->entries) * len);
+		sum->kind = summand->kind;
+		return;
+	}
+
 	for (unsigned i = 0; i < len; ++i) {
 		sum->entries[i] = pbqp_add(sum->entries[i], summand->entries[i]);
 	}
+
+	if (sum->kind != summand->kind)
+		sum->kind = PBQP_MATRIX_DENSE;
 }
 
 void pbqp_matrix_set_col_value(pbqp_matrix_t *mat, unsigned col, num value)
 {
 	assert(col < mat->cols);
 
+	mat->kind = PBQP_MATRIX_DENSE;
+
 	unsigned row_len = mat->rows;
 
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
@@ -96,6 +112,8 @@ void pbqp_matrix_set_row_value(pbqp_matrix_t *mat, unsigned row, num value)
 {
 	assert(row < mat->rows);
 
+	mat->kind = PBQP_MATRIX_DENSE;
+
 	unsigned col_len = mat->cols;
 
 	for (unsigned col_index = 0; col_index < col_len; ++col_index) {
@@ -109,6 +127,26 @@ void pbqp_matrix_set(pbqp_matrix_t *mat, unsigned row, unsigned col, num value)
 	assert(row < mat->rows);
 
 	mat->entries[row * mat->cols + col] = value;
+	mat->kind = PBQP_MATRIX_DENSE;
+}
+
+/**
+ * Returns the index of the minimum of a row or column of a structured matrix
+ * or UINT_MAX if all alternatives are virtually deleted in @p flags.  All
+ * entries are zero except the one at @p diag_index for PBQP_MATRIX_DIAG_INF.
+ */
+static unsigned get_structured_min_index(pbqp_matrix_t *matrix,
+                                         unsigned diag_index, vector_t *flags)
+{
+	unsigned len  = flags->len;
+	unsigned skip = matrix->kind == PBQP_MATRIX_DIAG_INF ? diag_index : UINT_MAX;
+
+	for (unsigned index = 0; index < len; ++index) {
+		if (index != skip && flags->entries[index].data != INF_COSTS)
+			return index;
+	}
+
+	return UINT_MAX;
 }
 
 num pbqp_matrix_get_col_min(pbqp_matrix_t *matrix, unsigned col_index, vector_t *flags)
@@ -119,6 +157,9 @@ num pbqp_matrix_get_col_min(pbqp_matrix_t *matrix, unsigned col_index, vector_t
 
 	assert(row_len == flags->len);
 
+	if (matrix->kind != PBQP_MATRIX_DENSE)
+		return get_structured_min_index(matrix, col_index, flags) == UINT_MAX ? INF_COSTS : 0;
+
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		/* Ignore virtual deleted columns. */
 		if (flags->entries[row_index].data == INF_COSTS) continue;
@@ -142,6 +183,11 @@ unsigned pbqp_matrix_get_col_min_index(pbqp_matrix_t *matrix, unsigned col_index
 
 	assert(row_len == flags->len);
 
+	if (matrix->kind != PBQP_MATRIX_DENSE) {
+		unsigned index = get_structured_min_index(matrix, col_index, flags);
+		return index == UINT_MAX ? 0 : index;
+	}
+
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		/* Ignore virtual deleted columns. */
 		if (flags->entries[row_index].data == INF_COSTS) continue;
@@ -165,6 +211,8 @@ void pbqp_matrix_sub_col_value(pbqp_matrix_t *matrix, unsigned col_index,
 
 	assert(row_len == flags->len);
 
+	matrix->kind = PBQP_MATRIX_DENSE;
+
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		if (flags->entries[row_index].data == INF_COSTS) {
 			matrix->entries[row_index * col_len + col_index] = 0;
@@ -185,6 +233,9 @@ num pbqp_matrix_get_row_min(pbqp_matrix_t *matrix, unsigned row_index, vector_t
 
 	assert(matrix->cols == len);
 
+	if (matrix->kind != PBQP_MATRIX_DENSE)
+		return get_structured_min_index(matrix, row_index, flags) == UINT_MAX ? INF_COSTS : 0;
+
 	for (unsigned col_index = 0; col_index < len; ++col_index) {
 		/* Ignore virtual deleted columns. */
 		if (flags->entries[col_index].data == INF_COSTS) continue;
@@ -207,6 +258,11 @@ unsigned pbqp_matrix_get_row_min_index(pbqp_matrix_t *matrix, unsigned row_index
 
 	assert(matrix->cols == len);
 
+	if (matrix->kind != PBQP_MATRIX_DENSE) {
+		unsigned index = get_structured_min_index(matrix, row_index, flags);
+		return index == UINT_MAX ? 0 : index;
+	}
+
 	for (unsigned col_index = 0; col_index < len; ++col_index) {
 		/* Ignore virtual deleted columns. */
 		if (flags->entries[col_index].data == INF_COSTS) continue;
@@ -229,6 +285,8 @@ void pbqp_matrix_sub_row_value(pbqp_matrix_t *matrix, unsigned row_index,
 
 	assert(col_len == flags->len);
 
+	matrix->kind = PBQP_MATRIX_DENSE;
+
 	for (unsigned col_index = 0; col_index < col_len; ++col_index) {
 		if (flags->entries[col_index].data == INF_COSTS) {
 			matrix->entries[row_index * col_len + col_index] = 0;
@@ -242,6 +300,33 @@ void pbqp_matrix_sub_row_value(pbqp_matrix_t *matrix, unsigned row_index,
 	}
 }
 
+void pbqp_matrix_classify(pbqp_matrix_t *mat)
+{
+	unsigned cols = mat->cols;
+	unsigned rows = mat->rows;
+	bool     zero = true;
+	bool     diag = rows == cols;
+
+	for (unsigned row_index = 0; row_index < rows; ++row_index) {
+		for (unsigned col_index = 0; col_index < cols; ++col_index) {
+			num elem = mat->entries[row_index * cols + col_index];
+
+			if (elem != 0)
+				zero = false;
+			if (elem != (row_index == col_index ? INF_COSTS : 0))
+				diag = false;
+		}
+	}
+
+	if (zero) {
+		mat->kind = PBQP_MATRIX_ZERO;
+	} else if (diag) {
+		mat->kind = PBQP_MATRIX_DIAG_INF;
+	} else {
+		mat->kind = PBQP_MATRIX_DENSE;
+	}
+}
+
 int pbqp_matrix_is_zero(pbqp_matrix_t *mat, vector_t *src_vec, vector_t *tgt_vec)
 {
 	unsigned col_len = mat->cols;
@@ -250,6 +335,9 @@ int pbqp_matrix_is_zero(pbqp_matrix_t *mat, vector_t *src_vec, vector_t *tgt_vec
 	assert(col_len == tgt_vec->len);
 	assert(row_len == src_vec->len);
 
+	if (mat->kind == PBQP_MATRIX_ZERO)
+		return 1;
+
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		if (src_vec->entries[row_index].data == INF_COSTS)
 			continue;
@@ -274,6 +362,8 @@ void pbqp_matrix_add_to_all_cols(pbqp_matrix_t *mat, vector_t *vec)
 
 	assert(row_len == vec->len);
 
+	mat->kind = PBQP_MATRIX_DENSE;
+
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		num value = vec->entries[row_index].data;
 
@@ -290,6 +380,8 @@ void pbqp_matrix_add_to_all_rows(pbqp_matrix_t *mat, vector_t *vec)
 
 	assert(col_len == vec->len);
 
+	mat->kind = PBQP_MATRIX_DENSE;
+
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
 			num value = vec->entries[col_index].data;
@@ -42,6 +42,9 @@ void pbqp_matrix_sub_col_value(pbqp_matrix_t *matrix, unsigned col_index,
 void pbqp_matrix_sub_row_value(pbqp_matrix_t *matrix, unsigned row_index,
                                vector_t *flags, num value);
 
+/* Determine the structure of the matrix from its entries. */
+void pbqp_matrix_classify(pbqp_matrix_t *mat);
+
 int pbqp_matrix_is_zero(pbqp_matrix_t *mat, vector_t *src_vec, vector_t *tgt_vec);
 
 void pbqp_matrix_add_to_all_cols(pbqp_matrix_t *mat, vector_t *vec);
@@ -16,9 +16,20 @@
 
 typedef struct pbqp_matrix_t pbqp_matrix_t;
 
+/**
+ * Known structure of a matrix, used to shortcut the reductions.  Writing an
+ * entry makes a matrix dense again.
+ */
+typedef enum pbqp_matrix_kind_t {
+	PBQP_MATRIX_DENSE,    /**< no known structure */
+	PBQP_MATRIX_ZERO,     /**< all entries are zero */
+	PBQP_MATRIX_DIAG_INF, /**< square, infinite diagonal, zero otherwise */
+} pbqp_matrix_kind_t;
+
 struct pbqp_matrix_t {
-	unsigned rows;
-	unsigned cols;
+	unsigned           rows;
+	unsigned           cols;
+	pbqp_matrix_kind_t kind;
 	num entries[];
 };
 
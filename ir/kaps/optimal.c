@@ -24,6 +24,7 @@
 #include "vector.h"
 #include <assert.h>
 #include <stdbool.h>
+#include <string.h>
 
 #if KAPS_DUMP
 #include "html_dumper.h"
@@ -97,12 +98,13 @@ void fill_node_buckets(pbqp_t *pbqp)
 
 		degree = pbqp_node_get_degree(node);
 
-		/* We have only one bucket for nodes with arity >= 3. */
-		if (degree > 3) {
-			degree = 3;
+		/* We have only one bucket for nodes with arity >= 3, it is a heap
+		 * to find the node with maximum degree quickly. */
+		if (degree >= 3) {
+			node_bucket_heap_insert(&node_buckets[3], node);
+		} else {
+			node_bucket_insert(&node_buckets[degree], node);
 		}
-
-		node_bucket_insert(&node_buckets[degree], node);
 	}
 
 	buckets_filled = 1;
@@ -522,12 +524,18 @@ void reorder_node_after_edge_deletion(pbqp_node_t *node)
 	if (!buckets_filled)
 		return;
 
-	/* Same bucket as before */
-	if (degree > 2)
+	/* Same bucket as before, restore the heap order. */
+	if (degree > 2) {
+		node_bucket_heap_update(node_buckets[3], node);
 		return;
+	}
 
 	/* Delete node from old bucket... */
-	node_bucket_remove(&node_buckets[old_degree], node);
+	if (old_degree == 3) {
+		node_bucket_heap_remove(&node_buckets[3], node);
+	} else {
+		node_bucket_remove(&node_buckets[old_degree], node);
+	}
 
 	/* ..and add to new one. */
 	node_bucket_insert(&node_buckets[degree], node);
@@ -542,15 +550,21 @@ void reorder_node_after_edge_insertion(pbqp_node_t *node)
 	if (!buckets_filled)
 		return;
 
-	/* Same bucket as before */
-	if (old_degree > 2)
+	/* Same bucket as before, restore the heap order. */
+	if (old_degree > 2) {
+		node_bucket_heap_update(node_buckets[3], node);
 		return;
+	}
 
 	/* Delete node from old bucket... */
 	node_bucket_remove(&node_buckets[old_degree], node);
 
 	/* ..and add to new one. */
-	node_bucket_insert(&node_buckets[degree], node);
+	if (degree == 3) {
+		node_bucket_heap_insert(&node_buckets[3], node);
+	} else {
+		node_bucket_insert(&node_buckets[degree], node);
+	}
 }
 
 void simplify_edge(pbqp_t *pbqp, pbqp_edge_t *edge)
@@ -965,29 +979,49 @@ void apply_RII(pbqp_t *pbqp)
 	unsigned       col_len  = tgt_vec->len;
 	unsigned       row_len  = src_vec->len;
 	pbqp_matrix_t *mat      = pbqp_matrix_alloc(pbqp, row_len, col_len);
+	vector_t      *vec      = vector_copy(pbqp, node_vec);
 
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
-		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
-			vector_t *vec = vector_copy(pbqp, node_vec);
+		/* The costs depending on the source alternative are the same for
+		 * all target alternatives. */
+		memcpy(vec->entries, node_vec->entries, sizeof(*vec->entries) * vec->len);
 
-			if (src_is_src) {
-				vector_add_matrix_col(vec, src_mat, row_index);
-			} else {
-				vector_add_matrix_row(vec, src_mat, row_index);
+		if (src_is_src) {
+			vector_add_matrix_col(vec, src_mat, row_index);
+		} else {
+			vector_add_matrix_row(vec, src_mat, row_index);
+		}
+
+		if (tgt_mat->kind == PBQP_MATRIX_DIAG_INF) {
+			/* Each target alternative forbids only the same alternative of
+			 * the reduced node, so the minimum of the other ones is either
+			 * the overall minimum or the second smallest entry. */
+			num      min;
+			num      second;
+			unsigned min_index;
+			vector_get_min_and_second(vec, &min, &min_index, &second);
+
+			for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+				mat->entries[row_index * col_len + col_index] = col_index == min_index ? second : min;
 			}
+			continue;
+		}
+
+		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+			num min;
 
 			if (tgt_is_src) {
-				vector_add_matrix_col(vec, tgt_mat, col_index);
+				min = vector_get_min_plus_matrix_col(vec, tgt_mat, col_index);
 			} else {
-				vector_add_matrix_row(vec, tgt_mat, col_index);
+				min = vector_get_min_plus_matrix_row(vec, tgt_mat, col_index);
 			}
 
-			mat->entries[row_index * col_len + col_index] = vector_get_min(vec);
-
-			obstack_free(&pbqp->obstack, vec);
+			mat->entries[row_index * col_len + col_index] = min;
 		}
 	}
 
+	obstack_free(&pbqp->obstack, vec);
+
 	pbqp_edge_t *edge = get_edge(pbqp, src_node->index, tgt_node->index);
 
 	/* Disconnect node. */
@@ -1131,26 +1165,19 @@ void select_alternative(pbqp_node_t *node, unsigned selected_index)
 
 pbqp_node_t *get_node_with_max_degree(void)
 {
-	pbqp_node_t **bucket     = node_buckets[3];
-	unsigned      bucket_len = node_bucket_get_length(bucket);
-	unsigned      max_degree = 0;
-	pbqp_node_t  *result     = NULL;
-
-	for (unsigned bucket_index = 0; bucket_index < bucket_len; ++bucket_index) {
-		pbqp_node_t *candidate = bucket[bucket_index];
-		unsigned     degree    = pbqp_node_get_degree(candidate);
-
-		if (degree > max_degree) {
-			result = candidate;
-			max_degree = degree;
-		}
-	}
+	pbqp_node_t **bucket = node_buckets[3];
+
+	/* The bucket is a max-heap ordered by degree. */
+	if (node_bucket_get_length(bucket) == 0)
+		return NULL;
 
-	return result;
+	return bucket[0];
 }
 
 unsigned get_local_minimal_alternative(pbqp_t *pbqp, pbqp_node_t *node)
 {
+	(void)pbqp;
+
 	vector_t *node_vec   = node->costs;
 	unsigned  node_len   = node_vec->len;
 	unsigned  max_degree = pbqp_node_get_degree(node);
@@ -1164,19 +1191,15 @@ unsigned get_local_minimal_alternative(pbqp_t *pbqp, pbqp_node_t *node)
 			pbqp_edge_t   *edge   = node->edges[edge_index];
 			pbqp_matrix_t *mat    = edge->costs;
 			bool           is_src = edge->src == node;
-			vector_t      *vec;
+			num            min;
 
 			if (is_src) {
-				vec = vector_copy(pbqp, edge->tgt->costs);
-				vector_add_matrix_row(vec, mat, node_index);
+				min = vector_get_min_plus_matrix_row(edge->tgt->costs, mat, node_index);
 			} else {
-				vec = vector_copy(pbqp, edge->src->costs);
-				vector_add_matrix_col(vec, mat, node_index);
+				min = vector_get_min_plus_matrix_col(edge->src->costs, mat, node_index);
 			}
 
-			value = pbqp_add(value, vector_get_min(vec));
-
-			obstack_free(&pbqp->obstack, vec);
+			value = pbqp_add(value, min);
 		}
 
 		if (value < min) {
@@ -27,6 +27,7 @@ pbqp_node_t *alloc_node(pbqp_t *pbqp, unsigned node_index, vector_t *costs)
 	node->edges = NEW_ARR_F(pbqp_edge_t *, 0);
 	node->costs = vector_copy(pbqp, costs);
 	node->bucket_index = UINT_MAX;
+	node->heap_degree = 0;
 	node->solution = UINT_MAX;
 	node->index = node_index;
 
@@ -132,6 +133,7 @@ pbqp_node_t *pbqp_node_deep_copy(pbqp_t *pbqp, pbqp_node_bucket_t new_bucket,
 
 	copy->costs        = vector_copy(pbqp, node->costs);
 	copy->bucket_index = node->bucket_index;
+	copy->heap_degree  = node->heap_degree;
 	copy->solution     = node->solution;
 	copy->index        = node->index;
 
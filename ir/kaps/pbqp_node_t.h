@@ -18,6 +18,7 @@ struct pbqp_node_t {
 	pbqp_edge_t **edges;
 	vector_t     *costs;
 	unsigned      bucket_index;
+	unsigned      heap_degree; /**< degree the node is ordered by in a heap */
 	unsigned      solution;
 	unsigned      index;
 };
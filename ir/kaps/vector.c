@@ -98,6 +98,9 @@ void vector_add_matrix_col(vector_t *vec, pbqp_matrix_t *mat, unsigned col_index
 	assert(len == mat->rows);
 	assert(col_index < mat->cols);
 
+	if (mat->kind == PBQP_MATRIX_ZERO)
+		return;
+
 	for (unsigned index = 0; index < len; ++index) {
 		vec->entries[index].data = pbqp_add(vec->entries[index].data, mat->entries[index * mat->cols + col_index]);
 	}
@@ -110,6 +113,8 @@ void vector_add_matrix_row(vector_t *vec, pbqp_matrix_t *mat, unsigned row_index
 	assert(len == mat->cols);
 	assert(row_index < mat->rows);
 
+	if (mat->kind == PBQP_MATRIX_ZERO)
+		return;
 
 	for (unsigned index = 0; index < len; ++index) {
 		vec->entries[index].data = pbqp_add(vec->entries[index].data, mat->entries[row_index * mat->cols + index]);
@@ -153,3 +158,100 @@ unsigned vector_get_min_index(vector_t *vec)
 
 	return min_index;
 }
+
+void vector_get_min_and_second(vector_t *vec, num *min, unsigned *min_index,
+                               num *second)
+{
+	unsigned len   = vec->len;
+	unsigned index = 0;
+	num      first = INF_COSTS;
+	num      other = INF_COSTS;
+
+	for (unsigned i = 0; i < len; ++i) {
+		num elem = vec->entries[i].data;
+
+		if (elem < first) {
+			other = first;
+			first = elem;
+			index = i;
+		} else if (elem < other) {
+			other = elem;
+		}
+	}
+
+	*min       = first;
+	*min_index = index;
+	*second    = other;
+}
+
+/**
+ * Returns the smallest entry of @p vec, skipping the entry at @p skip.
+ */
+static num get_min_except(vector_t *vec, unsigned skip)
+{
+	unsigned len = vec->len;
+	num      min = INF_COSTS;
+
+	for (unsigned index = 0; index < len; ++index) {
+		num elem = vec->entries[index].data;
+
+		if (index != skip && elem < min)
+			min = elem;
+	}
+
+	return min;
+}
+
+/**
+ * Returns min_i(vec[i] + entries[i * stride]).  Infinite costs are the
+ * largest values, so the minimum only has to saturate the sum.
+ */
+static num get_min_plus_strided(vector_t *vec, num const *entries,
+                                unsigned stride)
+{
+	unsigned len = vec->len;
+	num      min = INF_COSTS;
+
+	for (unsigned index = 0; index < len; ++index) {
+		num x   = vec->entries[index].data;
+		num y   = entries[index * stride];
+		num sum = x == INF_COSTS || y == INF_COSTS ? INF_COSTS : x + y;
+
+		if (sum < min)
+			min = sum;
+	}
+
+	return min;
+}
+
+num vector_get_min_plus_matrix_col(vector_t *vec, pbqp_matrix_t *mat, unsigned col_index)
+{
+	assert(vec->len == mat->rows);
+	assert(col_index < mat->cols);
+
+	switch (mat->kind) {
+	case PBQP_MATRIX_ZERO:
+		return vector_get_min(vec);
+	case PBQP_MATRIX_DIAG_INF:
+		return get_min_except(vec, col_index);
+	case PBQP_MATRIX_DENSE:
+		break;
+	}
+	return get_min_plus_strided(vec, &mat->entries[col_index], mat->cols);
+}
+
+num vector_get_min_plus_matrix_row(vector_t *vec, pbqp_matrix_t *mat, unsigned row_index)
+{
+	assert(vec->len == mat->cols);
+	assert(row_index < mat->rows);
+
+	switch (mat->kind) {
+	case PBQP_MATRIX_ZERO:
+		return vector_get_min(vec);
+	case PBQP_MATRIX_DIAG_INF:
+		return get_min_except(vec, row_index);
+	case PBQP_MATRIX_DENSE:
+		break;
+	}
+	return get_min_plus_strided(vec, &mat->entries[row_index * mat->cols], 1);
+}
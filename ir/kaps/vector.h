@@ -38,4 +38,12 @@ void vector_add_matrix_row(vector_t *vec, pbqp_matrix_t *mat, unsigned row_index
 num vector_get_min(vector_t *vec);
 unsigned vector_get_min_index(vector_t *vec);
 
+/* Smallest entry, its index and the smallest entry at another index. */
+void vector_get_min_and_second(vector_t *vec, num *min, unsigned *min_index,
+                               num *second);
+
+/* min(vec + column/row of mat) without materializing the sum. */
+num vector_get_min_plus_matrix_col(vector_t *vec, pbqp_matrix_t *mat, unsigned col_index);
+num vector_get_min_plus_matrix_row(vector_t *vec, pbqp_matrix_t *mat, unsigned row_index);
+
 #endif
@@ -13,6 +13,7 @@
 #include "adt/pmap.h"
 #include "deq.h"
 #include "ircons_t.h"
+#include "iredges_t.h"
 #include "irgmod.h"
 #include "irgwalk.h"
 #include "irnode_t.h"
@@ -27,6 +28,11 @@
 static bool dont_lower[ir_bk_last + 1];
 static lower_func lower_va_arg;
 
+typedef struct lower_env_t {
+	bool changed;    /**< graph was modified */
+	bool cf_changed; /**< control flow was modified */
+} lower_env_t;
+
 static const char *get_builtin_name(ir_builtin_kind kind)
 {
 	switch (kind) {
@@ -48,6 +54,15 @@ static const char *get_builtin_name(ir_builtin_kind kind)
 	case ir_bk_may_alias:
 	case ir_bk_va_start:
 	case ir_bk_va_arg:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
+	case ir_bk_atomic_fence:
 		break;
 	}
 	abort();
@@ -158,9 +173,141 @@ static void replace_may_alias(ir_node *node)
 	turn_into_tuple(node, ARRAY_SIZE(in), in);
 }
 
-static void lower_builtin(ir_node *node, void *env)
+static ir_node *create_atomic_op(ir_builtin_kind kind, dbg_info *dbgi,
+                                  ir_node *block, ir_node *old, ir_node *value)
+{
+	switch (kind) {
+	case ir_bk_atomic_fetch_add: return new_rd_Add(dbgi, block, old, value);
+	case ir_bk_atomic_fetch_sub: return new_rd_Sub(dbgi, block, old, value);
+	case ir_bk_atomic_fetch_and: return new_rd_And(dbgi, block, old, value);
+	case ir_bk_atomic_fetch_or:  return new_rd_Or(dbgi, block, old, value);
+	case ir_bk_atomic_fetch_xor: return new_rd_Eor(dbgi, block, old, value);
+	case ir_bk_atomic_exchange:  return value;
+	default:
+		panic("unexpected atomic builtin %s", get_builtin_kind_name(kind));
+	}
+}
+
+/**
+ * Replaces an atomic read-modify-write builtin by a compare_swap loop:
+ *
+ *   old = load(ptr)
+ * loop:
+ *   prev = compare_swap(ptr, old, op(old, value))
+ *   if (prev != old) { old = prev; goto loop; }
+ */
+static void replace_with_compare_swap_loop(ir_node *node)
+{
+	if (!dont_lower[ir_bk_compare_swap])
+		panic("builtin kind %s needs compare_swap support",
+		      get_builtin_kind_name(get_Builtin_kind(node)));
+
+	ir_builtin_kind const kind     = get_Builtin_kind(node);
+	ir_graph       *const irg      = get_irn_irg(node);
+	dbg_info       *const dbgi     = get_irn_dbg_info(node);
+	ir_node        *const mem      = get_Builtin_mem(node);
+	ir_node        *const ptr      = get_Builtin_param(node, 0);
+	ir_node        *const value    = get_Builtin_param(node, 1);
+	ir_mode        *const mode     = get_irn_mode(value);
+	ir_type        *const mtp      = get_Builtin_type(node);
+	ir_type        *const ptr_type = get_method_param_type(mtp, 0);
+	ir_type        *const val_type = get_method_param_type(mtp, 1);
+	/* Cmp on floats would never terminate for NaNs. */
+	assert(!mode_is_float(mode));
+
+	ir_node *const lower_block = part_block_edges(node);
+	ir_node *const upper_block = get_nodes_block(node);
+	ir_node *const load        = new_rd_Load(dbgi, upper_block, mem, ptr, mode,
+	                                         val_type, cons_volatile);
+	ir_node *const load_mem    = new_r_Proj(load, mode_M, pn_Load_M);
+	ir_node *const load_res    = new_r_Proj(load, mode, pn_Load_res);
+	ir_node *const jmp         = new_r_Jmp(upper_block);
+
+	/* Dummies for the back edge, they are replaced once the loop exists. */
+	ir_node *const dummy_x    = new_r_Dummy(irg, mode_X);
+	ir_node *const loop_in[]  = { jmp, dummy_x };
+	ir_node *const loop_block = new_r_Block(irg, ARRAY_SIZE(loop_in), loop_in);
+	ir_node       *mem_in[]   = { load_mem, new_r_Dummy(irg, mode_M) };
+	ir_node *const phi_mem    = new_r_Phi_loop(loop_block, ARRAY_SIZE(mem_in), mem_in);
+	ir_node *const old_in[]   = { load_res, new_r_Dummy(irg, mode) };
+	ir_node *const phi_old    = new_r_Phi(loop_block, ARRAY_SIZE(old_in), old_in, mode);
+	ir_node *const new_value  = create_atomic_op(kind, dbgi, loop_block, phi_old, value);
+
+	ir_type *const cas_type = new_type_method(3, 1, false, cc_cdecl_set, mtp_no_property);
+	set_method_param_type(cas_type, 0, ptr_type);
+	set_method_param_type(cas_type, 1, val_type);
+	set_method_param_type(cas_type, 2, val_type);
+	set_method_res_type(cas_type, 0, val_type);
+	ir_node *const cas_in[] = { ptr, phi_old, new_value };
+	ir_node *const cas      = new_rd_Builtin(dbgi, loop_block, phi_mem, ARRAY_SIZE(cas_in), cas_in, ir_bk_compare_swap, cas_type);
+	set_Builtin_order(cas, get_Builtin_order(node));
+	ir_node *const cas_mem  = new_r_Proj(cas, mode_M, pn_Builtin_M);
+	ir_node *const cas_res  = new_r_Proj(cas, mode, pn_Builtin_max + 1);
+
+	ir_node *const cmp        = new_rd_Cmp(dbgi, loop_block, cas_res, phi_old, ir_relation_equal);
+	ir_node *const cond       = new_rd_Cond(dbgi, loop_block, cmp);
+	ir_node *const proj_true  = new_r_Proj(cond, mode_X, pn_Cond_true);
+	ir_node *const proj_false = new_r_Proj(cond, mode_X, pn_Cond_false);
+	set_Block_cfgpred(loop_block, 1, proj_false);
+	set_Phi_pred(phi_mem, 1, cas_mem);
+	set_Phi_pred(phi_old, 1, cas_res);
+
+	ir_node *const lower_in[] = { proj_true };
+	set_irn_in(lower_block, ARRAY_SIZE(lower_in), lower_in);
+
+	/* Results live in the loop, so resolve the Projs right away instead of
+	 * leaving them behind in the upper block. */
+	ir_node *const in[] = {
+		[pn_Builtin_M]       = cas_mem,
+		[pn_Builtin_max + 1] = phi_old,
+	};
+	turn_into_tuple(node, ARRAY_SIZE(in), in);
+	foreach_out_edge_safe(node, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (is_Proj(proj))
+			exchange(proj, in[get_Proj_num(proj)]);
+	}
+}
+
+/**
+ * Replaces a relaxed atomic load or store by a volatile Load or Store.
+ */
+static void replace_with_volatile_memop(ir_node *node)
 {
-	bool *changed = (bool*)env;
+	ir_builtin_kind const kind = get_Builtin_kind(node);
+	if (get_Builtin_order(node) != ir_memory_order_relaxed)
+		panic("builtin kind %s with %s not supported (for this target)",
+		      get_builtin_kind_name(kind),
+		      get_memory_order_name(get_Builtin_order(node)));
+
+	dbg_info *const dbgi     = get_irn_dbg_info(node);
+	ir_node  *const block    = get_nodes_block(node);
+	ir_node  *const mem      = get_Builtin_mem(node);
+	ir_node  *const ptr      = get_Builtin_param(node, 0);
+	ir_type  *const mtp      = get_Builtin_type(node);
+	if (kind == ir_bk_atomic_load) {
+		ir_type *const type = get_method_res_type(mtp, 0);
+		ir_mode *const mode = get_type_mode(type);
+		ir_node *const load = new_rd_Load(dbgi, block, mem, ptr, mode, type,
+		                                  cons_volatile);
+		ir_node *const in[] = {
+			[pn_Builtin_M]       = new_r_Proj(load, mode_M, pn_Load_M),
+			[pn_Builtin_max + 1] = new_r_Proj(load, mode, pn_Load_res),
+		};
+		turn_into_tuple(node, ARRAY_SIZE(in), in);
+	} else {
+		ir_node *const value = get_Builtin_param(node, 1);
+		ir_type *const type  = get_method_param_type(mtp, 1);
+		ir_node *const store = new_rd_Store(dbgi, block, mem, ptr, value, type,
+		                                    cons_volatile);
+		ir_node *const in[]  = { new_r_Proj(store, mode_M, pn_Store_M) };
+		turn_into_tuple(node, ARRAY_SIZE(in), in);
+	}
+}
+
+static void lower_builtin(ir_node *node, void *ctx)
+{
+	lower_env_t *env = (lower_env_t*)ctx;
 	if (!is_Builtin(node))
 		return;
 
@@ -177,6 +324,30 @@ static void lower_builtin(ir_node *node, void *env)
 		goto changed;
 	}
 
+	case ir_bk_atomic_fence: {
+		/* a relaxed fence does not order anything */
+		if (get_Builtin_order(node) != ir_memory_order_relaxed)
+			break;
+		ir_node *const in[] = { get_Builtin_mem(node) };
+		turn_into_tuple(node, ARRAY_SIZE(in), in);
+		goto changed;
+	}
+
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store:
+		replace_with_volatile_memop(node);
+		goto changed;
+
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_exchange:
+		replace_with_compare_swap_loop(node);
+		env->cf_changed = true;
+		goto changed;
+
 	case ir_bk_ffs:
 	case ir_bk_clz:
 	case ir_bk_ctz:
@@ -190,7 +361,7 @@ static void lower_builtin(ir_node *node, void *env)
 	case ir_bk_may_alias:
 		replace_may_alias(node);
 changed:
-		*changed = true;
+		env->changed = true;
 		return;
 
 	case ir_bk_va_arg:
@@ -206,11 +377,11 @@ changed:
 	case ir_bk_saturating_increment:
 	case ir_bk_compare_swap:
 	case ir_bk_va_start:
-		/* can't do anything about these, backend will probably fail now */
-		panic("builtin kind %s not supported (for this target)",
-		      get_builtin_kind_name(kind));
+		break;
 	}
-	panic("unexpected builtin %+F", node);
+	/* can't do anything about these, backend will probably fail now */
+	panic("builtin kind %s not supported (for this target)",
+	      get_builtin_kind_name(kind));
 }
 
 static void collect_builtin(ir_node *node, void *env)
@@ -250,10 +421,177 @@ void lower_builtins(size_t n_exceptions,
 	}
 
 	foreach_irp_irg(i, irg) {
-		bool changed = false;
+		lower_env_t env = { .changed = false, .cf_changed = false };
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
+		irg_walk_builtin_nodes_post(irg, lower_builtin, &env);
+		confirm_irg_properties(irg,
+			env.cf_changed ? IR_GRAPH_PROPERTIES_NONE :
+			env.changed    ? IR_GRAPH_PROPERTIES_CONTROL_FLOW :
+			                 IR_GRAPH_PROPERTIES_ALL);
+	}
+}
+
+static bool     lower_with_result[ir_bk_last + 1];
+static unsigned max_atomic_bits;
+
+static void lower_rmw_result(ir_node *node, void *ctx)
+{
+	lower_env_t *env = (lower_env_t*)ctx;
+	if (!is_Builtin(node) || !lower_with_result[get_Builtin_kind(node)])
+		return;
+
+	ir_node *const res = get_Proj_for_pn(node, pn_Builtin_max + 1);
+	if (res == NULL || get_irn_n_edges(res) == 0)
+		return;
+
+	replace_with_compare_swap_loop(node);
+	env->changed    = true;
+	env->cf_changed = true;
+}
+
+void lower_atomic_rmw_results(size_t n_kinds, ir_builtin_kind const *kinds,
+                              bool have_compare_swap)
+{
+	memset(lower_with_result, 0, sizeof(lower_with_result));
+	for (size_t i = 0; i < n_kinds; ++i) {
+		lower_with_result[kinds[i]] = true;
+	}
+	memset(dont_lower, 0, sizeof(dont_lower));
+	dont_lower[ir_bk_compare_swap] = have_compare_swap;
+
+	foreach_irp_irg(i, irg) {
+		lower_env_t env = { .changed = false, .cf_changed = false };
 		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
-		irg_walk_builtin_nodes_post(irg, lower_builtin, &changed);
-		confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_CONTROL_FLOW
-		                                    : IR_GRAPH_PROPERTIES_ALL);
+		irg_walk_builtin_nodes_post(irg, lower_rmw_result, &env);
+		confirm_irg_properties(irg, env.changed ? IR_GRAPH_PROPERTIES_NONE
+		                                        : IR_GRAPH_PROPERTIES_ALL);
+	}
+}
+
+/** Returns the C11 memory order constant libatomic expects for @p order. */
+static int get_c11_memory_order(ir_memory_order const order)
+{
+	switch (order) {
+	case ir_memory_order_relaxed: return 0;
+	case ir_memory_order_acquire: return 2;
+	case ir_memory_order_release: return 3;
+	case ir_memory_order_acq_rel: return 4;
+	case ir_memory_order_seq_cst: return 5;
+	}
+	panic("invalid memory order");
+}
+
+/** Returns the name of the libatomic function implementing @p kind. */
+static char const *get_libatomic_name(ir_builtin_kind const kind)
+{
+	switch (kind) {
+	case ir_bk_atomic_fetch_add: return "fetch_add";
+	case ir_bk_atomic_fetch_sub: return "fetch_sub";
+	case ir_bk_atomic_fetch_and: return "fetch_and";
+	case ir_bk_atomic_fetch_or:  return "fetch_or";
+	case ir_bk_atomic_fetch_xor: return "fetch_xor";
+	case ir_bk_atomic_exchange:  return "exchange";
+	case ir_bk_atomic_load:      return "load";
+	case ir_bk_atomic_store:     return "store";
+	case ir_bk_atomic_fence:     return "thread_fence";
+	default:                     return NULL;
+	}
+}
+
+/**
+ * Replaces an atomic builtin by a call of the corresponding libatomic
+ * function __atomic_<name>_<size> (or __atomic_thread_fence), which takes
+ * the memory order as additional last argument.
+ */
+static void replace_with_libatomic_call(ir_node *node, ir_type *const val_type)
+{
+	ir_builtin_kind const kind     = get_Builtin_kind(node);
+	ir_type        *const mtp      = get_Builtin_type(node);
+	ir_graph       *const irg      = get_irn_irg(node);
+	int             const n_in     = get_Builtin_n_params(node);
+	bool            const has_res  = get_method_n_ress(mtp) > 0;
+	int             const c11      = get_c11_memory_order(get_Builtin_order(node));
+
+	ir_node *params[3];
+	ir_type *types[3];
+	assert(n_in < (int)ARRAY_SIZE(params));
+	for (int i = 0; i < n_in; ++i) {
+		params[i] = get_Builtin_param(node, i);
+		types[i]  = get_method_param_type(mtp, i);
+	}
+	params[n_in] = new_r_Const_long(irg, mode_Is, c11);
+	types[n_in]  = get_type_for_mode(mode_Is);
+
+	int      const n_params  = n_in + 1;
+	ir_type *const call_type = new_type_method(n_params, has_res, false,
+	                                           cc_cdecl_set, mtp_no_property);
+	for (int i = 0; i < n_params; ++i)
+		set_method_param_type(call_type, i, types[i]);
+	if (has_res)
+		set_method_res_type(call_type, 0, val_type);
+
+	char const *const name = get_libatomic_name(kind);
+	ident      *const id   = val_type == NULL
+		? new_id_fmt("__atomic_%s", name)
+		: new_id_fmt("__atomic_%s_%u", name, get_type_size(val_type));
+	ir_entity  *const entity = create_compilerlib_entity(get_id_str(id),
+	                                                     call_type);
+
+	dbg_info *const dbgi     = get_irn_dbg_info(node);
+	ir_node  *const block    = get_nodes_block(node);
+	ir_node  *const callee   = new_r_Address(irg, entity);
+	ir_node  *const call     = new_rd_Call(dbgi, block, get_Builtin_mem(node),
+	                                       callee, n_params, params, call_type);
+	ir_node  *const call_mem = new_r_Proj(call, mode_M, pn_Call_M);
+	if (has_res) {
+		ir_mode *const mode      = get_type_mode(val_type);
+		ir_node *const call_ress = new_r_Proj(call, mode_T, pn_Call_T_result);
+		ir_node *const in[]      = {
+			[pn_Builtin_M]       = call_mem,
+			[pn_Builtin_max + 1] = new_r_Proj(call_ress, mode, 0),
+		};
+		turn_into_tuple(node, ARRAY_SIZE(in), in);
+	} else {
+		ir_node *const in[] = { [pn_Builtin_M] = call_mem };
+		turn_into_tuple(node, ARRAY_SIZE(in), in);
+	}
+}
+
+static void lower_wide_atomic(ir_node *node, void *ctx)
+{
+	lower_env_t *env = (lower_env_t*)ctx;
+	if (!is_Builtin(node))
+		return;
+	ir_builtin_kind const kind = get_Builtin_kind(node);
+	if (get_libatomic_name(kind) == NULL)
+		return;
+
+	ir_type *const mtp = get_Builtin_type(node);
+	ir_type       *val_type;
+	if (kind == ir_bk_atomic_fence) {
+		/* relaxed fences are dropped by lower_builtins() */
+		if (max_atomic_bits > 0
+		    || get_Builtin_order(node) == ir_memory_order_relaxed)
+			return;
+		val_type = NULL;
+	} else {
+		val_type = kind == ir_bk_atomic_load ? get_method_res_type(mtp, 0)
+		                                     : get_method_param_type(mtp, 1);
+		if (get_mode_size_bits(get_type_mode(val_type)) <= max_atomic_bits)
+			return;
+	}
+
+	replace_with_libatomic_call(node, val_type);
+	env->changed = true;
+}
+
+void lower_wide_atomics(unsigned max_bits)
+{
+	max_atomic_bits = max_bits;
+	foreach_irp_irg(i, irg) {
+		lower_env_t env = { .changed = false, .cf_changed = false };
+		irg_walk_graph(irg, NULL, lower_wide_atomic, &env);
+		confirm_irg_properties(irg, env.changed ? IR_GRAPH_PROPERTIES_CONTROL_FLOW
+		                                        : IR_GRAPH_PROPERTIES_ALL);
 	}
 }
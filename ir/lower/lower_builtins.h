@@ -12,11 +12,36 @@
 #define FIRM_LOWER_BUILTINS_H
 
 #include "firm_types.h"
+#include <stdbool.h>
 #include <stddef.h>
 
 typedef void(*lower_func)(ir_node*);
 
+/**
+ * Lowers all builtins except the kinds listed in @p exceptions.
+ *
+ * Atomic read-modify-write builtins are replaced by compare_swap loops,
+ * relaxed atomic loads/stores by volatile Loads/Stores.
+ */
 void lower_builtins(size_t n_exceptions, ir_builtin_kind const *exceptions,
                     lower_func lower_va_arg);
 
+/**
+ * Replaces atomic read-modify-write builtins of the given kinds by
+ * compare_swap loops if their previous memory value is used.  This is for
+ * targets which can perform the operation atomically only without returning
+ * the old value (like "lock or" on x86).  Must run before lower_builtins().
+ */
+void lower_atomic_rmw_results(size_t n_kinds, ir_builtin_kind const *kinds,
+                              bool have_compare_swap);
+
+/**
+ * Replaces atomic read-modify-write, load and store builtins on values wider
+ * than @p max_bits by calls of the libatomic functions __atomic_*_N.  This is
+ * for targets which cannot access such values atomically in registers.  With
+ * @p max_bits 0 fences become calls of __atomic_thread_fence, too.  Must run
+ * before lower_atomic_rmw_results().
+ */
+void lower_wide_atomics(unsigned max_bits);
+
 #endif
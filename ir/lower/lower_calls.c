@@ -789,7 +789,10 @@ static void fix_int_return(cl_entry const *const entry,
 
 		while (spec_size > 0 && type_size > 0) {
 			ir_mode *mode = NULL;
-			if (type_size >= 8) {
+			if (type_size >= 8
+			 || (mode_is_float(spec_mode) && shift_offset == 0
+			  && spec_size <= type_size)) {
+				/* A float value which fits is stored as it is. */
 				mode = spec_mode;
 			} else if (type_size >= 4) {
 				mode = mode_Iu;
@@ -800,7 +803,7 @@ static void fix_int_return(cl_entry const *const entry,
 			}
 
 			// The value was classified as SSE, so we need a Lu bitcast before conv to the target mode
-			if (type_size < 8 && mode_is_float(spec_mode)) {
+			if (mode != spec_mode && type_size < 8 && mode_is_float(spec_mode)) {
 				value = new_r_Bitcast(block, value, mode_Lu);
 			}
 
@@ -2238,6 +2238,24 @@ static void lower_Builtin(ir_node *const builtin)
 {
 	ir_builtin_kind kind = get_Builtin_kind(builtin);
 	switch (kind) {
+	case ir_bk_atomic_exchange:
+	case ir_bk_atomic_fetch_add:
+	case ir_bk_atomic_fetch_and:
+	case ir_bk_atomic_fetch_or:
+	case ir_bk_atomic_fetch_sub:
+	case ir_bk_atomic_fetch_xor:
+	case ir_bk_atomic_load:
+	case ir_bk_atomic_store: {
+		/* double word atomics are not atomic when split, they have to be
+		 * replaced by library calls with lower_wide_atomics() before */
+		ir_type *const mtp = get_Builtin_type(builtin);
+		ir_type *const tp  = kind == ir_bk_atomic_load
+			? get_method_res_type(mtp, 0) : get_method_param_type(mtp, 1);
+		if (type_needs_lowering(tp))
+			panic("double word %+F not supported", builtin);
+		return;
+	}
+	case ir_bk_atomic_fence:
 	case ir_bk_compare_swap:
 	case ir_bk_debugbreak:
 	case ir_bk_frame_address:
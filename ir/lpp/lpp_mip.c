@@ -0,0 +1,1001 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   In-tree mixed integer solver for lpp problems.
+ *
+ * The LP relaxations are solved with a bounded dual simplex working on the
+ * column-major copy of the lpp matrix.  The basis inverse is kept in product
+ * form (a file of eta columns) and rebuilt from scratch every MIP_REFACTOR
+ * pivots.  Integrality of the binary variables is enforced by a depth-first
+ * branch and bound which warm starts every node from the optimal basis of
+ * its predecessor: changing variable bounds keeps the basis dual feasible,
+ * so the dual simplex only has to repair primal feasibility.
+ *
+ * Every row i is turned into an equation A_i x + s_i = b_i with a slack
+ * variable s_i whose bounds encode the constraint type.  Maximization
+ * problems are solved as minimization of the negated objective.
+ *
+ * Continuous variables, whose cost asks to increase them, get an artificial
+ * upper bound, so the slack basis is dual feasible.  Artificial bounds which
+ * end up binding are raised until they do not, or until a ray proves the LP
+ * unbounded.  The bounds used for pruning are computed by weak duality from
+ * the original costs, so neither artificial bounds nor the cost shifts and
+ * perturbations of the simplex can make them invalid.
+ */
+#include "lpp_mip.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sp_matrix.h"
+#include "timing.h"
+#include "util.h"
+#include "xmalloc.h"
+
+#define MIP_INF          HUGE_VAL
+#define MIP_BIG          1e7  /**< initial artificial bound for continuous variables */
+#define MIP_BIG_GROWTH   16.0 /**< factor to raise a binding artificial bound by */
+#define MIP_TOL_PRIMAL   1e-7 /**< primal feasibility tolerance */
+#define MIP_TOL_DUAL     1e-7 /**< dual feasibility tolerance */
+#define MIP_TOL_PIVOT    1e-9 /**< smallest acceptable pivot element */
+#define MIP_TOL_INT      1e-6 /**< integrality tolerance */
+#define MIP_TOL_DROP     1e-12 /**< eta entries below this are dropped */
+#define MIP_REFACTOR     64   /**< pivots between two refactorizations */
+#define MIP_MAX_DEGEN    50   /**< degenerate pivots before using Bland's rule */
+#define MIP_PERTURB      1e-5 /**< relative cost perturbation of binaries */
+
+typedef enum lp_result_t {
+	LP_OPTIMAL,
+	LP_INFEASIBLE,
+	LP_UNBOUNDED,
+	LP_ABORTED,
+} lp_result_t;
+
+/** An eta column of the product form of the basis inverse. */
+typedef struct eta_t {
+	int    row;   /**< pivot position */
+	int    start; /**< first off-pivot entry in the entry pool */
+	int    n;     /**< number of off-pivot entries */
+	double pivot; /**< the pivot element */
+} eta_t;
+
+/** A bound change recorded on the branch and bound trail. */
+typedef struct trail_t {
+	int    var;
+	double lower;
+	double upper;
+} trail_t;
+
+/** An open branch and bound node. */
+typedef struct mip_node_t {
+	int    var;   /**< the variable fixed by this node, -1 for the root */
+	double value; /**< the value var is fixed to */
+	int    trail; /**< trail height of the parent node */
+	double bound; /**< LP bound of the parent node */
+} mip_node_t;
+
+typedef struct mip_t {
+	lpp_t      *lpp;
+	int         n_rows;    /**< number of constraints */
+	int         n_structs; /**< number of structural variables */
+	int         n_cols;    /**< structural variables followed by slacks */
+
+	/* the constraint matrix, column major, slack columns are implicit */
+	int        *col_start;
+	int        *col_row;
+	double     *col_val;
+	double     *rhs;
+	double     *obj;       /**< objective of the (minimization) problem */
+	double     *cost;      /**< objective including perturbation and shifts */
+	double     *lower;     /**< current lower bounds */
+	double     *upper;     /**< current upper bounds */
+	bool       *is_int;
+
+	/* the basis */
+	int        *head;      /**< variable basic at each row position */
+	int        *pos;       /**< row position of basic variables, else -1 */
+	bool       *at_upper;  /**< nonbasic variable sits at its upper bound */
+	double     *x;         /**< primal values */
+	double     *d;         /**< reduced costs */
+	double     *rho;       /**< dense row sized work vector */
+	double     *col;       /**< dense row sized work vector */
+	double     *alpha;     /**< pivot row, indexed by variable */
+
+	/* product form of the basis inverse */
+	eta_t      *etas;
+	int         n_etas;
+	int         n_factor_etas; /**< etas making up the last factorization */
+	int         etas_size;
+	int        *eta_idx;
+	double     *eta_val;
+	int         n_eta_entries;
+	int         eta_entries_size;
+
+	ir_timer_t *timer;
+	unsigned    iterations;
+	bool        aborted;
+} mip_t;
+
+static void mip_init(mip_t *mip, lpp_t *lpp)
+{
+	int const n_rows    = lpp->cst_next - 1;
+	int const n_structs = lpp->var_next - 1;
+	int const n_cols    = n_structs + n_rows;
+	int const n_entries = matrix_get_entries(lpp->m);
+	bool const maximize = lpp->opt_type == lpp_maximize;
+
+	mip->lpp       = lpp;
+	mip->n_rows    = n_rows;
+	mip->n_structs = n_structs;
+	mip->n_cols    = n_cols;
+	mip->col_start = XMALLOCN(int, n_structs + 1);
+	mip->col_row   = XMALLOCN(int, n_entries);
+	mip->col_val   = XMALLOCN(double, n_entries);
+	mip->rhs       = XMALLOCN(double, n_rows);
+	mip->obj       = XMALLOCNZ(double, n_cols);
+	mip->cost      = XMALLOCNZ(double, n_cols);
+	mip->lower     = XMALLOCN(double, n_cols);
+	mip->upper     = XMALLOCN(double, n_cols);
+	mip->is_int    = XMALLOCNZ(bool, n_structs);
+	mip->head      = XMALLOCN(int, n_rows);
+	mip->pos       = XMALLOCN(int, n_cols);
+	mip->at_upper  = XMALLOCNZ(bool, n_cols);
+	mip->x         = XMALLOCNZ(double, n_cols);
+	mip->d         = XMALLOCNZ(double, n_cols);
+	mip->rho       = XMALLOCN(double, n_rows);
+	mip->col       = XMALLOCN(double, n_rows);
+	mip->alpha     = XMALLOCN(double, n_cols);
+
+	mip->etas_size        = MIP_REFACTOR + n_rows + 1;
+	mip->etas             = XMALLOCN(eta_t, mip->etas_size);
+	mip->n_etas           = 0;
+	mip->n_factor_etas    = 0;
+	mip->eta_entries_size = 1024;
+	mip->eta_idx          = XMALLOCN(int, mip->eta_entries_size);
+	mip->eta_val          = XMALLOCN(double, mip->eta_entries_size);
+	mip->n_eta_entries    = 0;
+	mip->iterations       = 0;
+	mip->aborted          = false;
+
+	int o = 0;
+	for (int i = 0; i < n_structs; ++i) {
+		lpp_name_t const *const var = lpp->vars[1 + i];
+		double            const c   = matrix_get(lpp->m, 0, 1 + i);
+
+		mip->obj[i]    = maximize ? -c : c;
+		mip->is_int[i] = var->type.var_type == lpp_binary;
+		mip->lower[i]  = 0.0;
+		if (mip->is_int[i])
+			mip->upper[i] = 1.0;
+		else
+			mip->upper[i] = mip->obj[i] < 0.0 ? MIP_BIG : MIP_INF;
+
+		mip->col_start[i] = o;
+		matrix_foreach_in_col(lpp->m, 1 + i, elem) {
+			if (elem->row == 0)
+				continue;
+			mip->col_row[o] = elem->row - 1;
+			mip->col_val[o] = elem->val;
+			++o;
+		}
+	}
+	mip->col_start[n_structs] = o;
+
+	for (int i = 0; i < n_rows; ++i) {
+		int const s = n_structs + i;
+		mip->rhs[i] = matrix_get(lpp->m, 1 + i, 0);
+		switch (lpp->csts[1 + i]->type.cst_type) {
+		case lpp_less_equal:
+			mip->lower[s] = 0.0;
+			mip->upper[s] = MIP_INF;
+			break;
+		case lpp_greater_equal:
+			mip->lower[s] = -MIP_INF;
+			mip->upper[s] = 0.0;
+			break;
+		default:
+			mip->lower[s] = 0.0;
+			mip->upper[s] = 0.0;
+			break;
+		}
+	}
+
+	/* start from the slack basis, which is dual feasible as every
+	 * structural variable is bounded on the side its cost points to */
+	for (int j = 0; j < n_cols; ++j) {
+		mip->cost[j] = mip->obj[j];
+		mip->d[j]    = mip->obj[j];
+		mip->pos[j]  = -1;
+	}
+
+	/* Copy coalescing problems have costs on few variables only, which makes
+	 * nearly every dual simplex pivot degenerate.  Perturbing the costs of
+	 * the binaries breaks the ties; mip_lp_bound() uses the original costs,
+	 * so this does not affect the bounds. */
+	int n_ints = 0;
+	for (int j = 0; j < n_structs; ++j)
+		n_ints += mip->is_int[j];
+	double   const scale = MIN(MIP_PERTURB, 0.05 / (n_ints + 1));
+	unsigned       seed  = 1;
+	for (int j = 0; j < n_structs; ++j) {
+		if (!mip->is_int[j])
+			continue;
+		seed = seed * 1103515245u + 12345u;
+		double const r     = (double)((seed >> 16) & 0x7fff) / 32768.0;
+		double const delta = scale * (1.0 + fabs(mip->obj[j])) * (1.0 + r);
+		mip->cost[j] += delta;
+		mip->d[j]    += delta;
+	}
+
+	for (int i = 0; i < n_rows; ++i) {
+		mip->head[i]            = n_structs + i;
+		mip->pos[n_structs + i] = i;
+	}
+
+	mip->timer = ir_timer_new();
+	ir_timer_start(mip->timer);
+}
+
+static void mip_free(mip_t *mip)
+{
+	ir_timer_free(mip->timer);
+	free(mip->col_start);
+	free(mip->col_row);
+	free(mip->col_val);
+	free(mip->rhs);
+	free(mip->obj);
+	free(mip->cost);
+	free(mip->lower);
+	free(mip->upper);
+	free(mip->is_int);
+	free(mip->head);
+	free(mip->pos);
+	free(mip->at_upper);
+	free(mip->x);
+	free(mip->d);
+	free(mip->rho);
+	free(mip->col);
+	free(mip->alpha);
+	free(mip->etas);
+	free(mip->eta_idx);
+	free(mip->eta_val);
+}
+
+static bool mip_time_exceeded(mip_t const *mip)
+{
+	double const limit = mip->lpp->time_limit_secs;
+	return limit > 0.0 && ir_timer_elapsed_sec(mip->timer) > limit;
+}
+
+/** Scatters column @p j of [A I] into the dense vector @p a. */
+static void mip_load_column(mip_t const *mip, int j, double *a)
+{
+	memset(a, 0, mip->n_rows * sizeof(*a));
+	if (j < mip->n_structs) {
+		for (int k = mip->col_start[j], e = mip->col_start[j + 1]; k < e; ++k)
+			a[mip->col_row[k]] = mip->col_val[k];
+	} else {
+		a[j - mip->n_structs] = 1.0;
+	}
+}
+
+/** Returns y * A_j for column @p j of [A I]. */
+static double mip_dot_column(mip_t const *mip, int j, double const *y)
+{
+	if (j >= mip->n_structs)
+		return y[j - mip->n_structs];
+
+	double sum = 0.0;
+	for (int k = mip->col_start[j], e = mip->col_start[j + 1]; k < e; ++k)
+		sum += y[mip->col_row[k]] * mip->col_val[k];
+	return sum;
+}
+
+/** Computes B^-1 a in place. */
+static void mip_ftran(mip_t const *mip, double *a)
+{
+	for (int k = 0, n = mip->n_etas; k < n; ++k) {
+		eta_t const *const eta = &mip->etas[k];
+		double             ap  = a[eta->row];
+		if (ap == 0.0)
+			continue;
+		ap          /= eta->pivot;
+		a[eta->row]  = ap;
+		for (int t = eta->start, e = eta->start + eta->n; t < e; ++t)
+			a[mip->eta_idx[t]] -= mip->eta_val[t] * ap;
+	}
+}
+
+/** Computes y B^-1 in place. */
+static void mip_btran(mip_t const *mip, double *y)
+{
+	for (int k = mip->n_etas; k-- > 0;) {
+		eta_t const *const eta = &mip->etas[k];
+		double             s   = y[eta->row];
+		for (int t = eta->start, e = eta->start + eta->n; t < e; ++t)
+			s -= y[mip->eta_idx[t]] * mip->eta_val[t];
+		y[eta->row] = s / eta->pivot;
+	}
+}
+
+/** Appends the eta column for pivoting the ftran'ed column @p a on @p row. */
+static void mip_add_eta(mip_t *mip, int row, double const *a)
+{
+	if (mip->n_etas == mip->etas_size) {
+		mip->etas_size *= 2;
+		mip->etas       = XREALLOC(mip->etas, eta_t, mip->etas_size);
+	}
+	if (mip->n_eta_entries + mip->n_rows > mip->eta_entries_size) {
+		do {
+			mip->eta_entries_size *= 2;
+		} while (mip->n_eta_entries + mip->n_rows > mip->eta_entries_size);
+		mip->eta_idx = XREALLOC(mip->eta_idx, int, mip->eta_entries_size);
+		mip->eta_val = XREALLOC(mip->eta_val, double, mip->eta_entries_size);
+	}
+
+	eta_t *const eta = &mip->etas[mip->n_etas++];
+	eta->row   = row;
+	eta->start = mip->n_eta_entries;
+	eta->pivot = a[row];
+	for (int i = 0, n = mip->n_rows; i < n; ++i) {
+		if (i == row || fabs(a[i]) <= MIP_TOL_DROP)
+			continue;
+		mip->eta_idx[mip->n_eta_entries] = i;
+		mip->eta_val[mip->n_eta_entries] = a[i];
+		++mip->n_eta_entries;
+	}
+	eta->n = mip->n_eta_entries - eta->start;
+}
+
+/** Puts nonbasic variable @p j on the bound its reduced cost asks for. */
+static void mip_place_nonbasic(mip_t *mip, int j)
+{
+	bool up;
+	if (mip->lower[j] == mip->upper[j] || mip->upper[j] == MIP_INF)
+		up = false;
+	else if (mip->lower[j] == -MIP_INF)
+		up = true;
+	else
+		up = mip->d[j] < 0.0;
+	mip->at_upper[j] = up;
+	mip->x[j]        = up ? mip->upper[j] : mip->lower[j];
+}
+
+/** Recomputes the values of the basic variables from the nonbasic ones. */
+static void mip_compute_primal(mip_t *mip)
+{
+	double *const beta = mip->col;
+	for (int i = 0, n = mip->n_rows; i < n; ++i)
+		beta[i] = mip->rhs[i];
+	for (int j = 0, n = mip->n_cols; j < n; ++j) {
+		double const v = mip->x[j];
+		if (mip->pos[j] >= 0 || v == 0.0)
+			continue;
+		if (j < mip->n_structs) {
+			for (int k = mip->col_start[j], e = mip->col_start[j + 1]; k < e; ++k)
+				beta[mip->col_row[k]] -= mip->col_val[k] * v;
+		} else {
+			beta[j - mip->n_structs] -= v;
+		}
+	}
+	mip_ftran(mip, beta);
+	for (int i = 0, n = mip->n_rows; i < n; ++i)
+		mip->x[mip->head[i]] = beta[i];
+}
+
+/**
+ * Recomputes the reduced costs.  Nonbasic variables whose reduced cost lost
+ * its sign through rounding are moved to the other bound if there is one,
+ * otherwise their cost is shifted so the basis stays dual feasible.
+ */
+static void mip_compute_duals(mip_t *mip)
+{
+	double *const y = mip->rho;
+	for (int i = 0, n = mip->n_rows; i < n; ++i)
+		y[i] = mip->cost[mip->head[i]];
+	mip_btran(mip, y);
+	for (int j = 0, n = mip->n_cols; j < n; ++j) {
+		if (mip->pos[j] >= 0) {
+			mip->d[j] = 0.0;
+			continue;
+		}
+		double const dj = mip->cost[j] - mip_dot_column(mip, j, y);
+		mip->d[j] = dj;
+		if (mip->lower[j] == mip->upper[j])
+			continue;
+		bool const wrong = mip->at_upper[j] ? dj > MIP_TOL_DUAL
+		                                    : dj < -MIP_TOL_DUAL;
+		if (!wrong)
+			continue;
+		if (mip->lower[j] != -MIP_INF && mip->upper[j] != MIP_INF) {
+			mip_place_nonbasic(mip, j);
+		} else {
+			mip->cost[j] -= dj;
+			mip->d[j]     = 0.0;
+		}
+	}
+}
+
+typedef struct refactor_entry_t {
+	int var;
+	int nnz;
+} refactor_entry_t;
+
+static int cmp_refactor_entry(void const *a, void const *b)
+{
+	refactor_entry_t const *const ea = (refactor_entry_t const*)a;
+	refactor_entry_t const *const eb = (refactor_entry_t const*)b;
+	if (ea->nnz != eb->nnz)
+		return ea->nnz < eb->nnz ? -1 : 1;
+	return ea->var < eb->var ? -1 : ea->var > eb->var;
+}
+
+/**
+ * Rebuilds the eta file for the current basis.  Slack columns are the
+ * identity and need no eta, so only the structural basic columns are
+ * pivoted in, sparsest first.  Columns which turn out to be (numerically)
+ * dependent are dropped from the basis in favour of a slack.
+ */
+static void mip_refactor(mip_t *mip)
+{
+	int const n_rows    = mip->n_rows;
+	int const n_structs = mip->n_structs;
+
+	refactor_entry_t *const structs = XMALLOCN(refactor_entry_t, n_rows);
+	bool             *const is_free = XMALLOCN(bool, n_rows);
+	int                     n       = 0;
+	for (int i = 0; i < n_rows; ++i) {
+		int const var = mip->head[i];
+		is_free[i] = mip->pos[n_structs + i] < 0;
+		if (var < n_structs) {
+			structs[n].var = var;
+			structs[n].nnz = mip->col_start[var + 1] - mip->col_start[var];
+			++n;
+		}
+	}
+	qsort(structs, n, sizeof(*structs), cmp_refactor_entry);
+
+	mip->n_etas        = 0;
+	mip->n_eta_entries = 0;
+	for (int i = 0; i < n_rows; ++i) {
+		int const slack = n_structs + i;
+		mip->head[i] = slack;
+		if (mip->pos[slack] >= 0)
+			mip->pos[slack] = i;
+	}
+
+	double *const a = mip->col;
+	for (int k = 0; k < n; ++k) {
+		int const var = structs[k].var;
+		mip_load_column(mip, var, a);
+		mip_ftran(mip, a);
+
+		int    best     = -1;
+		double best_abs = MIP_TOL_PIVOT;
+		for (int i = 0; i < n_rows; ++i) {
+			if (is_free[i] && fabs(a[i]) > best_abs) {
+				best     = i;
+				best_abs = fabs(a[i]);
+			}
+		}
+		if (best < 0) {
+			mip->pos[var] = -1;
+			mip_place_nonbasic(mip, var);
+			continue;
+		}
+		mip_add_eta(mip, best, a);
+		is_free[best]   = false;
+		mip->head[best] = var;
+		mip->pos[var]   = best;
+	}
+
+	/* rows left over by dependent columns get their slack back */
+	for (int i = 0; i < n_rows; ++i) {
+		if (!is_free[i])
+			continue;
+		mip->pos[n_structs + i] = i;
+	}
+
+	mip->n_factor_etas = mip->n_etas;
+	free(is_free);
+	free(structs);
+}
+
+static void mip_refresh(mip_t *mip)
+{
+	mip_refactor(mip);
+	mip_compute_duals(mip);
+	mip_compute_primal(mip);
+}
+
+/** Returns the row with the largest bound violation or -1. */
+static int mip_choose_row(mip_t const *mip, bool bland)
+{
+	int    best     = -1;
+	int    best_var = mip->n_cols;
+	double best_inf = 0.0;
+	for (int i = 0, n = mip->n_rows; i < n; ++i) {
+		int    const var = mip->head[i];
+		double const v   = mip->x[var];
+		double       inf;
+		if (v < mip->lower[var] - MIP_TOL_PRIMAL)
+			inf = mip->lower[var] - v;
+		else if (v > mip->upper[var] + MIP_TOL_PRIMAL)
+			inf = v - mip->upper[var];
+		else
+			continue;
+
+		if (bland ? var < best_var : inf > best_inf) {
+			best     = i;
+			best_var = var;
+			best_inf = inf;
+		}
+	}
+	return best;
+}
+
+/**
+ * Dual ratio test for the pivot row in mip->alpha.  @p sign is +1 if the
+ * leaving variable goes to its upper bound, -1 if it goes to its lower
+ * bound.  Uses Harris' two pass test, or the textbook test with smallest
+ * index tie breaking when @p bland is set.
+ */
+static int mip_ratio_test(mip_t const *mip, double sign, bool bland)
+{
+	double const *const alpha = mip->alpha;
+	double              max_ratio = MIP_INF;
+	for (int j = 0, n = mip->n_cols; j < n; ++j) {
+		if (mip->pos[j] >= 0 || mip->lower[j] == mip->upper[j])
+			continue;
+		double const a  = sign * alpha[j];
+		bool   const up = mip->at_upper[j];
+		if (up ? a >= -MIP_TOL_PIVOT : a <= MIP_TOL_PIVOT)
+			continue;
+		double const tol   = bland ? 0.0 : (up ? -MIP_TOL_DUAL : MIP_TOL_DUAL);
+		double const ratio = (mip->d[j] + tol) / a;
+		if (ratio < max_ratio)
+			max_ratio = ratio;
+	}
+	if (max_ratio == MIP_INF)
+		return -1;
+
+	int    best     = -1;
+	double best_abs = 0.0;
+	for (int j = 0, n = mip->n_cols; j < n; ++j) {
+		if (mip->pos[j] >= 0 || mip->lower[j] == mip->upper[j])
+			continue;
+		double const a  = sign * alpha[j];
+		bool   const up = mip->at_upper[j];
+		if (up ? a >= -MIP_TOL_PIVOT : a <= MIP_TOL_PIVOT)
+			continue;
+		double const ratio = mip->d[j] / a;
+		if (bland) {
+			if (ratio <= max_ratio + MIP_TOL_DROP) {
+				best = j;
+				break;
+			}
+		} else if (ratio <= max_ratio && fabs(a) > best_abs) {
+			best     = j;
+			best_abs = fabs(a);
+		}
+	}
+	return best;
+}
+
+/** Solves the LP relaxation under the current bounds with the dual simplex. */
+static lp_result_t mip_solve_lp(mip_t *mip)
+{
+	int const n_rows    = mip->n_rows;
+	int const n_cols    = mip->n_cols;
+	unsigned  max_iter  = 50u * (unsigned)(n_rows + n_cols) + 1000u;
+	unsigned  degen     = 0;
+
+	for (int j = 0; j < n_cols; ++j) {
+		if (mip->pos[j] < 0)
+			mip_place_nonbasic(mip, j);
+	}
+	mip_compute_primal(mip);
+
+	for (unsigned iter = 0;; ++iter) {
+		if (mip->n_etas - mip->n_factor_etas >= MIP_REFACTOR)
+			mip_refresh(mip);
+		if ((iter & 31) == 31 && mip_time_exceeded(mip))
+			return LP_ABORTED;
+		if (iter >= max_iter)
+			return LP_ABORTED;
+
+		bool const bland = degen > MIP_MAX_DEGEN;
+		int  const r     = mip_choose_row(mip, bland);
+		if (r < 0)
+			return LP_OPTIMAL;
+
+		int    const p        = mip->head[r];
+		bool   const to_upper = mip->x[p] > mip->upper[p];
+		double const target   = to_upper ? mip->upper[p] : mip->lower[p];
+		double const sign     = to_upper ? 1.0 : -1.0;
+
+		/* pivot row alpha_r = e_r B^-1 [A I], also computed for fixed
+		 * variables to keep their reduced costs valid when they are
+		 * released again */
+		double *const rho = mip->rho;
+		memset(rho, 0, n_rows * sizeof(*rho));
+		rho[r] = 1.0;
+		mip_btran(mip, rho);
+		for (int j = 0; j < n_cols; ++j) {
+			mip->alpha[j] = mip->pos[j] < 0 ? mip_dot_column(mip, j, rho) : 0.0;
+		}
+
+		int const q = mip_ratio_test(mip, sign, bland);
+		if (q < 0) {
+			if (mip->n_etas > mip->n_factor_etas) {
+				/* make sure this is not an artifact of rounding errors */
+				mip_refresh(mip);
+				continue;
+			}
+			return LP_INFEASIBLE;
+		}
+
+		double *const col = mip->col;
+		mip_load_column(mip, q, col);
+		mip_ftran(mip, col);
+		double const alpha_rq = mip->alpha[q];
+		if (fabs(col[r] - alpha_rq) > 1e-6 * (1.0 + fabs(alpha_rq))
+		    && mip->n_etas > mip->n_factor_etas) {
+			mip_refresh(mip);
+			continue;
+		}
+		++mip->iterations;
+
+		/* update the reduced costs */
+		double theta_d = mip->d[q] / alpha_rq;
+		if (sign * theta_d < 0.0)
+			theta_d = 0.0;
+		if (theta_d != 0.0) {
+			for (int j = 0; j < n_cols; ++j) {
+				if (mip->alpha[j] != 0.0)
+					mip->d[j] -= theta_d * mip->alpha[j];
+			}
+		}
+		mip->d[q] = 0.0;
+		mip->d[p] = -theta_d;
+		degen = fabs(theta_d) <= MIP_TOL_DROP ? degen + 1 : 0;
+
+		/* update the primal values */
+		double const theta_p = (mip->x[p] - target) / col[r];
+		for (int i = 0; i < n_rows; ++i) {
+			if (col[i] != 0.0)
+				mip->x[mip->head[i]] -= theta_p * col[i];
+		}
+		mip->x[q] += theta_p;
+
+		/* exchange the basis */
+		mip_add_eta(mip, r, col);
+		mip->head[r]     = q;
+		mip->pos[q]      = r;
+		mip->pos[p]      = -1;
+		mip->x[p]        = target;
+		mip->at_upper[p] = to_upper;
+	}
+}
+
+/** Returns the upper bound of variable @p j without artificial bounds. */
+static double mip_real_upper(mip_t const *mip, int j)
+{
+	if (j < mip->n_structs && !mip->is_int[j])
+		return MIP_INF;
+	return mip->upper[j];
+}
+
+/**
+ * Checks whether increasing nonbasic variable @p j never makes a basic
+ * variable leave its (real) bounds, i.e. whether it spans a ray.
+ */
+static bool mip_is_ray(mip_t *mip, int j)
+{
+	double *const col = mip->col;
+	mip_load_column(mip, j, col);
+	mip_ftran(mip, col);
+	for (int i = 0, n = mip->n_rows; i < n; ++i) {
+		int    const var = mip->head[i];
+		double const a   = col[i];
+		/* the basic variable changes by -a per unit of x_j */
+		if (a > MIP_TOL_DROP && mip->lower[var] != -MIP_INF)
+			return false;
+		if (a < -MIP_TOL_DROP && mip_real_upper(mip, var) != MIP_INF)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Solves the LP relaxation and raises artificial bounds, which bound the
+ * optimum, until none does.
+ */
+static lp_result_t mip_solve_relaxation(mip_t *mip)
+{
+	for (;;) {
+		lp_result_t const res = mip_solve_lp(mip);
+		if (res != LP_OPTIMAL)
+			return res;
+
+		bool raised = false;
+		for (int j = 0, n = mip->n_structs; j < n; ++j) {
+			if (mip->is_int[j] || mip->pos[j] >= 0 || !mip->at_upper[j]
+			    || mip->d[j] >= -MIP_TOL_DUAL)
+				continue;
+			if (mip_is_ray(mip, j) || mip->upper[j] >= MIP_INF / MIP_BIG_GROWTH)
+				return LP_UNBOUNDED;
+			mip->upper[j] *= MIP_BIG_GROWTH;
+			raised = true;
+		}
+		if (!raised)
+			return LP_OPTIMAL;
+	}
+}
+
+/**
+ * Returns a lower bound of the LP relaxation by weak duality: for the duals
+ * y of the current basis, y b + sum_j min(c_j - y A_j) x_j over the real
+ * bounds of x_j bounds every feasible solution.  It uses the original costs,
+ * so it is valid whatever shifts and perturbations the simplex applied.
+ * Reduced costs within the dual tolerance are treated as 0, so they do not
+ * turn the bound into -infinity on unbounded variables.
+ */
+static double mip_lp_bound(mip_t *mip)
+{
+	double *const y = mip->rho;
+	for (int i = 0, n = mip->n_rows; i < n; ++i)
+		y[i] = mip->cost[mip->head[i]];
+	mip_btran(mip, y);
+
+	double bound = 0.0;
+	for (int i = 0, n = mip->n_rows; i < n; ++i)
+		bound += y[i] * mip->rhs[i];
+	for (int j = 0, n = mip->n_cols; j < n; ++j) {
+		double const dj = mip->obj[j] - mip_dot_column(mip, j, y);
+		if (fabs(dj) <= MIP_TOL_DUAL)
+			continue;
+		double const limit = dj > 0.0 ? mip->lower[j] : mip_real_upper(mip, j);
+		if (limit == MIP_INF || limit == -MIP_INF)
+			return -MIP_INF;
+		bound += dj * limit;
+	}
+	return bound;
+}
+
+static double mip_objective(mip_t const *mip, double const *x)
+{
+	double sum = 0.0;
+	for (int j = 0, n = mip->n_structs; j < n; ++j)
+		sum += mip->obj[j] * x[j];
+	return sum;
+}
+
+/** Checks whether the lpp start values form a feasible solution. */
+static bool mip_load_start(mip_t const *mip, double *sol)
+{
+	lpp_t const *const lpp = mip->lpp;
+	for (int j = 0, n = mip->n_structs; j < n; ++j) {
+		lpp_name_t const *const var = lpp->vars[1 + j];
+		if (var->value_kind != lpp_value_start)
+			return false;
+		double const v = var->value;
+		if (v < -MIP_TOL_PRIMAL || (mip->is_int[j] && v > 1.0 + MIP_TOL_PRIMAL))
+			return false;
+		if (mip->is_int[j]) {
+			if (fabs(v - round(v)) > MIP_TOL_INT)
+				return false;
+			sol[j] = round(v);
+		} else {
+			sol[j] = v;
+		}
+	}
+
+	bool    feasible = true;
+	double *act      = XMALLOCNZ(double, mip->n_rows);
+	for (int j = 0, n = mip->n_structs; j < n; ++j) {
+		for (int k = mip->col_start[j], e = mip->col_start[j + 1]; k < e; ++k)
+			act[mip->col_row[k]] += mip->col_val[k] * sol[j];
+	}
+	for (int i = 0, n = mip->n_rows; i < n; ++i) {
+		int    const s     = mip->n_structs + i;
+		double const slack = mip->rhs[i] - act[i];
+		double const tol   = MIP_TOL_PRIMAL * (1.0 + fabs(mip->rhs[i]));
+		if (slack < mip->lower[s] - tol || slack > mip->upper[s] + tol) {
+			feasible = false;
+			break;
+		}
+	}
+	free(act);
+	return feasible;
+}
+
+/**
+ * Returns the binary variable to branch on, the one whose LP value is
+ * closest to 1/2, or -1 if the LP solution is integral.
+ */
+static int mip_choose_branch(mip_t const *mip)
+{
+	int    best      = -1;
+	double best_dist = 0.5 - MIP_TOL_INT;
+	for (int j = 0, n = mip->n_structs; j < n; ++j) {
+		if (!mip->is_int[j])
+			continue;
+		double const dist = fabs(mip->x[j] - 0.5);
+		if (dist < best_dist) {
+			best      = j;
+			best_dist = dist;
+		}
+	}
+	return best;
+}
+
+static void mip_solve(mip_t *mip)
+{
+	lpp_t *const lpp        = mip->lpp;
+	int    const n_structs  = mip->n_structs;
+	bool   const maximize   = lpp->opt_type == lpp_maximize;
+	double const sign       = maximize ? -1.0 : 1.0;
+	double const target     = lpp->set_bound ? sign * lpp->bound : -MIP_INF;
+	double      *best       = XMALLOCN(double, n_structs);
+	double       best_obj   = MIP_INF;
+	double       open_bound = MIP_INF;
+	bool         has_best   = false;
+	bool         stopped    = false;
+	bool         unbounded  = false;
+	unsigned     n_nodes    = 0;
+
+	if (mip_load_start(mip, best)) {
+		has_best = true;
+		best_obj = mip_objective(mip, best);
+	}
+
+	/* if all costs sit on binaries and are integral so is the optimum */
+	bool integral_obj = true;
+	for (int j = 0; j < n_structs; ++j) {
+		double const c = mip->obj[j];
+		if (c != 0.0 && (!mip->is_int[j] || c != floor(c)))
+			integral_obj = false;
+	}
+
+	int         n_trail    = 0;
+	int         trail_size = 64;
+	trail_t    *trail      = XMALLOCN(trail_t, trail_size);
+	int         n_stack    = 0;
+	int         stack_size = 64;
+	mip_node_t *stack      = XMALLOCN(mip_node_t, stack_size);
+	stack[n_stack++] = (mip_node_t){ -1, 0.0, 0, -MIP_INF };
+
+	while (n_stack > 0) {
+		mip_node_t const node = stack[--n_stack];
+		if (has_best && best_obj <= target + MIP_TOL_INT) {
+			stopped = true;
+			break;
+		}
+		if (mip_time_exceeded(mip)) {
+			mip->aborted = true;
+			open_bound   = node.bound;
+			break;
+		}
+
+		/* move the bounds from the previous node to this one */
+		while (n_trail > node.trail) {
+			trail_t const *const t = &trail[--n_trail];
+			mip->lower[t->var] = t->lower;
+			mip->upper[t->var] = t->upper;
+		}
+		if (node.var >= 0) {
+			if (n_trail == trail_size) {
+				trail_size *= 2;
+				trail       = XREALLOC(trail, trail_t, trail_size);
+			}
+			trail[n_trail++] = (trail_t){
+				node.var, mip->lower[node.var], mip->upper[node.var]
+			};
+			mip->lower[node.var] = node.value;
+			mip->upper[node.var] = node.value;
+		}
+
+		double cutoff = best_obj - MIP_TOL_INT;
+		if (has_best && integral_obj)
+			cutoff = best_obj - 1.0 + MIP_TOL_INT;
+		if (has_best && node.bound > cutoff)
+			continue;
+
+		++n_nodes;
+		lp_result_t const res = mip_solve_relaxation(mip);
+		if (res == LP_INFEASIBLE)
+			continue;
+		if (res == LP_UNBOUNDED) {
+			unbounded = true;
+			break;
+		}
+		if (res == LP_ABORTED) {
+			mip->aborted = true;
+			open_bound   = node.bound;
+			break;
+		}
+
+		double const lp_obj = mip_lp_bound(mip);
+		if (has_best && lp_obj > cutoff)
+			continue;
+
+		int const var = mip_choose_branch(mip);
+		if (var < 0) {
+			for (int j = 0; j < n_structs; ++j)
+				best[j] = mip->is_int[j] ? round(mip->x[j]) : mip->x[j];
+			best_obj = mip_objective(mip, best);
+			has_best = true;
+			continue;
+		}
+
+		if (n_stack + 2 > stack_size) {
+			stack_size *= 2;
+			stack       = XREALLOC(stack, mip_node_t, stack_size);
+		}
+		/* explore the rounding nearest to the LP value first */
+		double const first = mip->x[var] >= 0.5 ? 1.0 : 0.0;
+		stack[n_stack++] = (mip_node_t){ var, 1.0 - first, n_trail, lp_obj };
+		stack[n_stack++] = (mip_node_t){ var, first,       n_trail, lp_obj };
+	}
+
+	/* the best bound is the weakest bound of all unexplored nodes */
+	if (mip->aborted) {
+		for (int k = 0; k < n_stack; ++k)
+			open_bound = MIN(open_bound, stack[k].bound);
+		if (has_best)
+			open_bound = MIN(open_bound, best_obj);
+	} else {
+		open_bound = best_obj;
+	}
+
+	if (unbounded) {
+		lpp->sol_state = lpp_unbounded;
+		open_bound     = -MIP_INF;
+	} else if (!has_best) {
+		lpp->sol_state = mip->aborted ? lpp_unknown : lpp_infeasible;
+	} else {
+		if (mip->aborted && !stopped)
+			lpp->sol_state = lpp_feasible;
+		else
+			lpp->sol_state = lpp_optimal;
+
+		for (int j = 0; j < n_structs; ++j) {
+			lpp->vars[1 + j]->value      = best[j];
+			lpp->vars[1 + j]->value_kind = lpp_value_solution;
+		}
+		lpp->objval = sign * best_obj;
+	}
+	lpp->best_bound = sign * open_bound;
+
+	if (lpp->log != NULL) {
+		fprintf(lpp->log,
+		        "mip: %d rows, %d columns, %u nodes, %u iterations, objective %g\n",
+		        mip->n_rows, n_structs, n_nodes, mip->iterations,
+		        has_best ? sign * best_obj : 0.0);
+	}
+
+	free(stack);
+	free(trail);
+	free(best);
+}
+
+void lpp_solve_mip(lpp_t *lpp)
+{
+	mip_t mip;
+	mip_init(&mip, lpp);
+	lpp_free_matrix(lpp);
+
+	mip_solve(&mip);
+
+	ir_timer_stop(mip.timer);
+	lpp->iterations = mip.iterations;
+	lpp->sol_time   = ir_timer_elapsed_sec(mip.timer);
+	mip_free(&mip);
+}
@@ -0,0 +1,17 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   In-tree mixed integer solver for lpp problems.
+ */
+#ifndef LPP_MIP_H
+#define LPP_MIP_H
+
+#include "lpp.h"
+
+void lpp_solve_mip(lpp_t *lpp);
+
+#endif
@@ -205,6 +205,15 @@ void _obstack_newchunk(struct obstack *h, ptrdiff_t length)
   ptrdiff_t already;
   char *object_base;
 
+  /* Let the preferred chunk size grow geometrically, so obstacks holding
+     much data end up with few large chunks.  */
+  if (h->chunk_size < obstack_arena_get_max_chunk_size ())
+    {
+      h->chunk_size *= 2;
+      if (h->chunk_size > obstack_arena_get_max_chunk_size ())
+	h->chunk_size = obstack_arena_get_max_chunk_size ();
+    }
+
   /* Compute size for new chunk.  */
   new_size = (obj_size + length) + (obj_size >> 3) + h->alignment_mask + 100;
   if (new_size < h->chunk_size)
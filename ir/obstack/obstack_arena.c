@@ -0,0 +1,190 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology.
+ */
+
+/**
+ * @file
+ * @brief   Recycling chunk allocator backing the obstacks.
+ *
+ * Obstack chunks are rounded up to power of two size classes between 4 KiB
+ * and 2 MiB.  Freed chunks are not handed back to the system but kept in a
+ * per thread cache, so the chunks released when one graph is freed serve the
+ * obstacks of the next one.  Chunks of 2 MiB and more are mapped directly and
+ * aligned to 2 MiB, so they can be backed by transparent huge pages.
+ *
+ * Like the rest of the obstack library this does not depend on libfirm.
+ */
+#include "obstack.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#if defined(_MSC_VER)
+#define ARENA_THREAD_LOCAL __declspec(thread)
+#else
+#define ARENA_THREAD_LOCAL __thread
+#endif
+
+#define MIN_CLASS_LOG  12
+#define MAX_CLASS_LOG  21
+#define N_CLASSES      (MAX_CLASS_LOG - MIN_CLASS_LOG + 1)
+#define HUGE_PAGE_SIZE ((size_t)1 << MAX_CLASS_LOG)
+
+/** A cached chunk, the link overlays the start of the chunk. */
+typedef struct free_chunk {
+	struct free_chunk *next;
+} free_chunk;
+
+static ptrdiff_t max_chunk_size = (ptrdiff_t)64 * 1024;
+static size_t    cache_limit    = (size_t)32 * 1024 * 1024;
+static int       use_hugepages;
+
+static ARENA_THREAD_LOCAL free_chunk          *free_lists[N_CLASSES];
+static ARENA_THREAD_LOCAL obstack_arena_stats  stats;
+
+/** Returns the log2 of the size class serving @p size bytes. */
+static unsigned get_class_log(size_t size)
+{
+	unsigned log = MIN_CLASS_LOG;
+	while (((size_t)1 << log) < size)
+		++log;
+	return log;
+}
+
+/** Rounds @p size to the number of bytes actually requested from the
+ * system. */
+static size_t get_alloc_size(size_t size)
+{
+	if (size <= HUGE_PAGE_SIZE)
+		return (size_t)1 << get_class_log(size);
+	return (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+#ifndef _WIN32
+/** Maps @p size bytes aligned to the huge page size. */
+static void *map_chunk(size_t size)
+{
+	size_t const map_size = size + HUGE_PAGE_SIZE;
+	char  *const map      = (char*)mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+	                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == (char*)MAP_FAILED)
+		return NULL;
+
+	uintptr_t const addr    = (uintptr_t)map;
+	uintptr_t const aligned = (addr + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+	char     *const chunk   = map + (aligned - addr);
+	size_t    const head    = (size_t)(chunk - map);
+	if (head != 0)
+		munmap(map, head);
+	size_t const tail = map_size - head - size;
+	if (tail != 0)
+		munmap(chunk + size, tail);
+
+#ifdef MADV_HUGEPAGE
+	if (use_hugepages)
+		madvise(chunk, size, MADV_HUGEPAGE);
+#endif
+	return chunk;
+}
+#endif
+
+static void *system_alloc(size_t size)
+{
+	++stats.n_system_allocs;
+#ifndef _WIN32
+	if (size >= HUGE_PAGE_SIZE)
+		return map_chunk(size);
+#endif
+	return malloc(size);
+}
+
+static void system_free(void *chunk, size_t size)
+{
+	++stats.n_system_frees;
+#ifndef _WIN32
+	if (size >= HUGE_PAGE_SIZE) {
+		munmap(chunk, size);
+		return;
+	}
+#else
+	(void)size;
+#endif
+	free(chunk);
+}
+
+void *obstack_arena_chunk_alloc(ptrdiff_t size)
+{
+	size_t const alloc_size = get_alloc_size((size_t)size);
+	if (alloc_size <= HUGE_PAGE_SIZE) {
+		unsigned    const idx   = get_class_log(alloc_size) - MIN_CLASS_LOG;
+		free_chunk *const chunk = free_lists[idx];
+		if (chunk != NULL) {
+			free_lists[idx]     = chunk->next;
+			stats.cached_bytes -= alloc_size;
+			++stats.n_reused;
+			return chunk;
+		}
+	}
+	return system_alloc(alloc_size);
+}
+
+void obstack_arena_chunk_free(void *chunk)
+{
+	struct _obstack_chunk *const c = (struct _obstack_chunk*)chunk;
+	size_t const alloc_size = get_alloc_size((size_t)(c->limit - (char*)c));
+	if (alloc_size <= HUGE_PAGE_SIZE
+	    && stats.cached_bytes + alloc_size <= cache_limit) {
+		unsigned    const idx  = get_class_log(alloc_size) - MIN_CLASS_LOG;
+		free_chunk *const cached = (free_chunk*)chunk;
+		cached->next        = free_lists[idx];
+		free_lists[idx]     = cached;
+		stats.cached_bytes += alloc_size;
+		return;
+	}
+	system_free(chunk, alloc_size);
+}
+
+void obstack_arena_release(void)
+{
+	for (unsigned i = 0; i < N_CLASSES; ++i) {
+		size_t const size = (size_t)1 << (i + MIN_CLASS_LOG);
+		for (free_chunk *c = free_lists[i], *next; c != NULL; c = next) {
+			next = c->next;
+			system_free(c, size);
+		}
+		free_lists[i] = NULL;
+	}
+	stats.cached_bytes = 0;
+}
+
+void obstack_arena_set_max_chunk_size(ptrdiff_t size)
+{
+	size_t const clamped = size < 0 ? 0 : (size_t)size;
+	max_chunk_size = (ptrdiff_t)get_alloc_size(
+		clamped < HUGE_PAGE_SIZE ? clamped : HUGE_PAGE_SIZE);
+}
+
+ptrdiff_t obstack_arena_get_max_chunk_size(void)
+{
+	return max_chunk_size;
+}
+
+void obstack_arena_set_hugepages(int enable)
+{
+	use_hugepages = enable;
+}
+
+void obstack_arena_set_cache_limit(size_t bytes)
+{
+	cache_limit = bytes;
+}
+
+void obstack_arena_get_stats(obstack_arena_stats *result)
+{
+	*result = stats;
+}
@@ -13,19 +13,39 @@
  * The only drawback is that the nodes still take up memory. This phase fixes
  * this by copying all (reachable) nodes to a new obstack and throwing away
  * the old one.
+ *
+ * By default the copies are laid out in the order of a depth-first walk from
+ * the anchor, which is the order plain graph walks visit them in.  With
+ * set_opt_dce_block_layout() they are laid out block by block instead, with
+ * the blocks in control flow order and the nodes of each block in dependence
+ * order, which suits block-wise and topological walks.
  */
+#include "array.h"
 #include "cgana.h"
+#include "debug.h"
 #include "iredges_t.h"
+#include "irflag_t.h"
 #include "irgraph_t.h"
 #include "irgwalk.h"
 #include "irhooks.h"
+#include "irmemstat_t.h"
 #include "irnode_t.h"
 #include "iropt_t.h"
 #include "iroptimize.h"
 #include "irouts.h"
 #include "irtools.h"
 #include "pmap.h"
+#include "statev_t.h"
+#include "util.h"
 #include "vrp.h"
+#include "xmalloc.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+typedef struct dce_env_t {
+	ir_node **nodes;  /**< reachable nodes in dependence order */
+	ir_node **blocks; /**< blocks in control flow order */
+} dce_env_t;
 
 /**
  * Reroute the inputs of a node from nodes in the old graph to copied nodes in
@@ -37,26 +57,113 @@ static void rewire_inputs(ir_node *node, void *env)
 	irn_rewire_inputs(node);
 }
 
-static void copy_node_dce(ir_node *node, void *env)
+static void copy_node_dce(ir_node *node)
 {
-	(void)env;
 	ir_node *new_node = exact_copy(node);
 	/* preserve the node numbers for easier debugging */
 	new_node->node_nr = node->node_nr;
 	set_irn_link(node, new_node);
 }
 
+static void copy_node_dce_walker(ir_node *node, void *env)
+{
+	(void)env;
+	copy_node_dce(node);
+}
+
+static void collect_node(ir_node *node, void *env)
+{
+	dce_env_t *const dce = (dce_env_t*)env;
+	set_irn_link(node, NULL);
+	ARR_APP1(ir_node*, dce->nodes, node);
+}
+
+/** Collects a block and numbers it (starting with 1) in its link field. */
+static void collect_block(ir_node *block, void *env)
+{
+	dce_env_t *const dce = (dce_env_t*)env;
+	ARR_APP1(ir_node*, dce->blocks, block);
+	set_irn_link(block, INT_TO_PTR(ARR_LEN(dce->blocks)));
+}
+
+static size_t get_block_nr(ir_node const *const block)
+{
+	return PTR_TO_INT(get_irn_link(block)) - 1;
+}
+
 /**
- * Copies the graph reachable from the End node to the obstack
- * in irg. Then fixes the fields containing nodes of the graph.
- *
- * @param copy_node_nr  If non-zero, the node number will be copied
+ * Copies the nodes reachable from @p anchor block by block, the blocks in
+ * control flow order and the nodes of each block in dependence order.
+ */
+static void copy_nodes_blockwise(ir_graph *irg, ir_node *anchor)
+{
+	dce_env_t env = {
+		.nodes  = NEW_ARR_F(ir_node*, 0),
+		.blocks = NEW_ARR_F(ir_node*, 0),
+	};
+	irg_walk_in_or_dep(anchor, NULL, collect_node, &env);
+	/* Walking the predecessors of the End block in post order puts
+	 * predecessors before their successors (except for back edges). */
+	irg_block_walk_graph(irg, NULL, collect_block, &env);
+
+	/* Bucket the nodes by block, keeping the dependence order. */
+	ir_node **const nodes   = env.nodes;
+	size_t    const n_nodes = ARR_LEN(nodes);
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		if (is_Block(node) && get_irn_link(node) == NULL)
+			collect_block(node, &env);
+	}
+	size_t  const n_blocks = ARR_LEN(env.blocks);
+	size_t *const begin    = XMALLOCNZ(size_t, n_blocks + 1);
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		if (!is_Block(node) && !is_Anchor(node))
+			++begin[get_block_nr(get_nodes_block(node)) + 1];
+	}
+	for (size_t b = 0; b < n_blocks; ++b)
+		begin[b + 1] += begin[b];
+	ir_node **const order = XMALLOCN(ir_node*, begin[n_blocks]);
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		if (!is_Block(node) && !is_Anchor(node))
+			order[begin[get_block_nr(get_nodes_block(node))]++] = node;
+	}
+
+	/* copy nodes, begin[b] now marks the end of bucket b */
+	copy_node_dce(anchor);
+	size_t pos = 0;
+	for (size_t b = 0; b < n_blocks; ++b) {
+		copy_node_dce(env.blocks[b]);
+		for (size_t const end = begin[b]; pos < end; ++pos)
+			copy_node_dce(order[pos]);
+	}
+
+	/* rewire in the same order, so the new nodes are accessed sequentially */
+	rewire_inputs(anchor, NULL);
+	pos = 0;
+	for (size_t b = 0; b < n_blocks; ++b) {
+		rewire_inputs(env.blocks[b], NULL);
+		for (size_t const end = begin[b]; pos < end; ++pos)
+			rewire_inputs(order[pos], NULL);
+	}
+	free(order);
+	free(begin);
+	DEL_ARR_F(env.blocks);
+	DEL_ARR_F(env.nodes);
+}
+
+/**
+ * Copies the graph reachable from the anchor to the obstack of irg. Then
+ * fixes the fields containing nodes of the graph.
  */
 static void copy_graph_env(ir_graph *irg)
 {
-	/* copy nodes */
 	ir_node *anchor = irg->anchor;
-	irg_walk_in_or_dep(anchor, copy_node_dce, rewire_inputs, NULL);
+	if (get_opt_dce_block_layout())
+		copy_nodes_blockwise(irg, anchor);
+	else
+		irg_walk_in_or_dep(anchor, copy_node_dce_walker, rewire_inputs, NULL);
 
 	/* fix the anchor */
 	ir_node *new_anchor = (ir_node*)get_irn_link(anchor);
@@ -74,6 +181,7 @@ static void copy_graph_env(ir_graph *irg)
  */
 void dead_node_elimination(ir_graph *irg)
 {
+	FIRM_DBG_REGISTER(dbg, "firm.opt.dce");
 	edges_deactivate(irg);
 
 	/* Handle graph state */
@@ -88,7 +196,7 @@ void dead_node_elimination(ir_graph *irg)
 	struct obstack graveyard_obst = irg->obst;
 
 	/* A new obstack, where the reachable nodes will be copied to. */
-	obstack_init(&irg->obst);
+	ir_mem_obstack_init(&irg->obst, ir_mem_nodes);
 	irg->last_node_idx = 0;
 
 	/* We also need a new value table for CSE */
@@ -99,6 +207,16 @@ void dead_node_elimination(ir_graph *irg)
 	copy_graph_env(irg);
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
 
+	/* The node indices are dense now, drop the map entries of dead nodes. */
+	ARR_RESIZE(ir_node*, irg->idx_irn_map, irg->last_node_idx);
+
+	size_t const old_size  = obstack_memory_used(&graveyard_obst);
+	size_t const new_size  = obstack_memory_used(&irg->obst);
+	size_t const reclaimed = old_size > new_size ? old_size - new_size : 0;
+	DB((dbg, LEVEL_1, "%+F: %u nodes, reclaimed %zu of %zu bytes\n", irg,
+	    irg->last_node_idx, reclaimed, old_size));
+	stat_ev_ull("dce_bytes_reclaimed", reclaimed);
+
 	/* Free memory from old unoptimized obstack */
 	obstack_free(&graveyard_obst, 0);  /* First empty the obstack ... */
 }
@@ -340,6 +340,10 @@ static mtp_additional_properties follow_mem(ir_node *node,
 				/* Access context information => not pure anymore */
 				max_prop &= ~mtp_property_pure;
 				break;
+			case ir_bk_atomic_load:
+				/* reads memory other threads may write => like a Load */
+				max_prop &= ~mtp_property_pure;
+				break;
 			case ir_bk_prefetch:
 			case ir_bk_ffs:
 			case ir_bk_clz:
@@ -352,6 +356,14 @@ static mtp_additional_properties follow_mem(ir_node *node,
 				/* just arithmetic/no semantic change => no problem */
 				continue;
 			case ir_bk_compare_swap:
+			case ir_bk_atomic_fetch_add:
+			case ir_bk_atomic_fetch_sub:
+			case ir_bk_atomic_fetch_and:
+			case ir_bk_atomic_fetch_or:
+			case ir_bk_atomic_fetch_xor:
+			case ir_bk_atomic_exchange:
+			case ir_bk_atomic_store:
+			case ir_bk_atomic_fence:
 				/* write access */
 				max_prop &= ~(mtp_property_pure | mtp_property_no_write);
 				break;
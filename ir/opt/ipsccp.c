@@ -0,0 +1,475 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Interprocedural sparse conditional constant propagation.
+ *
+ * Every parameter and result of a function gets a lattice value: unknown
+ * (top), a constant or a range of integer constants, or anything (bottom).
+ * Argument values flow from all call sites into the parameters of functions
+ * whose callers are all known, return values flow back into the results of
+ * calls. Values are only derived from constants, parameters and call
+ * results, so the iteration over the call graph reaches a fixpoint quickly.
+ */
+#include "array.h"
+#include "callgraph.h"
+#include "cgana.h"
+#include "debug.h"
+#include "ircons.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irprog_t.h"
+#include "tv.h"
+#include "typerep.h"
+#include "xmalloc.h"
+
+#include <stdlib.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/**
+ * A lattice value: top if both bounds are tarval_unknown, bottom if both are
+ * tarval_bad, a constant if both are the same tarval and a range otherwise.
+ */
+typedef struct lattice_t {
+	ir_tarval *lo;
+	ir_tarval *hi;
+} lattice_t;
+
+typedef struct func_info_t {
+	ir_graph  *irg;
+	ir_type   *mtp;
+	bool       known;        /**< this graph is the definition at link time */
+	bool       free;         /**< may be called from unknown places */
+	bool       changed;      /**< graph was modified */
+	size_t     n_params;
+	size_t     n_ress;
+	lattice_t *params;
+	lattice_t *results;
+	bool      *result_used;  /**< result is used at some call site */
+	ir_node  **calls;        /**< Call nodes in this graph */
+	ir_node  **returns;      /**< Return nodes of this graph */
+	ir_node  **arg_projs;    /**< argument Projs of this graph */
+	ir_node  **result_projs; /**< call result Projs in this graph */
+} func_info_t;
+
+static func_info_t *infos;
+
+static lattice_t get_top(void)
+{
+	return (lattice_t){ .lo = tarval_unknown, .hi = tarval_unknown };
+}
+
+static lattice_t get_bottom(void)
+{
+	return (lattice_t){ .lo = tarval_bad, .hi = tarval_bad };
+}
+
+static bool is_top(lattice_t const *const l)
+{
+	return l->lo == tarval_unknown;
+}
+
+static bool is_bottom(lattice_t const *const l)
+{
+	return l->lo == tarval_bad;
+}
+
+static bool is_constant(lattice_t const *const l)
+{
+	return l->lo == l->hi && tarval_is_constant(l->lo);
+}
+
+static func_info_t *get_func_info(ir_graph const *const irg)
+{
+	return &infos[get_irg_idx(irg)];
+}
+
+/** Returns the info of a callee if it is known at link time. */
+static func_info_t *get_callee_info(ir_entity *const callee)
+{
+	if (!is_method_entity(callee))
+		return NULL;
+	ir_graph *const irg = get_entity_linktime_irg(callee);
+	if (irg == NULL)
+		return NULL;
+	func_info_t *const info = get_func_info(irg);
+	return info->known ? info : NULL;
+}
+
+/**
+ * Lowers @p l to the meet of @p l and @p v.
+ *
+ * @return true if @p l changed
+ */
+static bool meet(lattice_t *const l, lattice_t const v)
+{
+	if (is_top(&v) || is_bottom(l))
+		return false;
+	if (is_top(l)) {
+		*l = v;
+		return true;
+	}
+	if (is_bottom(&v)) {
+		*l = get_bottom();
+		return true;
+	}
+
+	ir_mode *const mode = get_tarval_mode(l->lo);
+	if (mode != get_tarval_mode(v.lo) || !mode_is_int(mode)) {
+		if (l->lo == v.lo && l->hi == v.hi)
+			return false;
+		*l = get_bottom();
+		return true;
+	}
+
+	ir_tarval *lo = l->lo;
+	ir_tarval *hi = l->hi;
+	if (tarval_cmp(v.lo, lo) == ir_relation_less)
+		lo = v.lo;
+	if (tarval_cmp(v.hi, hi) == ir_relation_greater)
+		hi = v.hi;
+	if (lo == l->lo && hi == l->hi)
+		return false;
+	l->lo = lo;
+	l->hi = hi;
+	return true;
+}
+
+static lattice_t get_call_result(ir_node const *const call, unsigned const pn,
+                                 ir_mode *const mode)
+{
+	lattice_t res = get_top();
+	size_t const n_callees = cg_get_call_n_callees(call);
+	if (n_callees == 0)
+		return get_bottom();
+	for (size_t i = 0; i < n_callees; ++i) {
+		func_info_t *const info = get_callee_info(cg_get_call_callee(call, i));
+		if (info == NULL || pn >= info->n_ress
+		 || get_type_mode(get_method_res_type(info->mtp, pn)) != mode)
+			return get_bottom();
+		meet(&res, info->results[pn]);
+	}
+	return res;
+}
+
+static bool is_call_result(ir_node const *const node)
+{
+	if (!is_Proj(node))
+		return false;
+	ir_node const *const pred = get_Proj_pred(node);
+	return is_Proj(pred) && get_Proj_num(pred) == pn_Call_T_result
+	    && is_Call(get_Proj_pred(pred));
+}
+
+static ir_node *get_result_call(ir_node const *const proj)
+{
+	return get_Proj_pred(get_Proj_pred(proj));
+}
+
+/**
+ * Evaluates a value in the current lattice. Phis are only followed if
+ * @p follow_phi is set and never recursively, so loops need no special care.
+ */
+static lattice_t eval_value(ir_node *const node, bool const follow_phi)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Const: {
+		ir_tarval *const tv = get_Const_tarval(node);
+		return (lattice_t){ .lo = tv, .hi = tv };
+	}
+	case iro_Confirm:
+		return eval_value(get_Confirm_value(node), follow_phi);
+	case iro_Phi: {
+		if (!follow_phi)
+			return get_bottom();
+		lattice_t res = get_top();
+		foreach_irn_in(node, i, pred) {
+			meet(&res, eval_value(pred, false));
+		}
+		return res;
+	}
+	case iro_Proj: {
+		ir_graph *const irg = get_irn_irg(node);
+		unsigned  const pn  = get_Proj_num(node);
+		if (get_Proj_pred(node) == get_irg_args(irg)) {
+			func_info_t const *const info = get_func_info(irg);
+			return pn < info->n_params ? info->params[pn] : get_bottom();
+		}
+		if (is_call_result(node))
+			return get_call_result(get_result_call(node), pn,
+			                       get_irn_mode(node));
+		return get_bottom();
+	}
+	default:
+		return get_bottom();
+	}
+}
+
+static void collect_walker(ir_node *const node, void *const data)
+{
+	func_info_t *const info = (func_info_t*)data;
+	switch (get_irn_opcode(node)) {
+	case iro_Call:
+		ARR_APP1(ir_node*, info->calls, node);
+		break;
+	case iro_Return:
+		ARR_APP1(ir_node*, info->returns, node);
+		break;
+	case iro_Proj:
+		if (get_Proj_pred(node) == get_irg_args(info->irg)) {
+			ARR_APP1(ir_node*, info->arg_projs, node);
+		} else if (is_call_result(node)) {
+			ARR_APP1(ir_node*, info->result_projs, node);
+			ir_node  *const call = get_result_call(node);
+			unsigned  const pn   = get_Proj_num(node);
+			for (size_t i = 0, n = cg_get_call_n_callees(call); i < n; ++i) {
+				func_info_t *const callee
+					= get_callee_info(cg_get_call_callee(call, i));
+				if (callee != NULL && pn < callee->n_ress)
+					callee->result_used[pn] = true;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void init_info(ir_graph *const irg)
+{
+	func_info_t *const info   = get_func_info(irg);
+	ir_entity   *const entity = get_irg_entity(irg);
+	ir_type     *const mtp    = get_entity_type(entity);
+	info->irg          = irg;
+	info->mtp          = mtp;
+	info->known        = get_entity_linktime_irg(entity) == irg
+	                  && entity_has_definition(entity);
+	info->n_params     = get_method_n_params(mtp);
+	info->n_ress       = get_method_n_ress(mtp);
+	info->params       = XMALLOCN(lattice_t, info->n_params);
+	info->results      = XMALLOCN(lattice_t, info->n_ress);
+	info->result_used  = XMALLOCNZ(bool, info->n_ress);
+	info->calls        = NEW_ARR_F(ir_node*, 0);
+	info->returns      = NEW_ARR_F(ir_node*, 0);
+	info->arg_projs    = NEW_ARR_F(ir_node*, 0);
+	info->result_projs = NEW_ARR_F(ir_node*, 0);
+	for (size_t i = 0; i < info->n_params; ++i) {
+		ir_type *const type = get_method_param_type(mtp, i);
+		info->params[i] = get_type_mode(type) != NULL ? get_top()
+		                                                : get_bottom();
+	}
+	for (size_t i = 0; i < info->n_ress; ++i) {
+		ir_type *const type = get_method_res_type(mtp, i);
+		info->results[i] = info->known && get_type_mode(type) != NULL
+		                 ? get_top() : get_bottom();
+	}
+}
+
+static void free_info(func_info_t *const info)
+{
+	free(info->params);
+	free(info->results);
+	free(info->result_used);
+	DEL_ARR_F(info->calls);
+	DEL_ARR_F(info->returns);
+	DEL_ARR_F(info->arg_projs);
+	DEL_ARR_F(info->result_projs);
+}
+
+static void mark_free(func_info_t *const info)
+{
+	info->free = true;
+	for (size_t i = 0; i < info->n_params; ++i)
+		info->params[i] = get_bottom();
+}
+
+/** Propagates argument values of @p call into its callees. */
+static bool update_call(ir_node *const call)
+{
+	bool         changed = false;
+	size_t const n_args  = get_Call_n_params(call);
+	for (size_t c = 0, n = cg_get_call_n_callees(call); c < n; ++c) {
+		func_info_t *const callee = get_callee_info(cg_get_call_callee(call, c));
+		if (callee == NULL || callee->free)
+			continue;
+		for (size_t i = 0; i < callee->n_params; ++i) {
+			lattice_t value = get_bottom();
+			if (i < n_args) {
+				ir_type *const type = get_method_param_type(callee->mtp, i);
+				ir_node *const arg  = get_Call_param(call, i);
+				ir_mode *const mode = get_type_mode(type);
+				if (get_irn_mode(arg) == mode)
+					value = eval_value(arg, true);
+			}
+			changed |= meet(&callee->params[i], value);
+		}
+	}
+	return changed;
+}
+
+static bool update_info(func_info_t *const info)
+{
+	bool changed = false;
+	for (size_t r = 0, n = ARR_LEN(info->returns); r < n; ++r) {
+		ir_node *const ret = info->returns[r];
+		for (size_t i = 0; i < info->n_ress; ++i) {
+			if ((size_t)get_Return_n_ress(ret) <= i)
+				changed |= meet(&info->results[i], get_bottom());
+			else
+				changed |= meet(&info->results[i],
+				                eval_value(get_Return_res(ret, i), true));
+		}
+	}
+	for (size_t i = 0, n = ARR_LEN(info->calls); i < n; ++i)
+		changed |= update_call(info->calls[i]);
+	return changed;
+}
+
+static void replace_params(func_info_t *const info)
+{
+	ir_graph *const irg = info->irg;
+	for (size_t i = 0, n = ARR_LEN(info->arg_projs); i < n; ++i) {
+		ir_node  *const proj = info->arg_projs[i];
+		unsigned  const pn   = get_Proj_num(proj);
+		if (pn >= info->n_params || !is_constant(&info->params[pn]))
+			continue;
+		ir_tarval *const tv = info->params[pn].lo;
+		if (get_tarval_mode(tv) != get_irn_mode(proj))
+			continue;
+		DB((dbg, LEVEL_2, "  parameter %u of %+F is %T\n", pn, irg, tv));
+		exchange(proj, new_r_Const(irg, tv));
+		info->changed = true;
+	}
+}
+
+static void replace_results(func_info_t *const info)
+{
+	ir_graph *const irg = info->irg;
+	for (size_t i = 0, n = ARR_LEN(info->result_projs); i < n; ++i) {
+		ir_node   *const proj  = info->result_projs[i];
+		ir_mode   *const mode  = get_irn_mode(proj);
+		lattice_t  const value = get_call_result(get_result_call(proj),
+		                                         get_Proj_num(proj), mode);
+		if (is_top(&value) || is_bottom(&value))
+			continue;
+
+		if (is_constant(&value)) {
+			DB((dbg, LEVEL_2, "  %+F is %T\n", proj, value.lo));
+			exchange(proj, new_r_Const(irg, value.lo));
+		} else {
+			DB((dbg, LEVEL_2, "  %+F is in [%T, %T]\n", proj, value.lo,
+			    value.hi));
+			assure_edges(irg);
+			ir_node *const block = get_nodes_block(proj);
+			ir_node *const lo    = new_r_Const(irg, value.lo);
+			ir_node *const hi    = new_r_Const(irg, value.hi);
+			ir_node *const lower = new_r_Confirm(block, proj, lo,
+			                                     ir_relation_greater_equal);
+			ir_node *const upper = new_r_Confirm(block, lower, hi,
+			                                     ir_relation_less_equal);
+			edges_reroute_except(proj, upper, lower);
+		}
+		info->changed = true;
+	}
+}
+
+/** Results no caller uses do not need to be computed. */
+static void drop_unused_results(func_info_t *const info)
+{
+	ir_graph *const irg = info->irg;
+	for (size_t i = 0; i < info->n_ress; ++i) {
+		if (info->result_used[i])
+			continue;
+		for (size_t r = 0, n = ARR_LEN(info->returns); r < n; ++r) {
+			ir_node *const ret = info->returns[r];
+			if ((size_t)get_Return_n_ress(ret) <= i)
+				continue;
+			ir_node *const value = get_Return_res(ret, i);
+			ir_mode *const mode  = get_irn_mode(value);
+			if (is_Const(value) || !mode_is_data(mode))
+				continue;
+			DB((dbg, LEVEL_2, "  result %zu of %+F is unused\n", i, irg));
+			set_Return_res(ret, i, new_r_Const(irg, get_mode_null(mode)));
+			info->changed = true;
+		}
+	}
+}
+
+typedef struct walk_env_t {
+	ir_graph **irgs;
+	size_t     n_irgs;
+} walk_env_t;
+
+static void callgraph_walker(ir_graph *const irg, void *const data)
+{
+	walk_env_t *const env = (walk_env_t*)data;
+	env->irgs[env->n_irgs++] = irg;
+}
+
+void ipsccp(void)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.ipsccp");
+
+	ir_entity **free_methods;
+	size_t const n_free = cgana(&free_methods);
+
+	/* visit callees before callers, so return values are known early */
+	compute_callgraph();
+	size_t const n_irgs = get_irp_n_irgs();
+	walk_env_t   env    = { .irgs = XMALLOCN(ir_graph*, n_irgs), .n_irgs = 0 };
+	callgraph_walk(NULL, callgraph_walker, &env);
+	free_callgraph();
+
+	infos = XMALLOCNZ(func_info_t, get_irp_last_idx());
+	foreach_irp_irg(i, irg) {
+		init_info(irg);
+	}
+	for (size_t i = 0; i < n_free; ++i) {
+		ir_graph *const irg = get_entity_irg(free_methods[i]);
+		if (irg != NULL)
+			mark_free(get_func_info(irg));
+	}
+	free(free_methods);
+	foreach_irp_irg(i, irg) {
+		func_info_t *const info = get_func_info(irg);
+		if (!info->known)
+			mark_free(info);
+		irg_walk_graph(irg, NULL, collect_walker, info);
+	}
+
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (size_t i = 0; i < env.n_irgs; ++i)
+			changed |= update_info(get_func_info(env.irgs[i]));
+	}
+
+	/* replace call results first, they refer to the unmodified callees */
+	foreach_irp_irg(i, irg) {
+		replace_results(get_func_info(irg));
+	}
+	foreach_irp_irg(i, irg) {
+		func_info_t *const info = get_func_info(irg);
+		if (info->free)
+			continue;
+		replace_params(info);
+		drop_unused_results(info);
+	}
+
+	foreach_irp_irg(i, irg) {
+		func_info_t *const info = get_func_info(irg);
+		if (info->changed)
+			confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_CONTROL_FLOW);
+		free_info(info);
+	}
+	free(infos);
+	infos = NULL;
+	free(env.irgs);
+}
@@ -151,7 +151,11 @@ static void opt_walker(ir_node *n, deq_t *waitq)
 	} while (optimized != last);
 }
 
-void optimize_graph_df(ir_graph *irg)
+/**
+ * Optimizes the nodes of @p irg with a wait queue.  If @p nodes is NULL the
+ * queue starts with all nodes of the graph, otherwise with the given nodes.
+ */
+static void optimize_df(ir_graph *irg, ir_node *const *nodes, size_t n_nodes)
 {
 	ir_graph_properties_t props = IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES;
 	if (get_opt_global_cse()) {
@@ -176,7 +180,13 @@ void optimize_graph_df(ir_graph *irg)
 
 	deq_t waitq;
 	deq_init(&waitq);
-	irg_walk_graph(irg, NULL, enqueue_node_init, &waitq);
+	if (nodes == NULL) {
+		irg_walk_graph(irg, NULL, enqueue_node_init, &waitq);
+	} else {
+		irg_walk_graph(irg, firm_clear_link, NULL, NULL);
+		for (size_t i = 0; i < n_nodes; ++i)
+			enqueue_node(nodes[i], &waitq);
+	}
 
 	/* any optimized nodes are stored in the wait queue,
 	 * so if it's not empty, the graph has been changed */
@@ -219,6 +229,16 @@ void optimize_graph_df(ir_graph *irg)
 	remove_End_Bads_and_doublets(end);
 }
 
+void optimize_graph_df(ir_graph *irg)
+{
+	optimize_df(irg, NULL, 0);
+}
+
+void optimize_nodes_df(ir_graph *irg, ir_node *const *nodes, size_t n_nodes)
+{
+	optimize_df(irg, nodes, n_nodes);
+}
+
 void local_opts_const_code(void)
 {
 	ir_graph *irg = get_const_code_irg();
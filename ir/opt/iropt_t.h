@@ -71,6 +71,12 @@ void ir_normalize_node(ir_node *n);
 
 ir_node *optimize_in_place_2(ir_node *n);
 
+/**
+ * Like optimize_graph_df() but only starts with the given nodes.  Their users
+ * are revisited as long as something changes.
+ */
+void optimize_nodes_df(ir_graph *irg, ir_node *const *nodes, size_t n_nodes);
+
 /**
  * The value_of operation.
  * This operation returns for every IR node an associated tarval if existing,
@@ -0,0 +1,295 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Driver for a sequence of optimization passes.
+ *
+ * A stage, which only consists of re-entrant passes, is run on a pool of
+ * threads.  The threads take the graphs one after another from a shared
+ * counter and apply all passes of the stage to them.  Each thread has its own
+ * timer per pass, their times are summed up after the stage.
+ */
+#include "irpipeline.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "array.h"
+#include "debug.h"
+#include "firm_common.h"
+#include "irgraph_t.h"
+#include "irmemstat_t.h"
+#include "irprog_t.h"
+#include "statev_t.h"
+#include "timing.h"
+#include "xmalloc.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+typedef struct pipeline_pass_t {
+	char const            *name;
+	ir_graph_pass_func     graph_func;  /**< set for graph passes */
+	ir_prog_pass_func      prog_func;   /**< set for program passes */
+	ir_graph_properties_t  required;
+	ir_graph_properties_t  invalidated;
+	bool                   reentrant;   /**< may run on several graphs at once */
+	ir_timer_t            *timer;
+	unsigned long          worker_usec; /**< time spent in worker threads */
+} pipeline_pass_t;
+
+struct ir_pipeline_t {
+	pipeline_pass_t *passes;    /**< flexible array of passes */
+	unsigned         n_threads; /**< number of threads for re-entrant stages */
+};
+
+ir_pipeline_t *new_ir_pipeline(void)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.pipeline");
+
+	ir_pipeline_t *const pipeline = XMALLOCZ(ir_pipeline_t);
+	pipeline->passes    = NEW_ARR_F(pipeline_pass_t, 0);
+	pipeline->n_threads = 1;
+	return pipeline;
+}
+
+void free_ir_pipeline(ir_pipeline_t *const pipeline)
+{
+	for (size_t i = 0, n = ARR_LEN(pipeline->passes); i != n; ++i)
+		ir_timer_free(pipeline->passes[i].timer);
+	DEL_ARR_F(pipeline->passes);
+	free(pipeline);
+}
+
+static void add_pass(ir_pipeline_t *const pipeline, pipeline_pass_t pass)
+{
+	pass.timer = ir_timer_new();
+	ARR_APP1(pipeline_pass_t, pipeline->passes, pass);
+}
+
+void ir_pipeline_add_graph_pass(ir_pipeline_t *const pipeline,
+                                char const *const name,
+                                ir_graph_pass_func const func,
+                                ir_graph_properties_t const required,
+                                ir_graph_properties_t const invalidated)
+{
+	add_pass(pipeline, (pipeline_pass_t) {
+		.name        = name,
+		.graph_func  = func,
+		.required    = required,
+		.invalidated = invalidated,
+	});
+}
+
+void ir_pipeline_add_reentrant_graph_pass(ir_pipeline_t *const pipeline,
+                                          char const *const name,
+                                          ir_graph_pass_func const func,
+                                          ir_graph_properties_t const required,
+                                          ir_graph_properties_t const invalidated)
+{
+	add_pass(pipeline, (pipeline_pass_t) {
+		.name        = name,
+		.graph_func  = func,
+		.required    = required,
+		.invalidated = invalidated,
+		.reentrant   = true,
+	});
+}
+
+void ir_pipeline_add_prog_pass(ir_pipeline_t *const pipeline,
+                               char const *const name,
+                               ir_prog_pass_func const func)
+{
+	add_pass(pipeline, (pipeline_pass_t) {
+		.name      = name,
+		.prog_func = func,
+	});
+}
+
+static void apply_graph_pass(pipeline_pass_t const *const pass,
+                             ir_graph *const irg, ir_timer_t *const timer)
+{
+	DB((dbg, LEVEL_2, "running %s on %+F\n", pass->name, irg));
+	assure_irg_properties(irg, pass->required);
+	ir_timer_start(timer);
+	pass->graph_func(irg);
+	ir_timer_stop(timer);
+	confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_ALL & ~pass->invalidated);
+}
+
+static void emit_mem_stat(pipeline_pass_t const *const pass)
+{
+	if (!stat_ev_enabled)
+		return;
+	stat_ev_ctx_push_str("irpipeline_pass", pass->name);
+	ir_mem_stat_ev("irpipeline_mem_");
+	stat_ev_ctx_pop("irpipeline_pass");
+}
+
+/**
+ * Runs the graph passes in [@p begin, @p end) over all graphs.  All passes are
+ * applied to one graph before the next graph is processed.
+ */
+static void run_stage(pipeline_pass_t *const begin, pipeline_pass_t *const end)
+{
+	foreach_irp_irg(i, irg) {
+		for (pipeline_pass_t *pass = begin; pass != end; ++pass) {
+			/* The memory is reported, when the pass confirms the properties. */
+			stat_ev_ctx_push_str("irpipeline_pass", pass->name);
+			apply_graph_pass(pass, irg, pass->timer);
+			stat_ev_ctx_pop("irpipeline_pass");
+		}
+	}
+}
+
+#ifndef _WIN32
+typedef struct parallel_stage_t {
+	pipeline_pass_t *begin;
+	pipeline_pass_t *end;
+	size_t           next_irg; /**< index of the next graph to optimize */
+} parallel_stage_t;
+
+typedef struct stage_worker_t {
+	parallel_stage_t *stage;
+	ir_timer_t      **timers;  /**< one timer per pass of the stage */
+	pthread_t         thread;
+} stage_worker_t;
+
+static void run_stage_worker(stage_worker_t *const worker)
+{
+	parallel_stage_t *const stage  = worker->stage;
+	size_t            const n_irgs = get_irp_n_irgs();
+	for (;;) {
+		size_t const idx = __atomic_fetch_add(&stage->next_irg, 1,
+		                                      __ATOMIC_RELAXED);
+		if (idx >= n_irgs)
+			break;
+		ir_graph *const irg = get_irp_irg(idx);
+		for (pipeline_pass_t *pass = stage->begin; pass != stage->end; ++pass) {
+			apply_graph_pass(pass, irg, worker->timers[pass - stage->begin]);
+		}
+	}
+}
+
+static void *stage_thread_main(void *const data)
+{
+	run_stage_worker((stage_worker_t*)data);
+	/* Hand the chunks cached by this thread back to the system. */
+	obstack_arena_release();
+	return NULL;
+}
+
+/**
+ * Runs the re-entrant graph passes in [@p begin, @p end) over all graphs on
+ * @p n_threads threads, the calling thread being one of them.
+ */
+static void run_parallel_stage(pipeline_pass_t *const begin,
+                               pipeline_pass_t *const end,
+                               unsigned const n_threads)
+{
+	size_t const n_passes = (size_t)(end - begin);
+	for (pipeline_pass_t const *pass = begin; pass != end; ++pass) {
+		/* Reset the global state here, which the threads would reset after
+		 * each graph anyway. */
+		if (pass->invalidated & IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE)
+			set_irp_globals_entity_usage_state(ir_entity_usage_not_computed);
+	}
+
+	ir_enable_threads();
+#ifndef DISABLE_STATEV
+	/* Statistic events are not thread-safe, so only the state after the whole
+	 * stage is reported. */
+	int const stat_ev_was_enabled = stat_ev_enabled;
+	stat_ev_enabled = 0;
+#endif
+
+	parallel_stage_t stage   = { .begin = begin, .end = end };
+	stage_worker_t  *workers = XMALLOCNZ(stage_worker_t, n_threads);
+	for (unsigned t = 0; t < n_threads; ++t) {
+		workers[t].stage  = &stage;
+		workers[t].timers = XMALLOCN(ir_timer_t*, n_passes);
+		for (size_t p = 0; p < n_passes; ++p)
+			workers[t].timers[p] = ir_timer_new();
+	}
+
+	unsigned n_started = 1;
+	for (; n_started < n_threads; ++n_started) {
+		stage_worker_t *const worker = &workers[n_started];
+		if (pthread_create(&worker->thread, NULL, stage_thread_main, worker) != 0)
+			break;
+	}
+	run_stage_worker(&workers[0]);
+	for (unsigned t = 1; t < n_started; ++t)
+		pthread_join(workers[t].thread, NULL);
+#ifndef DISABLE_STATEV
+	stat_ev_enabled = stat_ev_was_enabled;
+#endif
+
+	for (unsigned t = 0; t < n_threads; ++t) {
+		for (size_t p = 0; p < n_passes; ++p) {
+			begin[p].worker_usec += ir_timer_elapsed_usec(workers[t].timers[p]);
+			ir_timer_free(workers[t].timers[p]);
+		}
+		free(workers[t].timers);
+	}
+	free(workers);
+
+	emit_mem_stat(end - 1);
+}
+#endif
+
+void ir_pipeline_set_n_threads(ir_pipeline_t *const pipeline,
+                               unsigned const n_threads)
+{
+	pipeline->n_threads = n_threads > 0 ? n_threads : 1;
+}
+
+void ir_pipeline_run(ir_pipeline_t *const pipeline)
+{
+	pipeline_pass_t *const passes = pipeline->passes;
+	size_t           const n      = ARR_LEN(passes);
+	for (size_t i = 0; i != n;) {
+		pipeline_pass_t *const pass = &passes[i];
+		if (pass->prog_func) {
+			/* Program passes are barriers between stages. */
+			DB((dbg, LEVEL_1, "running %s\n", pass->name));
+			ir_timer_start(pass->timer);
+			pass->prog_func();
+			ir_timer_stop(pass->timer);
+			emit_mem_stat(pass);
+			++i;
+		} else {
+			/* Re-entrant and other graph passes form separate stages. */
+			size_t stage_end = i + 1;
+			while (stage_end != n && !passes[stage_end].prog_func
+			       && passes[stage_end].reentrant == pass->reentrant)
+				++stage_end;
+#ifndef _WIN32
+			if (pass->reentrant && pipeline->n_threads > 1) {
+				DB((dbg, LEVEL_1, "running stage of %zu graph passes on %u threads\n",
+				    stage_end - i, pipeline->n_threads));
+				run_parallel_stage(pass, &passes[stage_end], pipeline->n_threads);
+				i = stage_end;
+				continue;
+			}
+#endif
+			DB((dbg, LEVEL_1, "running stage of %zu graph passes\n", stage_end - i));
+			run_stage(pass, &passes[stage_end]);
+			i = stage_end;
+		}
+	}
+}
+
+void ir_pipeline_print_times(ir_pipeline_t const *const pipeline,
+                             FILE *const out)
+{
+	for (size_t i = 0, n = ARR_LEN(pipeline->passes); i != n; ++i) {
+		pipeline_pass_t const *const pass = &pipeline->passes[i];
+		unsigned long const usec
+			= ir_timer_elapsed_usec(pass->timer) + pass->worker_usec;
+		fprintf(out, "%-30s %10.3f msec\n", pass->name, usec / 1000.0);
+	}
+}
@@ -1865,6 +1865,13 @@ static void process_loop(scc *pscc, loop_env *env)
 		case iro_CopyB:
 			/* cannot handle CopyB yet */
 			goto fail;
+		case iro_Builtin:
+			/* atomics and fences may publish or observe stores of other
+			 * threads, so Loads must not be moved across them */
+			if (!is_irn_const_memory(irn))
+				goto fail;
+			only_phi = false;
+			break;
 		case iro_Load:
 			process = true;
 			if (get_Load_volatility(irn) == volatility_is_volatile) {
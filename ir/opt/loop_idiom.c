@@ -0,0 +1,681 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Loop idiom recognition for memset, memcpy and popcount loops
+ *
+ * Innermost loops consisting of a header with the exit test and a single
+ * body block are replaced if their body
+ *  - stores a loop invariant value with a repeated byte pattern to
+ *    consecutive elements (memset),
+ *  - copies consecutive elements between non-overlapping arrays (CopyB for
+ *    constant, memcpy for symbolic trip counts), or
+ *  - clears the lowest set bit of a value and counts the iterations until it
+ *    becomes zero (popcount builtin).
+ * Memory idioms with a symbolic trip count are guarded by the exit test of
+ * the first iteration, as the computed count is only valid if the body is
+ * executed at least once.  The loop is only replaced if none of its values
+ * besides the memory and the popcount result is used after it.
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irloop_t.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irouts_t.h"
+#include "scalar_evolution.h"
+#include "tv.h"
+#include "util.h"
+#include <assert.h>
+#include <limits.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+typedef enum idiom_kind_t {
+	IDIOM_MEMSET,
+	IDIOM_MEMCPY,
+	IDIOM_POPCOUNT,
+} idiom_kind_t;
+
+typedef struct idiom_t {
+	idiom_kind_t      kind;
+	ir_loop          *loop;
+	ir_node          *header;
+	ir_node          *body;
+	int               entry_idx;  /**< header pred entering the loop */
+	ir_node          *cond;       /**< the exit test in the header */
+	ir_node          *exit;       /**< Cond Proj leaving the loop */
+	ir_node          *exit_block; /**< block the loop exits to */
+	scev_trip_count_t tc;         /**< trip count of memory idioms */
+	ir_node          *mem_phi;    /**< memory Phi of the header or NULL */
+	ir_node          *load;
+	ir_node          *store;
+	ir_node          *bits;       /**< popcount: Phi of the cleared value */
+	ir_node          *counter;    /**< popcount: Phi of the counter */
+} idiom_t;
+
+typedef struct idiom_env_t {
+	ir_type *memset_type;
+	ir_type *memcpy_type;
+	ir_mode *size_mode;   /**< mode of size_t */
+	idiom_t *idioms;      /**< ARR_F of recognized idioms */
+} idiom_env_t;
+
+/**
+ * Returns the block @p proj jumps to or NULL.
+ */
+static ir_node *get_proj_target(ir_node *const proj)
+{
+	if (get_irn_n_outs(proj) != 1)
+		return NULL;
+	ir_node *const target = get_irn_out(proj, 0);
+	return is_Block(target) ? target : NULL;
+}
+
+/**
+ * Checks that @p loop consists of a header ending in a Cond and a body block
+ * which is only entered from the header and jumps back to it.
+ */
+static bool get_loop_shape(idiom_t *const idiom, ir_loop *const loop)
+{
+	if (get_loop_n_elements(loop) != 2)
+		return false;
+	ir_node *const header = scev_get_loop_header(loop);
+	if (header == NULL || get_Block_n_cfgpreds(header) != 2)
+		return false;
+
+	ir_node *body = NULL;
+	for (size_t i = 0; i < 2; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind != k_ir_node)
+			return false;
+		if (element.node != header)
+			body = element.node;
+	}
+	if (body == NULL || get_Block_n_cfgpreds(body) != 1
+	 || get_Block_cfgpred_block(body, 0) != header)
+		return false;
+
+	int const entry_idx = get_Block_cfgpred_block(header, 0) == body ? 1 : 0;
+	if (get_Block_cfgpred_block(header, 1 - entry_idx) != body)
+		return false;
+
+	idiom->loop      = loop;
+	idiom->header    = header;
+	idiom->body      = body;
+	idiom->entry_idx = entry_idx;
+	return true;
+}
+
+/**
+ * Collects the nodes of the header or body block @p block.  Besides pure
+ * computations the header may only contain Phis and the exit test, the body
+ * a single Store, a single Load and the jump back.
+ */
+static bool collect_block_nodes(idiom_t *const idiom, ir_node *const block)
+{
+	bool const is_header = block == idiom->header;
+	for (unsigned o = 0, n_outs = get_irn_n_outs(block); o < n_outs; ++o) {
+		ir_node *const node = get_irn_out(block, o);
+		if (get_nodes_block(node) != block)
+			continue;
+
+		switch (get_irn_opcode(node)) {
+		case iro_Proj:
+			continue;
+
+		case iro_Phi:
+			if (!is_header)
+				return false;
+			if (get_irn_mode(node) == mode_M) {
+				if (idiom->mem_phi != NULL)
+					return false;
+				idiom->mem_phi = node;
+			}
+			continue;
+
+		case iro_Cond:
+			if (!is_header || idiom->cond != NULL)
+				return false;
+			idiom->cond = node;
+			continue;
+
+		case iro_Jmp:
+			if (is_header)
+				return false;
+			continue;
+
+		case iro_Load:
+			if (is_header || idiom->load != NULL
+			 || get_Load_volatility(node) == volatility_is_volatile)
+				return false;
+			idiom->load = node;
+			continue;
+
+		case iro_Store:
+			if (is_header || idiom->store != NULL
+			 || get_Store_volatility(node) == volatility_is_volatile)
+				return false;
+			idiom->store = node;
+			continue;
+
+		default: {
+			ir_mode *const mode = get_irn_mode(node);
+			if (get_irn_pinned(node) || mode == mode_M || mode == mode_X
+			 || mode == mode_T)
+				return false;
+			continue;
+		}
+		}
+	}
+	return true;
+}
+
+/**
+ * Finds the Cond Proj leaving the loop and the block it jumps to.
+ */
+static bool find_exit(idiom_t *const idiom)
+{
+	ir_node *const cond = idiom->cond;
+	if (cond == NULL || get_irn_n_outs(cond) != 2)
+		return false;
+	for (unsigned i = 0; i < 2; ++i) {
+		ir_node *const proj   = get_irn_out(cond, i);
+		ir_node *const target = get_proj_target(proj);
+		if (target == NULL)
+			return false;
+		if (!scev_block_in_loop(target, idiom->loop)) {
+			idiom->exit       = proj;
+			idiom->exit_block = target;
+		}
+	}
+	return idiom->exit != NULL;
+}
+
+/**
+ * Checks that no value of the loop is used after it, except for the memory
+ * and the popcount Phis, which are replaced.
+ */
+static bool check_live_outs(idiom_t const *const idiom)
+{
+	ir_node *const blocks[] = { idiom->header, idiom->body };
+	for (size_t b = 0; b < ARRAY_SIZE(blocks); ++b) {
+		ir_node *const block = blocks[b];
+		for (unsigned o = 0, n_outs = get_irn_n_outs(block); o < n_outs; ++o) {
+			ir_node *const node = get_irn_out(block, o);
+			if (get_nodes_block(node) != block || node == idiom->exit
+			 || node == idiom->mem_phi || node == idiom->bits
+			 || node == idiom->counter)
+				continue;
+			for (unsigned u = 0, n_users = get_irn_n_outs(node); u < n_users; ++u) {
+				ir_node *const user = get_irn_out(node, u);
+				if (is_End(user))
+					continue;
+				ir_node *const user_block = is_Block(user) ? user : get_nodes_block(user);
+				if (!scev_block_in_loop(user_block, idiom->loop))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns the address @p ptr refers to in the first iteration, i.e. with the
+ * header Phis replaced by their initial values, built in @p block.
+ */
+static ir_node *build_start(idiom_t const *const idiom, ir_node *const ptr,
+                            ir_node *const block)
+{
+	if (scev_is_loop_invariant(ptr, idiom->loop))
+		return ptr;
+	if (is_Phi(ptr)) {
+		if (get_Phi_n_preds(ptr) == 1)
+			return build_start(idiom, get_Phi_pred(ptr, 0), block);
+		assert(get_nodes_block(ptr) == idiom->header);
+		return get_Phi_pred(ptr, idiom->entry_idx);
+	}
+
+	ir_node *const copy = exact_copy(ptr);
+	set_nodes_block(copy, block);
+	foreach_irn_in(ptr, i, pred) {
+		set_irn_n(copy, i, build_start(idiom, pred, block));
+	}
+	return copy;
+}
+
+/**
+ * Returns the loop invariant base object @p ptr points into.
+ */
+static ir_node *get_base(idiom_t const *const idiom, ir_node *ptr)
+{
+	while (!scev_is_loop_invariant(ptr, idiom->loop)) {
+		if (is_Phi(ptr)) {
+			ptr = get_Phi_n_preds(ptr) == 1 ? get_Phi_pred(ptr, 0)
+			                                : get_Phi_pred(ptr, idiom->entry_idx);
+		} else if (is_Add(ptr)) {
+			ir_node *const left = get_Add_left(ptr);
+			ptr = mode_is_reference(get_irn_mode(left)) ? left : get_Add_right(ptr);
+		} else if (is_Sub(ptr)) {
+			ptr = get_Sub_left(ptr);
+		} else {
+			return NULL;
+		}
+	}
+	return ptr;
+}
+
+/**
+ * Checks that @p ptr advances by the size of @p mode in each iteration.
+ */
+static bool is_consecutive(idiom_t const *const idiom, ir_node *const ptr,
+                           ir_mode *const mode)
+{
+	ir_mode   *const offset_mode = get_reference_offset_mode(get_irn_mode(ptr));
+	ir_tarval *stride;
+	if (!scev_get_stride(ptr, idiom->loop, offset_mode, &stride))
+		return false;
+	return tarval_is_long(stride)
+	    && get_tarval_long(stride) == (long)get_mode_size_bytes(mode);
+}
+
+/**
+ * Returns whether storing @p value to consecutive elements fills memory with
+ * a single byte, which is returned in @p byte if @p value is constant.
+ */
+static bool get_fill_byte(ir_node *const value, ir_loop const *const loop,
+                          long *const byte)
+{
+	if (!scev_is_loop_invariant(value, loop))
+		return false;
+	ir_mode *const mode = get_irn_mode(value);
+	if (!is_Const(value)) {
+		*byte = -1;
+		return mode_is_int(mode) && get_mode_size_bits(mode) == 8;
+	}
+
+	ir_tarval *const tv = get_Const_tarval(value);
+	if (mode_is_reference(mode)) {
+		*byte = 0;
+		return tarval_is_null(tv);
+	}
+	if (!mode_is_int(mode) && !mode_is_float(mode))
+		return false;
+	unsigned char const first = get_tarval_sub_bits(tv, 0);
+	for (unsigned i = 1, n = get_mode_size_bytes(mode); i < n; ++i) {
+		if (get_tarval_sub_bits(tv, i) != first)
+			return false;
+	}
+	*byte = first;
+	return true;
+}
+
+static bool match_memory_idiom(idiom_t *const idiom)
+{
+	ir_node *const store   = idiom->store;
+	ir_node *const load    = idiom->load;
+	ir_node *const mem_phi = idiom->mem_phi;
+	if (store == NULL || mem_phi == NULL)
+		return false;
+	if (!scev_get_trip_count(idiom->loop, &idiom->tc)
+	 || idiom->tc.stay != get_Block_cfgpred(idiom->body, 0))
+		return false;
+
+	ir_node *const back_mem = get_Phi_pred(mem_phi, 1 - idiom->entry_idx);
+	if (!is_Proj(back_mem) || get_Proj_pred(back_mem) != store)
+		return false;
+
+	ir_node *const value = get_Store_value(store);
+	ir_mode *const mode  = get_irn_mode(value);
+	if (!is_consecutive(idiom, get_Store_ptr(store), mode))
+		return false;
+
+	if (load == NULL) {
+		long byte;
+		if (get_Store_mem(store) != mem_phi
+		 || !get_fill_byte(value, idiom->loop, &byte))
+			return false;
+		idiom->kind = IDIOM_MEMSET;
+		return true;
+	}
+
+	ir_node *const load_mem = get_Store_mem(store);
+	if (get_Load_mem(load) != mem_phi || !is_Proj(load_mem)
+	 || get_Proj_pred(load_mem) != load || !is_Proj(value)
+	 || get_Proj_pred(value) != load || get_Load_mode(load) != mode)
+		return false;
+	ir_node *const src = get_Load_ptr(load);
+	if (!is_consecutive(idiom, src, mode))
+		return false;
+
+	/* The copied ranges must not overlap; objects the bases point into are
+	 * disjoint if the bases do not alias for any access size. */
+	ir_node *const dst_base = get_base(idiom, get_Store_ptr(store));
+	ir_node *const src_base = get_base(idiom, src);
+	if (dst_base == NULL || src_base == NULL
+	 || get_alias_relation(dst_base, get_Store_type(store), UINT_MAX,
+	                       src_base, get_Load_type(load), UINT_MAX)
+	    != ir_no_alias)
+		return false;
+	idiom->kind = IDIOM_MEMCPY;
+	return true;
+}
+
+/**
+ * Matches the popcount loop
+ *   while (x != 0) { x &= x - 1; ++count; }
+ */
+static bool match_popcount(idiom_t *const idiom)
+{
+	/* A memory Phi may only pass memory through the loop. */
+	ir_node *const mem_phi  = idiom->mem_phi;
+	int      const back_idx = 1 - idiom->entry_idx;
+	if (idiom->load != NULL || idiom->store != NULL
+	 || (mem_phi != NULL && get_Phi_pred(mem_phi, back_idx) != mem_phi))
+		return false;
+
+	ir_node *const cmp = get_Cond_selector(idiom->cond);
+	if (!is_Cmp(cmp) || !is_irn_null(get_Cmp_right(cmp)))
+		return false;
+	ir_node *const bits = get_Cmp_left(cmp);
+	ir_mode *const mode = get_irn_mode(bits);
+	if (!is_Phi(bits) || get_nodes_block(bits) != idiom->header
+	 || !mode_is_int(mode) || get_mode_size_bits(mode) < 32)
+		return false;
+
+	ir_relation relation = get_Cmp_relation(cmp);
+	if (get_Proj_num(idiom->exit) == pn_Cond_true)
+		relation = get_negated_relation(relation);
+	relation &= ir_relation_less_equal_greater;
+	if (relation != ir_relation_less_greater
+	 && (relation != ir_relation_greater || mode_is_signed(mode)))
+		return false;
+
+	/* x & (x - 1) clears the lowest set bit. */
+	ir_node *const next = get_Phi_pred(bits, back_idx);
+	if (!is_And(next))
+		return false;
+	ir_node *const left  = get_And_left(next);
+	ir_node *const right = get_And_right(next);
+	ir_node *const dec   = left == bits ? right : right == bits ? left : NULL;
+	if (dec == NULL)
+		return false;
+	if (is_Add(dec)) {
+		if (get_Add_left(dec) != bits || !is_Const(get_Add_right(dec))
+		 || !tarval_is_all_one(get_Const_tarval(get_Add_right(dec))))
+			return false;
+	} else if (!is_Sub(dec) || get_Sub_left(dec) != bits
+	           || !is_irn_one(get_Sub_right(dec))) {
+		return false;
+	}
+
+	ir_node *counter = NULL;
+	ir_node *const header  = idiom->header;
+	for (unsigned o = 0, n_outs = get_irn_n_outs(header); o < n_outs; ++o) {
+		ir_node *const phi = get_irn_out(header, o);
+		if (!is_Phi(phi) || get_nodes_block(phi) != header || phi == bits
+		 || phi == mem_phi)
+			continue;
+		if (counter != NULL)
+			return false;
+		counter = phi;
+	}
+	if (counter == NULL || !mode_is_int(get_irn_mode(counter)))
+		return false;
+	ir_node *const inc = get_Phi_pred(counter, back_idx);
+	if (!is_Add(inc) || get_Add_left(inc) != counter
+	 || !is_irn_one(get_Add_right(inc)))
+		return false;
+
+	idiom->kind    = IDIOM_POPCOUNT;
+	idiom->bits    = bits;
+	idiom->counter = counter;
+	return true;
+}
+
+static void find_idioms(idiom_env_t *const env, ir_loop *const loop)
+{
+	bool         innermost  = true;
+	size_t const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind == k_ir_loop) {
+			innermost = false;
+			find_idioms(env, element.son);
+		}
+	}
+	if (!innermost || get_loop_outer_loop(loop) == loop)
+		return;
+
+	idiom_t idiom = { .loop = NULL };
+	if (!get_loop_shape(&idiom, loop)
+	 || !collect_block_nodes(&idiom, idiom.header)
+	 || !collect_block_nodes(&idiom, idiom.body)
+	 || !find_exit(&idiom))
+		return;
+	if (!match_memory_idiom(&idiom) && !match_popcount(&idiom))
+		return;
+	if (!check_live_outs(&idiom))
+		return;
+
+	DB((dbg, LEVEL_2, "%+F: %s loop\n", loop,
+	    idiom.kind == IDIOM_MEMSET ? "memset" :
+	    idiom.kind == IDIOM_MEMCPY ? "memcpy" : "popcount"));
+	ARR_APP1(idiom_t, env->idioms, idiom);
+}
+
+/**
+ * Replaces the uses of @p node after the loop by @p value.
+ */
+static void replace_live_out(idiom_t const *const idiom, ir_node *const node,
+                             ir_node *const value)
+{
+	for (unsigned i = get_irn_n_outs(node); i-- > 0;) {
+		int            pos;
+		ir_node *const user = get_irn_out_ex(node, i, &pos);
+		if (!is_End(user)
+		 && !scev_block_in_loop(get_nodes_block(user), idiom->loop))
+			set_irn_n(user, pos, value);
+	}
+}
+
+/**
+ * Makes the loop unreachable by continuing after it in @p join instead and
+ * drops the keepalives of its nodes.
+ */
+static void remove_loop(idiom_t const *const idiom, ir_node *const join)
+{
+	ir_graph *const irg        = get_irn_irg(join);
+	ir_node  *const exit_block = idiom->exit_block;
+	for (int i = get_Block_n_cfgpreds(exit_block); i-- > 0;) {
+		if (get_Block_cfgpred(exit_block, i) == idiom->exit)
+			set_Block_cfgpred(exit_block, i, new_r_Jmp(join));
+	}
+	set_Block_cfgpred(idiom->header, idiom->entry_idx, new_r_Bad(irg, mode_X));
+
+	ir_node *const end = get_irg_end(irg);
+	foreach_irn_in_r(end, i, ka) {
+		ir_node *const block = is_Block(ka) ? ka : get_nodes_block(ka);
+		if (block == idiom->header || block == idiom->body)
+			remove_End_n(end, i);
+	}
+}
+
+static ir_type *new_mem_function_type(ir_mode *const size_mode,
+                                      ir_mode *const arg_mode)
+{
+	ir_type *const type = new_type_method(3, 1, false, cc_cdecl_set, mtp_no_property);
+	set_method_param_type(type, 0, get_type_for_mode(mode_P));
+	set_method_param_type(type, 1, get_type_for_mode(arg_mode));
+	set_method_param_type(type, 2, get_type_for_mode(size_mode));
+	set_method_res_type(type, 0, get_type_for_mode(mode_P));
+	return type;
+}
+
+/**
+ * Builds the operation replacing the memory idiom @p idiom for @p count
+ * elements in @p block and returns the resulting memory.
+ */
+static ir_node *build_memory_op(idiom_env_t const *const env,
+                                idiom_t const *const idiom,
+                                ir_node *const block, ir_node *const mem,
+                                ir_node *const count)
+{
+	ir_graph *const irg   = get_irn_irg(block);
+	ir_node  *const store = idiom->store;
+	dbg_info *const dbgi  = get_irn_dbg_info(store);
+	ir_node  *const value = get_Store_value(store);
+	ir_mode  *const mode  = get_irn_mode(value);
+	unsigned  const size  = get_mode_size_bytes(mode);
+	ir_node  *const dst   = build_start(idiom, get_Store_ptr(store), block);
+
+	ir_node *arg;
+	ir_type *type;
+	char const *name;
+	if (idiom->kind == IDIOM_MEMCPY) {
+		arg = build_start(idiom, get_Load_ptr(idiom->load), block);
+		if (is_Const(count)) {
+			ir_tarval *const tv = get_Const_tarval(count);
+			if (tarval_is_long(tv) && get_tarval_long(tv) <= (long)(UINT_MAX / size)) {
+				ir_type *const elem_type = get_type_for_mode(mode);
+				ir_type *const copy_type = new_type_array(elem_type, get_tarval_long(tv));
+				return new_rd_CopyB(dbgi, block, mem, dst, arg, copy_type, cons_none);
+			}
+		}
+		type = env->memcpy_type;
+		name = "memcpy";
+	} else {
+		long byte;
+		get_fill_byte(value, idiom->loop, &byte);
+		arg  = byte < 0 ? new_r_Conv(block, value, mode_Is)
+		                : new_r_Const_long(irg, mode_Is, byte);
+		type = env->memset_type;
+		name = "memset";
+	}
+
+	ir_mode *const size_mode = env->size_mode;
+	ir_node       *len       = get_irn_mode(count) == size_mode ? count
+	                         : new_r_Conv(block, count, size_mode);
+	if (size != 1)
+		len = new_r_Mul(block, len, new_r_Const_long(irg, size_mode, size));
+
+	ir_entity *const entity = create_compilerlib_entity(name, type);
+	ir_node   *const callee = new_r_Address(irg, entity);
+	ir_node   *const in[]   = { dst, arg, len };
+	ir_node   *const call   = new_rd_Call(dbgi, block, mem, callee, ARRAY_SIZE(in), in, type);
+	return new_r_Proj(call, mode_M, pn_Call_M);
+}
+
+static void replace_memory_idiom(idiom_env_t const *const env,
+                                 idiom_t const *const idiom)
+{
+	scev_trip_count_t const *const tc     = &idiom->tc;
+	ir_node                 *const header = idiom->header;
+	ir_graph                *const irg    = get_irn_irg(header);
+	ir_node                 *const entry  = get_Block_cfgpred(header, idiom->entry_idx);
+	ir_node                 *const mem    = get_Phi_pred(idiom->mem_phi, idiom->entry_idx);
+
+	ir_node *block;
+	ir_node *count;
+	ir_node *skip = NULL;
+	if (tc->count != NULL) {
+		block = new_r_Block(irg, 1, &entry);
+		count = tarval_is_null(tc->count) ? NULL : new_r_Const(irg, tc->count);
+	} else {
+		/* The computed trip count is only valid if the loop is entered. */
+		ir_node *const guard   = new_r_Block(irg, 1, &entry);
+		ir_node *const cmp     = new_r_Cmp(guard, tc->iv.init, tc->limit, tc->relation);
+		ir_node *const cond    = new_r_Cond(guard, cmp);
+		ir_node *const to_body = new_r_Proj(cond, mode_X, pn_Cond_true);
+		skip  = new_r_Proj(cond, mode_X, pn_Cond_false);
+		block = new_r_Block(irg, 1, &to_body);
+		count = scev_build_trip_count(tc, block);
+	}
+
+	ir_node *res_mem = mem;
+	if (count != NULL)
+		res_mem = build_memory_op(env, idiom, block, mem, count);
+
+	ir_node *join = block;
+	if (skip != NULL) {
+		ir_node *const join_in[] = { skip, new_r_Jmp(block) };
+		ir_node *const phi_in[]  = { mem, res_mem };
+		join    = new_r_Block(irg, ARRAY_SIZE(join_in), join_in);
+		res_mem = new_r_Phi(join, ARRAY_SIZE(phi_in), phi_in, mode_M);
+	}
+	replace_live_out(idiom, idiom->mem_phi, res_mem);
+	remove_loop(idiom, join);
+}
+
+static void replace_popcount(idiom_t const *const idiom)
+{
+	ir_node  *const header    = idiom->header;
+	ir_graph *const irg       = get_irn_irg(header);
+	dbg_info *const dbgi      = get_irn_dbg_info(idiom->cond);
+	int       const entry_idx = idiom->entry_idx;
+	ir_node  *const entry     = get_Block_cfgpred(header, entry_idx);
+	ir_node  *const block     = new_r_Block(irg, 1, &entry);
+	ir_node  *const bits      = get_Phi_pred(idiom->bits, entry_idx);
+	ir_node  *const counter   = get_Phi_pred(idiom->counter, entry_idx);
+	ir_mode  *const mode      = get_irn_mode(bits);
+	ir_mode  *const res_mode  = get_irn_mode(counter);
+
+	ir_type *const type = new_type_method(1, 1, false, cc_cdecl_set, mtp_no_property);
+	set_method_param_type(type, 0, get_type_for_mode(mode));
+	set_method_res_type(type, 0, get_type_for_mode(mode_Is));
+
+	ir_node *const nomem   = get_irg_no_mem(irg);
+	ir_node *const in[]    = { bits };
+	ir_node *const builtin = new_rd_Builtin(dbgi, block, nomem, ARRAY_SIZE(in), in, ir_bk_popcount, type);
+	ir_node       *res     = new_r_Proj(builtin, mode_Is, pn_Builtin_max + 1);
+	if (res_mode != mode_Is)
+		res = new_r_Conv(block, res, res_mode);
+	ir_node *const sum = new_r_Add(block, counter, res);
+
+	if (idiom->mem_phi != NULL) {
+		ir_node *const mem = get_Phi_pred(idiom->mem_phi, entry_idx);
+		replace_live_out(idiom, idiom->mem_phi, mem);
+	}
+	replace_live_out(idiom, idiom->bits, new_r_Const(irg, get_mode_null(mode)));
+	replace_live_out(idiom, idiom->counter, sum);
+	remove_loop(idiom, block);
+}
+
+void replace_loop_idioms(ir_graph *const irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.loop-idiom");
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_BADS
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+
+	ir_mode *const size_mode = find_unsigned_mode(get_reference_offset_mode(mode_P));
+	idiom_env_t env = {
+		.memset_type = new_mem_function_type(size_mode, mode_Is),
+		.memcpy_type = new_mem_function_type(size_mode, mode_P),
+		.size_mode   = size_mode,
+		.idioms      = NEW_ARR_F(idiom_t, 0),
+	};
+	find_idioms(&env, get_irg_loop(irg));
+
+	size_t const n_idioms = ARR_LEN(env.idioms);
+	for (size_t i = 0; i < n_idioms; ++i) {
+		idiom_t const *const idiom = &env.idioms[i];
+		if (idiom->kind == IDIOM_POPCOUNT) {
+			replace_popcount(idiom);
+		} else {
+			replace_memory_idiom(&env, idiom);
+		}
+	}
+	DEL_ARR_F(env.idioms);
+
+	DB((dbg, LEVEL_1, "%+F: %zu loop idioms replaced\n", irg, n_idioms));
+	confirm_irg_properties(irg, n_idioms > 0 ? IR_GRAPH_PROPERTIES_NONE
+	                                         : IR_GRAPH_PROPERTIES_ALL);
+}
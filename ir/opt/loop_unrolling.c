@@ -9,6 +9,7 @@
  * @author  Elias Aebi
  */
 #include "lcssa_t.h"
+#include "scalar_evolution.h"
 #include "irtools.h"
 #include "xmalloc.h"
 #include "debug.h"
@@ -260,152 +261,37 @@ static unsigned find_optimal_factor(unsigned long number, unsigned max) {
 	return 0;
 }
 
-/**
- * walk trivial phis (with only one input) until another node is found
- */
-static ir_node* skip_trivial_phis(ir_node *start) {
-	if (is_Phi(start) && get_Phi_n_preds(start) == 1) {
-		return skip_trivial_phis(get_Phi_pred(start, 0));
-	}
-	return start;
-}
-
 /**
  * Analyzes loop and decides whether it should be unrolled or not and chooses a suitable unroll factor.
  *
- * Currently only loops featuring a counter variable with constant start, step and limit known at compile time
- * are considered for unrolling.
+ * Currently only loops whose trip count is known at compile time are considered for unrolling.
  * Tries to find a divisor of the number of loop iterations which is smaller than the maximum unroll factor
  * and is a power of two. In this case, additional optimizations are possible.
  *
+ * @param loop the loop
  * @param header loop header
  * @param max max allowed unroll factor
  * @param fully_unroll pointer to where the decision to fully unroll the loop is stored
  * @return unroll factor to use fot this loop; 0 if loop should not be unrolled
  */
-static unsigned find_suitable_factor(ir_node *const header, unsigned max, bool *fully_unroll) {
+static unsigned find_suitable_factor(ir_loop *const loop, ir_node *const header, unsigned max, bool *fully_unroll) {
 	unsigned const DONT_UNROLL = 0;
-	unsigned const n_outs = get_irn_n_outs(header);
-	unsigned factor = 1;
-	for (unsigned i = 0; i < n_outs; ++i) {
-		ir_node *const node = get_irn_out(header, i);
-		assert(!is_Block(node));
-		if (get_nodes_block(node) != header)
-			continue;
-
-		if (is_Cmp(node)) {
-
-			ir_relation cmp_rel = get_Cmp_relation(node);
-			if (cmp_rel == ir_relation_less_greater || cmp_rel == ir_relation_equal || cmp_rel & ir_relation_unordered) {
-				return DONT_UNROLL;
-			}
-
-			ir_tarval *tv_init = NULL;
-			ir_tarval *tv_step = NULL;
-			ir_tarval *tv_limit = NULL;
-
-			ir_node *header_phi;
-			ir_node *cmp_right = get_Cmp_right(node);
-			if (is_Const(cmp_right) && mode_is_int(get_irn_mode(cmp_right))) {
-				if (!is_Phi(get_Cmp_left(node))) {
-					return DONT_UNROLL;
-				}
-				// found Cmp(?, const)
-				header_phi = get_Cmp_left(node);
-				tv_limit = get_Const_tarval(get_Cmp_right(node));
-			} else {
-				return DONT_UNROLL;
-			}
-			int phi_preds = get_Phi_n_preds(header_phi);
-			ir_node *cnt_add = NULL;
-			for (int j = 0; j < phi_preds; j++) {
-				ir_node *phi_pred = get_Phi_pred(header_phi, j);
-				if (is_Const(phi_pred) && mode_is_int(get_irn_mode(cmp_right))) {
-					// found constant init for (possible) counter
-					ir_tarval *const_tv = get_Const_tarval(phi_pred);
-					if (tv_init == NULL || tarval_cmp(tv_init, const_tv) == ir_relation_equal) {
-						tv_init = const_tv;
-						continue;
-					}
-				}
-				phi_pred = skip_trivial_phis(phi_pred);
-				// is_binop() would find more cases, but we currently can only optimize further if we have an Add here
-				if (is_Add(phi_pred) && cnt_add == NULL) {
-					cnt_add = phi_pred;
-					ir_node *left = get_binop_left(phi_pred);
-					ir_node *right = get_binop_right(phi_pred);
-					if (is_Const(right) && is_Phi(left)) {
-						// found Add(phi, const)
-
-						bool found_constant_step = false;
-						// LCSSA construction builds additional phi nodes
-						do {
-							if (left == header_phi) {
-								found_constant_step = true;
-								tv_step = get_Const_tarval(right);
-								break;
-							}
-							left = get_Phi_pred(left, 0);
-
-						} while (is_Phi(left) && (get_Phi_n_preds(left) == 1 || left == header_phi));
-
-						if (found_constant_step) {
-							continue;
-						}
-					}
-					return DONT_UNROLL;
-				}
-				// multiple uses of the same loop counter increment/decrement
-				if (phi_pred == cnt_add) {
-					continue;
-				} else {
-					return DONT_UNROLL;
-				}
-			}
-
-			assert(tv_limit != NULL && tv_init != NULL && tv_step != NULL);
-
-			// normalize: use less or less_equal as relation
-			if (cmp_rel & ir_relation_greater) {
-				ir_tarval *tmp = tv_init;
-				tv_init = tv_limit;
-				tv_limit = tmp;
-				tv_step = tarval_neg(tv_step);
-				cmp_rel = get_inversed_relation(cmp_rel);
-			}
-
-			ir_tarval *tv_interval = tarval_sub(tv_limit, tv_init);
-			if (tarval_is_negative(tv_interval) || tarval_is_negative(tv_step)) {
-				return DONT_UNROLL;
-			}
-
-			ir_tarval *tv_one = new_tarval_from_long(1, get_tarval_mode(tv_interval));
-			// normalize: use less_equal as relation
-			if (!(cmp_rel & ir_relation_equal)) {
-				// interval -= 1
-				tarval_sub(tv_interval, tv_one);
-			}
-
-			assert(!tarval_is_null(tv_step));
-			// calculate loop iterations; add one iteration to count the first iteration
-			ir_tarval *tv_loop_count = (tarval_add(tarval_div(tv_interval, tv_step), tv_one));
-			long loop_count = get_tarval_long(tv_loop_count);
-			if (loop_count <= 0) {
-				return DONT_UNROLL;
-			}
+	scev_trip_count_t tc;
+	if (!scev_get_trip_count(loop, &tc) || tc.header != header || tc.count == NULL) {
+		return DONT_UNROLL;
+	}
+	if (!tarval_is_long(tc.count)) {
+		return DONT_UNROLL;
+	}
+	long const loop_count = get_tarval_long(tc.count);
+	if (loop_count <= 0) {
+		return DONT_UNROLL;
+	}
+	DB((dbg, LEVEL_3, "\tinit: %+F, step: %T, limit: %+F, loop count: %ld\n", tc.iv.init, tc.step, tc.limit, loop_count));
 
-#ifdef DEBUG_libfirm
-			long limit = get_tarval_long(tv_limit);
-			long step = get_tarval_long(tv_step);
-			long init = get_tarval_long(tv_init);
-			DB((dbg, LEVEL_3 , "\tinit: %ld, step: %ld, limit: %ld, loop count: %ld\n", init, step, limit, loop_count));
-#endif
-			factor = find_optimal_factor((unsigned long) loop_count, max);
-			if (factor == (unsigned long) loop_count) {
-				*fully_unroll = true;
-			}
-			break;
-		}
+	unsigned const factor = find_optimal_factor((unsigned long) loop_count, max);
+	if (factor == (unsigned long) loop_count) {
+		*fully_unroll = true;
 	}
 	return factor;
 }
@@ -558,7 +444,7 @@ static bool unroll_loop(ir_loop *const loop, unsigned factor)
 	DB((dbg, LEVEL_4, "\tidentified loop header %+F\n", header));
 
 	bool fully_unroll = false;
-	factor = find_suitable_factor(header, factor, &fully_unroll);
+	factor = find_suitable_factor(loop, header, factor, &fully_unroll);
 	if (factor < 1 || (factor == 1 && !fully_unroll)) {
 		return false;
 	}
@@ -0,0 +1,386 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Loop versioning guarded by a runtime trip count check
+ *
+ * An innermost loop with a symbolic trip count is preceded by a fast version
+ * which executes @c factor iterations per exit test:
+ *
+ *   E:   if (init rel limit) goto G; else goto R;
+ *   G:   count = trip count; limit' = limit - (factor-1) * step;
+ *        if (count >= factor) goto H_0; else goto R;
+ *   H_0: fast loop, factor copies of the body, only the first one tests
+ *        the loop exit and uses limit' instead of limit, exits to R
+ *   R:   Phis merging the values of the header Phis
+ *   H:   original loop, runs the remaining iterations
+ *
+ * The guard ensures that limit' does not wrap around, so the fast loop only
+ * enters an iteration if all @c factor iterations would have been executed by
+ * the original loop as well.  Hence the induction variable passes the exit
+ * test in every copy of the body and compares of it against the limit, like
+ * bounds checks, are folded there.
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "irnodemap.h"
+#include "iroptimize.h"
+#include "irouts_t.h"
+#include "pset_new.h"
+#include "scalar_evolution.h"
+#include "tv.h"
+#include "util.h"
+#include "xmalloc.h"
+#include <assert.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+typedef struct version_env_t {
+	scev_trip_count_t tc;
+	ir_loop          *loop;
+	unsigned          factor;
+	int               entry_idx;  /**< header pred entering the loop */
+	int               back_idx;   /**< header pred of the back edge */
+	ir_node         **nodes;      /**< blocks and nodes of the loop */
+	ir_nodemap       *copies;     /**< original to copy for each version */
+} version_env_t;
+
+static bool is_loop_node(version_env_t const *const env, ir_node const *node)
+{
+	if (!is_Block(node))
+		node = get_nodes_block(node);
+	return scev_block_in_loop(node, env->loop);
+}
+
+static bool is_header_phi(version_env_t const *const env, ir_node const *node)
+{
+	return is_Phi(node) && get_nodes_block(node) == env->tc.header;
+}
+
+/**
+ * Returns the result of @p node in every copy of the fast loop if it is a
+ * compare of the induction variable against the limit outside of the header,
+ * which is decided by the exit test, or NULL otherwise.
+ */
+static ir_tarval *get_proven_cmp(version_env_t const *const env,
+                                 ir_node const *const node)
+{
+	scev_trip_count_t const *const tc = &env->tc;
+	if (!is_Cmp(node) || get_nodes_block(node) == tc->header)
+		return NULL;
+
+	ir_node const *const left     = get_Cmp_left(node);
+	ir_node const *const right    = get_Cmp_right(node);
+	ir_relation          relation = get_Cmp_relation(node);
+	if (left == tc->limit && right == tc->iv.phi)
+		relation = get_inversed_relation(relation);
+	else if (left != tc->iv.phi || right != tc->limit)
+		return NULL;
+
+	if ((tc->relation & ~relation) == ir_relation_false)
+		return tarval_b_true;
+	if ((tc->relation & relation) == ir_relation_false)
+		return tarval_b_false;
+	return NULL;
+}
+
+/**
+ * Returns the value of @p node in copy @p j of the loop body.  The header
+ * Phis of all but the first copy are replaced by the back edge values of the
+ * preceding copy.
+ */
+static ir_node *get_copy(version_env_t const *const env, ir_node *const node,
+                         unsigned const j)
+{
+	if (!is_loop_node(env, node))
+		return node;
+	if (j > 0 && is_header_phi(env, node))
+		return get_copy(env, get_Phi_pred(node, env->back_idx), j - 1);
+	ir_node *const copy = ir_nodemap_get(ir_node, &env->copies[j], node);
+	assert(copy != NULL);
+	return copy;
+}
+
+static size_t count_nodes(ir_loop const *const loop)
+{
+	size_t       n_nodes    = 0;
+	size_t const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind == k_ir_node)
+			n_nodes += get_irn_n_outs(element.node);
+	}
+	return n_nodes;
+}
+
+/**
+ * Checks that control flow leaves @p loop only through the exit of the
+ * header and collects the nodes of the loop.
+ */
+static bool collect_loop_nodes(version_env_t *const env)
+{
+	ir_loop const *const loop       = env->loop;
+	size_t         const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind != k_ir_node)
+			return false;
+
+		ir_node *const block = element.node;
+		ARR_APP1(ir_node*, env->nodes, block);
+		for (unsigned o = 0, n_outs = get_irn_n_outs(block); o < n_outs; ++o) {
+			ir_node *const node = get_irn_out(block, o);
+			if (get_nodes_block(node) != block)
+				continue;
+			ARR_APP1(ir_node*, env->nodes, node);
+
+			if (get_irn_mode(node) != mode_X || node == env->tc.exit)
+				continue;
+			for (unsigned s = 0, n_succs = get_irn_n_outs(node); s < n_succs; ++s) {
+				ir_node *const succ = get_irn_out(node, s);
+				if (!is_Block(succ) || !scev_block_in_loop(succ, loop))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool is_candidate(version_env_t *const env, unsigned const maxsize)
+{
+	scev_trip_count_t *const tc = &env->tc;
+	if (count_nodes(env->loop) > maxsize)
+		return false;
+	if (!scev_get_trip_count(env->loop, tc) || tc->count != NULL)
+		return false;
+
+	ir_node *const header = tc->header;
+	if (get_Block_n_cfgpreds(header) != 2 || get_nodes_block(tc->cmp) != header)
+		return false;
+	env->entry_idx = scev_block_in_loop(get_Block_cfgpred_block(header, 0), env->loop) ? 1 : 0;
+	env->back_idx  = 1 - env->entry_idx;
+	if (!scev_block_in_loop(get_Block_cfgpred_block(header, env->back_idx), env->loop))
+		return false;
+
+	/* (factor - 1) * step must be representable to compute the guard. */
+	ir_mode   *const umode    = find_unsigned_mode(get_irn_mode(tc->limit));
+	ir_tarval *const abs_step = tarval_is_negative(tc->step) ? tarval_neg(tc->step) : tc->step;
+	ir_tarval *const u_step   = tarval_convert_to(abs_step, umode);
+	ir_tarval *const u_n      = new_tarval_from_long(env->factor - 1, umode);
+	ir_tarval *const distance = tarval_mul(u_n, u_step);
+	if (tarval_is_negative(abs_step) || tarval_div(distance, u_step) != u_n)
+		return false;
+
+	return collect_loop_nodes(env);
+}
+
+/**
+ * Versions the loop described by @p env and returns the header of the fast
+ * loop.
+ */
+static ir_node *version_loop(version_env_t *const env)
+{
+	scev_trip_count_t const *const tc        = &env->tc;
+	ir_node                 *const header    = tc->header;
+	ir_graph                *const irg       = get_irn_irg(header);
+	unsigned                 const factor    = env->factor;
+	int                      const entry_idx = env->entry_idx;
+	int                      const back_idx  = env->back_idx;
+	size_t                   const n_nodes   = ARR_LEN(env->nodes);
+
+	/* Guard blocks on the entry edge: the loop is entered at all and runs
+	 * for at least factor iterations. */
+	ir_node   *const limit      = tc->limit;
+	ir_node   *const entry      = get_Block_cfgpred(header, entry_idx);
+	ir_node   *const enter      = new_r_Block(irg, 1, &entry);
+	ir_node   *const enter_cmp  = new_r_Cmp(enter, tc->iv.init, limit, tc->relation);
+	ir_node   *const enter_cond = new_r_Cond(enter, enter_cmp);
+	ir_node   *const to_guard   = new_r_Proj(enter_cond, mode_X, pn_Cond_true);
+	ir_node   *const skip       = new_r_Proj(enter_cond, mode_X, pn_Cond_false);
+	ir_node   *const guard      = new_r_Block(irg, 1, &to_guard);
+	ir_node   *const count      = scev_build_trip_count(tc, guard);
+	ir_node   *const c_factor   = new_r_Const_long(irg, get_irn_mode(count), factor);
+	ir_node   *const enough     = new_r_Cmp(guard, count, c_factor, ir_relation_greater_equal);
+	ir_node   *const guard_cond = new_r_Cond(guard, enough);
+	ir_node   *const to_fast    = new_r_Proj(guard_cond, mode_X, pn_Cond_true);
+	ir_node   *const to_rest    = new_r_Proj(guard_cond, mode_X, pn_Cond_false);
+	ir_mode   *const mode       = get_irn_mode(limit);
+	ir_tarval *const tv_n       = new_tarval_from_long(factor - 1, mode);
+	ir_node   *const distance   = new_r_Const(irg, tarval_mul(tv_n, tc->step));
+	ir_node   *const fast_limit = new_r_Sub(guard, limit, distance);
+
+	/* Create the copies of the loop body. */
+	env->copies = XMALLOCN(ir_nodemap, factor);
+	for (unsigned j = 0; j < factor; ++j) {
+		ir_nodemap *const map = &env->copies[j];
+		ir_nodemap_init(map, irg);
+		for (size_t i = 0; i < n_nodes; ++i) {
+			ir_node *const node = env->nodes[i];
+			if (is_Block(node))
+				ir_nodemap_insert(map, node, exact_copy(node));
+		}
+		for (size_t i = 0; i < n_nodes; ++i) {
+			ir_node *const node = env->nodes[i];
+			if (is_Block(node))
+				continue;
+			if (j > 0) {
+				if (is_header_phi(env, node))
+					continue;
+				/* Only the first copy tests for the loop exit. */
+				if (node == tc->stay) {
+					ir_node *const block = ir_nodemap_get(ir_node, map, header);
+					ir_nodemap_insert(map, node, new_r_Jmp(block));
+					continue;
+				}
+				if (node == tc->exit || (is_Cond(node) && get_nodes_block(node) == header))
+					continue;
+			}
+			ir_tarval *const proven = get_proven_cmp(env, node);
+			if (proven != NULL) {
+				ir_nodemap_insert(map, node, new_r_Const(irg, proven));
+				continue;
+			}
+			ir_nodemap_insert(map, node, exact_copy(node));
+		}
+	}
+
+	/* Rewire the copies. */
+	for (unsigned j = 0; j < factor; ++j) {
+		ir_nodemap const *const map = &env->copies[j];
+		for (size_t i = 0; i < n_nodes; ++i) {
+			ir_node *const node = env->nodes[i];
+			ir_node *const copy = ir_nodemap_get(ir_node, map, node);
+			if (copy == NULL || (j > 0 && node == tc->stay)
+			    || get_proven_cmp(env, node) != NULL)
+				continue;
+
+			if (node == header) {
+				ir_node *const back = get_Block_cfgpred(header, back_idx);
+				if (j == 0) {
+					set_Block_cfgpred(copy, entry_idx, to_fast);
+					set_Block_cfgpred(copy, back_idx, get_copy(env, back, factor - 1));
+				} else {
+					ir_node *const in[] = { get_copy(env, back, j - 1) };
+					set_irn_in(copy, ARRAY_SIZE(in), in);
+				}
+				continue;
+			}
+			if (is_header_phi(env, node)) {
+				assert(j == 0);
+				ir_node *const back = get_Phi_pred(node, back_idx);
+				set_nodes_block(copy, get_copy(env, header, 0));
+				set_Phi_pred(copy, back_idx, get_copy(env, back, factor - 1));
+				if (get_Phi_loop(copy))
+					add_End_keepalive(get_irg_end(irg), copy);
+				continue;
+			}
+
+			if (!is_Block(node))
+				set_nodes_block(copy, get_copy(env, get_nodes_block(node), j));
+			foreach_irn_in(node, n, pred) {
+				set_irn_n(copy, n, get_copy(env, pred, j));
+			}
+			if (j == 0 && node == tc->cmp) {
+				if (get_Cmp_left(node) == limit) {
+					set_Cmp_left(copy, fast_limit);
+				} else {
+					set_Cmp_right(copy, fast_limit);
+				}
+			}
+		}
+	}
+
+	/* The original loop runs the remaining iterations. */
+	ir_node *const rest_in[] = { skip, to_rest, get_copy(env, tc->exit, 0) };
+	ir_node *const rest      = new_r_Block(irg, ARRAY_SIZE(rest_in), rest_in);
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const phi = env->nodes[i];
+		if (!is_header_phi(env, phi))
+			continue;
+		ir_node *const init      = get_Phi_pred(phi, entry_idx);
+		ir_node *const phi_in[]  = { init, init, get_copy(env, phi, 0) };
+		ir_node *const rest_phi  = new_r_Phi(rest, ARRAY_SIZE(phi_in), phi_in, get_irn_mode(phi));
+		set_Phi_pred(phi, entry_idx, rest_phi);
+	}
+	set_Block_cfgpred(header, entry_idx, new_r_Jmp(rest));
+
+	ir_node *const fast_header = get_copy(env, header, 0);
+	for (unsigned j = 0; j < factor; ++j)
+		ir_nodemap_destroy(&env->copies[j]);
+	free(env->copies);
+	env->copies = NULL;
+
+	DB((dbg, LEVEL_2, "versioned %+F with factor %u\n", env->loop, factor));
+	return fast_header;
+}
+
+/**
+ * Returns the first innermost loop below @p loop that can be versioned.
+ */
+static bool find_candidate(version_env_t *const env, ir_loop *const loop,
+                           pset_new_t *const done, unsigned const maxsize)
+{
+	bool   innermost  = true;
+	size_t n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind == k_ir_loop) {
+			innermost = false;
+			if (find_candidate(env, element.son, done, maxsize))
+				return true;
+		}
+	}
+	if (!innermost || get_loop_outer_loop(loop) == loop)
+		return false;
+
+	ir_node *const header = scev_get_loop_header(loop);
+	if (header == NULL || pset_new_contains(done, header))
+		return false;
+	pset_new_insert(done, header);
+
+	env->loop = loop;
+	ARR_SHRINKLEN(env->nodes, 0);
+	return is_candidate(env, maxsize);
+}
+
+void version_loops(ir_graph *const irg, unsigned const factor,
+                   unsigned const maxsize)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.loop-versioning");
+	if (factor < 2)
+		return;
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_BADS);
+
+	version_env_t env = {
+		.factor = factor,
+		.nodes  = NEW_ARR_F(ir_node*, 0),
+	};
+
+	pset_new_t done;
+	pset_new_init(&done);
+	bool changed = false;
+	for (;;) {
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+		if (!find_candidate(&env, get_irg_loop(irg), &done, maxsize))
+			break;
+		ir_node *const fast_header = version_loop(&env);
+		pset_new_insert(&done, fast_header);
+		changed = true;
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_NONE);
+	}
+	pset_new_destroy(&done);
+	DEL_ARR_F(env.nodes);
+
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
@@ -0,0 +1,853 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Identical code folding: merges functions with identical bodies.
+ *
+ * Every graph gets a structural hash computed in a canonical walk order.
+ * Graphs with the same hash are compared with an exact isomorphism check.
+ * A function that is identical to another one becomes an alias of it (or a
+ * thunk calling it if its address may be compared). Functions differing
+ * only in a few numeric constants are merged into one body taking the
+ * constants as additional parameters, the originals become thunks calling
+ * that body.
+ */
+#include "array.h"
+#include "debug.h"
+#include "entity_t.h"
+#include "hashptr.h"
+#include "ircons.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irprog_t.h"
+#include "panic.h"
+#include "tv.h"
+#include "type_t.h"
+#include "util.h"
+#include "xmalloc.h"
+
+#include <stdlib.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Estimated machine code bytes per instruction node. */
+#define MERGE_BYTES_PER_NODE 4
+/** Estimated machine code bytes of a thunk without its arguments. */
+#define MERGE_THUNK_BYTES    8
+/** Maximum number of constants turned into parameters of a merged body. */
+#define MERGE_MAX_PARAMS     4
+
+/** A Const of the leader graph and the value a merged function uses. */
+typedef struct const_diff_t {
+	ir_node   *node; /**< the Const node in the leader graph */
+	ir_tarval *tv;   /**< the value in the other function */
+} const_diff_t;
+
+typedef struct func_t func_t;
+struct func_t {
+	ir_entity    *entity;
+	ir_graph     *irg;
+	unsigned      hash;
+	size_t        size;      /**< estimated code size in bytes */
+	bool          escapes;   /**< address used other than as call target */
+	bool          done;      /**< already folded or used as a leader */
+	func_t       *redirect;  /**< function direct calls are redirected to */
+	const_diff_t *diffs;     /**< constants differing from the leader */
+};
+
+typedef struct hash_env_t {
+	unsigned hash;
+	unsigned n_nodes;
+	size_t   n_insns;
+} hash_env_t;
+
+static ir_graph *get_func_irg(ir_entity *const entity)
+{
+	return get_entity_linktime_irg(entity);
+}
+
+static func_t *get_entity_func(ir_entity *const entity)
+{
+	if (!entity_visited(entity))
+		return NULL;
+	return (func_t*)get_entity_link(entity);
+}
+
+static bool is_frame_entity(ir_node const *const node, ir_entity *const entity)
+{
+	return get_entity_owner(entity) == get_irg_frame_type(get_irn_irg(node));
+}
+
+static bool is_code_node(ir_node const *const node)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Anchor:
+	case iro_Bad:
+	case iro_Block:
+	case iro_End:
+	case iro_NoMem:
+	case iro_Phi:
+	case iro_Pin:
+	case iro_Proj:
+	case iro_Start:
+	case iro_Sync:
+	case iro_Tuple:
+	case iro_Unknown:
+		return false;
+	default:
+		return !is_irn_constlike(node);
+	}
+}
+
+static void number_node(ir_node *const node, void *const data)
+{
+	hash_env_t *const env = (hash_env_t*)data;
+	set_irn_link(node, INT_TO_PTR(env->n_nodes++));
+}
+
+static unsigned hash_input(ir_node const *const pred)
+{
+	return PTR_TO_INT(get_irn_link(pred));
+}
+
+/**
+ * Hashes a node. Constant values are left out, so functions differing only
+ * in constants end up in the same bucket.
+ */
+static void hash_node(ir_node *const node, void *const data)
+{
+	hash_env_t *const env = (hash_env_t*)data;
+
+	unsigned h = hash_combine(get_irn_opcode(node), hash_ptr(get_irn_mode(node)));
+	h = hash_combine(h, get_irn_arity(node));
+	if (!is_Block(node))
+		h = hash_combine(h, hash_input(get_nodes_block(node)));
+	foreach_irn_in(node, i, pred) {
+		h = hash_combine(h, hash_input(pred));
+	}
+
+	switch (get_irn_opcode(node)) {
+	case iro_Proj:
+		h = hash_combine(h, get_Proj_num(node));
+		break;
+	case iro_Cmp:
+		h = hash_combine(h, get_Cmp_relation(node));
+		break;
+	case iro_Address:
+	case iro_Offset:
+		h = hash_combine(h, hash_ptr(get_irn_entity_attr(node)));
+		break;
+	case iro_Member: {
+		ir_entity *const entity = get_Member_entity(node);
+		if (!is_frame_entity(node, entity))
+			h = hash_combine(h, hash_ptr(entity));
+		break;
+	}
+	default:
+		break;
+	}
+
+	env->hash = hash_combine(env->hash, h);
+	if (is_code_node(node))
+		++env->n_insns;
+}
+
+static void hash_graph(func_t *const func)
+{
+	ir_graph *const irg = func->irg;
+	hash_env_t env = { .hash = 0, .n_nodes = 0, .n_insns = 0 };
+
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+	irg_walk_graph(irg, number_node, hash_node, &env);
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+
+	func->hash = hash_combine(env.hash, env.n_nodes);
+	func->size = env.n_insns * MERGE_BYTES_PER_NODE;
+}
+
+static bool types_compatible(ir_type *const a, ir_type *const b)
+{
+	if (a == b)
+		return true;
+	if (is_Array_type(a) && is_Array_type(b))
+		return get_array_size(a) == get_array_size(b)
+		    && types_compatible(get_array_element_type(a),
+		                        get_array_element_type(b));
+	ir_mode *const mode = get_type_mode(a);
+	return mode != NULL && mode == get_type_mode(b);
+}
+
+static bool method_types_compatible(ir_type *const a, ir_type *const b)
+{
+	size_t const n_params = get_method_n_params(a);
+	size_t const n_ress   = get_method_n_ress(a);
+	if (n_params != get_method_n_params(b) || n_ress != get_method_n_ress(b)
+	 || is_method_variadic(a) != is_method_variadic(b)
+	 || get_method_calling_convention(a) != get_method_calling_convention(b)
+	 || get_method_additional_properties(a)
+	    != get_method_additional_properties(b))
+		return false;
+	for (size_t i = 0; i < n_params; ++i) {
+		if (!types_compatible(get_method_param_type(a, i),
+		                      get_method_param_type(b, i)))
+			return false;
+	}
+	for (size_t i = 0; i < n_ress; ++i) {
+		if (!types_compatible(get_method_res_type(a, i),
+		                      get_method_res_type(b, i)))
+			return false;
+	}
+	return true;
+}
+
+/** A thunk can only forward parameters and results living in registers. */
+static bool can_build_thunk(ir_type *const mtp)
+{
+	if (is_method_variadic(mtp))
+		return false;
+	for (size_t i = 0, n = get_method_n_params(mtp); i < n; ++i) {
+		if (get_type_mode(get_method_param_type(mtp, i)) == NULL)
+			return false;
+	}
+	for (size_t i = 0, n = get_method_n_ress(mtp); i < n; ++i) {
+		if (get_type_mode(get_method_res_type(mtp, i)) == NULL)
+			return false;
+	}
+	return true;
+}
+
+static size_t get_thunk_size(ir_type *const mtp, size_t const n_extra)
+{
+	return (get_method_n_params(mtp) + n_extra) * MERGE_BYTES_PER_NODE
+	     + MERGE_THUNK_BYTES;
+}
+
+static void clear_frame_links(ir_graph *const irg)
+{
+	ir_type *const frame = get_irg_frame_type(irg);
+	for (size_t i = 0, n = get_compound_n_members(frame); i < n; ++i)
+		set_entity_link(get_compound_member(frame, i), NULL);
+}
+
+/** Frame entities are matched up one to one while comparing. */
+static bool frame_entities_equal(ir_entity *const a, ir_entity *const b)
+{
+	ir_entity *const mapped = (ir_entity*)get_entity_link(a);
+	if (mapped != NULL)
+		return mapped == b;
+	if (get_entity_link(b) != NULL)
+		return false;
+
+	if (get_entity_kind(a) != get_entity_kind(b))
+		return false;
+	if (is_parameter_entity(a)
+	 && get_entity_parameter_number(a) != get_entity_parameter_number(b))
+		return false;
+	ir_type *const type_a = get_entity_type(a);
+	ir_type *const type_b = get_entity_type(b);
+	if (!types_compatible(type_a, type_b)
+	 || get_type_size(type_a) != get_type_size(type_b))
+		return false;
+	if (get_entity_alignment(a) != get_entity_alignment(b))
+		return false;
+
+	set_entity_link(a, b);
+	set_entity_link(b, a);
+	return true;
+}
+
+static bool switch_tables_equal(ir_node const *const a, ir_node const *const b)
+{
+	if (get_Switch_n_outs(a) != get_Switch_n_outs(b))
+		return false;
+	ir_switch_table const *const ta = get_Switch_table(a);
+	ir_switch_table const *const tb = get_Switch_table(b);
+	size_t const n_entries = ir_switch_table_get_n_entries(ta);
+	if (n_entries != ir_switch_table_get_n_entries(tb))
+		return false;
+	for (size_t i = 0; i < n_entries; ++i) {
+		if (ir_switch_table_get_min(ta, i) != ir_switch_table_get_min(tb, i)
+		 || ir_switch_table_get_max(ta, i) != ir_switch_table_get_max(tb, i)
+		 || ir_switch_table_get_pn(ta, i)  != ir_switch_table_get_pn(tb, i))
+			return false;
+	}
+	return true;
+}
+
+static bool node_attrs_equal(ir_node const *const a, ir_node const *const b)
+{
+	switch (get_irn_opcode(a)) {
+	case iro_Block:
+		return get_Block_entity(a) == NULL && get_Block_entity(b) == NULL;
+	case iro_Cond:
+		return get_Cond_jmp_pred(a) == get_Cond_jmp_pred(b);
+	case iro_Member: {
+		ir_entity *const ea = get_Member_entity(a);
+		ir_entity *const eb = get_Member_entity(b);
+		bool const frame_a = is_frame_entity(a, ea);
+		if (frame_a != is_frame_entity(b, eb))
+			return false;
+		return frame_a ? frame_entities_equal(ea, eb) : ea == eb;
+	}
+	case iro_Phi:
+		return get_Phi_loop(a) == get_Phi_loop(b);
+	case iro_Switch:
+		return switch_tables_equal(a, b);
+	case iro_Unknown:
+		return true;
+	default:
+		return get_irn_op(a)->ops.attrs_equal(a, b);
+	}
+}
+
+static bool map_node(ir_node *const a, ir_node *const b, ir_node ***worklist)
+{
+	if (irn_visited(a))
+		return get_irn_link(a) == b;
+	if (irn_visited(b))
+		return false;
+	mark_irn_visited(a);
+	mark_irn_visited(b);
+	set_irn_link(a, b);
+	set_irn_link(b, a);
+	ARR_APP1(ir_node*, *worklist, a);
+	return true;
+}
+
+static bool consts_differ(ir_node const *const a, ir_node const *const b)
+{
+	return is_Const(a) && get_Const_tarval(a) != get_Const_tarval(b);
+}
+
+static bool compare_nodes(ir_node *const a, ir_node *const b,
+                          const_diff_t **const diffs, ir_node ***worklist)
+{
+	if (get_irn_op(a) != get_irn_op(b) || get_irn_mode(a) != get_irn_mode(b)
+	 || get_irn_arity(a) != get_irn_arity(b)
+	 || get_irn_pinned(a) != get_irn_pinned(b))
+		return false;
+
+	if (consts_differ(a, b)) {
+		if (diffs == NULL || !mode_is_num(get_irn_mode(a)))
+			return false;
+		const_diff_t const diff = { .node = a, .tv = get_Const_tarval(b) };
+		ARR_APP1(const_diff_t, *diffs, diff);
+	} else if (!node_attrs_equal(a, b)) {
+		return false;
+	}
+
+	if (!is_Block(a)
+	 && !map_node(get_nodes_block(a), get_nodes_block(b), worklist))
+		return false;
+	foreach_irn_in(a, i, pred_a) {
+		ir_node *const pred_b = get_irn_n(b, i);
+		/* asm immediates and builtin operands like prefetch hints or frame
+		 * levels must stay constants */
+		if ((is_ASM(a) || is_Builtin(a)) && consts_differ(pred_a, pred_b))
+			return false;
+		if (!map_node(pred_a, pred_b, worklist))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Checks whether the graphs of @p leader and @p other are isomorphic.
+ * If @p diffs is not NULL, Const nodes with different numeric values are
+ * accepted and recorded there.
+ */
+static bool graphs_isomorphic(func_t const *const leader,
+                              func_t const *const other,
+                              const_diff_t **const diffs)
+{
+	ir_graph *const irg_a = leader->irg;
+	ir_graph *const irg_b = other->irg;
+	if (get_entity_additional_properties(leader->entity)
+	    != get_entity_additional_properties(other->entity)
+	 || !method_types_compatible(get_entity_type(leader->entity),
+	                             get_entity_type(other->entity)))
+		return false;
+
+	clear_frame_links(irg_a);
+	clear_frame_links(irg_b);
+	ir_reserve_resources(irg_a, IR_RESOURCE_IRN_LINK | IR_RESOURCE_IRN_VISITED);
+	ir_reserve_resources(irg_b, IR_RESOURCE_IRN_LINK | IR_RESOURCE_IRN_VISITED);
+	inc_irg_visited(irg_a);
+	inc_irg_visited(irg_b);
+
+	ir_node **worklist = NEW_ARR_F(ir_node*, 0);
+	bool      res      = map_node(get_irg_end(irg_a), get_irg_end(irg_b),
+	                              &worklist);
+	while (res && ARR_LEN(worklist) != 0) {
+		size_t   const last = ARR_LEN(worklist) - 1;
+		ir_node *const a    = worklist[last];
+		ir_node *const b    = (ir_node*)get_irn_link(a);
+		ARR_SHRINKLEN(worklist, last);
+		res = compare_nodes(a, b, diffs, &worklist);
+	}
+	DEL_ARR_F(worklist);
+
+	ir_free_resources(irg_b, IR_RESOURCE_IRN_LINK | IR_RESOURCE_IRN_VISITED);
+	ir_free_resources(irg_a, IR_RESOURCE_IRN_LINK | IR_RESOURCE_IRN_VISITED);
+	return res;
+}
+
+static void mark_escaping_address(ir_node *const node)
+{
+	if (!is_Address(node))
+		return;
+	func_t *const func = get_entity_func(get_Address_entity(node));
+	if (func != NULL)
+		func->escapes = true;
+}
+
+static void find_escapes_walker(ir_node *const node, void *const data)
+{
+	(void)data;
+	foreach_irn_in(node, i, pred) {
+		if (is_Call(node) && i == n_Call_ptr)
+			continue;
+		mark_escaping_address(pred);
+	}
+}
+
+static void find_escapes_in_const(ir_node *const node)
+{
+	mark_escaping_address(node);
+	foreach_irn_in(node, i, pred) {
+		find_escapes_in_const(pred);
+	}
+}
+
+static void find_escapes_in_initializer(ir_initializer_t *const initializer)
+{
+	switch (get_initializer_kind(initializer)) {
+	case IR_INITIALIZER_CONST:
+		find_escapes_in_const(get_initializer_const_value(initializer));
+		return;
+	case IR_INITIALIZER_TARVAL:
+	case IR_INITIALIZER_NULL:
+		return;
+	case IR_INITIALIZER_COMPOUND:
+		for (size_t i = 0, n = get_initializer_compound_n_entries(initializer);
+		     i < n; ++i) {
+			find_escapes_in_initializer(
+				get_initializer_compound_value(initializer, i));
+		}
+		return;
+	}
+	panic("invalid initializer found");
+}
+
+static void find_escapes(void)
+{
+	foreach_irp_irg(i, irg) {
+		irg_walk_graph(irg, NULL, find_escapes_walker, NULL);
+	}
+	for (ir_segment_t s = IR_SEGMENT_FIRST; s <= IR_SEGMENT_LAST; ++s) {
+		ir_type *const segment = get_segment_type(s);
+		for (size_t i = 0, n = get_compound_n_members(segment); i < n; ++i) {
+			ir_entity *const entity = get_compound_member(segment, i);
+			if (get_entity_kind(entity) != IR_ENTITY_NORMAL)
+				continue;
+			ir_initializer_t *const init = get_entity_initializer(entity);
+			if (init != NULL)
+				find_escapes_in_initializer(init);
+		}
+	}
+}
+
+static bool address_matters(func_t const *const func)
+{
+	ir_entity *const entity = func->entity;
+	if (get_entity_linkage(entity) & IR_LINKAGE_NO_IDENTITY)
+		return false;
+	return func->escapes || entity_is_externally_visible(entity);
+}
+
+/**
+ * Replaces the graph of @p entity by a thunk calling @p target with the
+ * parameters of @p entity followed by the constants @p extra.
+ */
+static void build_thunk(ir_entity *const entity, ir_entity *const target,
+                        ir_tarval *const *const extra, size_t const n_extra)
+{
+	ir_graph *const old_irg = get_entity_irg(entity);
+	if (old_irg != NULL)
+		free_ir_graph(old_irg);
+
+	ir_type  *const mtp      = get_entity_type(entity);
+	size_t    const n_params = get_method_n_params(mtp);
+	size_t    const n_ress   = get_method_n_ress(mtp);
+	ir_graph *const irg      = new_ir_graph(entity, 0);
+	ir_node  *const block    = get_r_cur_block(irg);
+	ir_node  *const args     = get_irg_args(irg);
+	ir_node **const in       = ALLOCAN(ir_node*, n_params + n_extra);
+	for (size_t i = 0; i < n_params; ++i) {
+		ir_mode *const mode = get_type_mode(get_method_param_type(mtp, i));
+		in[i] = new_r_Proj(args, mode, i);
+	}
+	for (size_t i = 0; i < n_extra; ++i)
+		in[n_params + i] = new_r_Const(irg, extra[i]);
+
+	ir_node  *const callee   = new_r_Address(irg, target);
+	ir_node  *const mem      = get_irg_initial_mem(irg);
+	ir_type  *const call_tp  = get_entity_type(target);
+	ir_node  *const call     = new_r_Call(block, mem, callee, n_params + n_extra,
+	                                      in, call_tp);
+	ir_node  *const call_mem = new_r_Proj(call, mode_M, pn_Call_M);
+	ir_node  *const call_res = new_r_Proj(call, mode_T, pn_Call_T_result);
+	ir_node **const res      = ALLOCAN(ir_node*, n_ress);
+	for (size_t i = 0; i < n_ress; ++i) {
+		ir_mode *const mode = get_type_mode(get_method_res_type(mtp, i));
+		res[i] = new_r_Proj(call_res, mode, i);
+	}
+	ir_node  *const ret      = new_r_Return(block, call_mem, n_ress, res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	irg_finalize_cons(irg);
+}
+
+/** Turns the method entity @p entity into an alias of @p target. */
+static void make_alias(ir_entity *const entity, ir_entity *const target)
+{
+	ir_graph *const irg = get_entity_irg(entity);
+	if (irg != NULL)
+		free_ir_graph(irg);
+
+	method_ent_attr *const attr = &entity->attr.mtd_attr;
+	if (attr->param_access != NULL)
+		DEL_ARR_F(attr->param_access);
+	if (attr->param_weight != NULL)
+		DEL_ARR_F(attr->param_weight);
+	entity->kind               = IR_ENTITY_ALIAS;
+	entity->attr.alias.aliased = target;
+}
+
+static size_t fold_identical(func_t *const leader, func_t *const dup)
+{
+	if (!address_matters(dup)) {
+		DB((dbg, LEVEL_1, "  %+F becomes an alias of %+F (%zu bytes)\n",
+		    dup->entity, leader->entity, dup->size));
+		make_alias(dup->entity, leader->entity);
+		dup->redirect = leader;
+		return dup->size;
+	}
+
+	ir_type *const mtp        = get_entity_type(dup->entity);
+	size_t   const thunk_size = get_thunk_size(mtp, 0);
+	if (!can_build_thunk(mtp) || thunk_size >= dup->size)
+		return 0;
+
+	DB((dbg, LEVEL_1, "  %+F becomes a thunk of %+F (%zu bytes)\n",
+	    dup->entity, leader->entity, dup->size - thunk_size));
+	build_thunk(dup->entity, leader->entity, NULL, 0);
+	dup->redirect = leader;
+	return dup->size - thunk_size;
+}
+
+static size_t find_param(ir_node *const *const params, ir_node *const node)
+{
+	for (size_t i = 0, n = ARR_LEN(params); i < n; ++i) {
+		if (params[i] == node)
+			return i;
+	}
+	return (size_t)-1;
+}
+
+/** Adds the constants of @p func to @p params, fails if there are too many. */
+static bool add_params(ir_node ***const params, func_t const *const func)
+{
+	size_t const n_old = ARR_LEN(*params);
+	for (size_t i = 0, n = ARR_LEN(func->diffs); i < n; ++i) {
+		ir_node *const node = func->diffs[i].node;
+		if (find_param(*params, node) == (size_t)-1)
+			ARR_APP1(ir_node*, *params, node);
+	}
+	if (ARR_LEN(*params) <= MERGE_MAX_PARAMS)
+		return true;
+	ARR_SHRINKLEN(*params, n_old);
+	return false;
+}
+
+/**
+ * Moves the graph of @p leader to a new entity taking the constants
+ * @p params as additional parameters and returns that entity.
+ */
+static ir_entity *create_merged_body(func_t *const leader,
+                                     ir_node *const *const params)
+{
+	ir_entity *const entity   = leader->entity;
+	ir_type   *const mtp      = get_entity_type(entity);
+	size_t     const n_params = get_method_n_params(mtp);
+	size_t     const n_ress   = get_method_n_ress(mtp);
+	size_t     const n_extra  = ARR_LEN(params);
+	ir_type   *const new_mtp
+		= new_type_method(n_params + n_extra, n_ress, false,
+		                  get_method_calling_convention(mtp),
+		                  get_method_additional_properties(mtp));
+	for (size_t i = 0; i < n_params; ++i)
+		set_method_param_type(new_mtp, i, get_method_param_type(mtp, i));
+	for (size_t i = 0; i < n_extra; ++i) {
+		ir_type *const type = get_type_for_mode(get_irn_mode(params[i]));
+		set_method_param_type(new_mtp, n_params + i, type);
+	}
+	for (size_t i = 0; i < n_ress; ++i)
+		set_method_res_type(new_mtp, i, get_method_res_type(mtp, i));
+
+	ident     *const name   = id_unique(get_entity_name(entity));
+	ir_entity *const merged = clone_entity(entity, name, get_entity_owner(entity));
+	set_entity_visibility(merged, ir_visibility_local);
+	set_entity_linkage(merged, IR_LINKAGE_CONSTANT);
+	set_entity_type(merged, new_mtp);
+
+	ir_graph *const irg = leader->irg;
+	set_entity_irg(entity, NULL);
+	set_irg_entity(irg, merged);
+	set_entity_irg(merged, irg);
+
+	ir_node *const args = get_irg_args(irg);
+	for (size_t i = 0; i < n_extra; ++i) {
+		ir_node *const param = params[i];
+		exchange(param, new_r_Proj(args, get_irn_mode(param), n_params + i));
+	}
+	confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_CONTROL_FLOW);
+	return merged;
+}
+
+/** Merges the near-identical functions @p members into @p leader. */
+static size_t merge_near_identical(func_t *const leader, func_t **const members)
+{
+	ir_type *const mtp = get_entity_type(leader->entity);
+	if (ARR_LEN(members) == 0 || !can_build_thunk(mtp))
+		return 0;
+
+	ir_node **params  = NEW_ARR_F(ir_node*, 0);
+	func_t  **merging = NEW_ARR_F(func_t*, 0);
+	for (size_t i = 0, n = ARR_LEN(members); i < n; ++i) {
+		if (add_params(&params, members[i]))
+			ARR_APP1(func_t*, merging, members[i]);
+	}
+
+	size_t const n_extra    = ARR_LEN(params);
+	size_t const thunk_size = get_thunk_size(mtp, n_extra);
+	size_t       removed    = 0;
+	for (size_t i = 0, n = ARR_LEN(merging); i < n; ++i)
+		removed += merging[i]->size;
+	size_t const added = (ARR_LEN(merging) + 1) * thunk_size;
+
+	size_t saved = 0;
+	if (removed > added) {
+		ir_tarval **const extra = ALLOCAN(ir_tarval*, n_extra);
+		for (size_t i = 0; i < n_extra; ++i)
+			extra[i] = get_Const_tarval(params[i]);
+
+		ir_entity *const merged = create_merged_body(leader, params);
+		DB((dbg, LEVEL_1, "  merging into %+F with %zu extra parameters\n",
+		    merged, n_extra));
+		build_thunk(leader->entity, merged, extra, n_extra);
+
+		for (size_t i = 0, n = ARR_LEN(merging); i < n; ++i) {
+			func_t *const member = merging[i];
+			for (size_t p = 0; p < n_extra; ++p)
+				extra[p] = NULL;
+			for (size_t d = 0, n_diffs = ARR_LEN(member->diffs); d < n_diffs; ++d) {
+				const_diff_t const *const diff = &member->diffs[d];
+				extra[find_param(params, diff->node)] = diff->tv;
+			}
+			for (size_t p = 0; p < n_extra; ++p) {
+				if (extra[p] == NULL)
+					extra[p] = get_Const_tarval(params[p]);
+			}
+			DB((dbg, LEVEL_1, "  %+F becomes a thunk of %+F\n",
+			    member->entity, merged));
+			build_thunk(member->entity, merged, extra, n_extra);
+			member->done = true;
+		}
+		saved = removed - added;
+	}
+
+	DEL_ARR_F(merging);
+	DEL_ARR_F(params);
+	return saved;
+}
+
+static bool diffs_equal(const_diff_t const *const a, const_diff_t const *const b)
+{
+	size_t const n = ARR_LEN(a);
+	if (n != ARR_LEN(b))
+		return false;
+	for (size_t i = 0; i < n; ++i) {
+		if (a[i].node != b[i].node || a[i].tv != b[i].tv)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Folds near-identical functions using the same constants into each other,
+ * leaves the remaining ones in @p near.
+ */
+static size_t fold_near_duplicates(func_t ***const near)
+{
+	size_t saved  = 0;
+	size_t n_kept = 0;
+	for (size_t i = 0, n = ARR_LEN(*near); i < n; ++i) {
+		func_t *const func  = (*near)[i];
+		func_t       *first = NULL;
+		for (size_t k = 0; k < n_kept; ++k) {
+			if (diffs_equal((*near)[k]->diffs, func->diffs)) {
+				first = (*near)[k];
+				break;
+			}
+		}
+		if (first != NULL) {
+			saved += fold_identical(first, func);
+			func->done = true;
+			DEL_ARR_F(func->diffs);
+			func->diffs = NULL;
+		} else {
+			(*near)[n_kept++] = func;
+		}
+	}
+	ARR_SHRINKLEN(*near, n_kept);
+	return saved;
+}
+
+/** Folds all functions in @p funcs, which have the same hash. */
+static size_t fold_bucket(func_t **const funcs, size_t const n_funcs)
+{
+	size_t saved = 0;
+	for (size_t l = 0; l < n_funcs; ++l) {
+		func_t *const leader = funcs[l];
+		if (leader->done)
+			continue;
+		leader->done = true;
+
+		func_t **identical = NEW_ARR_F(func_t*, 0);
+		func_t **near      = NEW_ARR_F(func_t*, 0);
+		for (size_t o = l + 1; o < n_funcs; ++o) {
+			func_t *const other = funcs[o];
+			if (other->done)
+				continue;
+			other->diffs = NEW_ARR_F(const_diff_t, 0);
+			if (!graphs_isomorphic(leader, other, &other->diffs)) {
+				DEL_ARR_F(other->diffs);
+				other->diffs = NULL;
+			} else if (ARR_LEN(other->diffs) == 0) {
+				ARR_APP1(func_t*, identical, other);
+				other->done = true;
+			} else {
+				ARR_APP1(func_t*, near, other);
+			}
+		}
+
+		/* fold identical functions first, merging moves the leader graph */
+		for (size_t i = 0, n = ARR_LEN(identical); i < n; ++i)
+			saved += fold_identical(leader, identical[i]);
+		saved += fold_near_duplicates(&near);
+		saved += merge_near_identical(leader, near);
+
+		for (size_t i = 0, n = ARR_LEN(near); i < n; ++i) {
+			func_t *const other = near[i];
+			DEL_ARR_F(other->diffs);
+			other->diffs = NULL;
+		}
+		for (size_t i = 0, n = ARR_LEN(identical); i < n; ++i)
+			DEL_ARR_F(identical[i]->diffs);
+		DEL_ARR_F(near);
+		DEL_ARR_F(identical);
+	}
+	return saved;
+}
+
+static void redirect_calls(ir_node *const node, void *const data)
+{
+	(void)data;
+	if (!is_Call(node))
+		return;
+	ir_entity *const callee = get_Call_callee(node);
+	if (callee == NULL)
+		return;
+	func_t *const func = get_entity_func(callee);
+	if (func == NULL || func->redirect == NULL)
+		return;
+	ir_graph *const irg = get_irn_irg(node);
+	set_Call_ptr(node, new_r_Address(irg, func->redirect->entity));
+}
+
+static bool is_candidate(ir_entity *const entity, ir_graph *const irg)
+{
+	if (irg == NULL || get_func_irg(entity) != irg
+	 || irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION))
+		return false;
+	ir_linkage const linkage = get_entity_linkage(entity);
+	return !(linkage & (IR_LINKAGE_WEAK | IR_LINKAGE_MERGE
+	                    | IR_LINKAGE_NO_CODEGEN));
+}
+
+static int cmp_func_hash(const void *a, const void *b)
+{
+	func_t const *const fa = *(func_t const**)a;
+	func_t const *const fb = *(func_t const**)b;
+	if (fa->hash != fb->hash)
+		return fa->hash < fb->hash ? -1 : 1;
+	return QSORT_CMP(get_entity_nr(fa->entity), get_entity_nr(fb->entity));
+}
+
+size_t merge_identical_functions(void)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.mergefunctions");
+
+	irp_reserve_resources(irp, IRP_RESOURCE_TYPE_VISITED
+	                         | IRP_RESOURCE_ENTITY_LINK);
+	inc_master_type_visited();
+
+	size_t   const n_irgs = get_irp_n_irgs();
+	func_t  *const all    = XMALLOCNZ(func_t, n_irgs);
+	func_t **const funcs  = XMALLOCN(func_t*, n_irgs);
+	size_t         n      = 0;
+	for (size_t i = 0; i < n_irgs; ++i) {
+		ir_graph  *const irg    = get_irp_irg(i);
+		ir_entity *const entity = get_irg_entity(irg);
+		if (!is_candidate(entity, irg))
+			continue;
+		func_t *const func = &all[n];
+		func->entity = entity;
+		func->irg    = irg;
+		funcs[n++]   = func;
+		mark_entity_visited(entity);
+		set_entity_link(entity, func);
+		hash_graph(func);
+	}
+	find_escapes();
+	qsort(funcs, n, sizeof(*funcs), cmp_func_hash);
+
+	size_t saved = 0;
+	for (size_t b = 0; b < n;) {
+		size_t e = b + 1;
+		while (e < n && funcs[e]->hash == funcs[b]->hash)
+			++e;
+		if (e - b > 1)
+			saved += fold_bucket(&funcs[b], e - b);
+		b = e;
+	}
+
+	if (saved > 0) {
+		foreach_irp_irg(i, irg) {
+			irg_walk_graph(irg, NULL, redirect_calls, NULL);
+		}
+	}
+	DB((dbg, LEVEL_1, "saved about %zu bytes\n", saved));
+
+	free(funcs);
+	free(all);
+	irp_free_resources(irp, IRP_RESOURCE_TYPE_VISITED
+	                      | IRP_RESOURCE_ENTITY_LINK);
+	return saved;
+}
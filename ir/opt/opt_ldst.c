@@ -718,6 +718,32 @@ static void update_Call_memop(memop_t *m)
 	}
 }
 
+/**
+ * Update a memop for a Builtin.
+ *
+ * @param m  the memop
+ */
+static void update_Builtin_memop(memop_t *m)
+{
+	ir_node *builtin = m->node;
+	/* Builtins not touching memory and relaxed atomic loads do not order
+	 * anything, all others (atomics, fences) invalidate the known values. */
+	if (is_irn_const_memory(builtin)) {
+		m->flags = 0;
+	} else {
+		m->flags = FLAG_KILL_ALL;
+	}
+
+	foreach_irn_out_r(builtin, i, proj) {
+		/* beware of keep edges */
+		if (is_End(proj))
+			continue;
+
+		if (get_Proj_num(proj) == pn_Builtin_M)
+			m->mem = proj;
+	}
+}
+
 /**
  * Update a memop for a Div/Mod.
  *
@@ -833,7 +859,8 @@ static void collect_memops(ir_node *irn, void *ctx)
 			break;
 
 		case iro_Builtin:
-			/* TODO: handle some builtins */
+			update_Builtin_memop(op);
+			break;
 		default:
 			/* unsupported operation */
 			op->flags = FLAG_KILL_ALL;
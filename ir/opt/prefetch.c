@@ -0,0 +1,203 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Software prefetch insertion for strided loads in loops
+ *
+ * Loads in innermost loops whose address advances by a constant stride per
+ * iteration get a prefetch for the address they will access a few iterations
+ * later.  The distance is chosen such that the prefetch is issued about
+ * @c latency cost units ahead, the cost of an iteration is estimated by the
+ * number of nodes in the loop.
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons.h"
+#include "irgraph_t.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irouts_t.h"
+#include "scalar_evolution.h"
+#include "tv.h"
+#include "util.h"
+
+/** Assumed size of a cache line in bytes. */
+#define PREFETCH_LINE_SIZE    64
+/** Maximum prefetch distance in iterations. */
+#define PREFETCH_MAX_DISTANCE 64
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+typedef struct prefetch_t {
+	ir_node   *load;
+	ir_node   *base;   /**< address without constant offset */
+	ir_tarval *stride; /**< address increment per iteration */
+	ir_tarval *offset; /**< distance of the prefetched address in bytes */
+} prefetch_t;
+
+typedef struct prefetch_env_t {
+	unsigned    latency;
+	ir_type    *type;       /**< method type of the prefetch builtin */
+	prefetch_t *prefetches; /**< ARR_F of loads to prefetch */
+	unsigned    n_inserted;
+} prefetch_env_t;
+
+static ir_node *skip_const_offset(ir_node *node)
+{
+	while (is_Add(node) && is_Const(get_Add_right(node)))
+		node = get_Add_left(node);
+	return node;
+}
+
+static size_t count_loop_nodes(ir_loop const *const loop)
+{
+	size_t       n_nodes    = 0;
+	size_t const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind != k_ir_node)
+			continue;
+		ir_node *const block = element.node;
+		for (unsigned o = 0, n_outs = get_irn_n_outs(block); o < n_outs; ++o) {
+			ir_node *const node = get_irn_out(block, o);
+			if (get_nodes_block(node) == block && !is_Proj(node) && !is_Phi(node))
+				++n_nodes;
+		}
+	}
+	return n_nodes;
+}
+
+/**
+ * Collects the strided loads of the innermost loop @p loop.
+ */
+static void collect_loads(prefetch_env_t *const env, ir_loop const *const loop)
+{
+	size_t const first      = ARR_LEN(env->prefetches);
+	size_t const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind != k_ir_node)
+			continue;
+
+		ir_node *const block = element.node;
+		for (unsigned o = 0, n_outs = get_irn_n_outs(block); o < n_outs; ++o) {
+			ir_node *const load = get_irn_out(block, o);
+			if (!is_Load(load) || get_nodes_block(load) != block
+			 || get_Load_volatility(load) == volatility_is_volatile)
+				continue;
+
+			ir_node   *const ptr  = get_Load_ptr(load);
+			ir_mode   *const mode = get_reference_offset_mode(get_irn_mode(ptr));
+			ir_tarval *stride;
+			if (!scev_get_stride(ptr, loop, mode, &stride) || tarval_is_null(stride))
+				continue;
+
+			/* Loads differing only by a constant offset share a prefetch. */
+			ir_node *const base = skip_const_offset(ptr);
+			bool           seen = false;
+			for (size_t p = first, n = ARR_LEN(env->prefetches); p < n; ++p) {
+				prefetch_t const *const other = &env->prefetches[p];
+				if (other->base == base && other->stride == stride) {
+					seen = true;
+					break;
+				}
+			}
+			if (seen)
+				continue;
+
+			prefetch_t const prefetch = { load, base, stride, NULL };
+			ARR_APP1(prefetch_t, env->prefetches, prefetch);
+		}
+	}
+	if (ARR_LEN(env->prefetches) == first)
+		return;
+
+	/* Prefetch far enough ahead to hide the latency, but at least one cache
+	 * line. */
+	size_t   const cost     = MAX(count_loop_nodes(loop), (size_t)1);
+	unsigned const distance = (env->latency + cost - 1) / cost;
+	for (size_t p = first, n = ARR_LEN(env->prefetches); p < n; ++p) {
+		prefetch_t *const prefetch = &env->prefetches[p];
+		ir_tarval  *const stride   = prefetch->stride;
+		ir_mode    *const mode     = get_tarval_mode(stride);
+		ir_tarval  *const abs      = tarval_is_negative(stride) ? tarval_neg(stride) : stride;
+		unsigned          dist     = distance;
+		if (tarval_is_long(abs) && get_tarval_long(abs) < PREFETCH_LINE_SIZE) {
+			long const line_dist = (PREFETCH_LINE_SIZE + get_tarval_long(abs) - 1) / get_tarval_long(abs);
+			dist = MAX(dist, (unsigned)line_dist);
+		}
+		dist = MIN(dist, PREFETCH_MAX_DISTANCE);
+		prefetch->offset = tarval_mul(stride, new_tarval_from_long(dist, mode));
+	}
+	DB((dbg, LEVEL_2, "%+F: %zu prefetches, distance %u\n", loop,
+	    ARR_LEN(env->prefetches) - first, distance));
+}
+
+static void collect_innermost_loops(prefetch_env_t *const env,
+                                    ir_loop const *const loop)
+{
+	bool         innermost  = true;
+	size_t const n_elements = get_loop_n_elements(loop);
+	for (size_t i = 0; i < n_elements; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind == k_ir_loop) {
+			innermost = false;
+			collect_innermost_loops(env, element.son);
+		}
+	}
+	if (innermost && get_loop_outer_loop(loop) != loop)
+		collect_loads(env, loop);
+}
+
+/**
+ * Inserts a prefetch of the address @p prefetch->offset bytes ahead of the
+ * load into the memory chain before the load.
+ */
+static void insert_prefetch(prefetch_env_t *const env,
+                            prefetch_t const *const prefetch)
+{
+	ir_node  *const load     = prefetch->load;
+	ir_graph *const irg      = get_irn_irg(load);
+	ir_node  *const block    = get_nodes_block(load);
+	dbg_info *const dbgi     = get_irn_dbg_info(load);
+	ir_node  *const ptr      = get_Load_ptr(load);
+	ir_node  *const offset   = new_r_Const(irg, prefetch->offset);
+	ir_node  *const addr     = new_rd_Add(dbgi, block, ptr, offset);
+	ir_node  *const rw       = new_r_Const_long(irg, mode_Is, 0);
+	ir_node  *const locality = new_r_Const_long(irg, mode_Is, 3);
+	ir_node  *const in[]     = { addr, rw, locality };
+	ir_node  *const mem      = get_Load_mem(load);
+	ir_node  *const builtin  = new_rd_Builtin(dbgi, block, mem, ARRAY_SIZE(in), in, ir_bk_prefetch, env->type);
+	set_Load_mem(load, new_r_Proj(builtin, mode_M, pn_Builtin_M));
+	++env->n_inserted;
+}
+
+void insert_prefetches(ir_graph *const irg, unsigned const latency)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.prefetch");
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+
+	ir_type *const type = new_type_method(3, 0, false, cc_cdecl_set, mtp_no_property);
+	set_method_param_type(type, 0, get_type_for_mode(mode_P));
+	set_method_param_type(type, 1, get_type_for_mode(mode_Is));
+	set_method_param_type(type, 2, get_type_for_mode(mode_Is));
+
+	prefetch_env_t env = {
+		.latency    = latency,
+		.type       = type,
+		.prefetches = NEW_ARR_F(prefetch_t, 0),
+	};
+	collect_innermost_loops(&env, get_irg_loop(irg));
+	for (size_t i = 0, n = ARR_LEN(env.prefetches); i < n; ++i)
+		insert_prefetch(&env, &env.prefetches[i]);
+	DEL_ARR_F(env.prefetches);
+
+	DB((dbg, LEVEL_1, "%+F: %u prefetches inserted\n", irg, env.n_inserted));
+	confirm_irg_properties(irg, env.n_inserted > 0
+		? IR_GRAPH_PROPERTIES_CONTROL_FLOW : IR_GRAPH_PROPERTIES_ALL);
+}
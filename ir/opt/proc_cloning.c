@@ -170,7 +170,7 @@ static void copy_irn_to_irg(ir_node *n, ir_graph *irg)
 
 	/* Copy the attributes.  These might point to additional data.  If this
 	   was allocated on the old obstack the pointers now are dangling.  This
-	   frees e.g. the memory of the graph_arr allocated in new_immBlock. */
+	   frees e.g. the memory of the values allocated in new_immBlock. */
 	copy_node_attr(irg, n, nn);
 	set_irn_link(n, nn);
 }
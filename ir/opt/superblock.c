@@ -0,0 +1,565 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2018 Karlsruhe Institute of Technology
+ */
+
+/**
+ * @file
+ * @brief   Superblock formation by tail duplication
+ *
+ * Traces are grown from the hottest blocks along their most likely successor.
+ * A block of a trace which is also entered from outside of the trace (a side
+ * entrance) is duplicated: the copy takes over the side entrances and the
+ * original block is only entered from its trace predecessor.  The copy in turn
+ * enters the next block of the trace from the side, so the whole tail below a
+ * side entrance is duplicated and each trace becomes a superblock with a
+ * single entry.
+ *
+ *   A   X            A   X
+ *    \ /             |   |
+ *     B      =>      B   B'
+ *     |              |   |
+ *     C              C   C'
+ *
+ * Merges on hot paths disappear this way, so values flowing along the trace
+ * are no longer obscured by Phis.  The local optimizations are rerun on the
+ * duplicated blocks afterwards.
+ */
+#include "array.h"
+#include "debug.h"
+#include "execfreq_t.h"
+#include "ircons.h"
+#include "irdom.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irnodemap.h"
+#include "iropt_t.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Minimum probability of an edge to extend a trace along it. */
+static const double min_edge_probability = 0.6;
+
+typedef struct superblock_env_t {
+	ir_node **blocks;     /**< blocks sorted by decreasing frequency */
+	ir_node **trace;      /**< the current trace */
+	ir_node **changed;    /**< nodes of duplicated blocks and their copies */
+	size_t    budget;     /**< number of nodes which may still be copied */
+} superblock_env_t;
+
+static void collect_block(ir_node *const block, void *const data)
+{
+	superblock_env_t *const env = (superblock_env_t*)data;
+	ARR_APP1(ir_node*, env->blocks, block);
+}
+
+static void count_node(ir_node *const node, void *const data)
+{
+	(void)node;
+	size_t *const n_nodes = (size_t*)data;
+	++*n_nodes;
+}
+
+static int cmp_block_freq(void const *const a, void const *const b)
+{
+	double const freq_a = get_block_execfreq(*(ir_node const*const*)a);
+	double const freq_b = get_block_execfreq(*(ir_node const*const*)b);
+	if (freq_a != freq_b)
+		return freq_a < freq_b ? 1 : -1;
+	return QSORT_CMP(get_irn_idx(*(ir_node const*const*)a),
+	                 get_irn_idx(*(ir_node const*const*)b));
+}
+
+static unsigned get_n_block_succs(ir_node const *const block)
+{
+	unsigned n_succs = 0;
+	foreach_block_succ(block, edge) {
+		++n_succs;
+	}
+	return n_succs;
+}
+
+/**
+ * Estimates the frequency of the control flow edge from @p pred to @p block.
+ * For critical edges the flow of the other edges, which is known exactly, is
+ * subtracted from the frequencies of both blocks.
+ */
+static double get_edge_freq(ir_node const *const pred,
+                            ir_node const *const block)
+{
+	double const pred_freq = get_block_execfreq(pred);
+	if (get_n_block_succs(pred) == 1)
+		return pred_freq;
+	double const freq = get_block_execfreq(block);
+	if (get_Block_n_cfgpreds(block) == 1)
+		return freq;
+
+	double out_rest = pred_freq;
+	foreach_block_succ(pred, edge) {
+		ir_node const *const succ = get_edge_src_irn(edge);
+		if (succ != block && get_Block_n_cfgpreds(succ) == 1)
+			out_rest -= get_block_execfreq(succ);
+	}
+	double in_rest = freq;
+	for (int i = 0, n = get_Block_n_cfgpreds(block); i < n; ++i) {
+		ir_node const *const other = get_Block_cfgpred_block(block, i);
+		if (other != pred && get_n_block_succs(other) == 1)
+			in_rest -= get_block_execfreq(other);
+	}
+	double const edge_freq = MIN(out_rest, in_rest);
+	return edge_freq > 0 ? edge_freq : 0;
+}
+
+/**
+ * Checks whether @p block may be duplicated: it must not be a loop header,
+ * have its address taken or pass mode_b values to other blocks.
+ */
+static bool is_duplicable(ir_node const *const block)
+{
+	ir_graph const *const irg = get_irn_irg(block);
+	if (block == get_irg_start_block(irg) || block == get_irg_end_block(irg))
+		return false;
+	if (get_Block_entity(block) != NULL)
+		return false;
+	for (int i = 0, n = get_Block_n_cfgpreds(block); i < n; ++i) {
+		ir_node const *const pred = get_Block_cfgpred_block(block, i);
+		if (pred == NULL || block_dominates(block, pred))
+			return false;
+	}
+	foreach_out_edge(block, edge) {
+		ir_node const *const node = get_edge_src_irn(edge);
+		if (is_End(node) || get_irn_mode(node) != mode_b)
+			continue;
+		foreach_out_edge(node, user_edge) {
+			ir_node const *const user = get_edge_src_irn(user_edge);
+			if (get_nodes_block(user) != block)
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns the successor of @p block which continues the trace, or NULL if the
+ * trace ends at @p block.
+ */
+static ir_node *get_trace_succ(ir_node const *const block)
+{
+	double   const freq      = get_block_execfreq(block);
+	ir_node       *best      = NULL;
+	double         best_freq = -1.0;
+	foreach_block_succ(block, edge) {
+		ir_node *const succ      = get_edge_src_irn(edge);
+		double   const edge_freq = get_edge_freq(block, succ);
+		if (edge_freq > best_freq) {
+			best      = succ;
+			best_freq = edge_freq;
+		}
+	}
+	if (best == NULL || Block_block_visited(best) || !is_duplicable(best))
+		return NULL;
+	if (best_freq < min_edge_probability * freq || best_freq <= 0)
+		return NULL;
+	return best;
+}
+
+/**
+ * Adds the new predecessor @p x to @p node, which is either a Block or a Phi.
+ */
+static void add_pred(ir_node *const node, ir_node *const x)
+{
+	int       const n   = get_irn_arity(node);
+	ir_node **const ins = ALLOCAN(ir_node*, n + 1);
+	foreach_irn_in(node, i, pred) {
+		ins[i] = pred;
+	}
+	ins[n] = x;
+	set_irn_in(node, n + 1, ins);
+}
+
+static bool is_kept_alive(ir_node const *const node)
+{
+	ir_node const *const end = get_irg_end(get_irn_irg(node));
+	for (int i = 0, n = get_End_n_keepalives(end); i < n; ++i) {
+		if (get_End_keepalive(end, i) == node)
+			return true;
+	}
+	return false;
+}
+
+static ir_node *get_copy(ir_nodemap const *const map, ir_node *const node)
+{
+	ir_node *const copy = ir_nodemap_get(ir_node, map, node);
+	return copy != NULL ? copy : node;
+}
+
+static ir_node *ssa_second_def;
+static ir_node *ssa_second_def_block;
+
+static ir_node *search_def_and_create_phis(ir_node *const block,
+                                           ir_mode *const mode,
+                                           bool const first)
+{
+	/* A user in the block of the second definition itself must not see it,
+	 * only users in blocks below it. */
+	if (block == ssa_second_def_block && !first)
+		return ssa_second_def;
+
+	if (irn_visited(block))
+		return (ir_node*)get_irn_link(block);
+
+	ir_graph *const irg = get_irn_irg(block);
+	assert(block != get_irg_start_block(irg));
+
+	int const n_cfgpreds = get_Block_n_cfgpreds(block);
+	if (n_cfgpreds == 1) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, 0);
+		ir_node *const value      = search_def_and_create_phis(pred_block, mode, false);
+		set_irn_link(block, value);
+		mark_irn_visited(block);
+		return value;
+	}
+
+	ir_node **const in    = ALLOCAN(ir_node*, n_cfgpreds);
+	ir_node  *const dummy = new_r_Dummy(irg, mode);
+	for (int i = 0; i < n_cfgpreds; ++i)
+		in[i] = dummy;
+
+	/* Tail duplication creates no new loops, so no PhiM has to be marked as
+	 * potentially endless loop here. */
+	ir_node *const phi = new_r_Phi(block, n_cfgpreds, in, mode);
+	set_irn_link(block, phi);
+	mark_irn_visited(block);
+
+	for (int i = 0; i < n_cfgpreds; ++i) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, i);
+		set_irn_n(phi, i, search_def_and_create_phis(pred_block, mode, false));
+	}
+	return phi;
+}
+
+/**
+ * Reroutes the users of @p orig_val, which is defined in @p orig_block, to
+ * @p second_val defined in @p second_block where necessary, inserting Phis at
+ * the merge points.
+ */
+static void construct_ssa(ir_node *const orig_block, ir_node *const orig_val,
+                          ir_node *const second_block,
+                          ir_node *const second_val)
+{
+	ir_graph *const irg = get_irn_irg(orig_val);
+	inc_irg_visited(irg);
+
+	ir_mode *const mode = get_irn_mode(orig_val);
+	set_irn_link(orig_block, orig_val);
+	mark_irn_visited(orig_block);
+	ssa_second_def_block = second_block;
+	ssa_second_def       = second_val;
+
+	foreach_out_edge_safe(orig_val, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (is_End(user))
+			continue;
+
+		int      const pos        = get_edge_src_pos(edge);
+		ir_node *const user_block = get_nodes_block(user);
+		ir_node       *newval;
+		if (is_Phi(user)) {
+			ir_node *const pred_block = get_Block_cfgpred_block(user_block, pos);
+			newval = search_def_and_create_phis(pred_block, mode, false);
+		} else {
+			newval = search_def_and_create_phis(user_block, mode, true);
+		}
+
+		if (newval != orig_val)
+			set_irn_n(user, pos, newval);
+	}
+}
+
+/**
+ * Duplicates @p block of a trace such that the copy takes all predecessors
+ * except @p trace_pred.  Returns the copy.
+ */
+static ir_node *duplicate_block(superblock_env_t *const env,
+                                ir_node *const block,
+                                ir_node const *const trace_pred)
+{
+	ir_graph *const irg      = get_irn_irg(block);
+	int       const n_preds  = get_Block_n_cfgpreds(block);
+	ir_node **const in       = ALLOCAN(ir_node*, n_preds);
+	bool     *const on_trace = ALLOCAN(bool, n_preds);
+	int             n_off    = 0;
+	for (int i = 0; i < n_preds; ++i) {
+		on_trace[i] = get_Block_cfgpred_block(block, i) == trace_pred;
+		if (!on_trace[i])
+			in[n_off++] = get_Block_cfgpred(block, i);
+	}
+	int const n_on = n_preds - n_off;
+	assert(n_on > 0 && n_off > 0);
+
+	/* Split the execution frequency between the block and its copy. */
+	double const freq       = get_block_execfreq(block);
+	double const trace_freq = MIN(get_edge_freq(trace_pred, block), freq);
+
+	dbg_info *const dbgi       = get_irn_dbg_info(block);
+	ir_node  *const copy_block = new_rd_Block(dbgi, irg, n_off, in);
+	set_block_execfreq(copy_block, freq - trace_freq);
+	set_block_execfreq(block, trace_freq);
+
+	ir_node **nodes = NEW_ARR_F(ir_node*, 0);
+	bool      kept  = false;
+	foreach_out_edge(block, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		if (is_End(node)) {
+			kept = true;
+			continue;
+		}
+		ARR_APP1(ir_node*, nodes, node);
+	}
+	if (kept)
+		keep_alive(copy_block);
+
+	ir_nodemap map;
+	ir_nodemap_init(&map, irg);
+	ir_nodemap_insert(&map, block, copy_block);
+
+	/* Copy the nodes, the Phis only keep the side entrances. */
+	size_t const n_nodes = ARR_LEN(nodes);
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		ir_node       *copy;
+		if (is_Phi(node)) {
+			ir_node **const phi_in = ALLOCAN(ir_node*, n_off);
+			for (int p = 0, j = 0; p < n_preds; ++p) {
+				if (!on_trace[p])
+					phi_in[j++] = get_Phi_pred(node, p);
+			}
+			copy = new_rd_Phi(get_irn_dbg_info(node), copy_block, n_off,
+			                  phi_in, get_irn_mode(node));
+			if (get_Phi_loop(node)) {
+				set_Phi_loop(copy, true);
+				if (is_kept_alive(node))
+					keep_alive(copy);
+			}
+		} else {
+			copy = exact_copy(node);
+			set_nodes_block(copy, copy_block);
+		}
+		ir_nodemap_insert(&map, node, copy);
+		ARR_APP1(ir_node*, env->changed, node);
+		ARR_APP1(ir_node*, env->changed, copy);
+	}
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		if (is_Phi(node))
+			continue;
+		ir_node *const copy = get_copy(&map, node);
+		foreach_irn_in(node, n, pred) {
+			set_irn_n(copy, n, get_copy(&map, pred));
+		}
+	}
+
+	/* The original block keeps the trace predecessor only. */
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const phi = nodes[i];
+		if (!is_Phi(phi))
+			continue;
+		ir_node **const phi_in = ALLOCAN(ir_node*, n_on);
+		for (int p = 0, j = 0; p < n_preds; ++p) {
+			if (on_trace[p])
+				phi_in[j++] = get_Phi_pred(phi, p);
+		}
+		set_irn_in(phi, n_on, phi_in);
+	}
+	for (int p = 0, j = 0; p < n_preds; ++p) {
+		if (on_trace[p])
+			in[j++] = get_Block_cfgpred(block, p);
+	}
+	set_irn_in(block, n_on, in);
+
+	/* The copied control flow enters the successors as additional
+	 * predecessor. */
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		if (get_irn_mode(node) != mode_X)
+			continue;
+
+		ir_node *const copy  = get_copy(&map, node);
+		ir_node      **succs = NEW_ARR_F(ir_node*, 0);
+		foreach_out_edge(node, edge) {
+			ir_node *const succ = get_edge_src_irn(edge);
+			if (is_Block(succ))
+				ARR_APP1(ir_node*, succs, succ);
+		}
+		for (size_t s = 0, n_succs = ARR_LEN(succs); s < n_succs; ++s) {
+			ir_node *const succ = succs[s];
+			for (int p = 0, n = get_Block_n_cfgpreds(succ); p < n; ++p) {
+				if (get_Block_cfgpred(succ, p) != node)
+					continue;
+				foreach_out_edge_safe(succ, edge) {
+					ir_node *const phi = get_edge_src_irn(edge);
+					if (is_Phi(phi))
+						add_pred(phi, get_copy(&map, get_Phi_pred(phi, p)));
+				}
+				add_pred(succ, copy);
+			}
+		}
+		DEL_ARR_F(succs);
+	}
+
+	/* Values of the block may now reach their users from the copy, too. */
+	for (size_t i = 0; i < n_nodes; ++i) {
+		ir_node *const node = nodes[i];
+		ir_mode *const mode = get_irn_mode(node);
+		if (mode == mode_X || mode == mode_T)
+			continue;
+		construct_ssa(block, node, copy_block, get_copy(&map, node));
+	}
+
+	ir_nodemap_destroy(&map);
+	DEL_ARR_F(nodes);
+	return copy_block;
+}
+
+/**
+ * Checks whether @p block is entered from another block than @p trace_pred.
+ */
+static bool has_side_entrance(ir_node const *const block,
+                              ir_node const *const trace_pred)
+{
+	for (int i = 0, n = get_Block_n_cfgpreds(block); i < n; ++i) {
+		if (get_Block_cfgpred_block(block, i) != trace_pred)
+			return true;
+	}
+	return false;
+}
+
+static size_t count_block_nodes(ir_node const *const block)
+{
+	size_t n_nodes = 0;
+	foreach_out_edge(block, edge) {
+		if (!is_End(get_edge_src_irn(edge)))
+			++n_nodes;
+	}
+	return n_nodes;
+}
+
+/**
+ * Removes the side entrances of the current trace by duplicating its tail.
+ * Returns whether the graph changed.
+ */
+static bool form_superblock(superblock_env_t *const env)
+{
+	bool         changed  = false;
+	size_t const n_blocks = ARR_LEN(env->trace);
+	for (size_t i = 1; i < n_blocks; ++i) {
+		/* Blocks only entered from the trace, possibly along several edges
+		 * like two Switch cases, need no copy. */
+		ir_node *const block      = env->trace[i];
+		ir_node *const trace_pred = env->trace[i - 1];
+		if (!has_side_entrance(block, trace_pred))
+			continue;
+
+		size_t const n_nodes = count_block_nodes(block);
+		if (n_nodes > env->budget) {
+			DB((dbg, LEVEL_2, "budget exceeded at %+F\n", block));
+			break;
+		}
+		env->budget -= n_nodes;
+
+		ir_node *const copy = duplicate_block(env, block, trace_pred);
+		(void)copy;
+		DB((dbg, LEVEL_2, "duplicated %+F into %+F\n", block, copy));
+		changed = true;
+	}
+	return changed;
+}
+
+/**
+ * Grows a trace from @p seed along the most likely successors.
+ */
+static void select_trace(superblock_env_t *const env, ir_node *const seed)
+{
+	ARR_SHRINKLEN(env->trace, 0);
+	for (ir_node *block = seed; block != NULL; block = get_trace_succ(block)) {
+		mark_Block_block_visited(block);
+		ARR_APP1(ir_node*, env->trace, block);
+	}
+}
+
+void form_superblocks(ir_graph *const irg, unsigned const growth)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.superblock");
+
+	assure_irg_properties(irg,
+		IR_GRAPH_PROPERTY_NO_BADS
+		| IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE
+		| IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+		| IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+
+	/* Profile based frequencies are kept, estimate them if there are none. */
+	if (get_block_execfreq(get_irg_start_block(irg)) == 0.0)
+		ir_estimate_execfreq(irg);
+
+	size_t n_nodes = 0;
+	irg_walk_graph(irg, count_node, NULL, &n_nodes);
+
+	superblock_env_t env = {
+		.blocks  = NEW_ARR_F(ir_node*, 0),
+		.trace   = NEW_ARR_F(ir_node*, 0),
+		.changed = NEW_ARR_F(ir_node*, 0),
+		.budget  = n_nodes * growth / 100,
+	};
+	irg_block_walk_graph(irg, collect_block, NULL, &env);
+	QSORT_ARR(env.blocks, cmp_block_freq);
+
+	/* Select all traces first, duplication invalidates the dominance
+	 * information used to detect loop headers. */
+	ir_node ***traces = NEW_ARR_F(ir_node**, 0);
+	ir_reserve_resources(irg, IR_RESOURCE_BLOCK_VISITED);
+	inc_irg_block_visited(irg);
+	for (size_t i = 0, n = ARR_LEN(env.blocks); i < n; ++i) {
+		ir_node *const block = env.blocks[i];
+		if (Block_block_visited(block) || get_block_execfreq(block) <= 0)
+			continue;
+		select_trace(&env, block);
+		if (ARR_LEN(env.trace) < 2)
+			continue;
+		ir_node **const trace = NEW_ARR_F(ir_node*, ARR_LEN(env.trace));
+		MEMCPY(trace, env.trace, ARR_LEN(env.trace));
+		ARR_APP1(ir_node**, traces, trace);
+	}
+	ir_free_resources(irg, IR_RESOURCE_BLOCK_VISITED);
+
+	bool changed = false;
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK | IR_RESOURCE_IRN_VISITED);
+	for (size_t i = 0, n = ARR_LEN(traces); i < n; ++i) {
+		DEL_ARR_F(env.trace);
+		env.trace = traces[i];
+		DB((dbg, LEVEL_1, "trace from %+F with %zu blocks\n", env.trace[0],
+		    ARR_LEN(env.trace)));
+		changed |= form_superblock(&env);
+	}
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK | IR_RESOURCE_IRN_VISITED);
+	DEL_ARR_F(traces);
+	DEL_ARR_F(env.trace);
+	DEL_ARR_F(env.blocks);
+
+	if (changed) {
+		remove_End_Bads_and_doublets(get_irg_end(irg));
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_NONE);
+		/* Values merged at the side entrances are known along the trace now. */
+		optimize_nodes_df(irg, env.changed, ARR_LEN(env.changed));
+	} else {
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_ALL);
+	}
+	DEL_ARR_F(env.changed);
+}
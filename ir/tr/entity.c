@@ -15,11 +15,13 @@
 #include "irdump.h"
 #include "irgraph_t.h"
 #include "irhooks.h"
+#include "irmemstat_t.h"
 #include "irprog_t.h"
 #include "panic.h"
 #include "util.h"
 #include "xmalloc.h"
 #include <stdlib.h>
+#include <string.h>
 
 /** The name of the unknown entity. */
 #define UNKNOWN_ENTITY_NAME "unknown_entity"
@@ -35,7 +37,8 @@ static ir_entity *intern_new_entity(ir_type *owner, ir_entity_kind kind,
 {
 	assert(owner != NULL);
 
-	ir_entity *res = XMALLOCZ(ir_entity);
+	ir_entity *res = (ir_entity*)ir_mem_alloc(ir_mem_types, sizeof(*res));
+	memset(res, 0, sizeof(*res));
 	res->firm_tag    = k_entity;
 	res->name        = name;
 	res->ld_name     = name;
@@ -183,7 +186,7 @@ static void free_entity_attrs(ir_entity *ent)
 ir_entity *clone_entity(ir_entity const *const old, ident *const name,
                         ir_type *const owner)
 {
-	ir_entity *res = XMALLOC(ir_entity);
+	ir_entity *res = (ir_entity*)ir_mem_alloc(ir_mem_types, sizeof(*res));
 
 	*res = *old;
 	/* FIXME: the initializers are NOT copied */
@@ -215,7 +218,7 @@ void free_entity(ir_entity *ent)
 #ifdef DEBUG_libfirm
 	ent->firm_tag = k_BAD;
 #endif
-	free(ent);
+	ir_mem_free(ir_mem_types, ent, sizeof(*ent));
 }
 
 long get_entity_nr(const ir_entity *ent)
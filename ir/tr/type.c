@@ -35,6 +35,7 @@
 #include "entity_t.h"
 #include "ircons.h"
 #include "irhooks.h"
+#include "irmemstat_t.h"
 #include "irnode_t.h"
 #include "irprog_t.h"
 #include "irprog_t.h"
@@ -47,7 +48,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-static ir_type *new_type(tp_opcode opcode, size_t attr_size, ir_mode *mode);
+static ir_type *new_type(tp_opcode opcode, ir_mode *mode);
 static void free_compound_entities(ir_type *type);
 
 const char *get_type_opcode_name(tp_opcode const opcode)
@@ -80,10 +81,10 @@ ir_type *get_unknown_type(void)
 
 void ir_init_type(ir_prog *irp)
 {
-	irp->code_type = new_type(tpo_code, 0, mode_ANY);
+	irp->code_type = new_type(tpo_code, mode_ANY);
 	set_type_state(irp->code_type, layout_fixed);
 
-	irp->unknown_type = new_type(tpo_unknown, 0, mode_ANY);
+	irp->unknown_type = new_type(tpo_unknown, mode_ANY);
 	set_type_state (irp->unknown_type, layout_fixed);
 
 	irp->dummy_owner = new_type_struct(new_id_from_str("$dummy_owner$"));
@@ -113,16 +114,41 @@ void inc_master_type_visited(void)
 	++firm_type_visited;
 }
 
+/** Returns the number of bytes allocated for a type with opcode @p opcode. */
+static size_t get_type_node_size(tp_opcode const opcode)
+{
+	size_t const base_size = offsetof(ir_type, attr);
+	switch (opcode) {
+	case tpo_class:
+		return base_size + sizeof(class_attr);
+	case tpo_segment:
+	case tpo_struct:
+	case tpo_union:
+		return base_size + sizeof(compound_attr);
+	case tpo_method:
+		return base_size + sizeof(method_attr);
+	case tpo_array:
+		return base_size + sizeof(array_attr);
+	case tpo_pointer:
+		return base_size + sizeof(pointer_attr);
+	case tpo_code:
+	case tpo_primitive:
+	case tpo_unknown:
+	case tpo_uninitialized:
+		return base_size;
+	}
+	panic("Invalid type");
+}
+
 /**
  *   Creates a new type representation:
  *   @return A new type of the given type.  The remaining private attributes are
  *           not initialized.  The type is in state layout_undefined.
  */
-static ir_type *new_type(tp_opcode const opcode, size_t attr_size,
-                         ir_mode *const mode)
+static ir_type *new_type(tp_opcode const opcode, ir_mode *const mode)
 {
-	size_t   const node_size = offsetof(ir_type, attr) +  attr_size;
-	ir_type *const res       = (ir_type*)xmalloc(node_size);
+	size_t   const node_size = get_type_node_size(opcode);
+	ir_type *const res       = (ir_type*)ir_mem_alloc(ir_mem_types, node_size);
 	memset(res, 0, node_size);
 
 	res->kind   = k_type;
@@ -179,10 +205,11 @@ void free_type(ir_type *tp)
 	/* Free the attributes of the type. */
 	free_type_attrs(tp);
 	/* And now the type itself... */
+	tp_opcode const opcode = get_type_opcode(tp);
 #ifdef DEBUG_libfirm
 	tp->kind = k_BAD;
 #endif
-	free(tp);
+	ir_mem_free(ir_mem_types, tp, get_type_node_size(opcode));
 }
 
 void *(get_type_link)(const ir_type *tp)
@@ -332,7 +359,7 @@ static void free_compound_entities(ir_type *type)
 
 ir_type *new_type_class(ident *name)
 {
-	ir_type *res = new_type(tpo_class, sizeof(class_attr), NULL);
+	ir_type *res = new_type(tpo_class, NULL);
 	compound_init(res, name);
 	res->attr.cls.subtypes   = NEW_ARR_F(ir_type*, 0);
 	res->attr.cls.supertypes = NEW_ARR_F(ir_type*, 0);
@@ -488,7 +515,7 @@ int (is_Class_type)(const ir_type *clss)
 
 ir_type *new_type_struct(ident *name)
 {
-	ir_type *res = new_type(tpo_struct, sizeof(compound_attr), NULL);
+	ir_type *res = new_type(tpo_struct, NULL);
 	compound_init(res, name);
 	hook_new_type(res);
 	return res;
@@ -519,7 +546,7 @@ int (is_Struct_type)(const ir_type *strct)
 
 ir_type *new_type_method(size_t const n_param, size_t const n_res, int const is_variadic, unsigned const cc_mask, mtp_additional_properties const property_mask)
 {
-	ir_type *const res = new_type(tpo_method, sizeof(method_attr), NULL);
+	ir_type *const res = new_type(tpo_method, NULL);
 	res->flags                       |= tf_layout_fixed;
 	res->attr.method.n_params         = n_param;
 	res->attr.method.params           = XMALLOCNZ(ir_type*, n_param);
@@ -540,7 +567,7 @@ ir_type *clone_type_method(ir_type *const tp, int const variadic_index, mtp_addi
 	size_t         n_params = tp->attr.method.n_params;
 	size_t         n_res    = tp->attr.method.n_res;
 	type_dbg_info *db       = tp->dbi;
-	ir_type       *res      = new_type(tpo_method, sizeof(method_attr), mode);
+	ir_type       *res      = new_type(tpo_method, mode);
 	set_type_dbg_info(res, db);
 
 	res->flags                        = tp->flags;
@@ -647,7 +674,7 @@ int (is_Method_type)(const ir_type *method)
 
 ir_type *new_type_union(ident *name)
 {
-	ir_type *res = new_type(tpo_union, sizeof(compound_attr), NULL);
+	ir_type *res = new_type(tpo_union, NULL);
 	compound_init(res, name);
 	hook_new_type(res);
 	return res;
@@ -678,7 +705,7 @@ int (is_Union_type)(const ir_type *uni)
 
 ir_type *new_type_segment(ident *const name, type_flags const flags)
 {
-	ir_type *const res = new_type(tpo_segment, sizeof(compound_attr), NULL);
+	ir_type *const res = new_type(tpo_segment, NULL);
 	compound_init(res, name);
 	res->flags |= flags;
 	return res;
@@ -693,7 +720,7 @@ ir_type *new_type_array(ir_type *const element_type, unsigned const n_elements)
 {
 	assert(!is_Method_type(element_type));
 
-	ir_type *const res = new_type(tpo_array, sizeof(array_attr), NULL);
+	ir_type *const res = new_type(tpo_array, NULL);
 	res->attr.array.element_type = element_type;
 	res->attr.array.size         = n_elements;
 	set_type_alignment(res, get_type_alignment(element_type));
@@ -727,7 +754,7 @@ int (is_Array_type)(const ir_type *array)
 ir_type *new_type_pointer(ir_type *points_to)
 {
 	ir_mode *const mode = mode_P;
-	ir_type *const res  = new_type(tpo_pointer, sizeof(pointer_attr), mode);
+	ir_type *const res  = new_type(tpo_pointer, mode);
 	res->attr.pointer.points_to = points_to;
 	unsigned size = get_mode_size_bytes(mode);
 	res->size = size;
@@ -761,7 +788,7 @@ ir_type *new_type_primitive(ir_mode *mode)
 	unsigned align = (size > 0 && size != (unsigned)-1)
 	               ? ceil_po2(size) : 1;
 
-	ir_type *res = new_type(tpo_primitive, 0, mode);
+	ir_type *res = new_type(tpo_primitive, mode);
 	res->size  = size;
 	res->flags |= tf_layout_fixed;
 	set_type_alignment(res, align);
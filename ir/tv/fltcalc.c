@@ -11,6 +11,7 @@
  */
 #include "fltcalc.h"
 
+#include "compiler.h"
 #include "panic.h"
 #include "strcalc.h"
 #include "xmalloc.h"
@@ -48,8 +49,8 @@ static unsigned fp_value_size;
 static unsigned value_size;
 static unsigned max_precision;
 
-/** Exact flag. */
-static bool fc_exact = true;
+/** Exact flag of the last operation of this thread. */
+static THREAD_LOCAL bool fc_exact = true;
 
 static float_descriptor_t long_double_desc;
 
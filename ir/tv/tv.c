@@ -28,7 +28,7 @@
 #include "irnode_t.h"
 #include "irprintf.h"
 #include "panic.h"
-#include "set.h"
+#include "shardset.h"
 #include "strcalc.h"
 #include "util.h"
 #include "xmalloc.h"
@@ -42,8 +42,9 @@
  * constant target values */
 #define N_CONSTANTS 2048
 
-/** A set containing all existing tarvals. */
-static struct set *tarvals = NULL;
+/** A set containing all existing tarvals.  Sharded once threads are used, so
+ * tarvals can be created from several threads. */
+static shardset_t tarvals;
 
 static unsigned sc_value_length;
 static unsigned fp_value_size;
@@ -71,8 +72,8 @@ static int cmp_tv(const void *p1, const void *p2, size_t n)
 static ir_tarval *identify_tarval(ir_tarval const *const tv)
 {
 	unsigned hash = hash_tv(tv);
-	return set_insert(ir_tarval, tarvals, tv, sizeof(ir_tarval) + tv->length,
-	                  hash);
+	return (ir_tarval*)shardset_insert(&tarvals, tv,
+	                                   sizeof(ir_tarval) + tv->length, hash);
 }
 
 static ir_tarval *get_fp_tarval(const fp_value *value, ir_mode *mode)
@@ -637,14 +638,16 @@ ir_tarval *tarval_convert_to(ir_tarval const *const src,
 			/* XXX floating point unit does not understand internal integer
 			 * representation, convert to string first, then create float from
 			 * string */
-			char *buffer = ALLOCAN(char, 100);
 			/* decimal string representation because hexadecimal output is
-			 * interpreted unsigned by fc_val_from_str, so this is a HACK */
-			int len = snprintf(buffer, 100, "%s",
-				sc_print(src->value, get_mode_size_bits(src->mode), SC_DEC, mode_is_signed(src->mode)));
+			 * interpreted unsigned by fc_val_from_str, so this is a HACK.
+			 * Print into a local buffer, this may run on several threads. */
+			size_t const buf_len = sc_get_precision() + 1;
+			char  *const buffer  = ALLOCAN(char, buf_len);
+			char const *const str = sc_print_buf(buffer, buf_len, src->value,
+				get_mode_size_bits(src->mode), SC_DEC, mode_is_signed(src->mode));
 
 			fp_value *fpval = (fp_value*)ALLOCAN(char, fp_value_size);
-			fc_val_from_str(buffer, len, fpval);
+			fc_val_from_str(str, strlen(str), fpval);
 			fc_cast(fpval, get_descriptor(dst_mode), fpval);
 			return get_fp_tarval(fpval, dst_mode);
 		}
@@ -1331,7 +1334,7 @@ void init_tarval_1(void)
 {
 	/* initialize the sets holding the tarvals with a comparison function and
 	 * an initial size, which is the expected number of constants */
-	tarvals = new_set(cmp_tv, N_CONSTANTS);
+	shardset_init(&tarvals, cmp_tv, N_CONSTANTS, ir_mem_tarvals);
 	/* calls init_strcalc() with needed size */
 	init_fltcalc(128);
 
@@ -1356,10 +1359,15 @@ void init_tarval_2(void)
 	tarval_b_false->mode = mode_b;
 }
 
+void tarval_enable_threads(void)
+{
+	shardset_enable_threads(&tarvals);
+}
+
 void finish_tarval(void)
 {
 	finish_strcalc();
-	del_set(tarvals); tarvals = NULL;
+	shardset_destroy(&tarvals);
 }
 
 bool tarval_in_range(ir_tarval const *const min, ir_tarval const *const val, ir_tarval const *const max)
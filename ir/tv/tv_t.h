@@ -42,6 +42,11 @@ void init_tarval_1(void);
  */
 void init_tarval_2(void);
 
+/**
+ * Prepares the tarval module for creating tarvals from several threads.
+ */
+void tarval_enable_threads(void);
+
 /**
  * Free all memory occupied by the tarval module.
  */
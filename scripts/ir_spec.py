@@ -252,9 +252,9 @@ class Block(Node):
     res->attr.block.backedge = new_backedge_arr(get_irg_obstack(irg), arity);
     set_Block_matured(res, 1);
 
-    /* Create and initialize array for Phi-node construction. */
+    /* Create and initialize the values for Phi-node construction. */
     if (irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION)) {
-        res->attr.block.graph_arr = NEW_ARR_DZ(ir_node*, get_irg_obstack(irg), irg->n_loc);
+        alloc_block_values(res);
     }
     '''
 
@@ -277,6 +277,9 @@ class Builtin(Node):
         Attribute("kind", type="ir_builtin_kind", comment="kind of builtin"),
         Attribute("type", type="ir_type*",
                   comment="method type for the builtin call"),
+        Attribute("order", type="ir_memory_order",
+                  init="ir_memory_order_seq_cst",
+                  comment="memory ordering of atomic builtins"),
     ]
     pinned = "exception"
     pinned_init = "op_pin_state_pinned"
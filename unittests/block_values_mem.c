@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "firm.h"
+
+/*
+ * Builds a function with many locals and a chain of if/else diamonds, where
+ * each diamond touches two neighbouring locals, and checks the peak memory of
+ * the node obstacks against the dense per block value arrays, which SSA
+ * construction would need otherwise.
+ *
+ * Called with the number of locals and diamonds as arguments, this is a
+ * benchmark and prints the peak memory instead.
+ */
+
+#define N_LOCALS   2000
+#define N_DIAMONDS 2000
+
+static ir_graph *build_graph(int const n_locals, int const n_diamonds)
+{
+	ir_mode   *const mode     = mode_Is;
+	ir_type   *const int_type = new_type_primitive(mode);
+	ir_type   *const mtp      = new_type_method(1, 1, false, cc_cdecl_set,
+	                                            mtp_no_property);
+	set_method_param_type(mtp, 0, int_type);
+	set_method_res_type(mtp, 0, int_type);
+	ir_entity *const ent = new_entity(get_glob_type(), new_id_from_str("f"), mtp);
+	ir_graph  *const irg = new_ir_graph(ent, n_locals);
+	set_current_ir_graph(irg);
+
+	ir_node *const arg = new_Proj(get_irg_args(irg), mode, 0);
+	for (int i = 0; i < n_locals; ++i)
+		set_value(i, i % 7 == 0 ? arg : new_Const_long(mode, i));
+
+	for (int d = 0; d < n_diamonds; ++d) {
+		int const a = d % n_locals;
+		int const b = (d + 1) % n_locals;
+		set_value(a, new_Const_long(mode, d));
+		set_value(b, new_Add(get_value(a, mode), arg));
+		ir_node *const cmp  = new_Cmp(get_value(a, mode), get_value(b, mode),
+		                              ir_relation_less);
+		ir_node *const cond = new_Cond(cmp);
+
+		ir_node *const block_true = new_immBlock();
+		add_immBlock_pred(block_true, new_Proj(cond, mode_X, pn_Cond_true));
+		mature_immBlock(block_true);
+		set_cur_block(block_true);
+		set_value(a, new_Add(get_value(a, mode), get_value(b, mode)));
+		ir_node *const jmp_true = new_Jmp();
+
+		ir_node *const block_false = new_immBlock();
+		add_immBlock_pred(block_false, new_Proj(cond, mode_X, pn_Cond_false));
+		mature_immBlock(block_false);
+		set_cur_block(block_false);
+		set_value(b, new_Sub(get_value(b, mode), get_value(a, mode)));
+		ir_node *const jmp_false = new_Jmp();
+
+		ir_node *const join = new_immBlock();
+		add_immBlock_pred(join, jmp_true);
+		add_immBlock_pred(join, jmp_false);
+		mature_immBlock(join);
+		set_cur_block(join);
+	}
+
+	/* Query locals, which were not touched since the start block. */
+	ir_node *sum = get_value(0, mode);
+	for (int i = 1; i < n_locals; i += n_locals / 16 + 1)
+		sum = new_Add(sum, get_value(i, mode));
+	ir_node *const ret = new_Return(get_store(), 1, &sum);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_cur_block());
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+int main(int argc, char **argv)
+{
+	bool const benchmark  = argc > 1;
+	int  const n_locals   = benchmark ? atoi(argv[1]) : N_LOCALS;
+	int  const n_diamonds = argc > 2 ? atoi(argv[2]) : N_DIAMONDS;
+
+	ir_mem_stat_enable();
+	ir_init();
+
+	ir_graph *const irg = build_graph(n_locals, n_diamonds);
+	irg_verify(irg);
+
+	size_t const peak     = ir_mem_stat_get_peak(ir_mem_nodes);
+	size_t const n_blocks = 1 + 3 * (size_t)n_diamonds;
+	size_t const dense    = n_blocks * n_locals * sizeof(ir_node*);
+	if (benchmark) {
+		printf("locals %d, diamonds %d: peak node memory %zu KiB, dense value arrays %zu KiB\n",
+		       n_locals, n_diamonds, peak / 1024, dense / 1024);
+	} else {
+		/* The dense arrays alone would be 92 MiB. */
+		assert(peak < dense / 4);
+	}
+
+	ir_finish();
+	return 0;
+}
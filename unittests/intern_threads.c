@@ -0,0 +1,103 @@
+#include "ident_t.h"
+#include "irmode_t.h"
+#include "irprog_t.h"
+#include "tv_t.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#define N_THREADS 8
+#define N_VALUES  (1U << 20)
+#define N_WINDOW  (N_VALUES / N_THREADS * 2)
+#define N_EARLY   (N_VALUES / 4)
+#define N_MODES   16
+
+static ident     *idents[N_VALUES];
+static ir_tarval *tarvals[N_VALUES];
+static ir_mode   *modes[N_THREADS][N_MODES];
+
+/* Every thread visits a window of the values, which overlaps with the window
+ * of the next thread, in a different order, so two threads race for the first
+ * insertion of each value. */
+static unsigned permute(unsigned seed, unsigned i)
+{
+	unsigned const start = seed * (N_VALUES / N_THREADS);
+	return (start + (i * 7919 + seed * 104729) % N_WINDOW) % N_VALUES;
+}
+
+/** Records @p value as the result for slot @p dst, or checks that it equals
+ * the result recorded by another thread. */
+static void check(void **const dst, void *const value)
+{
+	void *expected = NULL;
+	if (!__atomic_compare_exchange_n(dst, &expected, value, false,
+	                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		assert(expected == value);
+}
+
+static ident *get_ident(unsigned const v)
+{
+	char name[16];
+	snprintf(name, sizeof(name), "ident%u", v);
+	return new_id_from_str(name);
+}
+
+static void *intern(void *const arg)
+{
+	unsigned const seed = (unsigned)(size_t)arg;
+	for (unsigned i = 0; i != N_WINDOW; ++i) {
+		unsigned const v = permute(seed, i);
+		check((void**)&idents[v], (void*)get_ident(v));
+		check((void**)&tarvals[v], new_tarval_from_long(v, mode_Iu));
+	}
+	for (unsigned i = 0; i != N_MODES; ++i) {
+		unsigned const m    = (i + seed) % N_MODES;
+		char           name[16];
+		snprintf(name, sizeof(name), "I%u", 40 + m);
+		modes[seed][m] = new_int_mode(name, 40 + m, true, 64);
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	init_ident();
+	init_tarval_1();
+	init_irprog_1();
+	init_mode();
+	init_tarval_2();
+
+	/* Some values exist before the tables are sharded. */
+	for (unsigned v = 0; v != N_EARLY; ++v) {
+		idents[v]  = get_ident(v);
+		tarvals[v] = new_tarval_from_long(v, mode_Iu);
+	}
+	ident_enable_threads();
+	tarval_enable_threads();
+
+	pthread_t threads[N_THREADS];
+	for (unsigned t = 0; t != N_THREADS; ++t) {
+		int const res = pthread_create(&threads[t], NULL, intern,
+		                               (void*)(size_t)t);
+		assert(res == 0);
+		(void)res;
+	}
+	for (unsigned t = 0; t != N_THREADS; ++t)
+		pthread_join(threads[t], NULL);
+
+	for (unsigned v = 0; v != N_VALUES; ++v) {
+		assert(idents[v] == get_ident(v));
+		assert(tarvals[v] == new_tarval_from_long(v, mode_Iu));
+	}
+	for (unsigned m = 0; m != N_MODES; ++m) {
+		ir_mode *const mode = modes[0][m];
+		assert(get_mode_size_bits(mode) == 40 + m);
+		for (unsigned t = 1; t != N_THREADS; ++t)
+			assert(modes[t][m] == mode);
+	}
+
+	finish_tarval();
+	finish_mode();
+	finish_ident();
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bejitheap.h"
+#include "firm.h"
+#include "statev.h"
+
+#define SMALL 40
+#define LARGE 100000
+
+static size_t const expected_live[] = {
+	SMALL, 2 * SMALL, SMALL, 2 * SMALL, 2 * SMALL + LARGE, 2 * SMALL, SMALL, 0
+};
+
+static char *alloc_code(jit_heap_t *const heap, size_t const size,
+                        char const fill)
+{
+	char       *writable;
+	char *const code = jit_heap_alloc(heap, size, &writable);
+	memset(writable, fill, size);
+	jit_heap_seal(heap, code);
+	/* The code is visible at its executable address. */
+	for (size_t i = 0; i < size; ++i)
+		assert(code[i] == fill);
+	return code;
+}
+
+/**
+ * Checks the statistics events: the live bytes after each allocation and
+ * free, and the fragmentation matching the live and mapped bytes.
+ */
+static void check_events(char const *const filename)
+{
+	FILE *const file = fopen(filename, "r");
+	assert(file != NULL);
+	char   line[256];
+	size_t n_live = 0;
+	double live   = 0;
+	double mapped = 0;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		unsigned long long value;
+		double             frag;
+		if (sscanf(line, "E;jit_heap_live;%llu", &value) == 1) {
+			assert(n_live < sizeof(expected_live) / sizeof(*expected_live));
+			assert(value == expected_live[n_live]);
+			++n_live;
+			live = value;
+		} else if (sscanf(line, "E;jit_heap_mapped;%llu", &value) == 1) {
+			assert(value >= live);
+			mapped = value;
+		} else if (sscanf(line, "E;jit_heap_fragmentation;%lf", &frag) == 1) {
+			assert(fabs(frag - (1.0 - live / mapped)) < 1e-4);
+		}
+	}
+	assert(n_live == sizeof(expected_live) / sizeof(*expected_live));
+	assert(mapped == 0);
+	fclose(file);
+	remove(filename);
+}
+
+int main(void)
+{
+	ir_init();
+	stat_ev_begin("jit_heap", NULL);
+
+	jit_heap_t heap;
+	jit_heap_init(&heap);
+
+	char *const a = alloc_code(&heap, SMALL, 0x11);
+	assert(heap.live == SMALL);
+	size_t const mapped = heap.mapped;
+	assert(mapped >= SMALL);
+	/* Without dual mappings each allocation gets pages of its own. */
+	bool const slabs = mapped >= 64 * 1024;
+
+	char *const b = alloc_code(&heap, SMALL, 0x22);
+	assert(b != a);
+	assert(heap.live == 2 * SMALL);
+	assert(slabs ? heap.mapped == mapped : heap.mapped == 2 * mapped);
+
+	/* A freed slot is reused and keeps its neighbour intact. */
+	jit_heap_free(&heap, a);
+	assert(heap.live == SMALL);
+	char *const c = alloc_code(&heap, SMALL, 0x33);
+	if (slabs)
+		assert(c == a);
+	assert(b[0] == 0x22 && b[SMALL - 1] == 0x22);
+	size_t const small_mapped = heap.mapped;
+
+	/* Large allocations get a mapping of their own, which is unmapped when
+	 * freed. */
+	char *const large = alloc_code(&heap, LARGE, 0x44);
+	assert(heap.live == 2 * SMALL + LARGE);
+	assert(heap.mapped >= small_mapped + LARGE);
+	jit_heap_free(&heap, large);
+	assert(heap.mapped == small_mapped);
+
+	/* Empty slabs are returned to the system. */
+	jit_heap_free(&heap, b);
+	jit_heap_free(&heap, c);
+	assert(heap.live == 0);
+	assert(heap.mapped == 0);
+	jit_heap_destroy(&heap);
+
+	stat_ev_end();
+	check_events("jit_heap.ev");
+	(void)slabs;
+
+	ir_finish();
+	return 0;
+}
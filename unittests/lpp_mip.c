@@ -0,0 +1,223 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "firm.h"
+#include "lpp.h"
+
+#define N_VARS 10
+#define N_CSTS 4
+#define N_CONTS 2
+
+static unsigned seed = 1;
+
+static int next_random(int limit)
+{
+	seed = seed * 1103515245u + 12345u;
+	return (int)((seed >> 16) % (unsigned)limit);
+}
+
+static bool close_to(double a, double b)
+{
+	return fabs(a - b) <= 1e-6 * (1.0 + fabs(b));
+}
+
+/** Solves a random binary problem and compares it with enumeration. */
+static void test_random_binary(void)
+{
+	double       obj[N_VARS];
+	double       factor[N_CSTS][N_VARS];
+	double       rhs[N_CSTS];
+	lpp_cst_t    type[N_CSTS];
+	lpp_opt_t    const opt = next_random(2) ? lpp_maximize : lpp_minimize;
+	lpp_t *const lpp       = lpp_new("random", opt);
+
+	int vars[N_VARS];
+	for (int j = 0; j < N_VARS; ++j) {
+		obj[j]  = next_random(21) - 10;
+		vars[j] = lpp_add_var(lpp, NULL, lpp_binary, obj[j]);
+	}
+	for (int i = 0; i < N_CSTS; ++i) {
+		static lpp_cst_t const types[] = {
+			lpp_less_equal, lpp_greater_equal, lpp_equal
+		};
+		type[i] = types[next_random(i == 0 ? 2 : 3)];
+		rhs[i]  = next_random(7) - 1;
+		int const cst = lpp_add_cst(lpp, NULL, type[i], rhs[i]);
+		for (int j = 0; j < N_VARS; ++j) {
+			factor[i][j] = next_random(3) == 0 ? next_random(5) - 2 : 0;
+			if (factor[i][j] != 0)
+				lpp_set_factor_fast(lpp, cst, vars[j], factor[i][j]);
+		}
+	}
+
+	bool   feasible = false;
+	double best     = 0.0;
+	for (unsigned mask = 0; mask < 1u << N_VARS; ++mask) {
+		bool ok = true;
+		for (int i = 0; i < N_CSTS && ok; ++i) {
+			double lhs = 0.0;
+			for (int j = 0; j < N_VARS; ++j)
+				lhs += (mask >> j & 1) ? factor[i][j] : 0.0;
+			switch (type[i]) {
+			case lpp_less_equal:    ok = lhs <= rhs[i]; break;
+			case lpp_greater_equal: ok = lhs >= rhs[i]; break;
+			default:                ok = lhs == rhs[i]; break;
+			}
+		}
+		if (!ok)
+			continue;
+		double value = 0.0;
+		for (int j = 0; j < N_VARS; ++j)
+			value += (mask >> j & 1) ? obj[j] : 0.0;
+		if (!feasible || (opt == lpp_maximize ? value > best : value < best))
+			best = value;
+		feasible = true;
+	}
+
+	lpp_solve(lpp, "mip");
+	if (feasible) {
+		assert(lpp_get_sol_state(lpp) == lpp_optimal);
+		assert(close_to(lpp->objval, best));
+	} else {
+		assert(lpp_get_sol_state(lpp) == lpp_infeasible);
+	}
+	lpp_free(lpp);
+}
+
+/**
+ * Solves a random problem min c x + w z, where each continuous z_k is bounded
+ * below by some linear functions of the binaries x, so its optimum is their
+ * maximum (or 0) and the problem can be solved by enumeration.
+ */
+static void test_random_mixed(void)
+{
+	double       obj[N_VARS];
+	double       weight[N_CONTS];
+	double       factor[N_CSTS][N_VARS];
+	double       rhs[N_CSTS];
+	int          cont[N_CSTS];
+	lpp_t *const lpp = lpp_new("random_mixed", lpp_minimize);
+
+	int vars[N_VARS];
+	for (int j = 0; j < N_VARS; ++j) {
+		obj[j]  = next_random(21) - 10;
+		vars[j] = lpp_add_var(lpp, NULL, lpp_binary, obj[j]);
+	}
+	int conts[N_CONTS];
+	for (int k = 0; k < N_CONTS; ++k) {
+		weight[k] = 1 + next_random(5);
+		conts[k]  = lpp_add_var(lpp, NULL, lpp_continous, weight[k]);
+	}
+	for (int i = 0; i < N_CSTS; ++i) {
+		/* z_k - a x >= rhs */
+		cont[i] = next_random(N_CONTS);
+		rhs[i]  = next_random(5) - 2;
+		int const cst = lpp_add_cst(lpp, NULL, lpp_greater_equal, rhs[i]);
+		lpp_set_factor_fast(lpp, cst, conts[cont[i]], 1.0);
+		for (int j = 0; j < N_VARS; ++j) {
+			factor[i][j] = next_random(3) == 0 ? next_random(7) - 3 : 0;
+			if (factor[i][j] != 0)
+				lpp_set_factor_fast(lpp, cst, vars[j], -factor[i][j]);
+		}
+	}
+
+	double best = HUGE_VAL;
+	for (unsigned mask = 0; mask < 1u << N_VARS; ++mask) {
+		double value = 0.0;
+		for (int j = 0; j < N_VARS; ++j)
+			value += (mask >> j & 1) ? obj[j] : 0.0;
+		double z[N_CONTS] = { 0.0 };
+		for (int i = 0; i < N_CSTS; ++i) {
+			double lhs = rhs[i];
+			for (int j = 0; j < N_VARS; ++j)
+				lhs += (mask >> j & 1) ? factor[i][j] : 0.0;
+			if (lhs > z[cont[i]])
+				z[cont[i]] = lhs;
+		}
+		for (int k = 0; k < N_CONTS; ++k)
+			value += weight[k] * z[k];
+		if (value < best)
+			best = value;
+	}
+
+	lpp_solve(lpp, "mip");
+	assert(lpp_get_sol_state(lpp) == lpp_optimal);
+	assert(close_to(lpp->objval, best));
+	lpp_free(lpp);
+}
+
+/**
+ * max x + 2y - 2b  s.t.  x + y <= 2.5,  x - y >= -0.5,  x <= 2b
+ * with continuous x, y and binary b has the optimum 2 at b = 1, x = 1,
+ * y = 1.5.
+ */
+static void test_mixed(void)
+{
+	lpp_t *const lpp = lpp_new("mixed", lpp_maximize);
+	int const x  = lpp_add_var(lpp, "x", lpp_continous, 1.0);
+	int const y  = lpp_add_var(lpp, "y", lpp_continous, 2.0);
+	int const b  = lpp_add_var(lpp, "b", lpp_binary, -2.0);
+	int const c0 = lpp_add_cst(lpp, "c0", lpp_less_equal, 2.5);
+	lpp_set_factor_fast(lpp, c0, x, 1.0);
+	lpp_set_factor_fast(lpp, c0, y, 1.0);
+	int const c1 = lpp_add_cst(lpp, "c1", lpp_greater_equal, -0.5);
+	lpp_set_factor_fast(lpp, c1, x, 1.0);
+	lpp_set_factor_fast(lpp, c1, y, -1.0);
+	int const c2 = lpp_add_cst(lpp, "c2", lpp_less_equal, 0.0);
+	lpp_set_factor_fast(lpp, c2, x, 1.0);
+	lpp_set_factor_fast(lpp, c2, b, -2.0);
+
+	lpp_solve(lpp, "mip");
+	assert(lpp_get_sol_state(lpp) == lpp_optimal);
+	assert(close_to(lpp->objval, 2.0));
+	assert(close_to(lpp_get_var_sol(lpp, y), 1.5));
+	lpp_free(lpp);
+}
+
+/** Continuous optima beyond any artificial bound are found. */
+static void test_large(void)
+{
+	lpp_t *const lpp = lpp_new("large", lpp_maximize);
+	int const x   = lpp_add_var(lpp, "x", lpp_continous, 1.0);
+	int const b   = lpp_add_var(lpp, "b", lpp_binary, -1e3);
+	int const cst = lpp_add_cst(lpp, "c", lpp_less_equal, 0.0);
+	lpp_set_factor_fast(lpp, cst, x, 1.0);
+	lpp_set_factor_fast(lpp, cst, b, -4e7);
+
+	lpp_solve(lpp, "mip");
+	assert(lpp_get_sol_state(lpp) == lpp_optimal);
+	assert(close_to(lpp->objval, 4e7 - 1e3));
+	assert(close_to(lpp_get_var_sol(lpp, x), 4e7));
+	lpp_free(lpp);
+}
+
+/** max x  s.t.  x - y <= 1 is unbounded. */
+static void test_unbounded(void)
+{
+	lpp_t *const lpp = lpp_new("unbounded", lpp_maximize);
+	int const x   = lpp_add_var(lpp, "x", lpp_continous, 1.0);
+	int const y   = lpp_add_var(lpp, "y", lpp_continous, 0.0);
+	int const cst = lpp_add_cst(lpp, "c", lpp_less_equal, 1.0);
+	lpp_set_factor_fast(lpp, cst, x, 1.0);
+	lpp_set_factor_fast(lpp, cst, y, -1.0);
+
+	lpp_solve(lpp, "mip");
+	assert(lpp_get_sol_state(lpp) == lpp_unbounded);
+	lpp_free(lpp);
+}
+
+int main(void)
+{
+	ir_init();
+	for (int i = 0; i < 200; ++i) {
+		test_random_binary();
+		test_random_mixed();
+	}
+	test_mixed();
+	test_large();
+	test_unbounded();
+	ir_finish();
+	return 0;
+}
@@ -0,0 +1,191 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "firm.h"
+
+#define CHAIN 12
+
+static ir_type *int_type;
+static ir_type *ptr_type;
+static ir_type *prefetch_type;
+
+/**
+ * Creates a local function returning an int and taking @p n_params
+ * parameters, an int followed by pointers.
+ */
+static ir_graph *new_function(char const *const name, size_t const n_params)
+{
+	ir_type *const mtp = new_type_method(n_params, 1, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	for (size_t i = 0; i < n_params; ++i)
+		set_method_param_type(mtp, i, i == 0 ? int_type : ptr_type);
+	set_method_res_type(mtp, 0, int_type);
+	ir_entity *const ent = new_global_entity(get_glob_type(),
+		new_id_from_str(name), mtp, ir_visibility_local, IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(ent, 0);
+	set_current_ir_graph(irg);
+	return irg;
+}
+
+static ir_node *get_param(size_t const num)
+{
+	ir_mode *const mode = num == 0 ? mode_Is : mode_P;
+	return new_Proj(get_irg_args(current_ir_graph), mode, num);
+}
+
+static void finish_function(ir_node *value)
+{
+	ir_node *const ret = new_Return(get_store(), 1, &value);
+	add_immBlock_pred(get_irg_end_block(current_ir_graph), ret);
+	mature_immBlock(get_cur_block());
+	irg_finalize_cons(current_ir_graph);
+}
+
+/** f(x): a chain of multiplications and additions of constants. */
+static ir_graph *build_identical(char const *const name)
+{
+	ir_graph *const irg   = new_function(name, 1);
+	ir_node        *value = get_param(0);
+	for (long i = 1; i <= CHAIN; ++i) {
+		value = new_Mul(value, new_Const_long(mode_Is, 3));
+		value = new_Add(value, new_Const_long(mode_Is, i));
+	}
+	finish_function(value);
+	return irg;
+}
+
+/** f(x): (x ^ @p c) followed by a chain of subtractions and shifts. */
+static ir_graph *build_near_identical(char const *const name, long const c)
+{
+	ir_graph *const irg   = new_function(name, 1);
+	ir_node        *value = new_Eor(get_param(0), new_Const_long(mode_Is, c));
+	for (long i = 1; i <= CHAIN; ++i) {
+		value = new_Sub(value, new_Const_long(mode_Is, i));
+		value = new_Shl(value, new_Const_long(mode_Iu, 1));
+	}
+	finish_function(value);
+	return irg;
+}
+
+/** f(x, p): prefetch p with @p rw, then a chain of ors and multiplications. */
+static ir_graph *build_prefetch(char const *const name, long const rw)
+{
+	ir_graph *const irg  = new_function(name, 2);
+	ir_node  *const in[] = {
+		get_param(1), new_Const_long(mode_Is, rw), new_Const_long(mode_Is, 3)
+	};
+	ir_node *const builtin = new_Builtin(get_store(), 3, in,
+	                                     ir_bk_prefetch,
+	                                     prefetch_type);
+	set_store(new_Proj(builtin, mode_M, pn_Builtin_M));
+
+	ir_node *const x     = get_param(0);
+	ir_node       *value = x;
+	for (long i = 1; i <= CHAIN; ++i) {
+		value = new_Or(value, new_Const_long(mode_Is, i << 4));
+		value = new_Mul(value, x);
+	}
+	finish_function(value);
+	return irg;
+}
+
+/** Builds a function returning the result of calling @p callee with 1. */
+static ir_graph *build_caller(char const *const name, ir_graph *const callee)
+{
+	ir_graph  *const irg    = new_function(name, 0);
+	ir_entity *const entity = get_irg_entity(callee);
+	ir_node   *const arg    = new_Const_long(mode_Is, 1);
+	ir_node   *const call   = new_Call(get_store(), new_Address(entity), 1,
+	                                   &arg, get_entity_type(entity));
+	set_store(new_Proj(call, mode_M, pn_Call_M));
+	ir_node *const res = new_Proj(call, mode_T, pn_Call_T_result);
+	finish_function(new_Proj(res, mode_Is, 0));
+	return irg;
+}
+
+static void find_call_walker(ir_node *const node, void *const env)
+{
+	ir_node **const call = (ir_node**)env;
+	if (is_Call(node)) {
+		assert(*call == NULL);
+		*call = node;
+	}
+}
+
+/** Returns the only Call in the graph of @p entity. */
+static ir_node *find_call(ir_entity *const entity)
+{
+	ir_node *call = NULL;
+	irg_walk_graph(get_entity_irg(entity), find_call_walker, NULL, &call);
+	assert(call != NULL);
+	return call;
+}
+
+static long get_const_param(ir_node *const call, int const pos)
+{
+	return get_tarval_long(get_Const_tarval(get_Call_param(call, pos)));
+}
+
+/** The identical @p a2 becomes an alias of @p a1, @p a3 calls @p a1. */
+static void check_identical(ir_entity *const a1, ir_entity *const a2,
+                            ir_entity *const a3)
+{
+	assert(is_alias_entity(a2));
+	assert(get_entity_alias(a2) == a1);
+	assert(get_Call_callee(find_call(a3)) == a1);
+}
+
+/**
+ * The near-identical @p b1 and @p b2 become thunks passing their constant to
+ * one merged body.
+ */
+static void check_near_identical(ir_entity *const b1, ir_entity *const b2)
+{
+	ir_node   *const b1_call = find_call(b1);
+	ir_node   *const b2_call = find_call(b2);
+	ir_entity *const merged  = get_Call_callee(b1_call);
+	assert(merged != b1 && merged != b2);
+	assert(get_Call_callee(b2_call) == merged);
+	assert(get_method_n_params(get_entity_type(merged)) == 2);
+	assert(get_const_param(b1_call, 1) == 17);
+	assert(get_const_param(b2_call, 1) == 23);
+}
+
+int main(void)
+{
+	ir_init();
+	int_type = new_type_primitive(mode_Is);
+	ptr_type = new_type_pointer(int_type);
+	prefetch_type = new_type_method(3, 0, false, cc_cdecl_set, mtp_no_property);
+	set_method_param_type(prefetch_type, 0, ptr_type);
+	set_method_param_type(prefetch_type, 1, int_type);
+	set_method_param_type(prefetch_type, 2, int_type);
+
+	ir_graph *const a1 = build_identical("a1");
+	ir_graph *const a2 = build_identical("a2");
+	ir_graph *const a3 = build_caller("a3", a2);
+	ir_graph *const b1 = build_near_identical("b1", 17);
+	ir_graph *const b2 = build_near_identical("b2", 23);
+	ir_graph *const c1 = build_prefetch("c1", 0);
+	ir_graph *const c2 = build_prefetch("c2", 1);
+	ir_entity *const a1_ent = get_irg_entity(a1);
+	ir_entity *const a2_ent = get_irg_entity(a2);
+	ir_entity *const a3_ent = get_irg_entity(a3);
+	ir_entity *const b1_ent = get_irg_entity(b1);
+	ir_entity *const b2_ent = get_irg_entity(b2);
+	ir_entity *const c1_ent = get_irg_entity(c1);
+	ir_entity *const c2_ent = get_irg_entity(c2);
+
+	if (merge_identical_functions() == 0)
+		return 1;
+
+	check_identical(a1_ent, a2_ent, a3_ent);
+	check_near_identical(b1_ent, b2_ent);
+	/* Functions differing in a builtin operand are left alone. */
+	if (get_entity_irg(c1_ent) != c1 || get_entity_irg(c2_ent) != c2)
+		return 1;
+
+	ir_finish();
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "array.h"
+#include "firm.h"
+
+#define N_GRAPHS  64
+#define N_THREADS 4
+#define CHAIN     300
+
+static long expected[N_GRAPHS];
+
+/**
+ * Builds a graph returning a long chain of additions of constants, which is
+ * converted to double and back, so folding it needs integer and float
+ * arithmetic.  Local optimization is off during the construction, so the
+ * chain is only folded by the pipeline.
+ */
+static ir_graph *build_graph(long const k)
+{
+	ir_mode   *const mode     = mode_Is;
+	ir_type   *const int_type = new_type_primitive(mode);
+	ir_type   *const mtp      = new_type_method(0, 1, false, cc_cdecl_set,
+	                                            mtp_no_property);
+	set_method_res_type(mtp, 0, int_type);
+	ir_entity *const ent = new_entity(get_glob_type(), id_unique("f"), mtp);
+	ir_graph  *const irg = new_ir_graph(ent, 0);
+	set_current_ir_graph(irg);
+
+	ir_node *value = new_Const_long(mode, k);
+	long     sum   = k;
+	for (long i = 1; i <= CHAIN; ++i) {
+		value = new_Add(value, new_Const_long(mode, i));
+		sum  += i;
+	}
+	ir_node *const half = new_Const(new_tarval_from_double(0.5, mode_D));
+	value = new_Conv(new_Add(new_Conv(value, mode_D), half), mode);
+	expected[k] = sum;
+
+	ir_node *const ret = new_Return(get_store(), 1, &value);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_cur_block());
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+static ir_node *get_return_value(ir_graph *const irg)
+{
+	ir_node *const end_block = get_irg_end_block(irg);
+	assert(get_Block_n_cfgpreds(end_block) == 1);
+	ir_node *const ret = get_Block_cfgpred(end_block, 0);
+	assert(is_Return(ret));
+	return get_Return_res(ret, 0);
+}
+
+static void check_folded(ir_graph *const irg)
+{
+	ir_node *const value = get_return_value(irg);
+	assert(is_Const(value));
+	long const k = (long)(size_t)get_entity_link(get_irg_entity(irg));
+	assert(get_tarval_long(get_Const_tarval(value)) == expected[k]);
+	(void)value;
+	(void)k;
+}
+
+static void collect_node_nr(ir_node *const node, void *const env)
+{
+	long **const nrs = (long**)env;
+	ARR_APP1(long, *nrs, get_irn_node_nr(node));
+}
+
+static int cmp_long(void const *const a, void const *const b)
+{
+	long const l = *(long const*)a;
+	long const r = *(long const*)b;
+	return (l > r) - (l < r);
+}
+
+int main(void)
+{
+	ir_init();
+
+	set_optimize(0);
+	for (long k = 0; k < N_GRAPHS; ++k) {
+		ir_graph *const irg = build_graph(k);
+		set_entity_link(get_irg_entity(irg), (void*)(size_t)k);
+	}
+	set_optimize(1);
+
+	ir_pipeline_t *const pipeline = new_ir_pipeline();
+	ir_pipeline_set_n_threads(pipeline, N_THREADS);
+	ir_pipeline_add_reentrant_graph_pass(pipeline, "remove_tuples",
+		remove_tuples, IR_GRAPH_PROPERTIES_NONE, IR_GRAPH_PROPERTIES_NONE);
+	ir_pipeline_add_reentrant_graph_pass(pipeline, "local_opts",
+		local_optimize_graph, IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE,
+		IR_GRAPH_PROPERTIES_ALL);
+	ir_pipeline_add_reentrant_graph_pass(pipeline, "remove_bads",
+		remove_bads, IR_GRAPH_PROPERTIES_NONE, IR_GRAPH_PROPERTIES_NONE);
+	/* Not re-entrant, so this stage runs on the calling thread. */
+	ir_pipeline_add_graph_pass(pipeline, "check", check_folded,
+		IR_GRAPH_PROPERTIES_NONE, IR_GRAPH_PROPERTIES_NONE);
+	ir_pipeline_run(pipeline);
+	free_ir_pipeline(pipeline);
+
+	/* The nodes created concurrently got distinct numbers. */
+	long *nrs = NEW_ARR_F(long, 0);
+	for (size_t i = 0, n = get_irp_n_irgs(); i < n; ++i) {
+		ir_graph *const irg = get_irp_irg(i);
+		irg_verify(irg);
+		irg_walk_graph(irg, NULL, collect_node_nr, &nrs);
+	}
+	qsort(nrs, ARR_LEN(nrs), sizeof(*nrs), cmp_long);
+	for (size_t i = 1, n = ARR_LEN(nrs); i < n; ++i)
+		assert(nrs[i - 1] != nrs[i]);
+	DEL_ARR_F(nrs);
+
+	ir_finish();
+	return 0;
+}
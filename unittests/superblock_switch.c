@@ -0,0 +1,78 @@
+#include <assert.h>
+#include <stdbool.h>
+
+#include "firm.h"
+
+/*
+ * f(x): switch (x) { case 1: case 2: y = x * 3; break; default: y = x - 5; }
+ *       return y + 7;
+ *
+ * Both cases enter the hot block of y = x * 3 from the switch block, so the
+ * block has no side entrance and must not be duplicated, while the join
+ * block below it is entered from the default block and is.
+ */
+static ir_graph *build_graph(void)
+{
+	ir_mode   *const mode     = mode_Is;
+	ir_type   *const int_type = new_type_primitive(mode);
+	ir_type   *const mtp      = new_type_method(1, 1, false, cc_cdecl_set,
+	                                            mtp_no_property);
+	set_method_param_type(mtp, 0, int_type);
+	set_method_res_type(mtp, 0, int_type);
+	ir_entity *const ent = new_entity(get_glob_type(), new_id_from_str("f"), mtp);
+	ir_graph  *const irg = new_ir_graph(ent, 1);
+	set_current_ir_graph(irg);
+
+	ir_node         *const x     = new_Proj(get_irg_args(irg), mode, 0);
+	ir_switch_table *const table = ir_new_switch_table(irg, 2);
+	ir_tarval       *const one   = get_mode_one(mode);
+	ir_tarval       *const two   = new_tarval_from_long(2, mode);
+	ir_switch_table_set(table, 0, one, one, 1);
+	ir_switch_table_set(table, 1, two, two, 2);
+	ir_node *const swtch = new_Switch(x, 3, table);
+
+	ir_node *const hot = new_immBlock();
+	add_immBlock_pred(hot, new_Proj(swtch, mode_X, 1));
+	add_immBlock_pred(hot, new_Proj(swtch, mode_X, 2));
+	mature_immBlock(hot);
+	set_cur_block(hot);
+	set_value(0, new_Mul(x, new_Const_long(mode, 3)));
+	ir_node *const jmp_hot = new_Jmp();
+
+	ir_node *const cold = new_immBlock();
+	add_immBlock_pred(cold, new_Proj(swtch, mode_X, pn_Switch_default));
+	mature_immBlock(cold);
+	set_cur_block(cold);
+	set_value(0, new_Sub(x, new_Const_long(mode, 5)));
+	ir_node *const jmp_cold = new_Jmp();
+
+	ir_node *const join = new_immBlock();
+	add_immBlock_pred(join, jmp_hot);
+	add_immBlock_pred(join, jmp_cold);
+	mature_immBlock(join);
+	set_cur_block(join);
+	ir_node *const res = new_Add(get_value(0, mode), new_Const_long(mode, 7));
+	ir_node *const ret = new_Return(get_store(), 1, &res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+int main(void)
+{
+	ir_init();
+
+	ir_graph *const irg = build_graph();
+	form_superblocks(irg, 100);
+	irg_verify(irg);
+
+	/* The join block was duplicated, so each copy returns. */
+	ir_node *const end_block = get_irg_end_block(irg);
+	assert(get_Block_n_cfgpreds(end_block) == 2);
+	for (int i = 0; i < 2; ++i)
+		assert(is_Return(get_Block_cfgpred(end_block, i)));
+	(void)end_block;
+
+	ir_finish();
+	return 0;
+}